@@ -0,0 +1,150 @@
+#include "dirty_region.h"
+#include <algorithm>
+
+namespace videoeditor {
+
+bool Rect::intersects(const Rect& other) const {
+    return x < other.right() && other.x < right() &&
+           y < other.bottom() && other.y < bottom();
+}
+
+bool Rect::touches(const Rect& other) const {
+    return x <= other.right() && other.x <= right() &&
+           y <= other.bottom() && other.y <= bottom();
+}
+
+Rect Rect::intersect(const Rect& other) const {
+    int left = std::max(x, other.x);
+    int top = std::max(y, other.y);
+    int r = std::min(right(), other.right());
+    int b = std::min(bottom(), other.bottom());
+    
+    if (r <= left || b <= top) {
+        return {0, 0, 0, 0};
+    }
+    return {left, top, r - left, b - top};
+}
+
+Rect Rect::unite(const Rect& other) const {
+    if (isEmpty()) return other;
+    if (other.isEmpty()) return *this;
+    
+    int left = std::min(x, other.x);
+    int top = std::min(y, other.y);
+    int r = std::max(right(), other.right());
+    int b = std::max(bottom(), other.bottom());
+    return {left, top, r - left, b - top};
+}
+
+DirtyRegion::DirtyRegion(size_t maxRects)
+    : m_maxRects(std::max<size_t>(1, maxRects)) {
+}
+
+void DirtyRegion::add(const Rect& rect) {
+    if (rect.isEmpty()) return;
+    
+    // Merge with any rect it overlaps or abuts; repeat since the union may grow into others
+    Rect merged = rect;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = m_rects.begin(); it != m_rects.end(); ++it) {
+            if (it->touches(merged)) {
+                merged = merged.unite(*it);
+                m_rects.erase(it);
+                changed = true;
+                break;
+            }
+        }
+    }
+    m_rects.push_back(merged);
+    
+    // Too fragmented - a single bounding box is cheaper than many small blits
+    if (m_rects.size() > m_maxRects) {
+        Rect all = bounds();
+        m_rects.clear();
+        m_rects.push_back(all);
+    }
+}
+
+void DirtyRegion::clear() {
+    m_rects.clear();
+}
+
+Rect DirtyRegion::bounds() const {
+    Rect result = {0, 0, 0, 0};
+    for (const auto& rect : m_rects) {
+        result = result.unite(rect);
+    }
+    return result;
+}
+
+DirtyTracker::DirtyTracker(int width, int height)
+    : m_width(width)
+    , m_height(height)
+    , m_fullInvalidate(true) {
+}
+
+Rect DirtyTracker::clipToFrame(const Rect& rect) const {
+    return rect.intersect({0, 0, m_width, m_height});
+}
+
+DirtyRegion DirtyTracker::update(const std::vector<LayerState>& layers) {
+    DirtyRegion region;
+    
+    if (m_fullInvalidate) {
+        region.add({0, 0, m_width, m_height});
+        m_fullInvalidate = false;
+        m_previous = layers;
+        return region;
+    }
+    
+    std::vector<bool> matched(m_previous.size(), false);
+    size_t lastPrevIndex = 0;
+    
+    for (size_t i = 0; i < layers.size(); i++) {
+        const LayerState& layer = layers[i];
+        
+        size_t prevIndex = m_previous.size();
+        for (size_t j = 0; j < m_previous.size(); j++) {
+            if (m_previous[j].layerId == layer.layerId) {
+                prevIndex = j;
+                break;
+            }
+        }
+        
+        if (prevIndex == m_previous.size()) {
+            // New layer
+            region.add(clipToFrame(layer.bounds));
+            continue;
+        }
+        
+        matched[prevIndex] = true;
+        const LayerState& prev = m_previous[prevIndex];
+        
+        // Layer now stacks below one it used to be above
+        bool reordered = prevIndex < lastPrevIndex;
+        lastPrevIndex = std::max(lastPrevIndex, prevIndex);
+        
+        if (prev.bounds != layer.bounds) {
+            // Moved or resized - both the uncovered and covered areas change
+            region.add(clipToFrame(prev.bounds));
+            region.add(clipToFrame(layer.bounds));
+        } else if (layer.animated || prev.contentKey != layer.contentKey ||
+                   prev.revision != layer.revision || reordered) {
+            region.add(clipToFrame(layer.bounds));
+        }
+    }
+    
+    // Removed layers expose whatever was underneath
+    for (size_t j = 0; j < m_previous.size(); j++) {
+        if (!matched[j]) {
+            region.add(clipToFrame(m_previous[j].bounds));
+        }
+    }
+    
+    m_previous = layers;
+    return region;
+}
+
+}  // namespace videoeditor
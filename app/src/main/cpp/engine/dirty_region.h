@@ -0,0 +1,79 @@
+#ifndef VIDEO_EDITOR_DIRTY_REGION_H
+#define VIDEO_EDITOR_DIRTY_REGION_H
+
+#include "common.h"
+#include <unordered_map>
+
+namespace videoeditor {
+
+// Axis-aligned rectangle in output frame pixels
+struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+
+    int right() const { return x + width; }
+    int bottom() const { return y + height; }
+    bool isEmpty() const { return width <= 0 || height <= 0; }
+
+    bool intersects(const Rect& other) const;
+    bool touches(const Rect& other) const;
+    Rect intersect(const Rect& other) const;
+    Rect unite(const Rect& other) const;
+
+    bool operator==(const Rect& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+    bool operator!=(const Rect& other) const { return !(*this == other); }
+};
+
+// Snapshot of one composited layer, compared frame to frame to find dirty areas
+struct LayerState {
+    int layerId;
+    Rect bounds;          // Destination rectangle in the output frame
+    int64_t contentKey;   // Changes whenever the layer pixels change (e.g. source PTS)
+    uint64_t revision;    // Bumped when layer parameters (filters, text, ...) change
+    bool animated;        // Animated layers are redrawn every frame
+};
+
+// Small set of non-overlapping rectangles that need recompositing
+class DirtyRegion {
+public:
+    explicit DirtyRegion(size_t maxRects = 8);
+
+    void add(const Rect& rect);
+    void clear();
+
+    bool isEmpty() const { return m_rects.empty(); }
+    Rect bounds() const;
+    const std::vector<Rect>& rects() const { return m_rects; }
+
+private:
+    size_t m_maxRects;
+    std::vector<Rect> m_rects;
+};
+
+// Tracks layer states between frames and reports what must be recomposited
+class DirtyTracker {
+public:
+    DirtyTracker(int width, int height);
+
+    // Diff against the previous frame's layers
+    DirtyRegion update(const std::vector<LayerState>& layers);
+
+    // Force the next update to report the whole frame
+    void invalidate() { m_fullInvalidate = true; }
+
+private:
+    Rect clipToFrame(const Rect& rect) const;
+
+    int m_width;
+    int m_height;
+    bool m_fullInvalidate;
+    std::vector<LayerState> m_previous;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_DIRTY_REGION_H
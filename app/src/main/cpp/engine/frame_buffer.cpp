@@ -1,12 +1,21 @@
 #include "frame_buffer.h"
+#include "video_stabilizer.h"
+#include "../filters/pixel_kernels.h"
+#include "../utils/pixel_format.h"
 #include <cmath>
+#include <cstring>
 
 namespace videoeditor {
 
 FrameBuffer::FrameBuffer(int width, int height)
     : m_width(width)
-    , m_height(height) {
-    m_buffer.resize(width * height * 4);  // RGBA
+    , m_height(height)
+    , m_dirtyTracker(width, height) {
+    m_frame.width = width;
+    m_frame.height = height;
+    m_frame.format = PixelFormat::RGBA;
+    m_frame.timestamp_us = 0;
+    m_frame.data.resize(m_frame.dataSize());
     clear();
     LOGI("FrameBuffer created: %dx%d", width, height);
 }
@@ -17,10 +26,177 @@ FrameBuffer::~FrameBuffer() {
 
 void FrameBuffer::clear() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    std::fill(m_buffer.begin(), m_buffer.end(), 0);
+    std::fill(m_frame.data.begin(), m_frame.data.end(), 0);
+    m_dirtyTracker.invalidate();
 }
 
+void FrameBuffer::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dirtyTracker.invalidate();
+}
+
+DirtyRegion FrameBuffer::beginFrame(const std::vector<LayerState>& layers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dirtyTracker.update(layers);
+}
+
+void FrameBuffer::clearRect(const Rect& rect) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    Rect area = rect.intersect({0, 0, m_frame.width, m_frame.height});
+    if (area.isEmpty()) return;
+    
+    size_t rowBytes = static_cast<size_t>(area.width) * 4;
+    for (int y = area.y; y < area.bottom(); y++) {
+        uint8_t* row = m_frame.data.data() + (static_cast<size_t>(y) * m_frame.width + area.x) * 4;
+        memset(row, 0, rowBytes);
+    }
+}
+
+Rect FrameBuffer::fitRect(int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+    if (srcWidth <= 0 || srcHeight <= 0) {
+        return {0, 0, 0, 0};
+    }
+    
+    float scaleX = static_cast<float>(dstWidth) / srcWidth;
+    float scaleY = static_cast<float>(dstHeight) / srcHeight;
+    float scale = std::min(scaleX, scaleY);  // Fit inside
+    
+    int scaledWidth = static_cast<int>(srcWidth * scale);
+    int scaledHeight = static_cast<int>(srcHeight * scale);
+    
+    return {(dstWidth - scaledWidth) / 2, (dstHeight - scaledHeight) / 2, scaledWidth, scaledHeight};
+}
+
+namespace {
+
+// Nearest-neighbour blit of a packed source into the RGBA destination, alpha blended
+template <class Format>
+void compositeArea(VideoFrame& dest, const VideoFrame& src, const Rect& fitted, const Rect& area, float scale) {
+    int srcWidth = src.width;
+    int srcHeight = src.height;
+    int dstWidth = dest.width;
+    size_t srcStride = static_cast<size_t>(srcWidth) * Format::kBytesPerPixel;
+    if (src.data.size() < srcStride * srcHeight || dest.data.size() < static_cast<size_t>(dstWidth) * dest.height * 4) {
+        return;
+    }
+    
+    for (int dy = area.y; dy < area.bottom(); dy++) {
+        int srcY = static_cast<int>((dy - fitted.y) / scale);
+        if (srcY >= srcHeight) srcY = srcHeight - 1;
+        
+        const uint8_t* srcRow = src.data.data() + srcY * srcStride;
+        uint8_t* dstRow = dest.data.data() + static_cast<size_t>(dy) * dstWidth * 4;
+        
+        for (int dx = area.x; dx < area.right(); dx++) {
+            int srcX = static_cast<int>((dx - fitted.x) / scale);
+            if (srcX >= srcWidth) srcX = srcWidth - 1;
+            
+            const uint8_t* in = srcRow + srcX * Format::kBytesPerPixel;
+            uint8_t* out = dstRow + dx * 4;
+            
+            // Straight-alpha blending (keyed clips); weight 0-256 so 255 copies exactly
+            int weight = 256;
+            if constexpr (Format::kA >= 0) {
+                weight = in[Format::kA] + (in[Format::kA] >> 7);
+            }
+            int inverse = 256 - weight;
+            
+            out[0] = static_cast<uint8_t>((in[Format::kR] * weight + out[0] * inverse + 128) >> 8);
+            out[1] = static_cast<uint8_t>((in[Format::kG] * weight + out[1] * inverse + 128) >> 8);
+            out[2] = static_cast<uint8_t>((in[Format::kB] * weight + out[2] * inverse + 128) >> 8);
+            out[3] = 255;
+        }
+    }
+}
+
+// Stabilised blit: the clip's correction, the crop zoom and the fit scale folded
+// into one inverse affine map, sampled bilinearly with clamped edges. Source
+// coordinates are 16.16 fixed point, computed per pixel from its own offset so
+// a dirty region gives exactly the pixels of a full draw.
+template <class Format>
+void compositeAreaTransformed(VideoFrame& dest, const VideoFrame& src, const Rect& fitted, const Rect& area,
+                              float scale, const FrameTransform& transform, float zoom) {
+    int srcWidth = src.width;
+    int srcHeight = src.height;
+    int dstWidth = dest.width;
+    size_t srcStride = static_cast<size_t>(srcWidth) * Format::kBytesPerPixel;
+    if (src.data.size() < srcStride * srcHeight || dest.data.size() < static_cast<size_t>(dstWidth) * dest.height * 4) {
+        return;
+    }
+    
+    // Output point q: p' = (q - fitted) / scale, zoomed about the centre c, then
+    // the correction undone: p = c + R(-angle) * ((p' - c) / zoom - (dx, dy)) / transform.scale
+    float cx = srcWidth * 0.5f;
+    float cy = srcHeight * 0.5f;
+    float m = 1.0f / (scale * zoom);
+    float cosA = std::cos(transform.angle) * m / transform.scale;
+    float sinA = std::sin(transform.angle) * m / transform.scale;
+    float c = std::cos(transform.angle) / transform.scale;
+    float s = std::sin(transform.angle) / transform.scale;
+    float ex = (0.5f - fitted.x) * m - cx / zoom - transform.dx;
+    float ey = (0.5f - fitted.y) * m - cy / zoom - transform.dy;
+    // Source position of output pixel (0, 0); texel centres sit at i + 0.5
+    float u0 = cx + c * ex + s * ey - 0.5f;
+    float v0 = cy - s * ex + c * ey - 0.5f;
+    
+    const int32_t duX = static_cast<int32_t>(std::lround(cosA * 65536.0f));
+    const int32_t duY = static_cast<int32_t>(std::lround(sinA * 65536.0f));
+    const int32_t dvX = -duY;
+    const int32_t dvY = duX;
+    const int32_t u00 = static_cast<int32_t>(std::lround(u0 * 65536.0f));
+    const int32_t v00 = static_cast<int32_t>(std::lround(v0 * 65536.0f));
+    const int32_t maxU = (srcWidth - 1) << 16;
+    const int32_t maxV = (srcHeight - 1) << 16;
+    
+    for (int dy = area.y; dy < area.bottom(); dy++) {
+        int32_t rowU = u00 + dy * duY;
+        int32_t rowV = v00 + dy * dvY;
+        uint8_t* out = dest.data.data() + (static_cast<size_t>(dy) * dstWidth + area.x) * 4;
+        
+        for (int dx = area.x; dx < area.right(); dx++, out += 4) {
+            int32_t u = std::max(0, std::min(maxU, rowU + dx * duX));
+            int32_t v = std::max(0, std::min(maxV, rowV + dx * dvX));
+            int x0 = u >> 16;
+            int y0 = v >> 16;
+            int fx = (u >> 8) & 255;
+            int fy = (v >> 8) & 255;
+            const uint8_t* p00 = src.data.data() + y0 * srcStride + x0 * Format::kBytesPerPixel;
+            const uint8_t* p10 = x0 + 1 < srcWidth ? p00 + Format::kBytesPerPixel : p00;
+            const uint8_t* p01 = y0 + 1 < srcHeight ? p00 + srcStride : p00;
+            const uint8_t* p11 = x0 + 1 < srcWidth ? p01 + Format::kBytesPerPixel : p01;
+            
+            int w00 = (256 - fx) * (256 - fy);
+            int w10 = fx * (256 - fy);
+            int w01 = (256 - fx) * fy;
+            int w11 = fx * fy;
+            auto sample = [&](int c) {
+                return (p00[c] * w00 + p10[c] * w10 + p01[c] * w01 + p11[c] * w11 + 32768) >> 16;
+            };
+            
+            int weight = 256;
+            if constexpr (Format::kA >= 0) {
+                int a = sample(Format::kA);
+                weight = a + (a >> 7);
+            }
+            int inverse = 256 - weight;
+            
+            out[0] = static_cast<uint8_t>((sample(Format::kR) * weight + out[0] * inverse + 128) >> 8);
+            out[1] = static_cast<uint8_t>((sample(Format::kG) * weight + out[1] * inverse + 128) >> 8);
+            out[2] = static_cast<uint8_t>((sample(Format::kB) * weight + out[2] * inverse + 128) >> 8);
+            out[3] = 255;
+        }
+    }
+}
+
+}  // namespace
+
 void FrameBuffer::composite(VideoFrame& dest, const VideoFrame& src, const TimelineClip& clip) {
+    composite(dest, src, clip, {0, 0, dest.width, dest.height});
+}
+
+void FrameBuffer::composite(VideoFrame& dest, const VideoFrame& src, const TimelineClip& clip,
+                            const Rect& region) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (src.data.empty()) {
@@ -31,46 +207,38 @@ void FrameBuffer::composite(VideoFrame& dest, const VideoFrame& src, const Timel
     int srcWidth = src.width;
     int srcHeight = src.height;
     int dstWidth = dest.width;
-    int dstHeight = dest.height;
     
     // Calculate scaling factors
     float scaleX = static_cast<float>(dstWidth) / srcWidth;
-    float scaleY = static_cast<float>(dstHeight) / srcHeight;
+    float scaleY = static_cast<float>(dest.height) / srcHeight;
     float scale = std::min(scaleX, scaleY);  // Fit inside
+    Rect fitted = fitRect(srcWidth, srcHeight, dstWidth, dest.height);
     
-    int scaledWidth = static_cast<int>(srcWidth * scale);
-    int scaledHeight = static_cast<int>(srcHeight * scale);
+    // Only touch destination pixels inside the requested region
+    Rect area = fitted.intersect(region).intersect({0, 0, dest.width, dest.height});
+    if (area.isEmpty()) {
+        return;
+    }
     
-    // Center position
-    int offsetX = (dstWidth - scaledWidth) / 2;
-    int offsetY = (dstHeight - scaledHeight) / 2;
+    // Stabilised clips take the affine path in the same single pass
+    const FrameTransform* transform = clip.stabilization ? clip.stabilization->find(src.timestamp_us) : nullptr;
     
-    // Copy with scaling (nearest neighbor for simplicity)
-    for (int y = 0; y < scaledHeight; y++) {
-        for (int x = 0; x < scaledWidth; x++) {
-            int srcX = static_cast<int>(x / scale);
-            int srcY = static_cast<int>(y / scale);
-            
-            if (srcX >= srcWidth) srcX = srcWidth - 1;
-            if (srcY >= srcHeight) srcY = srcHeight - 1;
-            
-            int dstIdx = ((offsetY + y) * dstWidth + (offsetX + x)) * 4;
-            int srcIdx = (srcY * srcWidth + srcX) * 4;
-            
-            if (dstIdx + 3 < dest.data.size() && srcIdx + 3 < src.data.size()) {
-                // Alpha blending
-                uint8_t srcAlpha = src.data[srcIdx + 3];
-                float alpha = srcAlpha / 255.0f;
-                
-                dest.data[dstIdx + 0] = static_cast<uint8_t>(
-                    src.data[srcIdx + 0] * alpha + dest.data[dstIdx + 0] * (1 - alpha));
-                dest.data[dstIdx + 1] = static_cast<uint8_t>(
-                    src.data[srcIdx + 1] * alpha + dest.data[dstIdx + 1] * (1 - alpha));
-                dest.data[dstIdx + 2] = static_cast<uint8_t>(
-                    src.data[srcIdx + 2] * alpha + dest.data[dstIdx + 2] * (1 - alpha));
-                dest.data[dstIdx + 3] = 255;
+    // Pick the source layout once; the blit loop is compiled per format
+    bool known = dispatchPixelFormat(src.format, [&](auto layout) {
+        using Format = decltype(layout);
+        if constexpr (Format::kPacked) {
+            if (transform) {
+                compositeAreaTransformed<Format>(dest, src, fitted, area, scale, *transform,
+                                                 clip.stabilization->zoom);
+            } else {
+                compositeArea<Format>(dest, src, fitted, area, scale);
             }
+        } else {
+            LOGW("Cannot composite planar frames; convert to RGBA first");
         }
+    });
+    if (!known) {
+        LOGW("Cannot composite frames of unknown format");
     }
 }
 
@@ -79,15 +247,9 @@ void FrameBuffer::blend(VideoFrame& dest, const VideoFrame& src, float alpha) {
     
     size_t pixelCount = std::min(dest.data.size(), src.data.size()) / 4;
     
-    for (size_t i = 0; i < pixelCount; i++) {
-        size_t idx = i * 4;
-        dest.data[idx + 0] = static_cast<uint8_t>(
-            src.data[idx + 0] * alpha + dest.data[idx + 0] * (1 - alpha));
-        dest.data[idx + 1] = static_cast<uint8_t>(
-            src.data[idx + 1] * alpha + dest.data[idx + 1] * (1 - alpha));
-        dest.data[idx + 2] = static_cast<uint8_t>(
-            src.data[idx + 2] * alpha + dest.data[idx + 2] * (1 - alpha));
-    }
+    // Alpha in 1/256 steps, rounded rather than truncated
+    int weight = static_cast<int>(std::max(0.0f, std::min(1.0f, alpha)) * 256.0f + 0.5f);
+    pixelKernels().blendRgb(dest.data.data(), src.data.data(), pixelCount, weight);
 }
 
 VideoFrame FrameBuffer::scale(const VideoFrame& src, int newWidth, int newHeight) {
@@ -247,64 +409,11 @@ VideoFrame FrameBuffer::flipVertical(const VideoFrame& src) {
 }
 
 void FrameBuffer::rgbaToYuv420(const uint8_t* rgba, uint8_t* yuv, int width, int height) {
-    int ySize = width * height;
-    int uvSize = ySize / 4;
-    
-    uint8_t* yPlane = yuv;
-    uint8_t* uPlane = yuv + ySize;
-    uint8_t* vPlane = yuv + ySize + uvSize;
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int idx = (y * width + x) * 4;
-            uint8_t r = rgba[idx + 0];
-            uint8_t g = rgba[idx + 1];
-            uint8_t b = rgba[idx + 2];
-            
-            // Y
-            yPlane[y * width + x] = static_cast<uint8_t>(
-                ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
-            
-            // U, V (subsampled 2x2)
-            if (y % 2 == 0 && x % 2 == 0) {
-                int uvIdx = (y / 2) * (width / 2) + (x / 2);
-                uPlane[uvIdx] = static_cast<uint8_t>(
-                    ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
-                vPlane[uvIdx] = static_cast<uint8_t>(
-                    ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
-            }
-        }
-    }
+    fromRgba<I420Format>(rgba, width, height, tightLayout<I420Format>(width, height), yuv);
 }
 
 void FrameBuffer::yuv420ToRgba(const uint8_t* yuv, uint8_t* rgba, int width, int height) {
-    int ySize = width * height;
-    int uvSize = ySize / 4;
-    
-    const uint8_t* yPlane = yuv;
-    const uint8_t* uPlane = yuv + ySize;
-    const uint8_t* vPlane = yuv + ySize + uvSize;
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int yIdx = y * width + x;
-            int uvIdx = (y / 2) * (width / 2) + (x / 2);
-            
-            int Y = yPlane[yIdx] - 16;
-            int U = uPlane[uvIdx] - 128;
-            int V = vPlane[uvIdx] - 128;
-            
-            int r = (298 * Y + 409 * V + 128) >> 8;
-            int g = (298 * Y - 100 * U - 208 * V + 128) >> 8;
-            int b = (298 * Y + 516 * U + 128) >> 8;
-            
-            int idx = (y * width + x) * 4;
-            rgba[idx + 0] = static_cast<uint8_t>(std::max(0, std::min(255, r)));
-            rgba[idx + 1] = static_cast<uint8_t>(std::max(0, std::min(255, g)));
-            rgba[idx + 2] = static_cast<uint8_t>(std::max(0, std::min(255, b)));
-            rgba[idx + 3] = 255;
-        }
-    }
+    toRgba<I420Format>(yuv, width, height, tightLayout<I420Format>(width, height), rgba);
 }
 
 }  // namespace videoeditor
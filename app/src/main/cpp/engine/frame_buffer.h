@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "timeline.h"
+#include "dirty_region.h"
 
 namespace videoeditor {
 
@@ -17,6 +18,18 @@ public:
     // Composite source frame onto this buffer
     void composite(VideoFrame& dest, const VideoFrame& src, const TimelineClip& clip);
 
+    // Composite only the part of the source that lands inside region
+    void composite(VideoFrame& dest, const VideoFrame& src, const TimelineClip& clip, const Rect& region);
+
+    // Destination rectangle a source of the given size occupies once fitted
+    static Rect fitRect(int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+
+    // Retained output frame for incremental (dirty-region) compositing
+    VideoFrame& getRetainedFrame() { return m_frame; }
+    DirtyRegion beginFrame(const std::vector<LayerState>& layers);
+    void clearRect(const Rect& rect);
+    void invalidate();
+
     // Apply alpha blending
     void blend(VideoFrame& dest, const VideoFrame& src, float alpha);
 
@@ -44,7 +57,8 @@ public:
 private:
     int m_width;
     int m_height;
-    std::vector<uint8_t> m_buffer;
+    VideoFrame m_frame;
+    DirtyTracker m_dirtyTracker;
     std::mutex m_mutex;
 };
 
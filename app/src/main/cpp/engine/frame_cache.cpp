@@ -0,0 +1,111 @@
+#include "frame_cache.h"
+
+namespace videoeditor {
+
+size_t FrameCache::KeyHash::operator()(const FrameCacheKey& key) const {
+    size_t hash = std::hash<std::string>()(key.mediaPath);
+    hash ^= std::hash<int64_t>()(key.sourcePts) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<uint64_t>()(key.programHash) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+FrameCache::FrameCache(size_t budgetBytes)
+    : m_budgetBytes(budgetBytes)
+    , m_usedBytes(0) {
+    LOGI("FrameCache created (%zu MB)", budgetBytes >> 20);
+}
+
+FrameCache::~FrameCache() {
+    LOGI("FrameCache destroyed");
+}
+
+std::shared_ptr<const VideoFrame> FrameCache::get(const FrameCacheKey& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+    
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->frame;
+}
+
+void FrameCache::put(const FrameCacheKey& key, int clipId, std::shared_ptr<const VideoFrame> frame) {
+    if (!frame) return;
+    
+    size_t size = frame->data.size();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        erase(it->second);
+    }
+    
+    // A frame bigger than the whole budget would only flush everything else
+    if (size > m_budgetBytes) {
+        return;
+    }
+    
+    evictToFit(m_budgetBytes - size);
+    
+    m_entries.push_front({key, clipId, std::move(frame)});
+    m_index[key] = m_entries.begin();
+    m_usedBytes += size;
+}
+
+void FrameCache::invalidateClip(int clipId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    size_t before = m_entries.size();
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        auto next = std::next(it);
+        if (it->clipId == clipId) {
+            erase(it);
+        }
+        it = next;
+    }
+    
+    if (m_entries.size() != before) {
+        LOGD("Dropped %zu cached frames of clip %d", before - m_entries.size(), clipId);
+    }
+}
+
+void FrameCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_index.clear();
+    m_entries.clear();
+    m_usedBytes = 0;
+}
+
+void FrameCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_budgetBytes = budgetBytes;
+    evictToFit(budgetBytes);
+}
+
+size_t FrameCache::getBudget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budgetBytes;
+}
+
+size_t FrameCache::getUsedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_usedBytes;
+}
+
+void FrameCache::evictToFit(size_t budgetBytes) {
+    while (m_usedBytes > budgetBytes && !m_entries.empty()) {
+        erase(std::prev(m_entries.end()));
+    }
+}
+
+void FrameCache::erase(EntryList::iterator it) {
+    m_usedBytes -= it->frame->data.size();
+    m_index.erase(it->key);
+    m_entries.erase(it);
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,71 @@
+#ifndef VIDEO_EDITOR_FRAME_CACHE_H
+#define VIDEO_EDITOR_FRAME_CACHE_H
+
+#include "common.h"
+#include <list>
+#include <unordered_map>
+
+namespace videoeditor {
+
+// Identifies a filtered clip frame: the same source frame through the same
+// filter program always gives the same pixels
+struct FrameCacheKey {
+    std::string mediaPath;
+    int64_t sourcePts;
+    uint64_t programHash;  // FilterManager::getProgramHash, 0 = unfiltered
+
+    bool operator==(const FrameCacheKey& other) const {
+        return sourcePts == other.sourcePts && programHash == other.programHash &&
+               mediaPath == other.mediaPath;
+    }
+};
+
+// LRU cache of decoded + filtered clip frames within a byte budget. Frames are
+// shared, so a caller can keep compositing one after it has been evicted.
+class FrameCache {
+public:
+    explicit FrameCache(size_t budgetBytes);
+    ~FrameCache();
+
+    // Null on a miss
+    std::shared_ptr<const VideoFrame> get(const FrameCacheKey& key);
+
+    // Store a frame produced for clipId, evicting least recently used frames to fit
+    void put(const FrameCacheKey& key, int clipId, std::shared_ptr<const VideoFrame> frame);
+
+    // Drop the clip's frames, e.g. when its filters change and they can't be hit again
+    void invalidateClip(int clipId);
+
+    void clear();
+
+    void setBudget(size_t budgetBytes);
+    size_t getBudget() const;
+    size_t getUsedBytes() const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const FrameCacheKey& key) const;
+    };
+
+    struct Entry {
+        FrameCacheKey key;
+        int clipId;
+        std::shared_ptr<const VideoFrame> frame;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Caller holds m_mutex
+    void evictToFit(size_t budgetBytes);
+    void erase(EntryList::iterator it);
+
+    size_t m_budgetBytes;
+    size_t m_usedBytes;
+    EntryList m_entries;  // Most recently used first
+    std::unordered_map<FrameCacheKey, EntryList::iterator, KeyHash> m_index;
+    mutable std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_FRAME_CACHE_H
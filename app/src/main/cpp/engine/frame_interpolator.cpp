@@ -0,0 +1,245 @@
+#include "frame_interpolator.h"
+#include "../filters/pixel_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+inline float median3x3(float* values) {
+    std::nth_element(values, values + 4, values + 9);
+    return values[4];
+}
+
+}  // namespace
+
+size_t FrameInterpolator::KeyHash::operator()(const FieldKey& key) const {
+    size_t hash = std::hash<std::string>()(key.filePath);
+    hash ^= std::hash<int64_t>()(key.from) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int64_t>()(key.to) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+FrameInterpolator::FrameInterpolator(size_t cacheBytes)
+    : m_pyramidTimes{-1, -1}
+    , m_tileColumns(0)
+    , m_budgetBytes(cacheBytes)
+    , m_usedBytes(0)
+    , m_threadPool(nullptr) {
+    LOGI("FrameInterpolator created (%zu MB of motion fields)", cacheBytes >> 20);
+}
+
+FrameInterpolator::~FrameInterpolator() {
+    LOGI("FrameInterpolator destroyed");
+}
+
+void FrameInterpolator::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+    m_estimator.setThreadPool(pool);
+}
+
+bool FrameInterpolator::interpolate(const std::string& filePath, const VideoFrame& a, const VideoFrame& b, float t,
+                                    VideoFrame& out) {
+    if (a.format != PixelFormat::RGBA || b.format != PixelFormat::RGBA || a.width != b.width ||
+        a.height != b.height || a.width <= 0 || a.height <= 0 ||
+        a.data.size() < a.dataSize() || b.data.size() < b.dataSize()) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    std::shared_ptr<const MotionField> field = motionField(filePath, a, b);
+    if (!field || field->empty()) {
+        return false;
+    }
+    
+    // Vector at each tile centre, bilinear between block centres, split into the
+    // whole-pixel offsets back into a and forward into b
+    const int width = a.width;
+    const int height = a.height;
+    const int tileRows = (height + kTileSize - 1) / kTileSize;
+    m_tileColumns = (width + kTileSize - 1) / kTileSize;
+    m_offsets.resize(static_cast<size_t>(m_tileColumns) * tileRows * 4);
+    
+    const float span = static_cast<float>(field->blockSize * field->factor);  // Frame pixels per block
+    const float lastColumn = static_cast<float>(field->columns - 1);
+    const float lastRow = static_cast<float>(field->rows - 1);
+    int16_t* offsets = m_offsets.data();
+    for (int ty = 0; ty < tileRows; ty++) {
+        float fy = std::max(0.0f, std::min(lastRow, (ty + 0.5f) * kTileSize / span - 0.5f));
+        int y0 = static_cast<int>(fy);
+        int y1 = std::min(y0 + 1, field->rows - 1);
+        float wy = fy - y0;
+        for (int tx = 0; tx < m_tileColumns; tx++, offsets += 4) {
+            float fx = std::max(0.0f, std::min(lastColumn, (tx + 0.5f) * kTileSize / span - 0.5f));
+            int x0 = static_cast<int>(fx);
+            int x1 = std::min(x0 + 1, field->columns - 1);
+            float wx = fx - x0;
+            
+            const MotionVector& v00 = field->at(x0, y0);
+            const MotionVector& v10 = field->at(x1, y0);
+            const MotionVector& v01 = field->at(x0, y1);
+            const MotionVector& v11 = field->at(x1, y1);
+            float vx = ((v00.dx * (1.0f - wx) + v10.dx * wx) * (1.0f - wy) +
+                        (v01.dx * (1.0f - wx) + v11.dx * wx) * wy) * field->factor;
+            float vy = ((v00.dy * (1.0f - wx) + v10.dy * wx) * (1.0f - wy) +
+                        (v01.dy * (1.0f - wx) + v11.dy * wx) * wy) * field->factor;
+            
+            offsets[0] = static_cast<int16_t>(std::lround(-t * vx));
+            offsets[1] = static_cast<int16_t>(std::lround(-t * vy));
+            offsets[2] = static_cast<int16_t>(std::lround((1.0f - t) * vx));
+            offsets[3] = static_cast<int16_t>(std::lround((1.0f - t) * vy));
+        }
+    }
+    
+    out.width = width;
+    out.height = height;
+    out.format = PixelFormat::RGBA;
+    out.data.resize(out.dataSize());
+    
+    int alpha = static_cast<int>(std::lround(std::max(0.0f, std::min(1.0f, t)) * 256.0f));
+    auto body = [&](int rowBegin, int rowEnd) {
+        warpRows(a, b, alpha, out, rowBegin, rowEnd);
+    };
+    if (m_threadPool && height > 2 * kTileSize) {
+        m_threadPool->parallelFor(0, height, kTileSize, body);
+    } else {
+        body(0, height);
+    }
+    return true;
+}
+
+void FrameInterpolator::warpRows(const VideoFrame& a, const VideoFrame& b, int alpha, VideoFrame& out,
+                                 int rowBegin, int rowEnd) {
+    const int width = a.width;
+    const int height = a.height;
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const PixelKernels& kernels = pixelKernels();
+    std::vector<uint8_t> later(stride);
+    
+    // Each tile row is two straight copies; moved tiles that would leave the frame
+    // are slid back inside it
+    for (int y = rowBegin; y < rowEnd; y++) {
+        uint8_t* dst = out.data.data() + y * stride;
+        const int16_t* offsets = m_offsets.data() + static_cast<size_t>(y / kTileSize) * m_tileColumns * 4;
+        for (int tx = 0; tx < m_tileColumns; tx++, offsets += 4) {
+            int x = tx * kTileSize;
+            int count = std::min(kTileSize, width - x);
+            int ax = std::max(0, std::min(width - count, x + offsets[0]));
+            int ay = std::max(0, std::min(height - 1, y + offsets[1]));
+            int bx = std::max(0, std::min(width - count, x + offsets[2]));
+            int by = std::max(0, std::min(height - 1, y + offsets[3]));
+            memcpy(dst + x * 4, a.data.data() + ay * stride + ax * 4, count * 4);
+            memcpy(later.data() + x * 4, b.data.data() + by * stride + bx * 4, count * 4);
+        }
+        kernels.blendRgb(dst, later.data(), width, alpha);
+    }
+}
+
+std::shared_ptr<const MotionField> FrameInterpolator::motionField(const std::string& filePath, const VideoFrame& a,
+                                                                  const VideoFrame& b) {
+    FieldKey key = {filePath, a.timestamp_us, b.timestamp_us};
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->field;
+    }
+    
+    int slotA = findPyramid(filePath, a.timestamp_us);
+    int slotB = findPyramid(filePath, b.timestamp_us);
+    if (slotA < 0) {
+        slotA = slotB == 0 ? 1 : 0;
+        buildPyramid(slotA, filePath, a);
+    }
+    if (slotB < 0) {
+        slotB = 1 - slotA;
+        buildPyramid(slotB, filePath, b);
+    }
+    
+    auto field = std::make_shared<MotionField>();
+    if (m_estimator.estimate(m_pyramids[slotA], m_pyramids[slotB], *field)) {
+        // Matches that are on the whole worse than a one-pixel misalignment (texture
+        // is two of those) mean a cut or motion beyond the search range. The empty
+        // field is cached too, so the pair isn't searched again.
+        uint64_t sad = 0;
+        uint64_t texture = 0;
+        for (const MotionVector& v : field->vectors) {
+            sad += v.sad;
+            texture += v.texture;
+        }
+        if (2 * sad > texture) {
+            field->vectors.clear();
+        } else {
+            medianFilter(*field);
+        }
+    }
+    
+    // Evict least recently used fields to fit
+    size_t size = sizeof(MotionField) + field->vectors.size() * sizeof(MotionVector);
+    while (!m_entries.empty() && m_usedBytes + size > m_budgetBytes) {
+        const Entry& last = m_entries.back();
+        m_usedBytes -= sizeof(MotionField) + last.field->vectors.size() * sizeof(MotionVector);
+        m_index.erase(last.key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front({key, field});
+    m_index[key] = m_entries.begin();
+    m_usedBytes += size;
+    return field;
+}
+
+int FrameInterpolator::findPyramid(const std::string& filePath, int64_t timestamp) const {
+    for (int i = 0; i < 2; i++) {
+        if (m_pyramidTimes[i] == timestamp && m_pyramidPaths[i] == filePath) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void FrameInterpolator::buildPyramid(int slot, const std::string& filePath, const VideoFrame& frame) {
+    m_pyramids[slot].build(frame, kAnalysisWidth, kPyramidLevels, m_threadPool);
+    m_pyramidPaths[slot] = filePath;
+    m_pyramidTimes[slot] = frame.timestamp_us;
+}
+
+void FrameInterpolator::medianFilter(MotionField& field) {
+    std::vector<MotionVector> filtered = field.vectors;
+    float xs[9];
+    float ys[9];
+    for (int by = 0; by < field.rows; by++) {
+        for (int bx = 0; bx < field.columns; bx++) {
+            int n = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                int y = std::max(0, std::min(field.rows - 1, by + dy));
+                for (int dx = -1; dx <= 1; dx++, n++) {
+                    int x = std::max(0, std::min(field.columns - 1, bx + dx));
+                    xs[n] = field.at(x, y).dx;
+                    ys[n] = field.at(x, y).dy;
+                }
+            }
+            MotionVector& v = filtered[static_cast<size_t>(by) * field.columns + bx];
+            v.dx = median3x3(xs);
+            v.dy = median3x3(ys);
+        }
+    }
+    field.vectors = std::move(filtered);
+}
+
+void FrameInterpolator::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_usedBytes = 0;
+    m_pyramidTimes[0] = -1;
+    m_pyramidTimes[1] = -1;
+}
+
+size_t FrameInterpolator::getUsedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_usedBytes;
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,91 @@
+#ifndef VIDEO_EDITOR_FRAME_INTERPOLATOR_H
+#define VIDEO_EDITOR_FRAME_INTERPOLATOR_H
+
+#include "common.h"
+#include "../utils/motion_estimation.h"
+#include <list>
+#include <unordered_map>
+
+namespace videoeditor {
+
+// In-between frames for slowed-down clips. Block motion from the earlier frame
+// to the later one (MotionEstimator on small luma pyramids) is median-filtered
+// and spread over 8x8 output tiles; each tile row is copied from both frames
+// along its vector, scaled by where the output lies between them, and the two
+// rows are blended with the blendRgb kernel. Motion fields are kept in an LRU
+// keyed by file and frame pair, so export reuses what preview already found.
+class FrameInterpolator {
+public:
+    explicit FrameInterpolator(size_t cacheBytes);
+    ~FrameInterpolator();
+
+    // Motion search and the warp are banded across the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Frame t (0-1) of the way from a to b, two RGBA frames of filePath. False when
+    // they can't be matched (size, format, or too different, e.g. across a cut).
+    bool interpolate(const std::string& filePath, const VideoFrame& a, const VideoFrame& b, float t,
+                     VideoFrame& out);
+
+    void clear();
+    size_t getUsedBytes() const;
+
+private:
+    struct FieldKey {
+        std::string filePath;
+        int64_t from;
+        int64_t to;
+
+        bool operator==(const FieldKey& other) const {
+            return from == other.from && to == other.to && filePath == other.filePath;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const FieldKey& key) const;
+    };
+
+    struct Entry {
+        FieldKey key;
+        std::shared_ptr<const MotionField> field;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Cached or newly estimated motion from a to b; an empty field when the pair doesn't match
+    std::shared_ptr<const MotionField> motionField(const std::string& filePath, const VideoFrame& a,
+                                                   const VideoFrame& b);
+
+    // Slot of m_pyramids holding the frame, or -1. The last two are kept since
+    // playback steps through pairs that share a frame.
+    int findPyramid(const std::string& filePath, int64_t timestamp) const;
+    void buildPyramid(int slot, const std::string& filePath, const VideoFrame& frame);
+
+    // Component-wise 3x3 median, so a stray block can't tear the picture
+    static void medianFilter(MotionField& field);
+
+    // Output rows [rowBegin, rowEnd) from the per-tile offsets
+    void warpRows(const VideoFrame& a, const VideoFrame& b, int alpha, VideoFrame& out, int rowBegin, int rowEnd);
+
+    static constexpr int kAnalysisWidth = 480;
+    static constexpr int kPyramidLevels = 3;
+    static constexpr int kTileSize = 8;             // Output pixels sharing one offset
+
+    MotionEstimator m_estimator;
+    LumaPyramid m_pyramids[2];
+    std::string m_pyramidPaths[2];
+    int64_t m_pyramidTimes[2];
+    std::vector<int16_t> m_offsets;     // Per tile: a's x, y then b's x, y
+    int m_tileColumns;
+
+    size_t m_budgetBytes;
+    size_t m_usedBytes;
+    EntryList m_entries;  // Most recently used first
+    std::unordered_map<FieldKey, EntryList::iterator, KeyHash> m_index;
+    ThreadPool* m_threadPool;
+    mutable std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_FRAME_INTERPOLATOR_H
@@ -0,0 +1,144 @@
+#include "glyph_atlas.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+namespace videoeditor {
+
+std::vector<uint32_t> decodeUtf8(const std::string& text) {
+    std::vector<uint32_t> codepoints;
+    codepoints.reserve(text.size());
+    
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(text.data());
+    const uint8_t* end = p + text.size();
+    
+    while (p < end) {
+        uint32_t cp;
+        int extra;
+        if (*p < 0x80) {
+            cp = *p;
+            extra = 0;
+        } else if ((*p & 0xE0) == 0xC0) {
+            cp = *p & 0x1F;
+            extra = 1;
+        } else if ((*p & 0xF0) == 0xE0) {
+            cp = *p & 0x0F;
+            extra = 2;
+        } else if ((*p & 0xF8) == 0xF0) {
+            cp = *p & 0x07;
+            extra = 3;
+        } else {
+            p++;  // Stray continuation byte
+            continue;
+        }
+        
+        if (end - p <= extra) {
+            break;
+        }
+        bool valid = true;
+        for (int i = 1; i <= extra; i++) {
+            if ((p[i] & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        p += valid ? extra + 1 : 1;
+        if (!valid) {
+            continue;
+        }
+        
+        // Low surrogate following a high one: one supplementary character
+        if (cp >= 0xDC00 && cp <= 0xDFFF && !codepoints.empty() &&
+            codepoints.back() >= 0xD800 && codepoints.back() <= 0xDBFF) {
+            codepoints.back() = 0x10000 + ((codepoints.back() - 0xD800) << 10) + (cp - 0xDC00);
+            continue;
+        }
+        codepoints.push_back(cp);
+    }
+    
+    return codepoints;
+}
+
+GlyphAtlas::GlyphAtlas(int size)
+    : m_size(size)
+    , m_pixels(static_cast<size_t>(size) * size, 0)
+    , m_shelfX(0)
+    , m_shelfY(0)
+    , m_shelfHeight(0)
+    , m_revision(0) {
+    LOGI("GlyphAtlas created: %dx%d", size, size);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    LOGI("GlyphAtlas destroyed");
+}
+
+bool GlyphAtlas::addGlyph(int pixelSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                          int stride, int bearingX, int bearingY, int advance) {
+    if (width < 0 || height < 0 || width >= m_size || height >= m_size) {
+        LOGW("Glyph U+%04X at %dpx doesn't fit the atlas (%dx%d)", codepoint, pixelSize, width, height);
+        return false;
+    }
+    if (width == 0 || height == 0 || !coverage) {
+        width = 0;
+        height = 0;
+    }
+    
+    GlyphInfo info = {0, 0, width, height, bearingX, bearingY, advance};
+    
+    if (width > 0) {
+        // One pixel gap so scaled lookups never bleed into a neighbour
+        if (m_shelfX + width + 1 > m_size) {
+            m_shelfX = 0;
+            m_shelfY += m_shelfHeight + 1;
+            m_shelfHeight = 0;
+        }
+        if (m_shelfY + height + 1 > m_size) {
+            LOGI("Glyph atlas full with %zu glyphs, starting over", m_glyphs.size());
+            clear();
+        }
+        
+        info.x = m_shelfX;
+        info.y = m_shelfY;
+        for (int row = 0; row < height; row++) {
+            memcpy(m_pixels.data() + static_cast<size_t>(info.y + row) * m_size + info.x,
+                   coverage + static_cast<size_t>(row) * stride, width);
+        }
+        
+        m_shelfX += width + 1;
+        m_shelfHeight = std::max(m_shelfHeight, height);
+    }
+    
+    m_glyphs[key(pixelSize, codepoint)] = info;
+    m_revision++;
+    return true;
+}
+
+const GlyphInfo* GlyphAtlas::find(int pixelSize, uint32_t codepoint) const {
+    auto it = m_glyphs.find(key(pixelSize, codepoint));
+    return it != m_glyphs.end() ? &it->second : nullptr;
+}
+
+std::vector<uint32_t> GlyphAtlas::missingGlyphs(const std::vector<uint32_t>& codepoints, int pixelSize) const {
+    std::vector<uint32_t> missing;
+    std::unordered_set<uint32_t> seen;
+    
+    for (uint32_t cp : codepoints) {
+        if (!find(pixelSize, cp) && seen.insert(cp).second) {
+            missing.push_back(cp);
+        }
+    }
+    return missing;
+}
+
+void GlyphAtlas::clear() {
+    std::fill(m_pixels.begin(), m_pixels.end(), 0);
+    m_glyphs.clear();
+    m_shelfX = 0;
+    m_shelfY = 0;
+    m_shelfHeight = 0;
+    m_revision++;
+}
+
+}  // namespace videoeditor
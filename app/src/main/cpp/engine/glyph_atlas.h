@@ -0,0 +1,72 @@
+#ifndef VIDEO_EDITOR_GLYPH_ATLAS_H
+#define VIDEO_EDITOR_GLYPH_ATLAS_H
+
+#include "common.h"
+#include <unordered_map>
+
+namespace videoeditor {
+
+// Placement of one glyph in the atlas plus its metrics, in pixels
+struct GlyphInfo {
+    int x;          // Coverage rectangle in the atlas
+    int y;
+    int width;      // 0 for blank glyphs such as spaces
+    int height;
+    int bearingX;   // Left edge relative to the pen position
+    int bearingY;   // Top edge above the baseline
+    int advance;    // Pen movement to the next glyph
+};
+
+// Codepoints of UTF-8 text; surrogate pairs (as JNI's modified UTF-8 encodes
+// supplementary characters) are combined, invalid bytes are skipped
+std::vector<uint32_t> decodeUtf8(const std::string& text);
+
+// 8-bit coverage atlas of glyphs rasterised by the platform (Paint on the Kotlin
+// side) and uploaded once per codepoint and pixel size. Shelf packed; when full
+// it starts over and bumps its revision so layers missing glyphs ask again.
+// Not thread-safe; TextOverlayManager serialises access.
+class GlyphAtlas {
+public:
+    explicit GlyphAtlas(int size = kDefaultSize);
+    ~GlyphAtlas();
+
+    // Copy a glyph's coverage in; false if it is larger than the whole atlas
+    bool addGlyph(int pixelSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                  int stride, int bearingX, int bearingY, int advance);
+
+    // Null if the glyph hasn't been uploaded
+    const GlyphInfo* find(int pixelSize, uint32_t codepoint) const;
+
+    // Codepoints of the text that still have to be uploaded at this size, each once
+    std::vector<uint32_t> missingGlyphs(const std::vector<uint32_t>& codepoints, int pixelSize) const;
+
+    void clear();
+
+    const uint8_t* pixels() const { return m_pixels.data(); }
+    int stride() const { return m_size; }
+
+    // Changes whenever glyphs are added or dropped
+    uint32_t getRevision() const { return m_revision; }
+
+private:
+    static constexpr int kDefaultSize = 1024;
+
+    static uint64_t key(int pixelSize, uint32_t codepoint) {
+        return (static_cast<uint64_t>(pixelSize) << 32) | codepoint;
+    }
+
+    int m_size;
+    std::vector<uint8_t> m_pixels;
+    std::unordered_map<uint64_t, GlyphInfo> m_glyphs;
+
+    // Current shelf: glyphs are placed left to right, the next shelf starts below the tallest
+    int m_shelfX;
+    int m_shelfY;
+    int m_shelfHeight;
+
+    uint32_t m_revision;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_GLYPH_ATLAS_H
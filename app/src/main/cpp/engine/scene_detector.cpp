@@ -0,0 +1,246 @@
+#include "scene_detector.h"
+#include "../filters/pixel_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videoeditor {
+
+namespace {
+
+// First frame at or after time; a keyframe time needs no frames before it
+VideoFrame decodeAt(VideoDecoder& decoder, const std::string& filePath, int64_t time) {
+    decoder.seekTo(filePath, time);
+    VideoFrame frame;
+    do {
+        frame = decoder.decodeNextFrame(filePath);
+    } while (!frame.data.empty() && frame.timestamp_us < time);
+    return frame;
+}
+
+}  // namespace
+
+SceneDetector::SceneDetector()
+    : m_threadPool(nullptr) {
+    LOGI("SceneDetector created");
+}
+
+SceneDetector::~SceneDetector() {
+    LOGI("SceneDetector destroyed");
+}
+
+void SceneDetector::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+}
+
+std::vector<int64_t> SceneDetector::detect(const std::string& filePath, int64_t start, int64_t end) {
+    std::vector<int64_t> cuts;
+    if (end <= start) {
+        return cuts;
+    }
+    
+    std::vector<int64_t> keyframes;
+    {
+        VideoDecoder index;
+        if (!index.initialize() || !index.openFile(filePath)) {
+            return cuts;
+        }
+        keyframes = index.getKeyframeTimes(filePath, start, end);
+    }
+    
+    // The clip may start inside a GOP; its first frame stands in for that keyframe
+    if (keyframes.empty() || keyframes.front() > start) {
+        keyframes.insert(keyframes.begin(), start);
+    }
+    
+    // Contiguous GOP ranges; each also reads the first keyframe of the next one so
+    // the GOP spanning the boundary is compared too
+    size_t count = keyframes.size();
+    int ranges = m_threadPool ? static_cast<int>(m_threadPool->size()) + 1 : 1;
+    ranges = static_cast<int>(std::min<size_t>({static_cast<size_t>(ranges), static_cast<size_t>(kMaxDecoders),
+                                                std::max<size_t>(1, count - 1)}));
+    std::vector<std::vector<int64_t>> rangeCuts(ranges);
+    
+    auto body = [&](int rangeBegin, int rangeEnd) {
+        for (int range = rangeBegin; range < rangeEnd; range++) {
+            size_t first = (count - 1) * range / ranges;
+            size_t last = range + 1 < ranges ? (count - 1) * (range + 1) / ranges : count - 1;
+            scanRange(filePath, keyframes.data() + first, last - first + 1, end, range + 1 == ranges,
+                      rangeCuts[range]);
+        }
+    };
+    if (m_threadPool && ranges > 1) {
+        m_threadPool->parallelFor(0, ranges, 1, body);
+    } else {
+        body(0, ranges);
+    }
+    
+    // Ranges are in order; drop cuts too close to the start or the previous cut
+    int64_t previous = start;
+    for (const auto& found : rangeCuts) {
+        for (int64_t cut : found) {
+            if (cut - previous >= kMinShotUs && end - cut >= kMinShotUs) {
+                cuts.push_back(cut);
+                previous = cut;
+            }
+        }
+    }
+    
+    LOGI("Scene detection: %zu cuts from %zu keyframes in %d ranges", cuts.size(), count, ranges);
+    return cuts;
+}
+
+void SceneDetector::scanRange(const std::string& filePath, const int64_t* keyframes, size_t count, int64_t end,
+                              bool last, std::vector<int64_t>& cuts) {
+    VideoDecoder decoder;
+    if (!decoder.initialize() || !decoder.openFile(filePath)) {
+        return;
+    }
+    
+    Signature previous;
+    Signature current;
+    VideoFrame frame = decodeAt(decoder, filePath, keyframes[0]);
+    if (frame.data.empty()) {
+        return;
+    }
+    computeSignature(frame, previous);
+    
+    for (size_t i = 1; i < count; i++) {
+        frame = decodeAt(decoder, filePath, keyframes[i]);
+        if (frame.data.empty()) {
+            return;
+        }
+        computeSignature(frame, current);
+        
+        // Only GOPs whose ends look different are decoded in full
+        if (difference(previous, current) > kCandidateThreshold) {
+            int64_t cut = locateCut(decoder, filePath, keyframes[i - 1], keyframes[i], &current);
+            if (cut >= 0) {
+                cuts.push_back(cut);
+            }
+        }
+        std::swap(previous, current);
+    }
+    
+    // Nothing follows the last GOP to compare it against
+    if (last) {
+        int64_t cut = locateCut(decoder, filePath, keyframes[count - 1], end, nullptr);
+        if (cut >= 0) {
+            cuts.push_back(cut);
+        }
+    }
+}
+
+int64_t SceneDetector::locateCut(VideoDecoder& decoder, const std::string& filePath, int64_t from, int64_t to,
+                                 const Signature* next) {
+    VideoFrame frame = decodeAt(decoder, filePath, from);
+    if (frame.data.empty()) {
+        return -1;
+    }
+    
+    Signature previous;
+    Signature current;
+    computeSignature(frame, previous);
+    
+    float best = 0.0f;
+    int64_t bestTime = -1;
+    while (true) {
+        frame = decoder.decodeNextFrame(filePath);
+        if (frame.data.empty() || frame.timestamp_us >= to) {
+            break;
+        }
+        computeSignature(frame, current);
+        float change = difference(previous, current);
+        if (change > best) {
+            best = change;
+            bestTime = frame.timestamp_us;
+        }
+        std::swap(previous, current);
+    }
+    
+    if (next) {
+        float change = difference(previous, *next);
+        if (change > best) {
+            best = change;
+            bestTime = to;
+        }
+    }
+    return best > kCutThreshold ? bestTime : -1;
+}
+
+void SceneDetector::computeSignature(const VideoFrame& frame, Signature& out) {
+    const int width = frame.width;
+    const int height = frame.height;
+    const PixelKernels& kernels = pixelKernels();
+    
+    static thread_local std::vector<uint8_t> lumaRow;
+    static thread_local std::vector<uint16_t> columnSums;
+    lumaRow.resize(width);
+    columnSums.resize(width);
+    
+    // Box-averaged thumbnail from a few rows per cell, each converted with extractLuma
+    uint8_t thumb[kThumbPixels];
+    for (int ty = 0; ty < kThumbHeight; ty++) {
+        int y0 = ty * height / kThumbHeight;
+        int y1 = std::max(y0 + 1, (ty + 1) * height / kThumbHeight);
+        int rows = std::min(kSampleRows, y1 - y0);
+        
+        std::fill(columnSums.begin(), columnSums.end(), 0);
+        for (int k = 0; k < rows; k++) {
+            int y = y0 + k * (y1 - y0) / rows;
+            kernels.extractLuma(frame.data.data() + static_cast<size_t>(y) * width * 4, lumaRow.data(), width);
+            uint16_t* sums = columnSums.data();
+            const uint8_t* luma = lumaRow.data();
+            for (int x = 0; x < width; x++) {
+                sums[x] += luma[x];
+            }
+        }
+        
+        for (int tx = 0; tx < kThumbWidth; tx++) {
+            int x0 = tx * width / kThumbWidth;
+            int x1 = std::max(x0 + 1, (tx + 1) * width / kThumbWidth);
+            uint32_t sum = 0;
+            for (int x = x0; x < x1; x++) {
+                sum += columnSums[x];
+            }
+            thumb[ty * kThumbWidth + tx] = static_cast<uint8_t>(sum / ((x1 - x0) * rows));
+        }
+    }
+    
+    out.histogram.fill(0);
+    out.edgeCount = 0;
+    for (int y = 0; y < kThumbHeight; y++) {
+        for (int x = 0; x < kThumbWidth; x++) {
+            const uint8_t* p = thumb + y * kThumbWidth + x;
+            int dx = x + 1 < kThumbWidth ? std::abs(p[1] - p[0]) : 0;
+            int dy = y + 1 < kThumbHeight ? std::abs(p[kThumbWidth] - p[0]) : 0;
+            bool edge = dx + dy > kEdgeThreshold;
+            out.edges[y * kThumbWidth + x] = edge ? 255 : 0;
+            out.edgeCount += edge;
+            out.histogram[p[0] * kHistogramBins / 256]++;
+        }
+    }
+}
+
+float SceneDetector::difference(const Signature& a, const Signature& b) {
+    int histogram = 0;
+    for (int i = 0; i < kHistogramBins; i++) {
+        histogram += std::abs(a.histogram[i] - b.histogram[i]);
+    }
+    float histogramChange = histogram / (2.0f * kThumbPixels);
+    
+    // Flat frames (fades, black, sky) have too few edges to say anything, and a
+    // zero edge change would hide a cut between them; the histogram decides alone
+    int edges = a.edgeCount + b.edgeCount;
+    if (edges < kMinEdgePixels) {
+        return histogramChange;
+    }
+    
+    // Edge pixels that appeared or vanished, against all edge pixels of both
+    uint32_t changed = pixelKernels().sumAbsDiff(a.edges.data(), kThumbWidth, b.edges.data(), kThumbWidth,
+                                                 kThumbWidth, kThumbHeight) / 255;
+    float edgeChange = static_cast<float>(changed) / edges;
+    
+    return std::sqrt(histogramChange * edgeChange);
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,70 @@
+#ifndef VIDEO_EDITOR_SCENE_DETECTOR_H
+#define VIDEO_EDITOR_SCENE_DETECTOR_H
+
+#include "common.h"
+#include "video_decoder.h"
+#include "../utils/thread_pool.h"
+#include <array>
+
+namespace videoeditor {
+
+// Shot-change detection over a file. Keyframes are decoded first and compared
+// by a small luma thumbnail's histogram and edge map; only GOPs whose ends
+// differ are then decoded frame by frame to find the cut. The keyframes are
+// split into contiguous GOP ranges that run in parallel, each on its own decoder.
+class SceneDetector {
+public:
+    static constexpr int kThumbWidth = 64;
+    static constexpr int kThumbHeight = 36;
+    static constexpr int kThumbPixels = kThumbWidth * kThumbHeight;
+    static constexpr int kHistogramBins = 32;
+
+    // Downscaled view of one frame
+    struct Signature {
+        std::array<uint8_t, kThumbPixels> edges;        // 255 where the thumbnail's gradient is strong
+        std::array<uint16_t, kHistogramBins> histogram;
+        int edgeCount;
+    };
+
+    SceneDetector();
+    ~SceneDetector();
+
+    // Ranges run on the pool; null runs them one after another on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Source times (microseconds, ascending) in (start, end) where a new shot begins
+    std::vector<int64_t> detect(const std::string& filePath, int64_t start, int64_t end);
+
+    // Signature of an RGBA frame
+    static void computeSignature(const VideoFrame& frame, Signature& out);
+
+    // 0 for the same picture, towards 1 for unrelated ones: the geometric mean of the
+    // histogram and edge-map changes, so camera motion (edges only) and flashes
+    // (histogram only) stay low while a cut moves both
+    static float difference(const Signature& a, const Signature& b);
+
+private:
+    // Cuts between keyframes[0] and keyframes[count - 1], and after the last one
+    // up to end when it is the final range, using a decoder of its own
+    void scanRange(const std::string& filePath, const int64_t* keyframes, size_t count, int64_t end,
+                   bool last, std::vector<int64_t>& cuts);
+
+    // Frame by frame from the keyframe at from up to to, whose signature is next
+    // (null at the end of the clip); the time of the biggest jump if it is a cut, else -1
+    int64_t locateCut(VideoDecoder& decoder, const std::string& filePath, int64_t from, int64_t to,
+                      const Signature* next);
+
+    static constexpr float kCandidateThreshold = 0.2f;   // Between keyframes, which lie far apart
+    static constexpr float kCutThreshold = 0.35f;        // Between neighbouring frames
+    static constexpr int kEdgeThreshold = 24;            // |dx| + |dy| on the thumbnail
+    static constexpr int kMinEdgePixels = kThumbPixels / 100;  // Fewer in both frames: edges aren't scored
+    static constexpr int kSampleRows = 4;                // Source rows averaged per thumbnail row
+    static constexpr int64_t kMinShotUs = 500000;        // Closer cuts are merged
+    static constexpr int kMaxDecoders = 4;               // Hardware decoder instances are scarce
+
+    ThreadPool* m_threadPool;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_SCENE_DETECTOR_H
@@ -0,0 +1,199 @@
+#include "sprite.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+// x / 255, rounded, for x in 0-65535
+inline int div255(int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Premultiplied source over dest, source scaled by alpha (0-256)
+inline void blendPixel(uint8_t* out, const uint8_t* in, int alpha) {
+    int a = (in[3] * alpha) >> 8;
+    if (a == 0) {
+        return;
+    }
+    int inv = 255 - a;
+    out[0] = static_cast<uint8_t>(((in[0] * alpha) >> 8) + div255(out[0] * inv));
+    out[1] = static_cast<uint8_t>(((in[1] * alpha) >> 8) + div255(out[1] * inv));
+    out[2] = static_cast<uint8_t>(((in[2] * alpha) >> 8) + div255(out[2] * inv));
+    out[3] = static_cast<uint8_t>(a + div255(out[3] * inv));
+}
+
+// Texel of a premultiplied sprite, transparent outside it
+inline const uint8_t* texel(const Sprite& sprite, int x, int y) {
+    static const uint8_t kTransparent[4] = {0, 0, 0, 0};
+    if (x < 0 || y < 0 || x >= sprite.width || y >= sprite.height) {
+        return kTransparent;
+    }
+    return sprite.pixels.data() + (static_cast<size_t>(y) * sprite.width + x) * 4;
+}
+
+// Half extents of the rotated, scaled sprite's bounding box
+inline void rotatedExtents(const Sprite& sprite, float scale, float degrees, float& extentX, float& extentY) {
+    float radians = degrees * static_cast<float>(M_PI) / 180.0f;
+    float c = std::fabs(std::cos(radians));
+    float s = std::fabs(std::sin(radians));
+    float halfWidth = sprite.width * scale * 0.5f;
+    float halfHeight = sprite.height * scale * 0.5f;
+    extentX = c * halfWidth + s * halfHeight;
+    extentY = s * halfWidth + c * halfHeight;
+}
+
+// Bilinear affine blit into a raw RGBA buffer. Output pixel centres are mapped
+// back into the sprite with the inverse rotation and scale; each pixel is mapped
+// from its own offset rather than accumulated along the row, so drawing a region
+// gives exactly the pixels of a full draw.
+void blitTransformed(uint8_t* dst, int dstWidth, const Sprite& sprite, float cx, float cy, float scale,
+                     float degrees, int alpha, const Rect& area) {
+    float radians = degrees * static_cast<float>(M_PI) / 180.0f;
+    float cosA = std::cos(radians) / scale;
+    float sinA = std::sin(radians) / scale;
+    float centreU = sprite.width * 0.5f - 0.5f;   // Texel centres sit at i + 0.5
+    float centreV = sprite.height * 0.5f - 0.5f;
+    
+    for (int y = area.y; y < area.bottom(); y++) {
+        float dy = y + 0.5f - cy;
+        float rowU = centreU + sinA * dy;
+        float rowV = centreV + cosA * dy;
+        uint8_t* out = dst + (static_cast<size_t>(y) * dstWidth + area.x) * 4;
+        
+        for (int x = area.x; x < area.right(); x++, out += 4) {
+            float dx = x + 0.5f - cx;
+            float u = rowU + cosA * dx;
+            float v = rowV - sinA * dx;
+            if (u <= -1.0f || v <= -1.0f || u >= sprite.width || v >= sprite.height) {
+                continue;
+            }
+            int x0 = static_cast<int>(std::floor(u));
+            int y0 = static_cast<int>(std::floor(v));
+            int fx = static_cast<int>((u - x0) * 256.0f);
+            int fy = static_cast<int>((v - y0) * 256.0f);
+            const uint8_t* p00 = texel(sprite, x0, y0);
+            const uint8_t* p10 = texel(sprite, x0 + 1, y0);
+            const uint8_t* p01 = texel(sprite, x0, y0 + 1);
+            const uint8_t* p11 = texel(sprite, x0 + 1, y0 + 1);
+            if ((p00[3] | p10[3] | p01[3] | p11[3]) == 0) {
+                continue;
+            }
+            
+            int w00 = (256 - fx) * (256 - fy);
+            int w10 = fx * (256 - fy);
+            int w01 = (256 - fx) * fy;
+            int w11 = fx * fy;
+            uint8_t sample[4];
+            for (int c = 0; c < 4; c++) {
+                sample[c] = static_cast<uint8_t>((p00[c] * w00 + p10[c] * w10 + p01[c] * w01 + p11[c] * w11 + 32768) >> 16);
+            }
+            blendPixel(out, sample, alpha);
+        }
+    }
+}
+
+}  // namespace
+
+void Sprite::allocate(int newWidth, int newHeight) {
+    width = std::max(0, newWidth);
+    height = std::max(0, newHeight);
+    pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+}
+
+Rect spriteBounds(const Rect& source, float x, float y, float scale) {
+    if (source.isEmpty() || scale <= 0.0f) {
+        return {0, 0, 0, 0};
+    }
+    return {static_cast<int>(std::lround(x)), static_cast<int>(std::lround(y)),
+            static_cast<int>(std::lround(source.width * scale)), static_cast<int>(std::lround(source.height * scale))};
+}
+
+void drawSprite(VideoFrame& dest, const Sprite& sprite, const Rect& source, float x, float y, float scale,
+                int alpha, const Rect& clip) {
+    Rect src = source.intersect({0, 0, sprite.width, sprite.height});
+    Rect bounds = spriteBounds(src, x, y, scale);
+    Rect area = bounds.intersect(clip).intersect({0, 0, dest.width, dest.height});
+    if (area.isEmpty() || alpha <= 0 || dest.data.size() < dest.dataSize()) {
+        return;
+    }
+    alpha = std::min(alpha, 256);
+    
+    size_t spriteStride = static_cast<size_t>(sprite.width) * 4;
+    bool unscaled = bounds.width == src.width && bounds.height == src.height;
+    
+    for (int dy = area.y; dy < area.bottom(); dy++) {
+        int sy = unscaled ? src.y + (dy - bounds.y) :
+            src.y + static_cast<int>(static_cast<int64_t>(dy - bounds.y) * src.height / bounds.height);
+        const uint8_t* srcRow = sprite.pixels.data() + sy * spriteStride;
+        uint8_t* dstRow = dest.data.data() + (static_cast<size_t>(dy) * dest.width) * 4;
+        
+        if (unscaled) {
+            const uint8_t* in = srcRow + (src.x + area.x - bounds.x) * 4;
+            uint8_t* out = dstRow + area.x * 4;
+            for (int i = 0; i < area.width; i++, in += 4, out += 4) {
+                // Most of a text sprite is empty space; opaque pixels at full alpha are a copy
+                if (in[3] == 255 && alpha == 256) {
+                    memcpy(out, in, 4);
+                } else if (in[3] != 0) {
+                    blendPixel(out, in, alpha);
+                }
+            }
+            continue;
+        }
+        
+        for (int dx = area.x; dx < area.right(); dx++) {
+            int sx = src.x + static_cast<int>(static_cast<int64_t>(dx - bounds.x) * src.width / bounds.width);
+            const uint8_t* in = srcRow + sx * 4;
+            if (in[3] != 0) {
+                blendPixel(dstRow + dx * 4, in, alpha);
+            }
+        }
+    }
+}
+
+Rect spriteBounds(const Sprite& sprite, float cx, float cy, float scale, float degrees) {
+    if (sprite.empty() || scale <= 0.0f) {
+        return {0, 0, 0, 0};
+    }
+    float extentX;
+    float extentY;
+    rotatedExtents(sprite, scale, degrees, extentX, extentY);
+    
+    // One extra pixel each side for the bilinear fringe
+    int left = static_cast<int>(std::floor(cx - extentX)) - 1;
+    int top = static_cast<int>(std::floor(cy - extentY)) - 1;
+    int right = static_cast<int>(std::ceil(cx + extentX)) + 1;
+    int bottom = static_cast<int>(std::ceil(cy + extentY)) + 1;
+    return {left, top, right - left, bottom - top};
+}
+
+void drawSpriteTransformed(VideoFrame& dest, const Sprite& sprite, float cx, float cy, float scale,
+                           float degrees, int alpha, const Rect& clip) {
+    Rect area = spriteBounds(sprite, cx, cy, scale, degrees).intersect(clip).intersect({0, 0, dest.width, dest.height});
+    if (area.isEmpty() || alpha <= 0 || dest.data.size() < dest.dataSize()) {
+        return;
+    }
+    blitTransformed(dest.data.data(), dest.width, sprite, cx, cy, scale, degrees, std::min(alpha, 256), area);
+}
+
+Sprite transformSprite(const Sprite& sprite, float scale, float degrees) {
+    Sprite out;
+    if (sprite.empty() || scale <= 0.0f) {
+        return out;
+    }
+    float extentX;
+    float extentY;
+    rotatedExtents(sprite, scale, degrees, extentX, extentY);
+    
+    // Even size puts the centre on a pixel corner; the extra pixel each side holds the bilinear fringe
+    out.allocate(static_cast<int>(std::ceil(extentX)) * 2 + 2, static_cast<int>(std::ceil(extentY)) * 2 + 2);
+    blitTransformed(out.pixels.data(), out.width, sprite, out.width * 0.5f, out.height * 0.5f, scale, degrees,
+                    256, {0, 0, out.width, out.height});
+    return out;
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,48 @@
+#ifndef VIDEO_EDITOR_SPRITE_H
+#define VIDEO_EDITOR_SPRITE_H
+
+#include "common.h"
+#include "dirty_region.h"
+
+namespace videoeditor {
+
+// Pre-rendered overlay image (text, stickers) in premultiplied RGBA, so
+// drawing it is one multiply-add per channel and transparent pixels are skipped
+struct Sprite {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;  // width * 4 bytes per row
+
+    bool empty() const { return width <= 0 || height <= 0; }
+
+    // Resize and clear to transparent
+    void allocate(int newWidth, int newHeight);
+};
+
+// Output rectangle of the source part of a sprite drawn with its top-left at
+// (x, y) and scaled by scale
+Rect spriteBounds(const Rect& source, float x, float y, float scale);
+
+// Blend the source part of the sprite over dest at spriteBounds(), faded by
+// alpha (0-256), touching only pixels inside clip. Unscaled sprites are copied
+// row by row; scaled ones are sampled nearest-neighbour.
+void drawSprite(VideoFrame& dest, const Sprite& sprite, const Rect& source, float x, float y, float scale,
+                int alpha, const Rect& clip);
+
+// Output rectangle covered by the sprite centred at (cx, cy), scaled and then
+// rotated about its centre (degrees, clockwise like Canvas.rotate)
+Rect spriteBounds(const Sprite& sprite, float cx, float cy, float scale, float degrees);
+
+// Affine blit: the sprite placed as above, sampled bilinearly with transparent
+// edges, faded by alpha (0-256) and blended only inside clip. Costs a sample per
+// covered pixel, so it is meant for transforms that change every frame.
+void drawSpriteTransformed(VideoFrame& dest, const Sprite& sprite, float cx, float cy, float scale,
+                           float degrees, int alpha, const Rect& clip);
+
+// Sprite resampled at a fixed scale and rotation, with the source centre at the
+// centre of the result; drawn unscaled afterwards it costs a plain blit
+Sprite transformSprite(const Sprite& sprite, float scale, float degrees);
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_SPRITE_H
@@ -0,0 +1,392 @@
+#include "sticker_overlay.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace videoeditor {
+
+namespace {
+
+// Matches the StickerManager.kt defaults and limits
+constexpr int64_t kDefaultAnimationDuration = 500000;  // 500 ms
+constexpr float kMinScale = 0.1f;
+constexpr float kMaxScale = 5.0f;
+constexpr float kBounceHeight = 30.0f;
+constexpr float kShakeWidth = 10.0f;
+constexpr float kBackOvershoot = 1.70158f;
+
+inline bool visibleAt(const StickerLayer& layer, int64_t position) {
+    return position >= layer.startTime && position - layer.startTime < layer.duration;
+}
+
+inline float easeOutBack(float t) {
+    float c3 = kBackOvershoot + 1.0f;
+    float u = t - 1.0f;
+    return 1.0f + c3 * u * u * u + kBackOvershoot * u * u;
+}
+
+inline float easeInBack(float t) {
+    float c3 = kBackOvershoot + 1.0f;
+    return c3 * t * t * t - kBackOvershoot * t * t;
+}
+
+inline size_t spriteBytes(const Sprite& sprite) {
+    return static_cast<size_t>(sprite.width) * sprite.height * 4;
+}
+
+}  // namespace
+
+StickerOverlayManager::StickerOverlayManager()
+    : m_cacheBytes(0)
+    , m_useCounter(0)
+    , m_nextStickerId(1)
+    , m_nextImageId(1) {
+    LOGI("StickerOverlayManager created");
+}
+
+StickerOverlayManager::~StickerOverlayManager() {
+    LOGI("StickerOverlayManager destroyed");
+}
+
+int StickerOverlayManager::addImage(const uint8_t* pixels, int width, int height, int stride, bool premultiplied) {
+    if (!pixels || width <= 0 || height <= 0 || stride < width * 4) {
+        return -1;
+    }
+    
+    // Premultiply once here so every later draw and resample is a plain weighted sum
+    auto sprite = std::make_shared<Sprite>();
+    sprite->allocate(width, height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* in = pixels + static_cast<size_t>(y) * stride;
+        uint8_t* out = sprite->pixels.data() + static_cast<size_t>(y) * width * 4;
+        if (premultiplied) {
+            memcpy(out, in, static_cast<size_t>(width) * 4);
+            continue;
+        }
+        for (int x = 0; x < width; x++, in += 4, out += 4) {
+            int a = in[3];
+            out[0] = static_cast<uint8_t>((in[0] * a + 127) / 255);
+            out[1] = static_cast<uint8_t>((in[1] * a + 127) / 255);
+            out[2] = static_cast<uint8_t>((in[2] * a + 127) / 255);
+            out[3] = static_cast<uint8_t>(a);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int imageId = m_nextImageId++;
+    m_images[imageId] = std::move(sprite);
+    
+    LOGI("Added sticker image %d: %dx%d", imageId, width, height);
+    return imageId;
+}
+
+bool StickerOverlayManager::removeImage(int imageId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_images.erase(imageId) == 0) {
+        return false;
+    }
+    
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (std::get<0>(it->first) == imageId) {
+            m_cacheBytes -= spriteBytes(*it->second.sprite);
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    LOGI("Removed sticker image %d", imageId);
+    return true;
+}
+
+int StickerOverlayManager::addSticker(int imageId, float x, float y, int64_t startTime, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_images.find(imageId) == m_images.end()) {
+        LOGE("Sticker image %d not found", imageId);
+        return -1;
+    }
+    
+    StickerLayer layer;
+    layer.id = m_nextStickerId++;
+    layer.imageId = imageId;
+    layer.x = x;
+    layer.y = y;
+    layer.scale = 1.0f;
+    layer.rotation = 0.0f;
+    layer.alpha = 1.0f;
+    layer.startTime = startTime;
+    layer.duration = duration > 0 ? duration : std::numeric_limits<int64_t>::max() - startTime;
+    layer.animation = StickerAnimation::None;
+    layer.animationDuration = kDefaultAnimationDuration;
+    layer.revision = 0;
+    
+    m_layers[layer.id] = layer;
+    
+    LOGI("Added sticker %d with image %d", layer.id, imageId);
+    return layer.id;
+}
+
+bool StickerOverlayManager::removeSticker(int stickerId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_layers.erase(stickerId) == 0) {
+        return false;
+    }
+    
+    LOGI("Removed sticker %d", stickerId);
+    return true;
+}
+
+bool StickerOverlayManager::setTransform(int stickerId, float x, float y, float scale, float rotation, float alpha) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_layers.find(stickerId);
+    if (it == m_layers.end()) {
+        return false;
+    }
+    
+    StickerLayer& layer = it->second;
+    layer.x = x;
+    layer.y = y;
+    layer.scale = std::max(kMinScale, std::min(scale, kMaxScale));
+    layer.rotation = rotation;
+    layer.alpha = std::max(0.0f, std::min(alpha, 1.0f));
+    layer.revision++;
+    return true;
+}
+
+bool StickerOverlayManager::setTimeRange(int stickerId, int64_t startTime, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_layers.find(stickerId);
+    if (it == m_layers.end()) {
+        return false;
+    }
+    
+    it->second.startTime = startTime;
+    it->second.duration = duration > 0 ? duration : std::numeric_limits<int64_t>::max() - startTime;
+    it->second.revision++;
+    return true;
+}
+
+bool StickerOverlayManager::setAnimation(int stickerId, StickerAnimation animation, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_layers.find(stickerId);
+    if (it == m_layers.end()) {
+        return false;
+    }
+    
+    it->second.animation = animation;
+    it->second.animationDuration = duration > 0 ? duration : kDefaultAnimationDuration;
+    it->second.revision++;
+    return true;
+}
+
+void StickerOverlayManager::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layers.clear();
+    m_images.clear();
+    m_cache.clear();
+    m_cacheBytes = 0;
+    m_nextStickerId = 1;
+    m_nextImageId = 1;
+}
+
+bool StickerOverlayManager::toStickerAnimation(const std::string& name, StickerAnimation& out) {
+    static const std::pair<const char*, StickerAnimation> kNames[] = {
+        {"none", StickerAnimation::None},
+        {"fade_in", StickerAnimation::FadeIn},
+        {"fade_out", StickerAnimation::FadeOut},
+        {"pop_in", StickerAnimation::PopIn},
+        {"pop_out", StickerAnimation::PopOut},
+        {"bounce", StickerAnimation::Bounce},
+        {"spin", StickerAnimation::Spin},
+        {"shake", StickerAnimation::Shake},
+        {"pulse", StickerAnimation::Pulse}
+    };
+    
+    for (const auto& entry : kNames) {
+        if (name == entry.first) {
+            out = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void StickerOverlayManager::collectLayers(int64_t position, int width, int height, std::vector<LayerState>& layers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (const auto& pair : m_layers) {
+        const StickerLayer& layer = pair.second;
+        Placement placement;
+        if (!visibleAt(layer, position) || !place(layer, position, width, height, placement)) {
+            continue;
+        }
+        
+        std::shared_ptr<const Sprite> sprite;
+        LayerState state;
+        state.layerId = kLayerIdBase - layer.id;
+        state.bounds = resolve(layer, placement, sprite);
+        state.contentKey = layer.imageId;
+        state.revision = static_cast<uint64_t>(layer.revision);
+        state.animated = placement.animating;
+        layers.push_back(state);
+    }
+}
+
+void StickerOverlayManager::composite(VideoFrame& dest, const Rect& region, int64_t position) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (const auto& pair : m_layers) {
+        const StickerLayer& layer = pair.second;
+        Placement placement;
+        if (!visibleAt(layer, position) || !place(layer, position, dest.width, dest.height, placement)) {
+            continue;
+        }
+        
+        std::shared_ptr<const Sprite> sprite;
+        Rect bounds = resolve(layer, placement, sprite);
+        if (!sprite || !bounds.intersects(region)) {
+            continue;
+        }
+        
+        if (placement.affine) {
+            drawSpriteTransformed(dest, *sprite, placement.cx, placement.cy, placement.scale, placement.rotation,
+                                  placement.alpha, region);
+        } else {
+            drawSprite(dest, *sprite, {0, 0, sprite->width, sprite->height}, static_cast<float>(bounds.x),
+                       static_cast<float>(bounds.y), 1.0f, placement.alpha, region);
+        }
+    }
+}
+
+bool StickerOverlayManager::place(const StickerLayer& layer, int64_t position, int width, int height,
+                                  Placement& out) const {
+    if (m_images.find(layer.imageId) == m_images.end()) {
+        return false;
+    }
+    
+    // Same curves as StickerManager.renderFrame
+    float animDuration = static_cast<float>(std::max<int64_t>(1, layer.animationDuration));
+    float inProgress = std::max(0.0f, std::min(1.0f, (position - layer.startTime) / animDuration));
+    float outProgress = std::max(0.0f, 1.0f - (layer.startTime + layer.duration - position) / animDuration);
+    float alpha = layer.alpha;
+    float scale = layer.scale;
+    float rotation = layer.rotation;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+    
+    out.animating = inProgress < 1.0f;
+    out.affine = false;
+    
+    switch (layer.animation) {
+        case StickerAnimation::None:
+            out.animating = false;
+            break;
+        case StickerAnimation::FadeIn:
+            alpha *= inProgress;
+            break;
+        case StickerAnimation::FadeOut:
+            alpha *= 1.0f - outProgress;
+            out.animating = outProgress > 0.0f;
+            break;
+        case StickerAnimation::PopIn:
+            scale *= easeOutBack(inProgress);
+            out.affine = out.animating;
+            break;
+        case StickerAnimation::PopOut:
+            scale *= 1.0f - easeInBack(outProgress);
+            out.animating = outProgress > 0.0f;
+            out.affine = out.animating;
+            break;
+        case StickerAnimation::Bounce:
+            offsetY = -kBounceHeight * std::fabs(std::sin(inProgress * static_cast<float>(M_PI) * 3.0f));
+            break;
+        case StickerAnimation::Spin:
+            rotation += 360.0f * inProgress;
+            out.affine = out.animating;
+            break;
+        case StickerAnimation::Shake:
+            offsetX = kShakeWidth * std::sin(inProgress * static_cast<float>(M_PI) * 10.0f);
+            break;
+        case StickerAnimation::Pulse:
+            scale *= 1.0f + 0.1f * std::sin(inProgress * static_cast<float>(M_PI) * 4.0f);
+            out.affine = out.animating;
+            break;
+    }
+    
+    if (scale <= 0.0f || alpha <= 0.0f) {
+        return false;
+    }
+    
+    out.cx = layer.x * width + offsetX;
+    out.cy = layer.y * height + offsetY;
+    out.scale = scale;
+    out.rotation = rotation;
+    out.alpha = static_cast<int>(std::min(alpha, 1.0f) * 256.0f + 0.5f);
+    return true;
+}
+
+Rect StickerOverlayManager::resolve(const StickerLayer& layer, const Placement& placement,
+                                    std::shared_ptr<const Sprite>& sprite) {
+    const std::shared_ptr<const Sprite>& image = m_images[layer.imageId];
+    if (placement.affine) {
+        sprite = image;
+        return spriteBounds(*image, placement.cx, placement.cy, placement.scale, placement.rotation);
+    }
+    
+    int scaleStep = static_cast<int>(std::lround(std::log2(placement.scale) * kScaleSteps));
+    int rotationStep = static_cast<int>(std::lround(placement.rotation * kRotationSteps)) % (360 * kRotationSteps);
+    if (rotationStep < 0) {
+        rotationStep += 360 * kRotationSteps;
+    }
+    sprite = scaleStep == 0 && rotationStep == 0 ? image : bucketSprite(layer.imageId, image, scaleStep, rotationStep);
+    
+    // Bucket sprites keep the image centre at their own centre
+    return spriteBounds({0, 0, sprite->width, sprite->height}, placement.cx - sprite->width * 0.5f,
+                        placement.cy - sprite->height * 0.5f, 1.0f);
+}
+
+std::shared_ptr<const Sprite> StickerOverlayManager::bucketSprite(int imageId, const std::shared_ptr<const Sprite>& image,
+                                                                  int scaleStep, int rotationStep) {
+    CacheKey key(imageId, scaleStep, rotationStep);
+    auto it = m_cache.find(key);
+    if (it != m_cache.end()) {
+        it->second.lastUse = ++m_useCounter;
+        return it->second.sprite;
+    }
+    
+    float scale = std::exp2(static_cast<float>(scaleStep) / kScaleSteps);
+    float rotation = static_cast<float>(rotationStep) / kRotationSteps;
+    auto sprite = std::make_shared<const Sprite>(transformSprite(*image, scale, rotation));
+    
+    m_cache[key] = {sprite, ++m_useCounter};
+    m_cacheBytes += spriteBytes(*sprite);
+    evictCache();
+    
+    LOGD("Cached sticker image %d at scale %.3f, %.1f deg: %dx%d", imageId, scale, rotation,
+         sprite->width, sprite->height);
+    return sprite;
+}
+
+void StickerOverlayManager::evictCache() {
+    // Least recently used first; the newest entry always survives so a single
+    // huge sticker still gets its copy
+    while (m_cacheBytes > kCacheBudget && m_cache.size() > 1) {
+        auto oldest = m_cache.begin();
+        for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        m_cacheBytes -= spriteBytes(*oldest->second.sprite);
+        m_cache.erase(oldest);
+    }
+}
+
+}  // namespace videoeditor
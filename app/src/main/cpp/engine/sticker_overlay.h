@@ -0,0 +1,120 @@
+#ifndef VIDEO_EDITOR_STICKER_OVERLAY_H
+#define VIDEO_EDITOR_STICKER_OVERLAY_H
+
+#include "common.h"
+#include "dirty_region.h"
+#include "sprite.h"
+#include <map>
+#include <tuple>
+
+namespace videoeditor {
+
+// Same set as StickerAnimation in StickerManager.kt
+enum class StickerAnimation {
+    None,
+    FadeIn,
+    FadeOut,
+    PopIn,
+    PopOut,
+    Bounce,
+    Spin,
+    Shake,
+    Pulse
+};
+
+// Sticker on the timeline: an uploaded image placed by its centre, scaled and
+// rotated about it
+struct StickerLayer {
+    int id;
+    int imageId;
+    float x;                    // Centre, 0-1 of the frame
+    float y;
+    float scale;
+    float rotation;             // Degrees, clockwise
+    float alpha;                // 0-1
+    int64_t startTime;
+    int64_t duration;
+    StickerAnimation animation;
+    int64_t animationDuration;
+    int64_t revision;           // Bumped whenever the sticker changes
+};
+
+// Sticker layers of the project, drawn over the composited clips and under the text.
+// Each decoded image is kept once, premultiplied. A sticker at rest is drawn from a
+// copy resampled for its (scale, rotation) bucket, so the per-frame cost is a plain
+// blit; only stickers whose animation changes their size or angle pay for the
+// bilinear affine path while the animation runs.
+class StickerOverlayManager {
+public:
+    StickerOverlayManager();
+    ~StickerOverlayManager();
+
+    // RGBA image, straight alpha unless premultiplied is set. Returns the image ID, or -1.
+    int addImage(const uint8_t* pixels, int width, int height, int stride, bool premultiplied);
+    bool removeImage(int imageId);
+
+    // Returns the sticker ID, or -1 if the image is unknown
+    int addSticker(int imageId, float x, float y, int64_t startTime, int64_t duration);
+    bool removeSticker(int stickerId);
+    bool setTransform(int stickerId, float x, float y, float scale, float rotation, float alpha);
+    bool setTimeRange(int stickerId, int64_t startTime, int64_t duration);
+    bool setAnimation(int stickerId, StickerAnimation animation, int64_t duration);
+    void clear();
+
+    // Snake-case name of a StickerAnimation ("pop_in", "spin", ...)
+    static bool toStickerAnimation(const std::string& name, StickerAnimation& out);
+
+    // Append a layer per sticker visible at position, with IDs below kLayerIdBase
+    // so they can't collide with clips or text
+    void collectLayers(int64_t position, int width, int height, std::vector<LayerState>& layers);
+
+    // Draw the stickers visible at position over dest, only inside region
+    void composite(VideoFrame& dest, const Rect& region, int64_t position);
+
+    static constexpr int kLayerIdBase = -(1 << 24);
+
+private:
+    // Where and how a sticker is drawn at one position
+    struct Placement {
+        float cx;        // Centre in the frame
+        float cy;
+        float scale;
+        float rotation;
+        int alpha;       // 0-256
+        bool animating;
+        bool affine;     // Size or angle changes every frame; skip the bucket cache
+    };
+
+    // Resampled copy of an image for one (scale, rotation) bucket
+    struct CachedSprite {
+        std::shared_ptr<const Sprite> sprite;
+        uint64_t lastUse;
+    };
+    using CacheKey = std::tuple<int, int, int>;  // Image ID, scale step, rotation step
+
+    bool place(const StickerLayer& layer, int64_t position, int width, int height, Placement& out) const;
+
+    // Sprite to draw and where it lands: the image itself for the affine path,
+    // otherwise the bucket copy (or the image when the bucket is the identity)
+    Rect resolve(const StickerLayer& layer, const Placement& placement, std::shared_ptr<const Sprite>& sprite);
+    std::shared_ptr<const Sprite> bucketSprite(int imageId, const std::shared_ptr<const Sprite>& image,
+                                               int scaleStep, int rotationStep);
+    void evictCache();
+
+    static constexpr int kScaleSteps = 32;         // Buckets per octave of scale (~2%)
+    static constexpr int kRotationSteps = 2;       // Buckets per degree
+    static constexpr size_t kCacheBudget = 32 * 1024 * 1024;
+
+    std::map<int, StickerLayer> m_layers;  // Drawn in ID order, like StickerManager.renderFrame
+    std::map<int, std::shared_ptr<const Sprite>> m_images;
+    std::map<CacheKey, CachedSprite> m_cache;
+    size_t m_cacheBytes;
+    uint64_t m_useCounter;
+    int m_nextStickerId;
+    int m_nextImageId;
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_STICKER_OVERLAY_H
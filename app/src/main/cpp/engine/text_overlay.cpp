@@ -0,0 +1,455 @@
+#include "text_overlay.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace videoeditor {
+
+namespace {
+
+// Matches the TextOverlay.kt defaults
+constexpr uint32_t kDefaultStrokeColor = 0xFF000000;
+constexpr float kDefaultStrokeWidth = 2.0f;
+constexpr int64_t kDefaultAnimationDuration = 500000;  // 500 ms
+constexpr float kBounceHeight = 20.0f;
+
+// Square max filter; small radii only, so the direct window is fine
+std::vector<uint8_t> dilate(const std::vector<uint8_t>& plane, int width, int height, int radius) {
+    std::vector<uint8_t> temp(plane.size());
+    std::vector<uint8_t> out(plane.size());
+    
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = plane.data() + static_cast<size_t>(y) * width;
+        uint8_t* dst = temp.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            uint8_t m = 0;
+            for (int k = std::max(0, x - radius); k <= std::min(width - 1, x + radius); k++) {
+                m = std::max(m, row[k]);
+            }
+            dst[x] = m;
+        }
+    }
+    
+    for (int y = 0; y < height; y++) {
+        uint8_t* dst = out.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            uint8_t m = 0;
+            for (int k = std::max(0, y - radius); k <= std::min(height - 1, y + radius); k++) {
+                m = std::max(m, temp[static_cast<size_t>(k) * width + x]);
+            }
+            dst[x] = m;
+        }
+    }
+    
+    return out;
+}
+
+inline bool visibleAt(const TextLayer& layer, int64_t position) {
+    return position >= layer.startTime && position - layer.startTime < layer.duration;
+}
+
+}  // namespace
+
+TextOverlayManager::TextOverlayManager()
+    : m_nextTextId(1) {
+    LOGI("TextOverlayManager created");
+}
+
+TextOverlayManager::~TextOverlayManager() {
+    LOGI("TextOverlayManager destroyed");
+}
+
+int TextOverlayManager::addText(const std::string& text, int64_t startTime, int64_t duration,
+                                float x, float y, float fontSize, uint32_t color) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    TextLayer layer;
+    layer.id = m_nextTextId++;
+    layer.text = text;
+    layer.startTime = startTime;
+    layer.duration = duration > 0 ? duration : std::numeric_limits<int64_t>::max() - startTime;
+    layer.x = x;
+    layer.y = y;
+    layer.fontSize = fontSize;
+    layer.color = color;
+    layer.strokeColor = kDefaultStrokeColor;
+    layer.strokeWidth = kDefaultStrokeWidth;
+    layer.shadow = true;
+    layer.animation = TextAnimation::None;
+    layer.animationDuration = kDefaultAnimationDuration;
+    layer.originX = 0;
+    layer.originY = 0;
+    layer.spriteDirty = true;
+    layer.missingGlyphs = false;
+    layer.atlasRevision = 0;
+    layer.revision = 0;
+    
+    m_layers[layer.id] = std::move(layer);
+    
+    LOGI("Added text %d: %s", m_nextTextId - 1, text.c_str());
+    return m_nextTextId - 1;
+}
+
+bool TextOverlayManager::updateText(int textId, const std::string& text, float fontSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_layers.find(textId);
+    if (it == m_layers.end()) {
+        return false;
+    }
+    
+    it->second.text = text;
+    it->second.fontSize = fontSize;
+    it->second.spriteDirty = true;
+    return true;
+}
+
+bool TextOverlayManager::setAnimation(int textId, TextAnimation animation, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_layers.find(textId);
+    if (it == m_layers.end()) {
+        return false;
+    }
+    
+    // Animations only transform the sprite, so it stays as it is; the new revision
+    // just makes the next preview redraw the layer
+    it->second.animation = animation;
+    it->second.animationDuration = duration > 0 ? duration : kDefaultAnimationDuration;
+    it->second.revision++;
+    return true;
+}
+
+bool TextOverlayManager::removeText(int textId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_layers.erase(textId) == 0) {
+        return false;
+    }
+    
+    LOGI("Removed text %d", textId);
+    return true;
+}
+
+void TextOverlayManager::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layers.clear();
+    m_nextTextId = 1;
+}
+
+bool TextOverlayManager::toTextAnimation(const std::string& name, TextAnimation& out) {
+    static const std::pair<const char*, TextAnimation> kNames[] = {
+        {"none", TextAnimation::None},
+        {"fade_in", TextAnimation::FadeIn},
+        {"fade_out", TextAnimation::FadeOut},
+        {"fade_in_out", TextAnimation::FadeInOut},
+        {"slide_left", TextAnimation::SlideLeft},
+        {"slide_right", TextAnimation::SlideRight},
+        {"slide_up", TextAnimation::SlideUp},
+        {"slide_down", TextAnimation::SlideDown},
+        {"scale_up", TextAnimation::ScaleUp},
+        {"scale_down", TextAnimation::ScaleDown},
+        {"typewriter", TextAnimation::Typewriter},
+        {"bounce", TextAnimation::Bounce}
+    };
+    
+    for (const auto& entry : kNames) {
+        if (name == entry.first) {
+            out = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TextOverlayManager::addGlyph(float fontSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                                  int stride, int bearingX, int bearingY, int advance) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_atlas.addGlyph(pixelSize(fontSize), codepoint, coverage, width, height, stride,
+                            bearingX, bearingY, advance);
+}
+
+std::vector<uint32_t> TextOverlayManager::getMissingGlyphs(const std::string& text, float fontSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_atlas.missingGlyphs(decodeUtf8(text), pixelSize(fontSize));
+}
+
+void TextOverlayManager::prepare(int64_t position) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (auto& pair : m_layers) {
+        if (visibleAt(pair.second, position)) {
+            ensureSprite(pair.second);
+        }
+    }
+}
+
+void TextOverlayManager::collectLayers(int64_t position, int width, int height, std::vector<LayerState>& layers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (auto& pair : m_layers) {
+        TextLayer& layer = pair.second;
+        if (!visibleAt(layer, position)) {
+            continue;
+        }
+        
+        ensureSprite(layer);
+        Placement placement;
+        if (!place(layer, position, width, height, placement)) {
+            continue;
+        }
+        
+        LayerState state;
+        state.layerId = -layer.id;
+        state.bounds = spriteBounds(placement.source, placement.x, placement.y, placement.scale);
+        state.contentKey = layer.revision;
+        state.revision = 0;
+        state.animated = placement.animating;
+        layers.push_back(state);
+    }
+}
+
+void TextOverlayManager::composite(VideoFrame& dest, const Rect& region, int64_t position) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    for (auto& pair : m_layers) {
+        TextLayer& layer = pair.second;
+        if (!visibleAt(layer, position)) {
+            continue;
+        }
+        
+        Placement placement;
+        if (place(layer, position, dest.width, dest.height, placement)) {
+            drawSprite(dest, layer.sprite, placement.source, placement.x, placement.y, placement.scale,
+                       placement.alpha, region);
+        }
+    }
+}
+
+bool TextOverlayManager::place(const TextLayer& layer, int64_t position, int width, int height,
+                               Placement& out) const {
+    if (layer.sprite.empty()) {
+        return false;
+    }
+    
+    // Same curves as TextRenderer.render
+    float posX = layer.x * width;
+    float posY = layer.y * height;
+    float animDuration = static_cast<float>(std::max<int64_t>(1, layer.animationDuration));
+    float inProgress = std::min(1.0f, (position - layer.startTime) / animDuration);
+    float outProgress = std::max(0.0f, 1.0f - (layer.startTime + layer.duration - position) / animDuration);
+    float alpha = 1.0f;
+    float scale = 1.0f;
+    
+    out.source = {0, 0, layer.sprite.width, layer.sprite.height};
+    out.animating = inProgress < 1.0f;
+    
+    switch (layer.animation) {
+        case TextAnimation::None:
+            out.animating = false;
+            break;
+        case TextAnimation::FadeIn:
+            alpha = inProgress;
+            break;
+        case TextAnimation::FadeOut:
+            alpha = 1.0f - outProgress;
+            out.animating = outProgress > 0.0f;
+            break;
+        case TextAnimation::FadeInOut:
+            alpha = std::min(inProgress, 1.0f - outProgress);
+            out.animating = inProgress < 1.0f || outProgress > 0.0f;
+            break;
+        case TextAnimation::SlideLeft:
+            posX = width + (posX - width) * inProgress;
+            break;
+        case TextAnimation::SlideRight:
+            posX = -width + (posX + width) * inProgress;
+            break;
+        case TextAnimation::SlideUp:
+            posY = height + (posY - height) * inProgress;
+            break;
+        case TextAnimation::SlideDown:
+            posY = -layer.fontSize + (posY + layer.fontSize) * inProgress;
+            break;
+        case TextAnimation::ScaleUp:
+            scale = inProgress;
+            break;
+        case TextAnimation::ScaleDown:
+            scale = 2.0f - inProgress;
+            break;
+        case TextAnimation::Typewriter: {
+            // Crop the finished sprite at a glyph boundary instead of re-rendering a prefix
+            size_t shown = static_cast<size_t>(layer.revealWidths.size() * inProgress);
+            out.source.width = shown == 0 ? 0 : layer.revealWidths[shown - 1];
+            break;
+        }
+        case TextAnimation::Bounce:
+            posY += std::sin(inProgress * static_cast<float>(M_PI) * 3.0f) * kBounceHeight;
+            break;
+    }
+    
+    // The sprite is scaled about the baseline centre, which lands on (posX, posY)
+    out.x = posX - layer.originX * scale;
+    out.y = posY - layer.originY * scale;
+    out.scale = scale;
+    out.alpha = static_cast<int>(std::max(0.0f, alpha) * 256.0f + 0.5f);
+    return true;
+}
+
+void TextOverlayManager::ensureSprite(TextLayer& layer) {
+    if (layer.spriteDirty || (layer.missingGlyphs && layer.atlasRevision != m_atlas.getRevision())) {
+        buildSprite(layer);
+    }
+}
+
+void TextOverlayManager::buildSprite(TextLayer& layer) {
+    int size = pixelSize(layer.fontSize);
+    std::vector<uint32_t> codepoints = decodeUtf8(layer.text);
+    
+    struct PlacedGlyph {
+        const GlyphInfo* glyph;
+        int penX;
+    };
+    std::vector<PlacedGlyph> glyphs;
+    std::vector<int> penEnds;
+    
+    // Lay the glyphs out along the baseline and measure the ink
+    int pen = 0;
+    int inkLeft = 0;
+    int inkRight = 0;
+    int ascent = 0;
+    int descent = 0;
+    bool missing = false;
+    
+    for (uint32_t cp : codepoints) {
+        const GlyphInfo* glyph = m_atlas.find(size, cp);
+        if (!glyph) {
+            // Leave a gap until the platform uploads it
+            missing = true;
+            pen += size / 2;
+            penEnds.push_back(pen);
+            continue;
+        }
+        if (glyph->width > 0) {
+            inkLeft = std::min(inkLeft, pen + glyph->bearingX);
+            inkRight = std::max(inkRight, pen + glyph->bearingX + glyph->width);
+            ascent = std::max(ascent, glyph->bearingY);
+            descent = std::max(descent, glyph->height - glyph->bearingY);
+        }
+        glyphs.push_back({glyph, pen});
+        pen += glyph->advance;
+        penEnds.push_back(pen);
+    }
+    
+    layer.spriteDirty = false;
+    layer.missingGlyphs = missing;
+    layer.atlasRevision = m_atlas.getRevision();
+    layer.revision++;
+    layer.revealWidths.clear();
+    
+    int right = std::max(inkRight, pen);
+    if (glyphs.empty() || ascent + descent <= 0 || right <= inkLeft) {
+        layer.sprite.allocate(0, 0);
+        return;
+    }
+    
+    // Paint strokes straddle the outline, so half the width lands outside
+    int strokeRadius = layer.strokeWidth > 0.0f ? static_cast<int>(std::ceil(layer.strokeWidth / 2.0f)) : 0;
+    int pad = strokeRadius + (layer.shadow ? kShadowOffset + 2 * kShadowBlur : 0) + 1;
+    int offsetX = pad - inkLeft;
+    int width = right - inkLeft + 2 * pad;
+    int height = ascent + descent + 2 * pad;
+    layer.originX = offsetX + pen / 2;  // Centre aligned on the advance, as Paint.Align.CENTER
+    layer.originY = pad + ascent;
+    
+    // Glyph coverage
+    std::vector<uint8_t> fill(static_cast<size_t>(width) * height, 0);
+    const uint8_t* atlas = m_atlas.pixels();
+    int atlasStride = m_atlas.stride();
+    
+    for (const auto& placed : glyphs) {
+        const GlyphInfo& glyph = *placed.glyph;
+        int left = offsetX + placed.penX + glyph.bearingX;
+        int top = layer.originY - glyph.bearingY;
+        for (int row = 0; row < glyph.height; row++) {
+            const uint8_t* src = atlas + static_cast<size_t>(glyph.y + row) * atlasStride + glyph.x;
+            uint8_t* dst = fill.data() + static_cast<size_t>(top + row) * width + left;
+            for (int col = 0; col < glyph.width; col++) {
+                dst[col] = std::max(dst[col], src[col]);
+            }
+        }
+    }
+    
+    std::vector<uint8_t> stroke;
+    if (strokeRadius > 0) {
+        stroke = dilate(fill, width, height, strokeRadius);
+    }
+    
+    std::vector<uint8_t> shadow;
+    if (layer.shadow) {
+        shadow.assign(fill.size(), 0);
+        for (int y = kShadowOffset; y < height; y++) {
+            memcpy(shadow.data() + static_cast<size_t>(y) * width + kShadowOffset,
+                   fill.data() + static_cast<size_t>(y - kShadowOffset) * width, width - kShadowOffset);
+        }
+        m_blur.boxBlurPlane(shadow.data(), width, height, kShadowBlur);
+        m_blur.boxBlurPlane(shadow.data(), width, height, kShadowBlur);
+    }
+    
+    // Shadow, stroke and fill, bottom to top, flattened into one premultiplied sprite
+    auto channel = [](uint32_t color, int shift) { return ((color >> shift) & 0xFF) / 255.0f; };
+    float fillR = channel(layer.color, 16);
+    float fillG = channel(layer.color, 8);
+    float fillB = channel(layer.color, 0);
+    float fillA = channel(layer.color, 24);
+    float strokeR = channel(layer.strokeColor, 16);
+    float strokeG = channel(layer.strokeColor, 8);
+    float strokeB = channel(layer.strokeColor, 0);
+    float strokeA = channel(layer.strokeColor, 24);
+    float shadowA = kShadowAlpha / 255.0f;
+    
+    layer.sprite.allocate(width, height);
+    uint8_t* out = layer.sprite.pixels.data();
+    
+    for (size_t i = 0; i < fill.size(); i++, out += 4) {
+        float r = 0.0f;
+        float g = 0.0f;
+        float b = 0.0f;
+        float a = shadow.empty() ? 0.0f : shadow[i] / 255.0f * shadowA;
+        
+        if (!stroke.empty() && stroke[i] != 0) {
+            float coverage = stroke[i] / 255.0f * strokeA;
+            r = strokeR * coverage + r * (1.0f - coverage);
+            g = strokeG * coverage + g * (1.0f - coverage);
+            b = strokeB * coverage + b * (1.0f - coverage);
+            a = coverage + a * (1.0f - coverage);
+        }
+        if (fill[i] != 0) {
+            float coverage = fill[i] / 255.0f * fillA;
+            r = fillR * coverage + r * (1.0f - coverage);
+            g = fillG * coverage + g * (1.0f - coverage);
+            b = fillB * coverage + b * (1.0f - coverage);
+            a = coverage + a * (1.0f - coverage);
+        }
+        
+        out[0] = static_cast<uint8_t>(r * 255.0f + 0.5f);
+        out[1] = static_cast<uint8_t>(g * 255.0f + 0.5f);
+        out[2] = static_cast<uint8_t>(b * 255.0f + 0.5f);
+        out[3] = static_cast<uint8_t>(a * 255.0f + 0.5f);
+    }
+    
+    // Typewriter crops: everything up to the end of each glyph's advance, plus its stroke
+    layer.revealWidths.reserve(penEnds.size());
+    for (int end : penEnds) {
+        layer.revealWidths.push_back(std::min(width, offsetX + end + strokeRadius + 1));
+    }
+    
+    LOGD("Built text %d sprite: %dx%d%s", layer.id, width, height, missing ? " (glyphs missing)" : "");
+}
+
+int TextOverlayManager::pixelSize(float fontSize) {
+    return std::max(1, static_cast<int>(std::lround(fontSize)));
+}
+
+}  // namespace videoeditor
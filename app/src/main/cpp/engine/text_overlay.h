@@ -0,0 +1,128 @@
+#ifndef VIDEO_EDITOR_TEXT_OVERLAY_H
+#define VIDEO_EDITOR_TEXT_OVERLAY_H
+
+#include "common.h"
+#include "dirty_region.h"
+#include "glyph_atlas.h"
+#include "sprite.h"
+#include "../filters/blur_filter.h"
+#include <map>
+
+namespace videoeditor {
+
+// Same set as TextAnimation in TextOverlay.kt
+enum class TextAnimation {
+    None,
+    FadeIn,
+    FadeOut,
+    FadeInOut,
+    SlideLeft,
+    SlideRight,
+    SlideUp,
+    SlideDown,
+    ScaleUp,
+    ScaleDown,
+    Typewriter,
+    Bounce
+};
+
+// Caption on the timeline. Its look (fill, stroke, shadow) is rendered once into
+// a sprite; animations only move, scale, fade or crop that sprite.
+struct TextLayer {
+    int id;
+    std::string text;
+    int64_t startTime;
+    int64_t duration;
+    float x;                    // Baseline centre, 0-1 of the frame
+    float y;
+    float fontSize;             // Pixels of the project frame
+    uint32_t color;             // ARGB
+    uint32_t strokeColor;       // ARGB
+    float strokeWidth;
+    bool shadow;
+    TextAnimation animation;
+    int64_t animationDuration;
+
+    // Rendered look, rebuilt only when the text or style changes
+    Sprite sprite;
+    int originX;                // Baseline centre inside the sprite
+    int originY;
+    std::vector<int> revealWidths;  // Sprite width showing the first i + 1 glyphs (typewriter)
+    bool spriteDirty;
+    bool missingGlyphs;         // Built before every glyph was uploaded
+    uint32_t atlasRevision;     // Atlas revision the sprite was built against
+    int64_t revision;           // Bumped on every rebuild
+};
+
+// Text layers of the project, drawn over the composited clips
+class TextOverlayManager {
+public:
+    TextOverlayManager();
+    ~TextOverlayManager();
+
+    // Returns the text ID
+    int addText(const std::string& text, int64_t startTime, int64_t duration,
+                float x, float y, float fontSize, uint32_t color);
+    // New text at fontSize, the size its glyphs were uploaded at
+    bool updateText(int textId, const std::string& text, float fontSize);
+    bool setAnimation(int textId, TextAnimation animation, int64_t duration);
+    bool removeText(int textId);
+    void clear();
+
+    // Snake-case name of a TextAnimation ("fade_in", "typewriter", ...)
+    static bool toTextAnimation(const std::string& name, TextAnimation& out);
+
+    // Glyph rasterised by the platform; coverage is 8-bit, bearingY is the top above the baseline
+    bool addGlyph(float fontSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                  int stride, int bearingX, int bearingY, int advance);
+
+    // Codepoints of the text that have to be uploaded before it can be drawn at this size
+    std::vector<uint32_t> getMissingGlyphs(const std::string& text, float fontSize);
+
+    // Bring the sprites of the text visible at position up to date with its text
+    // and the glyphs uploaded so far
+    void prepare(int64_t position);
+
+    // Append a layer per text visible at position, after preparing it. Text uses
+    // negative layer IDs so it can't collide with clips; animating text is marked animated.
+    void collectLayers(int64_t position, int width, int height, std::vector<LayerState>& layers);
+
+    // Draw the text visible at position over dest, only inside region. Sprites are
+    // drawn as last prepared, so a glyph that arrives after collectLayers can't
+    // change pixels outside the dirty region it produced.
+    void composite(VideoFrame& dest, const Rect& region, int64_t position);
+
+private:
+    // Where and how a layer's sprite is drawn at one position
+    struct Placement {
+        Rect source;     // Part of the sprite shown
+        float x;         // Top-left of the drawn sprite
+        float y;
+        float scale;
+        int alpha;       // 0-256
+        bool animating;
+    };
+
+    bool place(const TextLayer& layer, int64_t position, int width, int height, Placement& out) const;
+
+    // Rebuild the sprite if the text changed, or glyphs it lacked have arrived since
+    void ensureSprite(TextLayer& layer);
+    void buildSprite(TextLayer& layer);
+
+    static int pixelSize(float fontSize);
+
+    // Shadow as in TextRenderer.kt: offset (2, 2), blur radius 4, half-transparent black
+    static constexpr int kShadowOffset = 2;
+    static constexpr int kShadowBlur = 2;  // Box radius, twice over comes close to the Paint blur
+    static constexpr int kShadowAlpha = 128;
+
+    std::map<int, TextLayer> m_layers;  // Drawn in ID order, like TextRenderer.renderAll
+    GlyphAtlas m_atlas;
+    BlurFilter m_blur;
+    int m_nextTextId;
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_TEXT_OVERLAY_H
@@ -1,9 +1,11 @@
 #include "timeline.h"
+#include <algorithm>
 
 namespace videoeditor {
 
 Timeline::Timeline()
     : m_nextClipId(1)
+    , m_nextTransitionId(1)
     , m_trackCount(3)  // Default 3 tracks (video, overlay, audio)
     , m_duration(0) {
     LOGI("Timeline created");
@@ -17,8 +19,10 @@ Timeline::~Timeline() {
 void Timeline::clear() {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_clips.clear();
+    m_transitions.clear();
     m_duration = 0;
     m_nextClipId = 1;
+    m_nextTransitionId = 1;
     LOGI("Timeline cleared");
 }
 
@@ -34,6 +38,7 @@ bool Timeline::addClip(const std::string& filePath, int trackIndex, int64_t posi
     clip.trimEnd = 0;
     clip.speed = 1.0f;
     clip.volume = 1.0f;
+    clip.interpolateFrames = false;
     
     // TODO: Get actual duration from video file
     // For now, use placeholder
@@ -58,6 +63,17 @@ bool Timeline::removeClip(int clipId) {
     }
     
     m_clips.erase(it);
+    
+    // Transitions can't outlive either of their clips
+    for (auto transIt = m_transitions.begin(); transIt != m_transitions.end();) {
+        const TimelineTransition& transition = transIt->second;
+        if (transition.fromClipId == clipId || transition.toClipId == clipId) {
+            transIt = m_transitions.erase(transIt);
+        } else {
+            ++transIt;
+        }
+    }
+    
     recalculateDuration();
     
     LOGI("Removed clip %d", clipId);
@@ -109,10 +125,32 @@ bool Timeline::trimClip(int clipId, int64_t trimStart, int64_t trimEnd) {
 
 bool Timeline::splitClip(int clipId, int64_t position) {
     std::lock_guard<std::mutex> lock(m_mutex);
+    return splitLocked(clipId, position) >= 0;
+}
+
+std::vector<int> Timeline::splitClip(int clipId, std::vector<int64_t> positions) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    // Last cut first: each split leaves the head under clipId, so the earlier
+    // positions still fall inside it
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
     
+    std::vector<int> newClipIds;
+    for (auto it = positions.rbegin(); it != positions.rend(); ++it) {
+        int newClipId = splitLocked(clipId, *it);
+        if (newClipId >= 0) {
+            newClipIds.push_back(newClipId);
+        }
+    }
+    std::reverse(newClipIds.begin(), newClipIds.end());
+    return newClipIds;
+}
+
+int Timeline::splitLocked(int clipId, int64_t position) {
     auto it = m_clips.find(clipId);
     if (it == m_clips.end()) {
-        return false;
+        return -1;
     }
     
     TimelineClip& originalClip = it->second;
@@ -120,7 +158,7 @@ bool Timeline::splitClip(int clipId, int64_t position) {
     // Check if position is within clip
     if (position <= originalClip.startTime || 
         position >= originalClip.startTime + originalClip.duration) {
-        return false;
+        return -1;
     }
     
     // Calculate split point relative to source
@@ -140,8 +178,15 @@ bool Timeline::splitClip(int clipId, int64_t position) {
     
     m_clips[newClip.id] = newClip;
     
+    // The outgoing side of a transition now ends on the second half
+    for (auto& pair : m_transitions) {
+        if (pair.second.fromClipId == clipId) {
+            pair.second.fromClipId = newClip.id;
+        }
+    }
+    
     LOGI("Split clip %d at %lld, created new clip %d", clipId, (long long)position, newClip.id);
-    return true;
+    return newClip.id;
 }
 
 bool Timeline::setClipSpeed(int clipId, float speed) {
@@ -179,6 +224,129 @@ bool Timeline::setClipVolume(int clipId, float volume) {
     return true;
 }
 
+bool Timeline::setClipStabilization(int clipId, std::shared_ptr<const StabilizationTrack> track) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_clips.find(clipId);
+    if (it == m_clips.end()) {
+        return false;
+    }
+    
+    // Tracks are indexed by source time, so halves of a later split keep theirs
+    it->second.stabilization = std::move(track);
+    
+    LOGI("Clip %d stabilisation %s", clipId, it->second.stabilization ? "on" : "off");
+    return true;
+}
+
+bool Timeline::setClipFrameInterpolation(int clipId, bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_clips.find(clipId);
+    if (it == m_clips.end()) {
+        return false;
+    }
+    
+    it->second.interpolateFrames = enabled;
+    
+    LOGI("Clip %d frame interpolation %s", clipId, enabled ? "on" : "off");
+    return true;
+}
+
+int Timeline::addTransition(int fromClipId, int toClipId, TransitionType type, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto fromIt = m_clips.find(fromClipId);
+    auto toIt = m_clips.find(toClipId);
+    if (fromIt == m_clips.end() || toIt == m_clips.end() || fromClipId == toClipId || duration <= 0) {
+        return -1;
+    }
+    
+    TimelineClip& from = fromIt->second;
+    TimelineClip& to = toIt->second;
+    if (to.startTime < from.startTime) {
+        LOGW("Transition target clip %d starts before clip %d", toClipId, fromClipId);
+        return -1;
+    }
+    
+    // Neither clip can be covered completely
+    duration = std::min({duration, from.duration, to.duration});
+    
+    // Butted or gapped clips are pulled into an overlap of the transition length.
+    // Whatever follows the incoming clip on its track moves back with it, so no
+    // gap opens after it and the track stays in order.
+    int64_t fromEnd = from.startTime + from.duration;
+    if (fromEnd - to.startTime < duration) {
+        int64_t oldStart = to.startTime;
+        to.startTime = std::max(from.startTime, fromEnd - duration);
+        int64_t delta = oldStart - to.startTime;
+        for (auto& pair : m_clips) {
+            TimelineClip& clip = pair.second;
+            if (clip.id != toClipId && clip.id != fromClipId && clip.trackIndex == to.trackIndex &&
+                clip.startTime >= oldStart) {
+                clip.startTime -= delta;
+            }
+        }
+    }
+    
+    TimelineTransition transition;
+    transition.id = m_nextTransitionId++;
+    transition.fromClipId = fromClipId;
+    transition.toClipId = toClipId;
+    transition.type = type;
+    transition.duration = duration;
+    m_transitions[transition.id] = transition;
+    
+    recalculateDuration();
+    
+    LOGI("Added transition %d between clips %d and %d, %lld us from %lld",
+        transition.id, fromClipId, toClipId, (long long)duration, (long long)to.startTime);
+    return transition.id;
+}
+
+bool Timeline::removeTransition(int transitionId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_transitions.erase(transitionId) == 0) {
+        return false;
+    }
+    
+    LOGI("Removed transition %d", transitionId);
+    return true;
+}
+
+std::vector<ActiveTransition> Timeline::getTransitionsAtPosition(int64_t position) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    std::vector<ActiveTransition> result;
+    
+    for (const auto& pair : m_transitions) {
+        const TimelineTransition& transition = pair.second;
+        auto fromIt = m_clips.find(transition.fromClipId);
+        auto toIt = m_clips.find(transition.toClipId);
+        if (fromIt == m_clips.end() || toIt == m_clips.end()) {
+            continue;
+        }
+        
+        // Clips moved after the fact shrink the window to whatever still overlaps
+        const TimelineClip& from = fromIt->second;
+        const TimelineClip& to = toIt->second;
+        int64_t start = std::max(from.startTime, to.startTime);
+        int64_t end = std::min({from.startTime + from.duration, to.startTime + to.duration,
+                                to.startTime + transition.duration});
+        if (position < start || position >= end) {
+            continue;
+        }
+        
+        ActiveTransition active;
+        active.transition = transition;
+        active.progress = static_cast<float>(position - start) / static_cast<float>(end - start);
+        result.push_back(active);
+    }
+    
+    return result;
+}
+
 TimelineClip* Timeline::getClip(int clipId) {
     auto it = m_clips.find(clipId);
     return it != m_clips.end() ? &it->second : nullptr;
@@ -6,6 +6,8 @@
 
 namespace videoeditor {
 
+struct StabilizationTrack;
+
 struct TimelineClip {
     int id;
     std::string filePath;
@@ -18,6 +20,40 @@ struct TimelineClip {
     float speed;
     float volume;
     std::vector<EffectParams> effects;
+    std::shared_ptr<const StabilizationTrack> stabilization;  // Null unless stabilised
+    bool interpolateFrames; // Synthesise in-between frames when slowed below 1x
+};
+
+enum class TransitionType {
+    Fade,
+    Dissolve,
+    WipeLeft,
+    WipeRight,
+    WipeUp,
+    WipeDown,
+    SlideLeft,
+    SlideRight,
+    ZoomIn,
+    ZoomOut,
+    CircleOpen,
+    CircleClose,
+    Blur
+};
+
+// Cross-over between two clips; it plays where they overlap, from the start of
+// the incoming clip for at most duration
+struct TimelineTransition {
+    int id;
+    int fromClipId;
+    int toClipId;
+    TransitionType type;
+    int64_t duration;
+};
+
+// Transition running at a given position
+struct ActiveTransition {
+    TimelineTransition transition;
+    float progress;  // 0 = all outgoing clip, 1 = all incoming clip
 };
 
 class Timeline {
@@ -33,8 +69,19 @@ public:
     bool moveClip(int clipId, int trackIndex, int64_t position);
     bool trimClip(int clipId, int64_t trimStart, int64_t trimEnd);
     bool splitClip(int clipId, int64_t position);
+    // Split at every timeline position in one go; returns the new clip IDs in timeline order
+    std::vector<int> splitClip(int clipId, std::vector<int64_t> positions);
     bool setClipSpeed(int clipId, float speed);
     bool setClipVolume(int clipId, float volume);
+    // Per-frame corrections from VideoStabilizer; null turns stabilisation off
+    bool setClipStabilization(int clipId, std::shared_ptr<const StabilizationTrack> track);
+    bool setClipFrameInterpolation(int clipId, bool enabled);
+
+    // Transition operations; adding pulls the incoming clip back so the two
+    // overlap by the (clamped) duration. Returns the transition ID or -1.
+    int addTransition(int fromClipId, int toClipId, TransitionType type, int64_t duration);
+    bool removeTransition(int transitionId);
+    std::vector<ActiveTransition> getTransitionsAtPosition(int64_t position);
 
     // Get clips
     TimelineClip* getClip(int clipId);
@@ -48,10 +95,15 @@ public:
 
 private:
     int getNextClipId() { return m_nextClipId++; }
+
+    // Caller holds m_mutex; returns the ID of the new second half, or -1
+    int splitLocked(int clipId, int64_t position);
     void recalculateDuration();
 
     std::map<int, TimelineClip> m_clips;
+    std::map<int, TimelineTransition> m_transitions;
     int m_nextClipId;
+    int m_nextTransitionId;
     int m_trackCount;
     int64_t m_duration;
     std::mutex m_mutex;
@@ -0,0 +1,421 @@
+#include "transition_renderer.h"
+#include "../filters/pixel_kernels.h"
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+// Same seed as the Kotlin dissolve
+constexpr uint32_t kDissolveSeed = 42;
+
+// Blur radius at the midpoint, where the two clips swap
+constexpr int kMaxBlurRadius = 20;
+
+// How much further the zooms scale the zoomed clip by the far end
+constexpr float kZoomRange = 0.3f;
+
+// Per-pixel threshold 0-255, fixed for the whole transition so the pattern doesn't crawl
+inline int dissolveThreshold(int x, int y) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x9E3779B1u ^ static_cast<uint32_t>(y) * 0x85EBCA77u ^ kDissolveSeed;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return static_cast<int>(h >> 24);
+}
+
+inline uint8_t* pixelAt(VideoFrame& frame, int x, int y) {
+    return frame.data.data() + (static_cast<size_t>(y) * frame.width + x) * 4;
+}
+
+}  // namespace
+
+TransitionRenderer::TransitionRenderer()
+    : m_frameBuffer(nullptr)
+    , m_threadPool(nullptr) {
+    LOGI("TransitionRenderer created");
+}
+
+TransitionRenderer::~TransitionRenderer() {
+    LOGI("TransitionRenderer destroyed");
+}
+
+void TransitionRenderer::setThreadPool(ThreadPool* pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadPool = pool;
+    m_blur.setThreadPool(pool);
+}
+
+bool TransitionRenderer::toTransitionType(const std::string& name, TransitionType& out) {
+    static const std::pair<const char*, TransitionType> kNames[] = {
+        {"fade", TransitionType::Fade},
+        {"dissolve", TransitionType::Dissolve},
+        {"wipe_left", TransitionType::WipeLeft},
+        {"wipe_right", TransitionType::WipeRight},
+        {"wipe_up", TransitionType::WipeUp},
+        {"wipe_down", TransitionType::WipeDown},
+        {"slide_left", TransitionType::SlideLeft},
+        {"slide_right", TransitionType::SlideRight},
+        {"zoom_in", TransitionType::ZoomIn},
+        {"zoom_out", TransitionType::ZoomOut},
+        {"circle_open", TransitionType::CircleOpen},
+        {"circle_close", TransitionType::CircleClose},
+        {"blur", TransitionType::Blur}
+    };
+    
+    for (const auto& entry : kNames) {
+        if (name == entry.first) {
+            out = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+Rect TransitionRenderer::bounds(TransitionType type, const Rect& fromRect, const Rect& toRect,
+                                int width, int height) {
+    Rect full = {0, 0, width, height};
+    
+    switch (type) {
+        case TransitionType::Fade:
+        case TransitionType::Dissolve:
+        case TransitionType::WipeLeft:
+        case TransitionType::WipeRight:
+        case TransitionType::WipeUp:
+        case TransitionType::WipeDown:
+        case TransitionType::CircleOpen:
+        case TransitionType::CircleClose:
+            return fromRect.unite(toRect).intersect(full);
+        default:
+            return full;  // Slides, zooms and blurs move pixels outside the fitted rects
+    }
+}
+
+void TransitionRenderer::render(FrameBuffer& frameBuffer, VideoFrame& dest, const Rect& region,
+                                const ActiveTransition& active,
+                                const VideoFrame& from, const TimelineClip& fromClip,
+                                const VideoFrame& to, const TimelineClip& toClip) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    int width = dest.width;
+    int height = dest.height;
+    TransitionType type = active.transition.type;
+    
+    Rect fromRect = FrameBuffer::fitRect(from.width, from.height, width, height);
+    Rect toRect = FrameBuffer::fitRect(to.width, to.height, width, height);
+    Rect area = bounds(type, fromRect, toRect, width, height).intersect(region);
+    if (area.isEmpty() || dest.data.size() < dest.dataSize()) {
+        return;
+    }
+    
+    for (VideoFrame* scratch : {&m_first, &m_second}) {
+        if (scratch->width != width || scratch->height != height) {
+            scratch->width = width;
+            scratch->height = height;
+            scratch->format = PixelFormat::RGBA;
+            scratch->data.resize(scratch->dataSize());
+        }
+    }
+    
+    m_frameBuffer = &frameBuffer;
+    
+    Layer fromLayer = {from, fromClip};
+    Layer toLayer = {to, toClip};
+    float progress = std::max(0.0f, std::min(1.0f, active.progress));
+    float maxRadius = std::sqrt(static_cast<float>(width) * width + static_cast<float>(height) * height) / 2.0f;
+    
+    switch (type) {
+        case TransitionType::Fade:
+            renderFade(dest, area, fromLayer, toLayer, progress);
+            break;
+        case TransitionType::Dissolve:
+            renderDissolve(dest, area, fromLayer, toLayer, progress);
+            break;
+        case TransitionType::WipeLeft:
+        case TransitionType::WipeRight:
+        case TransitionType::WipeUp:
+        case TransitionType::WipeDown:
+            renderWipe(dest, area, fromLayer, toLayer, type, progress);
+            break;
+        case TransitionType::SlideLeft:
+            renderSlide(dest, area, fromLayer, toLayer, true, progress);
+            break;
+        case TransitionType::SlideRight:
+            renderSlide(dest, area, fromLayer, toLayer, false, progress);
+            break;
+        case TransitionType::ZoomIn:
+            // Outgoing clip grows and fades out over the incoming one
+            renderZoom(dest, area, toLayer, fromLayer, 1.0f + progress * kZoomRange, 1.0f - progress);
+            break;
+        case TransitionType::ZoomOut:
+            // Incoming clip shrinks into place as it fades in
+            renderZoom(dest, area, fromLayer, toLayer, 1.0f + (1.0f - progress) * kZoomRange, progress);
+            break;
+        case TransitionType::CircleOpen:
+            renderCircle(dest, area, fromLayer, toLayer, progress * maxRadius);
+            break;
+        case TransitionType::CircleClose:
+            renderCircle(dest, area, toLayer, fromLayer, (1.0f - progress) * maxRadius);
+            break;
+        case TransitionType::Blur:
+            // Outgoing clip blurs up to the midpoint, then the incoming one sharpens
+            if (progress < 0.5f) {
+                int radius = static_cast<int>(progress * 2.0f * kMaxBlurRadius);
+                renderBlur(dest, area, fromLayer, std::max(1, radius));
+            } else {
+                int radius = static_cast<int>((1.0f - (progress - 0.5f) * 2.0f) * kMaxBlurRadius);
+                renderBlur(dest, area, toLayer, std::max(1, radius));
+            }
+            break;
+    }
+    
+    m_frameBuffer = nullptr;
+}
+
+void TransitionRenderer::drawLayer(VideoFrame& target, const Rect& rect, const Layer& layer) {
+    Rect area = rect.intersect({0, 0, target.width, target.height});
+    if (area.isEmpty()) {
+        return;
+    }
+    
+    size_t rowBytes = static_cast<size_t>(area.width) * 4;
+    for (int y = area.y; y < area.bottom(); y++) {
+        memset(pixelAt(target, area.x, y), 0, rowBytes);
+    }
+    
+    m_frameBuffer->composite(target, layer.frame, layer.clip, area);
+}
+
+void TransitionRenderer::renderFade(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                                    float progress) {
+    drawLayer(dest, area, from);
+    drawLayer(m_second, area, to);
+    
+    int alpha = static_cast<int>(progress * 256.0f + 0.5f);
+    const PixelKernels& kernels = pixelKernels();
+    
+    forRows(area.y, area.bottom(), [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            kernels.blendRgb(pixelAt(dest, area.x, y), pixelAt(m_second, area.x, y), area.width, alpha);
+        }
+    });
+}
+
+void TransitionRenderer::renderDissolve(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                                        float progress) {
+    drawLayer(dest, area, from);
+    drawLayer(m_second, area, to);
+    
+    // A pixel switches to the incoming clip once progress passes its threshold
+    int level = static_cast<int>(progress * 256.0f + 0.5f);
+    
+    forRows(area.y, area.bottom(), [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            uint8_t* dst = pixelAt(dest, 0, y);
+            const uint8_t* src = pixelAt(m_second, 0, y);
+            for (int x = area.x; x < area.right(); x++) {
+                if (dissolveThreshold(x, y) < level) {
+                    memcpy(dst + x * 4, src + x * 4, 4);
+                }
+            }
+        }
+    });
+}
+
+void TransitionRenderer::renderWipe(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                                    TransitionType type, float progress) {
+    int width = dest.width;
+    int height = dest.height;
+    bool horizontal = type == TransitionType::WipeLeft || type == TransitionType::WipeRight;
+    
+    // Left and up wipes grow the incoming clip from the leading edge, right and down from the trailing one
+    bool incomingLeads = type == TransitionType::WipeLeft || type == TransitionType::WipeUp;
+    int extent = horizontal ? width : height;
+    int covered = static_cast<int>(extent * progress);
+    int edge = incomingLeads ? covered : extent - covered;
+    
+    Rect leading = horizontal ? Rect{0, 0, edge, height} : Rect{0, 0, width, edge};
+    Rect trailing = horizontal ? Rect{edge, 0, width - edge, height} : Rect{0, edge, width, height - edge};
+    
+    // Each side is composited straight into the output; no pixel is touched twice
+    drawLayer(dest, area.intersect(leading), incomingLeads ? to : from);
+    drawLayer(dest, area.intersect(trailing), incomingLeads ? from : to);
+}
+
+void TransitionRenderer::renderSlide(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                                     bool left, float progress) {
+    int width = dest.width;
+    int offset = static_cast<int>(width * progress);
+    
+    // Output columns [begin, end) show the layer's columns shifted by shift
+    auto place = [&](const Layer& layer, VideoFrame& scratch, int begin, int end, int shift) {
+        Rect span = area.intersect({begin, 0, end - begin, dest.height});
+        if (span.isEmpty()) {
+            return;
+        }
+        
+        drawLayer(scratch, {span.x + shift, span.y, span.width, span.height}, layer);
+        
+        size_t rowBytes = static_cast<size_t>(span.width) * 4;
+        forRows(span.y, span.bottom(), [&](int rowBegin, int rowEnd) {
+            for (int y = rowBegin; y < rowEnd; y++) {
+                memcpy(pixelAt(dest, span.x, y), pixelAt(scratch, span.x + shift, y), rowBytes);
+            }
+        });
+    };
+    
+    if (left) {
+        place(from, m_first, 0, width - offset, offset);
+        place(to, m_second, width - offset, width, offset - width);
+    } else {
+        place(from, m_first, offset, width, -offset);
+        place(to, m_second, 0, offset, width - offset);
+    }
+}
+
+void TransitionRenderer::renderZoom(VideoFrame& dest, const Rect& area, const Layer& base, const Layer& overlay,
+                                    float scale, float alpha) {
+    drawLayer(dest, area, base);
+    
+    int alphaQ8 = static_cast<int>(alpha * 256.0f + 0.5f);
+    if (alphaQ8 <= 0) {
+        return;
+    }
+    
+    // Scale >= 1 about the centre, so every output pixel samples inside the frame
+    int width = dest.width;
+    int height = dest.height;
+    float cx = width * 0.5f;
+    float cy = height * 0.5f;
+    auto sourceX = [&](int x) {
+        return std::max(0, std::min(width - 1, static_cast<int>(cx + (x + 0.5f - cx) / scale)));
+    };
+    auto sourceY = [&](int y) {
+        return std::max(0, std::min(height - 1, static_cast<int>(cy + (y + 0.5f - cy) / scale)));
+    };
+    
+    // Only the part of the overlay that lands in the area is composited
+    int srcLeft = sourceX(area.x);
+    int srcTop = sourceY(area.y);
+    Rect source = {srcLeft, srcTop, sourceX(area.right() - 1) + 1 - srcLeft, sourceY(area.bottom() - 1) + 1 - srcTop};
+    drawLayer(m_second, source, overlay);
+    
+    m_columns.resize(area.width);
+    for (int i = 0; i < area.width; i++) {
+        m_columns[i] = sourceX(area.x + i);
+    }
+    
+    const PixelKernels& kernels = pixelKernels();
+    
+    forRows(area.y, area.bottom(), [&](int rowBegin, int rowEnd) {
+        std::vector<uint8_t> row(static_cast<size_t>(area.width) * 4);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            const uint8_t* src = pixelAt(m_second, 0, sourceY(y));
+            for (int i = 0; i < area.width; i++) {
+                memcpy(&row[i * 4], src + m_columns[i] * 4, 4);
+            }
+            kernels.blendRgb(pixelAt(dest, area.x, y), row.data(), area.width, alphaQ8);
+        }
+    });
+}
+
+void TransitionRenderer::renderCircle(VideoFrame& dest, const Rect& area, const Layer& outside, const Layer& inside,
+                                      float radius) {
+    drawLayer(dest, area, outside);
+    if (radius <= 0.0f) {
+        return;
+    }
+    
+    float cx = dest.width * 0.5f;
+    float cy = dest.height * 0.5f;
+    int left = static_cast<int>(std::floor(cx - radius - 1.0f));
+    int top = static_cast<int>(std::floor(cy - radius - 1.0f));
+    int right = static_cast<int>(std::ceil(cx + radius + 1.0f));
+    int bottom = static_cast<int>(std::ceil(cy + radius + 1.0f));
+    Rect box = area.intersect({left, top, right - left, bottom - top});
+    if (box.isEmpty()) {
+        return;
+    }
+    
+    drawLayer(m_second, box, inside);
+    
+    // Pixels whose centre is within radius - 0.5 are copied whole; the one-pixel
+    // ring around them is blended by coverage for an anti-aliased edge
+    float inner = radius - 0.5f;
+    float outer = radius + 0.5f;
+    
+    forRows(box.y, box.bottom(), [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            float dy = y + 0.5f - cy;
+            if (std::fabs(dy) >= outer) {
+                continue;
+            }
+            
+            float outerHalf = std::sqrt(outer * outer - dy * dy);
+            int edgeBegin = std::max(box.x, static_cast<int>(std::floor(cx - outerHalf)));
+            int edgeEnd = std::min(box.right(), static_cast<int>(std::ceil(cx + outerHalf)));
+            
+            int solidBegin = edgeEnd;
+            int solidEnd = edgeEnd;
+            if (inner > std::fabs(dy)) {
+                float innerHalf = std::sqrt(inner * inner - dy * dy);
+                solidBegin = std::max(edgeBegin, static_cast<int>(std::ceil(cx - innerHalf - 0.5f)));
+                solidEnd = std::min(edgeEnd, static_cast<int>(std::floor(cx + innerHalf - 0.5f)) + 1);
+                if (solidBegin >= solidEnd) {
+                    solidBegin = edgeEnd;
+                    solidEnd = edgeEnd;
+                }
+            }
+            
+            uint8_t* dst = pixelAt(dest, 0, y);
+            const uint8_t* src = pixelAt(m_second, 0, y);
+            if (solidEnd > solidBegin) {
+                memcpy(dst + solidBegin * 4, src + solidBegin * 4, static_cast<size_t>(solidEnd - solidBegin) * 4);
+            }
+            
+            for (int x = edgeBegin; x < edgeEnd; x++) {
+                if (x == solidBegin) {
+                    x = solidEnd - 1;
+                    continue;
+                }
+                float dx = x + 0.5f - cx;
+                float coverage = outer - std::sqrt(dx * dx + dy * dy);
+                if (coverage <= 0.0f) {
+                    continue;
+                }
+                int a = coverage >= 1.0f ? 256 : static_cast<int>(coverage * 256.0f + 0.5f);
+                uint8_t* out = dst + x * 4;
+                const uint8_t* in = src + x * 4;
+                for (int c = 0; c < 3; c++) {
+                    out[c] = static_cast<uint8_t>((in[c] * a + out[c] * (256 - a) + 128) >> 8);
+                }
+            }
+        }
+    });
+}
+
+void TransitionRenderer::renderBlur(VideoFrame& dest, const Rect& area, const Layer& layer, int radius) {
+    // The blur reaches in from outside the area, so the whole clip is drawn and blurred
+    drawLayer(m_first, {0, 0, dest.width, dest.height}, layer);
+    m_blur.boxBlur(m_first, radius);
+    
+    size_t rowBytes = static_cast<size_t>(area.width) * 4;
+    forRows(area.y, area.bottom(), [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            memcpy(pixelAt(dest, area.x, y), pixelAt(m_first, area.x, y), rowBytes);
+        }
+    });
+}
+
+void TransitionRenderer::forRows(int begin, int end, const std::function<void(int, int)>& body) {
+    if (m_threadPool && end - begin > kMinBandRows) {
+        m_threadPool->parallelFor(begin, end, kMinBandRows, body);
+    } else {
+        body(begin, end);
+    }
+}
+
+}  // namespace videoeditor
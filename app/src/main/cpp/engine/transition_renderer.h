@@ -0,0 +1,76 @@
+#ifndef VIDEO_EDITOR_TRANSITION_RENDERER_H
+#define VIDEO_EDITOR_TRANSITION_RENDERER_H
+
+#include "common.h"
+#include "timeline.h"
+#include "frame_buffer.h"
+#include "../filters/blur_filter.h"
+#include "../utils/thread_pool.h"
+
+namespace videoeditor {
+
+// Draws the overlap between two clips natively, same looks as Transitions.kt.
+// Each transition works out which rows and columns need which clip and only
+// composites (and blends) those; wipes and slides are plain row copies.
+class TransitionRenderer {
+public:
+    TransitionRenderer();
+    ~TransitionRenderer();
+
+    // Blend passes are split into row bands across the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Snake-case name of a TransitionType ("fade", "wipe_left", "circle_open", ...)
+    static bool toTransitionType(const std::string& name, TransitionType& out);
+
+    // Part of a width x height output the transition draws, given where each clip is fitted
+    static Rect bounds(TransitionType type, const Rect& fromRect, const Rect& toRect, int width, int height);
+
+    // Draw the transition into dest inside region. Its bounds come out opaque:
+    // letterboxing is black, as the Kotlin version's full-frame bitmaps were.
+    void render(FrameBuffer& frameBuffer, VideoFrame& dest, const Rect& region,
+                const ActiveTransition& active,
+                const VideoFrame& from, const TimelineClip& fromClip,
+                const VideoFrame& to, const TimelineClip& toClip);
+
+private:
+    // Fitted clip frame with its timeline entry, as passed to FrameBuffer::composite
+    struct Layer {
+        const VideoFrame& frame;
+        const TimelineClip& clip;
+    };
+
+    // Clear rect of target to black and composite the layer into it
+    void drawLayer(VideoFrame& target, const Rect& rect, const Layer& layer);
+
+    void renderFade(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to, float progress);
+    void renderDissolve(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to, float progress);
+    void renderWipe(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                    TransitionType type, float progress);
+    void renderSlide(VideoFrame& dest, const Rect& area, const Layer& from, const Layer& to,
+                     bool left, float progress);
+    void renderZoom(VideoFrame& dest, const Rect& area, const Layer& base, const Layer& overlay,
+                    float scale, float alpha);
+    void renderCircle(VideoFrame& dest, const Rect& area, const Layer& outside, const Layer& inside,
+                      float radius);
+    void renderBlur(VideoFrame& dest, const Rect& area, const Layer& layer, int radius);
+
+    // Runs body(rowBegin, rowEnd) over [begin, end), banded across the pool
+    void forRows(int begin, int end, const std::function<void(int, int)>& body);
+
+    // Rows per band for the blend passes
+    static constexpr int kMinBandRows = 32;
+
+    // Scratch frames at output size, reallocated only when that changes
+    VideoFrame m_first;
+    VideoFrame m_second;
+    std::vector<int> m_columns;  // Source column per output column of a zoom
+    FrameBuffer* m_frameBuffer;  // Set for the duration of render()
+    BlurFilter m_blur;
+    ThreadPool* m_threadPool;
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_TRANSITION_RENDERER_H
@@ -40,7 +40,10 @@ void VideoDecoder::release() {
 
 bool VideoDecoder::openFile(const std::string& filePath) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+    return openLocked(filePath);
+}
+
+bool VideoDecoder::openLocked(const std::string& filePath) {
     if (m_contexts.find(filePath) != m_contexts.end()) {
         return true;  // Already open
     }
@@ -50,7 +53,12 @@ bool VideoDecoder::openFile(const std::string& filePath) {
     ctx->codec = nullptr;
     ctx->format = nullptr;
     ctx->videoTrackIndex = -1;
+    ctx->outputFormat = PixelFormat::NV12;
+    ctx->outputSupported = true;
+    ctx->outputWidth = 0;
+    ctx->outputHeight = 0;
     ctx->isConfigured = false;
+    ctx->endOfStream = false;
     
     if (!configureDecoder(ctx.get(), filePath)) {
         return false;
@@ -111,6 +119,9 @@ bool VideoDecoder::configureDecoder(DecoderContext* ctx, const std::string& file
             AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &ctx->width);
             AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &ctx->height);
             AMediaFormat_getInt64(format, AMEDIAFORMAT_KEY_DURATION, &ctx->duration);
+            ctx->outputWidth = ctx->width;
+            ctx->outputHeight = ctx->height;
+            ctx->outputPadding.stride = ctx->width;
             
             int32_t frameRate = 30;
             AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, &frameRate);
@@ -160,7 +171,7 @@ bool VideoDecoder::configureDecoder(DecoderContext* ctx, const std::string& file
 VideoDecoder::DecoderContext* VideoDecoder::getContext(const std::string& filePath) {
     auto it = m_contexts.find(filePath);
     if (it == m_contexts.end()) {
-        openFile(filePath);
+        openLocked(filePath);
         it = m_contexts.find(filePath);
     }
     return it != m_contexts.end() ? it->second.get() : nullptr;
@@ -178,8 +189,34 @@ VideoFrame VideoDecoder::decodeFrame(const std::string& filePath, int64_t timest
         return frame;
     }
     
-    // Seek to timestamp
+    // Seek to timestamp; the flush drops queued frames and any end of stream
+    // reached by an earlier call, as in seekTo
     AMediaExtractor_seekTo(ctx->extractor, timestamp, AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC);
+    AMediaCodec_flush(ctx->codec);
+    ctx->endOfStream = false;
+    
+    return decodeUntil(ctx, timestamp);
+}
+
+VideoFrame VideoDecoder::decodeNextFrame(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    DecoderContext* ctx = getContext(filePath);
+    if (!ctx || !ctx->isConfigured) {
+        LOGE("Decoder not configured for file: %s", filePath.c_str());
+        VideoFrame frame;
+        frame.format = PixelFormat::RGBA;
+        return frame;
+    }
+    return decodeUntil(ctx, INT64_MIN);
+}
+
+VideoFrame VideoDecoder::decodeUntil(DecoderContext* ctx, int64_t timestamp) {
+    VideoFrame frame;
+    frame.format = PixelFormat::RGBA;
+    if (ctx->endOfStream) {
+        return frame;  // The codec emits nothing more until it is flushed
+    }
     
     // Decode frames until we reach the target timestamp
     bool gotFrame = false;
@@ -204,7 +241,7 @@ VideoFrame VideoDecoder::decodeFrame(const std::string& filePath, int64_t timest
         }
         
         // Get output buffer
-        AMediaCodecBufferInfo info;
+        AMediaCodecBufferInfo info = {};
         ssize_t outputBufferIdx = AMediaCodec_dequeueOutputBuffer(ctx->codec, &info, 10000);
         
         if (outputBufferIdx >= 0) {
@@ -213,15 +250,16 @@ VideoFrame VideoDecoder::decodeFrame(const std::string& filePath, int64_t timest
                 size_t outputBufferSize;
                 uint8_t* outputBuffer = AMediaCodec_getOutputBuffer(ctx->codec, outputBufferIdx, &outputBufferSize);
                 
-                // Copy frame data
-                frame.width = ctx->width;
-                frame.height = ctx->height;
-                frame.timestamp_us = info.presentationTimeUs;
-                frame.data.resize(ctx->width * ctx->height * 4);
-                
-                // Convert YUV to RGBA (simplified - actual implementation needs proper conversion)
-                // This is a placeholder - real implementation would use libyuv or similar
-                memcpy(frame.data.data(), outputBuffer, std::min(frame.data.size(), outputBufferSize));
+                // Convert from the codec's layout; everything downstream works on RGBA
+                size_t offset = std::min<size_t>(std::max<int32_t>(0, info.offset), outputBufferSize);
+                if (outputBuffer && ctx->outputSupported &&
+                    PixelConverter::toRgba(outputBuffer + offset, outputBufferSize - offset, ctx->outputFormat,
+                                           ctx->outputWidth, ctx->outputHeight, ctx->outputPadding, frame)) {
+                    frame.timestamp_us = info.presentationTimeUs;
+                } else {
+                    LOGE("Unsupported decoder output (%zu bytes)", outputBufferSize);
+                    frame.data.clear();
+                }
                 
                 gotFrame = true;
             }
@@ -229,11 +267,12 @@ VideoFrame VideoDecoder::decodeFrame(const std::string& filePath, int64_t timest
             AMediaCodec_releaseOutputBuffer(ctx->codec, outputBufferIdx, false);
         } else if (outputBufferIdx == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
             AMediaFormat* newFormat = AMediaCodec_getOutputFormat(ctx->codec);
-            LOGI("Output format changed");
+            updateOutputFormat(ctx, newFormat);
             AMediaFormat_delete(newFormat);
         }
         
-        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+        if (outputBufferIdx >= 0 && (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM)) {
+            ctx->endOfStream = true;
             break;
         }
     }
@@ -241,7 +280,56 @@ VideoFrame VideoDecoder::decodeFrame(const std::string& filePath, int64_t timest
     return frame;
 }
 
-bool VideoDecoder::seekTo(const std::string& filePath, int64_t timestamp) {
+bool VideoDecoder::toPixelFormat(int32_t colorFormat, PixelFormat& format) {
+    switch (colorFormat) {
+        case 19:          // COLOR_FormatYUV420Planar
+            format = PixelFormat::YUV420P;
+            return true;
+        case 21:          // COLOR_FormatYUV420SemiPlanar
+        case 0x7f420888:  // COLOR_FormatYUV420Flexible, semi-planar on ByteBuffer output
+            format = PixelFormat::NV12;
+            return true;
+        default:
+            return false;  // Vendor formats (often tiled) would decode to garbage
+    }
+}
+
+void VideoDecoder::updateOutputFormat(DecoderContext* ctx, AMediaFormat* format) {
+    int32_t colorFormat = 0;
+    int32_t width = ctx->width;
+    int32_t height = ctx->height;
+    int32_t stride = 0;
+    int32_t sliceHeight = 0;
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, &colorFormat);
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &width);
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &height);
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &stride);
+    // Plain key names: the AMEDIAFORMAT_KEY_ constants for these need API 28
+    AMediaFormat_getInt32(format, "slice-height", &sliceHeight);
+    
+    // Crop edges are inclusive; without them the whole width x height is visible
+    int32_t cropLeft = 0, cropTop = 0, cropRight = width - 1, cropBottom = height - 1;
+    AMediaFormat_getInt32(format, "crop-left", &cropLeft);
+    AMediaFormat_getInt32(format, "crop-top", &cropTop);
+    AMediaFormat_getInt32(format, "crop-right", &cropRight);
+    AMediaFormat_getInt32(format, "crop-bottom", &cropBottom);
+    
+    ctx->outputSupported = toPixelFormat(colorFormat, ctx->outputFormat);
+    ctx->outputWidth = std::max(0, cropRight - cropLeft + 1);
+    ctx->outputHeight = std::max(0, cropBottom - cropTop + 1);
+    ctx->outputPadding.cropLeft = std::max(0, cropLeft);
+    ctx->outputPadding.cropTop = std::max(0, cropTop);
+    ctx->outputPadding.stride = std::max(stride, PixelConverter::tightStride(ctx->outputFormat, cropRight + 1));
+    ctx->outputPadding.sliceHeight = sliceHeight;
+    
+    if (!ctx->outputSupported) {
+        LOGE("Unsupported decoder colour format %d", colorFormat);
+    }
+    LOGI("Output format changed: colour format %d, %dx%d, stride %d, slice height %d, crop %d,%d-%d,%d",
+        colorFormat, width, height, stride, sliceHeight, cropLeft, cropTop, cropRight, cropBottom);
+}
+
+bool VideoDecoder::seekTo(const std::string& filePath, int64_t timestamp, SeekMode mode) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     DecoderContext* ctx = getContext(filePath);
@@ -249,16 +337,45 @@ bool VideoDecoder::seekTo(const std::string& filePath, int64_t timestamp) {
         return false;
     }
     
-    AMediaExtractor_seekTo(ctx->extractor, timestamp, AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC);
+    AMediaExtractor_seekTo(ctx->extractor, timestamp, mode);
     
     // Flush codec
     if (ctx->codec) {
         AMediaCodec_flush(ctx->codec);
     }
+    ctx->endOfStream = false;
     
     return true;
 }
 
+std::vector<int64_t> VideoDecoder::getKeyframeTimes(const std::string& filePath, int64_t start, int64_t end) {
+    std::vector<int64_t> times;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    DecoderContext* ctx = getContext(filePath);
+    if (!ctx || !ctx->extractor) {
+        return times;
+    }
+    
+    // Hop from sync sample to sync sample through the index; no sample data is read
+    int64_t position = std::max<int64_t>(0, start);
+    while (position < end) {
+        if (AMediaExtractor_seekTo(ctx->extractor, position, AMEDIAEXTRACTOR_SEEK_NEXT_SYNC) != AMEDIA_OK) {
+            break;
+        }
+        int64_t sampleTime = AMediaExtractor_getSampleTime(ctx->extractor);
+        if (sampleTime < position || sampleTime >= end) {
+            break;
+        }
+        times.push_back(sampleTime);
+        position = sampleTime + 1;
+    }
+    
+    // Leave the extractor where decoding expects it
+    AMediaExtractor_seekTo(ctx->extractor, std::max<int64_t>(0, start), AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC);
+    return times;
+}
+
 int VideoDecoder::getWidth(const std::string& filePath) {
     DecoderContext* ctx = getContext(filePath);
     return ctx ? ctx->width : 0;
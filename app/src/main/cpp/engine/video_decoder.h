@@ -2,6 +2,7 @@
 #define VIDEO_EDITOR_VIDEO_DECODER_H
 
 #include "common.h"
+#include "../utils/pixel_format.h"
 #include <media/NdkMediaCodec.h>
 #include <media/NdkMediaExtractor.h>
 #include <media/NdkMediaFormat.h>
@@ -30,8 +31,15 @@ public:
     // Decode frame at specific timestamp
     VideoFrame decodeFrame(const std::string& filePath, int64_t timestamp);
 
-    // Seek to timestamp
-    bool seekTo(const std::string& filePath, int64_t timestamp);
+    // Next frame in presentation order after seekTo or an earlier call; empty at the end of the stream
+    VideoFrame decodeNextFrame(const std::string& filePath);
+
+    // Seek to timestamp; by default to the nearest keyframe, which may be after it
+    bool seekTo(const std::string& filePath, int64_t timestamp, SeekMode mode = AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC);
+
+    // Presentation times of the sync samples (keyframes) in [start, end), in order;
+    // decodeFrame at one of them needs no frames but the keyframe itself
+    std::vector<int64_t> getKeyframeTimes(const std::string& filePath, int64_t start, int64_t end);
 
     // Get thumbnail
     VideoFrame getThumbnail(const std::string& filePath, int64_t timestamp, int maxWidth, int maxHeight);
@@ -46,13 +54,30 @@ private:
         int height;
         int64_t duration;
         int fps;
+        PixelFormat outputFormat;  // Layout of the codec's output buffers
+        bool outputSupported;      // False for colour formats we can't read (e.g. vendor tiled)
+        BufferPadding outputPadding;  // Stride, slice height and crop of those buffers
+        int outputWidth;           // Visible picture inside them
+        int outputHeight;
         bool isConfigured;
+        bool endOfStream;          // Codec has signalled the end; cleared by a flush
     };
 
+    // Map a MediaCodecInfo colour format to the layout its buffers use; false if unsupported
+    static bool toPixelFormat(int32_t colorFormat, PixelFormat& format);
+
+    // Read the buffer layout from the codec's new output format
+    static void updateOutputFormat(DecoderContext* ctx, AMediaFormat* format);
+
+    // Caller holds m_mutex
+    bool openLocked(const std::string& filePath);
     DecoderContext* getContext(const std::string& filePath);
     bool configureDecoder(DecoderContext* ctx, const std::string& filePath);
     VideoFrame extractFrame(DecoderContext* ctx);
 
+    // Feed samples from the extractor's position and return the first frame at or after timestamp
+    VideoFrame decodeUntil(DecoderContext* ctx, int64_t timestamp);
+
     std::unordered_map<std::string, std::unique_ptr<DecoderContext>> m_contexts;
     std::mutex m_mutex;
     bool m_initialized;
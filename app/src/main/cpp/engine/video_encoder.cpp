@@ -1,4 +1,5 @@
 #include "video_encoder.h"
+#include "../utils/pixel_format.h"
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -136,8 +137,17 @@ bool VideoEncoder::encodeFrame(const VideoFrame& frame) {
         return false;
     }
     
-    // Get input buffer
+    if (frame.width != m_width || frame.height != m_height) {
+        LOGE("Frame is %dx%d, encoder expects %dx%d", frame.width, frame.height, m_width, m_height);
+        return false;
+    }
+    
+    // Get input buffer; while the codec is backed up, drain its output and wait again
     ssize_t inputBufferIdx = AMediaCodec_dequeueInputBuffer(m_codec, 10000);
+    for (int attempt = 0; inputBufferIdx < 0 && attempt < kInputRetries; attempt++) {
+        writeEncodedData();
+        inputBufferIdx = AMediaCodec_dequeueInputBuffer(m_codec, 10000);
+    }
     if (inputBufferIdx < 0) {
         LOGW("Failed to get input buffer");
         return false;
@@ -146,20 +156,16 @@ bool VideoEncoder::encodeFrame(const VideoFrame& frame) {
     size_t inputBufferSize;
     uint8_t* inputBuffer = AMediaCodec_getInputBuffer(m_codec, inputBufferIdx, &inputBufferSize);
     
-    // Convert RGBA to YUV420 and copy to input buffer
-    // Simplified conversion - real implementation would use libyuv
-    size_t yuvSize = m_width * m_height * 3 / 2;
-    
-    // Copy Y plane (simplified - just using R channel as Y)
-    for (int i = 0; i < m_width * m_height && i * 4 < frame.data.size(); i++) {
-        inputBuffer[i] = frame.data[i * 4];  // R as Y
-    }
-    
-    // Copy UV planes (simplified)
-    int uvStart = m_width * m_height;
-    for (int i = 0; i < m_width * m_height / 4; i++) {
-        inputBuffer[uvStart + i * 2] = 128;      // U
-        inputBuffer[uvStart + i * 2 + 1] = 128;  // V
+    // Encoder is configured for COLOR_FormatYUV420SemiPlanar (NV12)
+    VideoFrame target;
+    target.width = m_width;
+    target.height = m_height;
+    target.format = PixelFormat::NV12;
+    size_t yuvSize = target.dataSize();
+    if (!inputBuffer || !PixelConverter::fromRgba(frame, PixelFormat::NV12, inputBuffer, inputBufferSize)) {
+        LOGE("Cannot convert %dx%d frame for the encoder", frame.width, frame.height);
+        AMediaCodec_queueInputBuffer(m_codec, inputBufferIdx, 0, 0, 0, 0);  // Hand the buffer back
+        return false;
     }
     
     int64_t presentationTime = m_frameCount * m_frameDuration;
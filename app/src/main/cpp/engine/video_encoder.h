@@ -17,6 +17,8 @@ public:
     void release();
 
     bool configure(const ExportSettings& settings);
+
+    // Queue one RGBA frame of the configured size; false if it can't be encoded
     bool encodeFrame(const VideoFrame& frame);
     bool finalize();
 
@@ -25,6 +27,8 @@ public:
 private:
     bool writeEncodedData();
 
+    static constexpr int kInputRetries = 50;  // 10 ms waits for a free input buffer
+
     AMediaCodec* m_codec;
     AMediaMuxer* m_muxer;
     AMediaFormat* m_format;
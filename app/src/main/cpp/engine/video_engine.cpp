@@ -3,11 +3,49 @@
 
 namespace videoeditor {
 
+namespace {
+
+// Fold value into hash, as FrameCacheKey's hash does
+inline uint64_t combineHash(uint64_t hash, uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+// Source time a timeline position shows
+inline int64_t sourceTime(const TimelineClip& clip, int64_t position) {
+    return clip.trimStart + static_cast<int64_t>((position - clip.startTime) * clip.speed);
+}
+
+// Index of the clip that shares an active transition with clips[index], -1 if none
+int findTransitionPartner(const std::vector<TimelineClip>& clips, size_t index,
+                          const std::vector<ActiveTransition>& transitions, const ActiveTransition*& active) {
+    int clipId = clips[index].id;
+    for (const auto& candidate : transitions) {
+        const TimelineTransition& transition = candidate.transition;
+        int partnerId = transition.fromClipId == clipId ? transition.toClipId :
+                        transition.toClipId == clipId ? transition.fromClipId : -1;
+        if (partnerId < 0) {
+            continue;
+        }
+        for (size_t i = 0; i < clips.size(); i++) {
+            if (clips[i].id == partnerId) {
+                active = &candidate;
+                return static_cast<int>(i);
+            }
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
 VideoEngine::VideoEngine()
     : m_projectWidth(1920)
     , m_projectHeight(1080)
     , m_projectFps(30)
     , m_previewSurface(nullptr)
+    , m_previewRevision(0)
+    , m_scopeFlags(0)
+    , m_scopeRevision(0)
     , m_initialized(false)
     , m_playing(false)
     , m_exporting(false)
@@ -29,8 +67,18 @@ bool VideoEngine::initialize() {
         LOGW("VideoEngine already initialized");
         return true;
     }
-
+    
     try {
+#ifndef NDEBUG
+        // Catch SIMD kernels that drift from the scalar reference on this device
+        if (!verifyPixelKernels()) {
+            LOGE("Pixel kernel self-test failed");
+        }
+        if (!BlurFilter::verifyRecursiveGaussian()) {
+            LOGE("Recursive Gaussian self-test failed");
+        }
+#endif
+
         // Initialize thread pool (4 threads for parallel processing)
         m_threadPool = std::make_unique<ThreadPool>(4);
         
@@ -64,14 +112,31 @@ bool VideoEngine::initialize() {
             LOGE("Failed to initialize filter manager");
             return false;
         }
+        m_filterManager->setThreadPool(m_threadPool.get());
         
         // Initialize frame buffer
         m_frameBuffer = std::make_unique<FrameBuffer>(m_projectWidth, m_projectHeight);
+        m_frameCache = std::make_unique<FrameCache>(kFrameCacheBytes);
+        
+        m_transitionRenderer = std::make_unique<TransitionRenderer>();
+        m_transitionRenderer->setThreadPool(m_threadPool.get());
+        m_stickerOverlays = std::make_unique<StickerOverlayManager>();
+        m_textOverlays = std::make_unique<TextOverlayManager>();
+        m_maskCompositor = std::make_unique<MaskCompositor>();
+        m_maskCompositor->setThreadPool(m_threadPool.get());
+        m_videoScopes = std::make_unique<VideoScopes>();
+        m_videoScopes->setThreadPool(m_threadPool.get());
+        m_sceneDetector = std::make_unique<SceneDetector>();
+        m_sceneDetector->setThreadPool(m_threadPool.get());
+        m_videoStabilizer = std::make_unique<VideoStabilizer>();
+        m_videoStabilizer->setThreadPool(m_threadPool.get());
+        m_frameInterpolator = std::make_unique<FrameInterpolator>(kMotionCacheBytes);
+        m_frameInterpolator->setThreadPool(m_threadPool.get());
         
         m_initialized = true;
         LOGI("VideoEngine initialized successfully");
         return true;
-        
+    
     } catch (const std::exception& e) {
         LOGE("Exception during initialization: %s", e.what());
         if (m_errorCallback) {
@@ -87,9 +152,19 @@ void VideoEngine::release() {
     if (!m_initialized) {
         return;
     }
-
+    
     stop();
-
+    
+    m_visibleLayers.clear();
+    m_transitionRenderer.reset();
+    m_stickerOverlays.reset();
+    m_textOverlays.reset();
+    m_maskCompositor.reset();
+    m_videoScopes.reset();
+    m_sceneDetector.reset();
+    m_videoStabilizer.reset();
+    m_frameInterpolator.reset();
+    m_frameCache.reset();
     m_frameBuffer.reset();
     m_filterManager.reset();
     m_audioEngine.reset();
@@ -97,12 +172,12 @@ void VideoEngine::release() {
     m_decoder.reset();
     m_timeline.reset();
     m_threadPool.reset();
-
+    
     if (m_previewSurface) {
         ANativeWindow_release(m_previewSurface);
         m_previewSurface = nullptr;
     }
-
+    
     m_initialized = false;
     LOGI("VideoEngine released");
 }
@@ -115,10 +190,26 @@ bool VideoEngine::createProject(int width, int height, int fps) {
     m_projectFps = fps;
     
     // Reinitialize frame buffer with new dimensions
-    m_frameBuffer = std::make_unique<FrameBuffer>(width, height);
+    {
+        std::lock_guard<std::mutex> previewLock(m_previewMutex);
+        m_frameBuffer = std::make_unique<FrameBuffer>(width, height);
+        m_visibleLayers.clear();
+    }
+    if (m_frameCache) {
+        m_frameCache->clear();
+    }
+    if (m_frameInterpolator) {
+        m_frameInterpolator->clear();
+    }
     
     // Reset timeline
     m_timeline->clear();
+    if (m_stickerOverlays) {
+        m_stickerOverlays->clear();
+    }
+    if (m_textOverlays) {
+        m_textOverlays->clear();
+    }
     m_currentPosition = 0;
     
     LOGI("Project created: %dx%d @ %d fps", width, height, fps);
@@ -151,7 +242,14 @@ bool VideoEngine::addClip(const std::string& filePath, int trackIndex, int64_t p
 
 bool VideoEngine::removeClip(int clipId) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_timeline ? m_timeline->removeClip(clipId) : false;
+    
+    if (!m_timeline || !m_timeline->removeClip(clipId)) {
+        return false;
+    }
+    if (m_frameCache) {
+        m_frameCache->invalidateClip(clipId);
+    }
+    return true;
 }
 
 bool VideoEngine::moveClip(int clipId, int trackIndex, int64_t position) {
@@ -174,6 +272,37 @@ bool VideoEngine::setClipSpeed(int clipId, float speed) {
     return m_timeline ? m_timeline->setClipSpeed(clipId, speed) : false;
 }
 
+bool VideoEngine::setClipFrameInterpolation(int clipId, bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline && m_timeline->setClipFrameInterpolation(clipId, enabled);
+}
+
+std::vector<int64_t> VideoEngine::detectSceneCuts(int clipId) {
+    TimelineClip clip;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TimelineClip* found = m_timeline ? m_timeline->getClip(clipId) : nullptr;
+        if (!found || !m_sceneDetector) return {};
+        clip = *found;
+    }
+    
+    // The detector opens decoders of its own, so playback keeps its one
+    return m_sceneDetector->detect(clip.filePath, clip.trimStart, clip.sourceDuration - clip.trimEnd);
+}
+
+std::vector<int> VideoEngine::splitClipAtSourceTimes(int clipId, const std::vector<int64_t>& sourceTimes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TimelineClip* clip = m_timeline ? m_timeline->getClip(clipId) : nullptr;
+    if (!clip) return {};
+    
+    std::vector<int64_t> positions;
+    positions.reserve(sourceTimes.size());
+    for (int64_t time : sourceTimes) {
+        positions.push_back(clip->startTime + static_cast<int64_t>((time - clip->trimStart) / clip->speed));
+    }
+    return m_timeline->splitClip(clipId, positions);
+}
+
 bool VideoEngine::setClipVolume(int clipId, float volume) {
     std::lock_guard<std::mutex> lock(m_mutex);
     return m_timeline ? m_timeline->setClipVolume(clipId, volume) : false;
@@ -256,20 +385,24 @@ VideoFrame VideoEngine::getPreviewFrame(int64_t position) {
     if (m_timeline && m_decoder) {
         // Get clips at this position
         auto clips = m_timeline->getClipsAtPosition(position);
+        auto transitions = m_timeline->getTransitionsAtPosition(position);
         
+        std::unordered_map<int, std::shared_ptr<const VideoFrame>> frames;
         for (const auto& clip : clips) {
-            // Decode frame from clip
-            VideoFrame clipFrame = m_decoder->decodeFrame(clip.filePath, 
-                position - clip.startTime + clip.trimStart);
-            
-            // Apply filters
-            if (m_filterManager) {
-                m_filterManager->applyFilters(clipFrame, clip.filePath);
-            }
-            
-            // Composite onto main frame
-            m_frameBuffer->composite(frame, clipFrame, clip);
+            // Decoded and filtered, or reused from an earlier request
+            frames[clip.id] = getClipFrameAt(clip, position);
         }
+        
+        // Composite onto main frame
+        compositeClips(frame, {0, 0, frame.width, frame.height}, clips, transitions, frames);
+    }
+    
+    if (m_stickerOverlays) {
+        m_stickerOverlays->composite(frame, {0, 0, frame.width, frame.height}, position);
+    }
+    if (m_textOverlays) {
+        m_textOverlays->prepare(position);
+        m_textOverlays->composite(frame, {0, 0, frame.width, frame.height}, position);
     }
     
     return frame;
@@ -277,6 +410,8 @@ VideoFrame VideoEngine::getPreviewFrame(int64_t position) {
 
 void VideoEngine::setPreviewSurface(ANativeWindow* surface) {
     std::lock_guard<std::mutex> lock(m_mutex);
+    // The render loop posts to the surface and diffs the frame buffer under this
+    std::lock_guard<std::mutex> previewLock(m_previewMutex);
     
     if (m_previewSurface) {
         ANativeWindow_release(m_previewSurface);
@@ -288,23 +423,36 @@ void VideoEngine::setPreviewSurface(ANativeWindow* surface) {
         ANativeWindow_acquire(surface);
     }
     
+    // A new surface has no valid content yet, so the next post must be full-frame
+    if (m_frameBuffer) {
+        m_frameBuffer->invalidate();
+    }
+    
     LOGI("Preview surface set");
 }
 
 // Effects & Filters
+// Cached frames are keyed by program hash, so a changed chain can never hit the
+// old ones; dropping them just gives their memory back
 bool VideoEngine::addFilter(int clipId, const std::string& filterType, const EffectParams& params) {
     if (!m_filterManager) return false;
-    return m_filterManager->addFilter(clipId, filterType, params);
+    if (!m_filterManager->addFilter(clipId, filterType, params)) return false;
+    if (m_frameCache) m_frameCache->invalidateClip(clipId);
+    return true;
 }
 
 bool VideoEngine::removeFilter(int clipId, int filterId) {
     if (!m_filterManager) return false;
-    return m_filterManager->removeFilter(clipId, filterId);
+    if (!m_filterManager->removeFilter(clipId, filterId)) return false;
+    if (m_frameCache) m_frameCache->invalidateClip(clipId);
+    return true;
 }
 
 bool VideoEngine::updateFilter(int clipId, int filterId, const EffectParams& params) {
     if (!m_filterManager) return false;
-    return m_filterManager->updateFilter(clipId, filterId, params);
+    if (!m_filterManager->updateFilter(clipId, filterId, params)) return false;
+    if (m_frameCache) m_frameCache->invalidateClip(clipId);
+    return true;
 }
 
 // Export
@@ -333,13 +481,23 @@ bool VideoEngine::exportVideo(const ExportSettings& settings, ProgressCallback p
         int64_t frameInterval = 1000000 / settings.fps;  // microseconds per frame
         int64_t totalFrames = duration / frameInterval;
         int64_t frameCount = 0;
+        bool failed = false;
         
         for (int64_t pos = 0; pos < duration && m_exporting; pos += frameInterval) {
             // Get frame at position
             VideoFrame frame = getPreviewFrame(pos);
             
-            // Encode frame
-            m_encoder->encodeFrame(frame);
+            // The project renders at its own size; the encoder takes the export size
+            if (frame.width != settings.width || frame.height != settings.height) {
+                frame = m_frameBuffer->scale(frame, settings.width, settings.height);
+            }
+            
+            // Encode frame; a dropped frame would leave the file short, so stop instead
+            if (!m_encoder->encodeFrame(frame)) {
+                LOGE("Export failed at %lld us", (long long)pos);
+                failed = true;
+                break;
+            }
             
             // Update progress
             frameCount++;
@@ -355,6 +513,16 @@ bool VideoEngine::exportVideo(const ExportSettings& settings, ProgressCallback p
         
         m_exporting = false;
         
+        if (failed) {
+            if (m_errorCallback) {
+                m_errorCallback(-1, "Export failed: the encoder rejected a frame");
+            }
+            if (m_progressCallback) {
+                m_progressCallback(static_cast<float>(frameCount) / totalFrames, "Export failed");
+            }
+            return;
+        }
+        
         if (m_progressCallback) {
             m_progressCallback(1.0f, "Export complete");
         }
@@ -403,28 +571,226 @@ void VideoEngine::renderLoop() {
 }
 
 void VideoEngine::updatePreview() {
-    if (!m_previewSurface) return;
+    std::lock_guard<std::mutex> lock(m_previewMutex);
+    
+    if (!m_previewSurface || !m_frameBuffer) return;
+    
+    DirtyRegion dirty = renderPreview(m_currentPosition);
+    if (dirty.isEmpty()) {
+        return;  // Nothing changed since the last post
+    }
+    m_previewRevision++;
     
-    VideoFrame frame = getPreviewFrame(m_currentPosition);
+    const VideoFrame& frame = m_frameBuffer->getRetainedFrame();
+    Rect bounds = dirty.bounds();
+    ARect dirtyBounds = {bounds.x, bounds.y, bounds.right(), bounds.bottom()};
     
     ANativeWindow_Buffer buffer;
-    if (ANativeWindow_lock(m_previewSurface, &buffer, nullptr) == 0) {
-        // Copy frame data to surface buffer
+    if (ANativeWindow_lock(m_previewSurface, &buffer, &dirtyBounds) == 0) {
+        // The window may grow the dirty bounds (e.g. on a fresh buffer), so copy what it asks for
+        int left = std::max(0, dirtyBounds.left);
+        int top = std::max(0, dirtyBounds.top);
+        int right = std::min({dirtyBounds.right, frame.width, buffer.width});
+        int bottom = std::min({dirtyBounds.bottom, frame.height, buffer.height});
+        
         uint8_t* dst = static_cast<uint8_t*>(buffer.bits);
         const uint8_t* src = frame.data.data();
         
         int srcStride = frame.width * 4;
         int dstStride = buffer.stride * 4;
         
-        for (int y = 0; y < frame.height && y < buffer.height; y++) {
-            memcpy(dst + y * dstStride, src + y * srcStride, 
-                   std::min(srcStride, dstStride));
+        for (int y = top; y < bottom; y++) {
+            memcpy(dst + y * dstStride + left * 4, src + y * srcStride + left * 4,
+                   (right - left) * 4);
         }
         
         ANativeWindow_unlockAndPost(m_previewSurface);
     }
 }
 
+std::shared_ptr<const VideoFrame> VideoEngine::getClipFrame(const TimelineClip& clip, int64_t sourcePts) {
+    uint64_t programHash = m_filterManager ? m_filterManager->getProgramHash(clip.id) : 0;
+    FrameCacheKey key = {clip.filePath, sourcePts, programHash};
+    
+    if (m_frameCache) {
+        auto cached = m_frameCache->get(key);
+        if (cached) {
+            return cached;  // Same source frame through the same filters - skip decode and filtering
+        }
+    }
+    
+    auto frame = std::make_shared<VideoFrame>(m_decoder->decodeFrame(clip.filePath, sourcePts));
+    if (frame->data.empty()) {
+        return frame;  // Decode failures aren't cached so the next request retries
+    }
+    
+    // Stored under the program that actually ran, which an edit since the lookup may have replaced
+    if (m_filterManager) {
+        auto program = m_filterManager->applyFilters(*frame, clip.id);
+        key.programHash = program ? program->hash() : 0;
+    }
+    if (m_frameCache) {
+        m_frameCache->put(key, clip.id, frame);
+    }
+    return frame;
+}
+
+std::shared_ptr<const VideoFrame> VideoEngine::getClipFrameAt(const TimelineClip& clip, int64_t position) {
+    int64_t sourcePts = sourceTime(clip, position);
+    if (!clip.interpolateFrames || clip.speed >= 1.0f || !m_frameInterpolator) {
+        return getClipFrame(clip, sourcePts);
+    }
+    
+    // Requests go to the source frame grid rather than sourcePts, so the many
+    // output frames between two source frames hit the cache instead of decoding
+    int fps = m_decoder->getFps(clip.filePath);
+    int64_t period = 1000000 / (fps > 0 ? fps : 30);
+    
+    // Nothing is requested past the trimmed end (or the file's real end): a
+    // request beyond the last frame would drive the decoder into end of stream
+    int64_t sourceEnd = clip.sourceDuration - clip.trimEnd;
+    int64_t fileDuration = m_decoder->getDuration(clip.filePath);
+    if (fileDuration > 0) {
+        sourceEnd = std::min(sourceEnd, fileDuration);
+    }
+    sourcePts = std::max(clip.trimStart, std::min(sourcePts, sourceEnd - 1));
+    int64_t slot = sourcePts - sourcePts % period;
+    
+    std::shared_ptr<const VideoFrame> before = getClipFrame(clip, slot);
+    std::shared_ptr<const VideoFrame> after;
+    if (before->data.empty()) {
+        return before;
+    }
+    if (before->timestamp_us > sourcePts) {
+        after = before;  // Timestamps sit off the grid; the frame before is a slot earlier
+        before = getClipFrame(clip, std::max(clip.trimStart, slot - period));
+    } else if (before->timestamp_us + period >= sourceEnd) {
+        return before;  // Last frame of the clip; hold it
+    } else {
+        after = getClipFrame(clip, before->timestamp_us + 1);
+    }
+    if (before->data.empty() || after->data.empty() ||
+        before->timestamp_us > sourcePts || after->timestamp_us <= before->timestamp_us) {
+        return after->data.empty() ? before : after;
+    }
+    
+    float t = static_cast<float>(sourcePts - before->timestamp_us) / (after->timestamp_us - before->timestamp_us);
+    if (t < kMinInterpolation) return before;
+    if (t > 1.0f - kMinInterpolation) return after;
+    
+    // The in-between frame isn't cached: it is only shown once, and the motion
+    // field that makes it is
+    auto frame = std::make_shared<VideoFrame>();
+    if (!m_frameInterpolator->interpolate(clip.filePath, *before, *after, t, *frame)) {
+        return t < 0.5f ? before : after;  // Across a cut, hold the nearer frame
+    }
+    frame->timestamp_us = sourcePts;
+    return frame;
+}
+
+void VideoEngine::compositeClips(VideoFrame& dest, const Rect& region, const std::vector<TimelineClip>& clips,
+                                 const std::vector<ActiveTransition>& transitions,
+                                 const std::unordered_map<int, std::shared_ptr<const VideoFrame>>& frames) {
+    for (size_t i = 0; i < clips.size(); i++) {
+        const TimelineClip& clip = clips[i];
+        const ActiveTransition* active = nullptr;
+        int partner = findTransitionPartner(clips, i, transitions, active);
+        
+        if (partner < 0 || !m_transitionRenderer) {
+            m_frameBuffer->composite(dest, *frames.at(clip.id), clip, region);
+            continue;
+        }
+        if (partner < static_cast<int>(i)) {
+            continue;  // Already drawn along with its pair
+        }
+        
+        bool outgoing = active->transition.fromClipId == clip.id;
+        const TimelineClip& fromClip = outgoing ? clip : clips[partner];
+        const TimelineClip& toClip = outgoing ? clips[partner] : clip;
+        m_transitionRenderer->render(*m_frameBuffer, dest, region, *active,
+                                     *frames.at(fromClip.id), fromClip, *frames.at(toClip.id), toClip);
+    }
+}
+
+DirtyRegion VideoEngine::renderPreview(int64_t position) {
+    std::vector<TimelineClip> clips;
+    std::vector<ActiveTransition> transitions;
+    if (m_timeline && m_decoder) {
+        clips = m_timeline->getClipsAtPosition(position);
+        transitions = m_timeline->getTransitionsAtPosition(position);
+    }
+    
+    std::unordered_map<int, std::shared_ptr<const VideoFrame>> visible;
+    for (const auto& clip : clips) {
+        visible[clip.id] = getClipFrameAt(clip, position);
+    }
+    
+    std::vector<LayerState> layers;
+    
+    for (size_t i = 0; i < clips.size(); i++) {
+        const TimelineClip& clip = clips[i];
+        const VideoFrame& frame = *visible[clip.id];
+        
+        LayerState state;
+        state.layerId = clip.id;
+        state.bounds = frame.data.empty() ? Rect{0, 0, 0, 0} :
+            FrameBuffer::fitRect(frame.width, frame.height, m_projectWidth, m_projectHeight);
+        state.contentKey = sourceTime(clip, position);
+        state.revision = m_filterManager ? m_filterManager->getProgramHash(clip.id) : 0;
+        state.revision = combineHash(state.revision, clip.stabilization ? clip.stabilization->generation : 0);
+        state.revision = combineHash(state.revision, clip.interpolateFrames ? 1 : 0);
+        state.animated = false;
+        
+        // A transition pair is a single layer, redrawn every frame over everything it can reach
+        const ActiveTransition* active = nullptr;
+        int partner = findTransitionPartner(clips, i, transitions, active);
+        if (partner >= 0) {
+            if (partner < static_cast<int>(i)) {
+                continue;
+            }
+            const VideoFrame& other = *visible[clips[partner].id];
+            Rect otherBounds = other.data.empty() ? Rect{0, 0, 0, 0} :
+                FrameBuffer::fitRect(other.width, other.height, m_projectWidth, m_projectHeight);
+            bool outgoing = active->transition.fromClipId == clip.id;
+            state.bounds = TransitionRenderer::bounds(active->transition.type,
+                outgoing ? state.bounds : otherBounds, outgoing ? otherBounds : state.bounds,
+                m_projectWidth, m_projectHeight);
+            state.animated = true;
+        }
+        layers.push_back(state);
+    }
+    
+    // Stickers sit above every clip, captions above the stickers
+    if (m_stickerOverlays) {
+        m_stickerOverlays->collectLayers(position, m_projectWidth, m_projectHeight, layers);
+    }
+    if (m_textOverlays) {
+        m_textOverlays->collectLayers(position, m_projectWidth, m_projectHeight, layers);
+    }
+    
+    // Held here as well as in the cache, so eviction can't pull a frame that is on screen
+    m_visibleLayers = std::move(visible);
+    
+    DirtyRegion dirty = m_frameBuffer->beginFrame(layers);
+    
+    VideoFrame& output = m_frameBuffer->getRetainedFrame();
+    output.timestamp_us = position;
+    
+    // Redraw every layer, bottom to top, but only inside the dirty rectangles
+    for (const Rect& rect : dirty.rects()) {
+        m_frameBuffer->clearRect(rect);
+        compositeClips(output, rect, clips, transitions, m_visibleLayers);
+        if (m_stickerOverlays) {
+            m_stickerOverlays->composite(output, rect, position);
+        }
+        if (m_textOverlays) {
+            m_textOverlays->composite(output, rect, position);
+        }
+    }
+    
+    return dirty;
+}
+
 void VideoEngine::processFrame(VideoFrame& frame) {
     // Apply any global effects/processing here
 }
@@ -432,31 +798,196 @@ void VideoEngine::processFrame(VideoFrame& frame) {
 // Text overlay
 int VideoEngine::addText(const std::string& text, int64_t startTime, int64_t duration,
                          float x, float y, float fontSize, uint32_t color) {
-    // TODO: Implement text overlay
+    if (!m_textOverlays) return -1;
     LOGI("Adding text: %s at (%f, %f)", text.c_str(), x, y);
-    return 0;
+    return m_textOverlays->addText(text, startTime, duration, x, y, fontSize, color);
 }
 
-bool VideoEngine::updateText(int textId, const std::string& text) {
-    // TODO: Implement
-    return true;
+bool VideoEngine::updateText(int textId, const std::string& text, float fontSize) {
+    return m_textOverlays ? m_textOverlays->updateText(textId, text, fontSize) : false;
+}
+
+bool VideoEngine::setTextAnimation(int textId, const std::string& animation, int64_t duration) {
+    TextAnimation type;
+    if (!TextOverlayManager::toTextAnimation(animation, type)) {
+        LOGW("Unknown text animation %s", animation.c_str());
+        return false;
+    }
+    return m_textOverlays ? m_textOverlays->setAnimation(textId, type, duration) : false;
 }
 
 bool VideoEngine::removeText(int textId) {
-    // TODO: Implement
+    return m_textOverlays ? m_textOverlays->removeText(textId) : false;
+}
+
+bool VideoEngine::addGlyph(float fontSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                           int stride, int bearingX, int bearingY, int advance) {
+    if (!m_textOverlays) return false;
+    return m_textOverlays->addGlyph(fontSize, codepoint, coverage, width, height, stride,
+                                    bearingX, bearingY, advance);
+}
+
+std::vector<uint32_t> VideoEngine::getMissingGlyphs(const std::string& text, float fontSize) {
+    return m_textOverlays ? m_textOverlays->getMissingGlyphs(text, fontSize) : std::vector<uint32_t>();
+}
+
+// Stickers
+int VideoEngine::addStickerImage(const uint8_t* pixels, int width, int height, int stride, bool premultiplied) {
+    return m_stickerOverlays ? m_stickerOverlays->addImage(pixels, width, height, stride, premultiplied) : -1;
+}
+
+bool VideoEngine::removeStickerImage(int imageId) {
+    return m_stickerOverlays ? m_stickerOverlays->removeImage(imageId) : false;
+}
+
+int VideoEngine::addSticker(int imageId, float x, float y, int64_t startTime, int64_t duration) {
+    if (!m_stickerOverlays) return -1;
+    LOGI("Adding sticker with image %d at (%f, %f)", imageId, x, y);
+    return m_stickerOverlays->addSticker(imageId, x, y, startTime, duration);
+}
+
+bool VideoEngine::removeSticker(int stickerId) {
+    return m_stickerOverlays ? m_stickerOverlays->removeSticker(stickerId) : false;
+}
+
+bool VideoEngine::setStickerTransform(int stickerId, float x, float y, float scale, float rotation, float alpha) {
+    return m_stickerOverlays ? m_stickerOverlays->setTransform(stickerId, x, y, scale, rotation, alpha) : false;
+}
+
+bool VideoEngine::setStickerTimeRange(int stickerId, int64_t startTime, int64_t duration) {
+    return m_stickerOverlays ? m_stickerOverlays->setTimeRange(stickerId, startTime, duration) : false;
+}
+
+bool VideoEngine::setStickerAnimation(int stickerId, const std::string& animation, int64_t duration) {
+    StickerAnimation type;
+    if (!StickerOverlayManager::toStickerAnimation(animation, type)) {
+        LOGW("Unknown sticker animation %s", animation.c_str());
+        return false;
+    }
+    return m_stickerOverlays ? m_stickerOverlays->setAnimation(stickerId, type, duration) : false;
+}
+
+// Background replacement
+bool VideoEngine::compositeMask(VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight,
+                                const MaskCompositeParams& params) {
+    if (!m_maskCompositor) return false;
+    return m_maskCompositor->apply(frame, matte, matteWidth, matteHeight, matteWidth, params);
+}
+
+void VideoEngine::setMaskBackgroundImage(const uint8_t* pixels, int width, int height, int stride) {
+    if (m_maskCompositor) {
+        m_maskCompositor->setBackgroundImage(pixels, width, height, stride);
+    }
+}
+
+// Scopes
+bool VideoEngine::getScopes(uint32_t scopes, ScopeData& out) {
+    if (!m_videoScopes) return false;
+    
+    std::lock_guard<std::mutex> lock(m_previewMutex);
+    
+    // Without a surface nothing keeps the retained frame current, so render one
+    if (!m_previewSurface || !m_frameBuffer) {
+        VideoFrame frame = getPreviewFrame(m_currentPosition);
+        return m_videoScopes->compute(frame, scopes, out);
+    }
+    
+    if (m_scopeFlags != scopes || m_scopeRevision != m_previewRevision) {
+        m_scopeFlags = 0;
+        if (!m_videoScopes->compute(m_frameBuffer->getRetainedFrame(), scopes, m_scopes)) {
+            return false;
+        }
+        m_scopeFlags = scopes;
+        m_scopeRevision = m_previewRevision;
+    }
+    out = m_scopes;
     return true;
 }
 
+// Auto enhance
+bool VideoEngine::analyzeAutoEnhance(int clipId, AutoEnhanceResult& out) {
+    TimelineClip clip;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TimelineClip* found = m_timeline ? m_timeline->getClip(clipId) : nullptr;
+        if (!found) return false;
+        clip = *found;
+    }
+    
+    // A decoder of its own, like scene detection and stabilisation, so the
+    // analysis neither holds nor flushes the one preview and export share
+    VideoDecoder decoder;
+    if (!decoder.initialize() || !decoder.openFile(clip.filePath)) {
+        return false;
+    }
+    
+    // Keyframes decode on their own, with no run of frames before them
+    int64_t start = clip.trimStart;
+    int64_t end = std::max(start + 1, clip.sourceDuration - clip.trimEnd);
+    std::vector<int64_t> keyframes = decoder.getKeyframeTimes(clip.filePath, start, end);
+    if (keyframes.empty()) {
+        keyframes.push_back(start);
+    }
+    
+    AutoEnhance analyser;
+    analyser.setThreadPool(m_threadPool.get());
+    size_t count = std::min(keyframes.size(), kAutoEnhanceFrames);
+    for (size_t i = 0; i < count; i++) {
+        VideoFrame frame = decoder.decodeFrame(clip.filePath, keyframes[i * keyframes.size() / count]);
+        if (!frame.data.empty()) {
+            analyser.addFrame(frame);
+        }
+    }
+    
+    LOGI("Auto enhance of clip %d from %d of %zu keyframes", clipId, analyser.frameCount(), keyframes.size());
+    return analyser.analyse(out);
+}
+
+// Stabilisation
+bool VideoEngine::stabilizeClip(int clipId) {
+    TimelineClip clip;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TimelineClip* found = m_timeline ? m_timeline->getClip(clipId) : nullptr;
+        if (!found || !m_videoStabilizer) return false;
+        clip = *found;
+    }
+    
+    // Analysed without the lock; the clip may be gone by the time it finishes
+    auto track = m_videoStabilizer->analyse(clip.filePath, clip.trimStart, clip.sourceDuration - clip.trimEnd);
+    if (!track) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline && m_timeline->setClipStabilization(clipId, std::move(track));
+}
+
+bool VideoEngine::removeStabilization(int clipId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline && m_timeline->setClipStabilization(clipId, nullptr);
+}
+
 // Transitions
-bool VideoEngine::addTransition(int clipId1, int clipId2, const std::string& transitionType, int64_t duration) {
-    // TODO: Implement transitions
+int VideoEngine::addTransition(int clipId1, int clipId2, const std::string& transitionType, int64_t duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    TransitionType type;
+    if (!TransitionRenderer::toTransitionType(transitionType, type)) {
+        LOGW("Unknown transition type %s", transitionType.c_str());
+        return -1;
+    }
+    if (!m_timeline) {
+        return -1;
+    }
+    
     LOGI("Adding transition: %s between clips %d and %d", transitionType.c_str(), clipId1, clipId2);
-    return true;
+    return m_timeline->addTransition(clipId1, clipId2, type, duration);
 }
 
 bool VideoEngine::removeTransition(int transitionId) {
-    // TODO: Implement
-    return true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline ? m_timeline->removeTransition(transitionId) : false;
 }
 
 // Audio
@@ -6,9 +6,21 @@
 #include "video_encoder.h"
 #include "audio_engine.h"
 #include "frame_buffer.h"
+#include "frame_cache.h"
 #include "timeline.h"
+#include "scene_detector.h"
+#include "video_stabilizer.h"
+#include "frame_interpolator.h"
+#include "transition_renderer.h"
+#include "sticker_overlay.h"
+#include "text_overlay.h"
+#include "../filters/auto_enhance.h"
 #include "../filters/filter_manager.h"
+#include "../filters/mask_compositor.h"
+#include "../filters/pixel_kernels.h"
+#include "../filters/video_scopes.h"
 #include "../utils/thread_pool.h"
+#include <unordered_map>
 
 namespace videoeditor {
 
@@ -33,6 +45,16 @@ public:
     bool trimClip(int clipId, int64_t startTrim, int64_t endTrim);
     bool splitClip(int clipId, int64_t position);
     bool setClipSpeed(int clipId, float speed);
+
+    // Below 1x, show motion-interpolated frames between source frames instead of repeating them
+    bool setClipFrameInterpolation(int clipId, bool enabled);
+
+    // Shot changes in a clip's trimmed source, as source times in microseconds.
+    // Decodes the file in parallel GOP ranges, so call it off the UI thread.
+    std::vector<int64_t> detectSceneCuts(int clipId);
+
+    // Split a clip at source times (e.g. detectSceneCuts) in one batch; returns the new clip IDs
+    std::vector<int> splitClipAtSourceTimes(int clipId, const std::vector<int64_t>& sourceTimes);
     bool setClipVolume(int clipId, float volume);
 
     // Playback
@@ -53,16 +75,50 @@ public:
     bool removeFilter(int clipId, int filterId);
     bool updateFilter(int clipId, int filterId, const EffectParams& params);
 
-    // Transitions
-    bool addTransition(int clipId1, int clipId2, const std::string& transitionType, int64_t duration);
+    // Transitions; returns the transition ID, -1 if the clips or type are invalid
+    int addTransition(int clipId1, int clipId2, const std::string& transitionType, int64_t duration);
     bool removeTransition(int transitionId);
 
     // Text overlay
     int addText(const std::string& text, int64_t startTime, int64_t duration,
                 float x, float y, float fontSize, uint32_t color);
-    bool updateText(int textId, const std::string& text);
+    bool updateText(int textId, const std::string& text, float fontSize);
+    bool setTextAnimation(int textId, const std::string& animation, int64_t duration);
     bool removeText(int textId);
 
+    // Glyphs for text layers, rasterised by the platform and uploaded once per size
+    bool addGlyph(float fontSize, uint32_t codepoint, const uint8_t* coverage, int width, int height,
+                  int stride, int bearingX, int bearingY, int advance);
+    std::vector<uint32_t> getMissingGlyphs(const std::string& text, float fontSize);
+
+    // Stickers; images are uploaded once (RGBA) and shared by every sticker that shows them
+    int addStickerImage(const uint8_t* pixels, int width, int height, int stride, bool premultiplied);
+    bool removeStickerImage(int imageId);
+    int addSticker(int imageId, float x, float y, int64_t startTime, int64_t duration);
+    bool removeSticker(int stickerId);
+    bool setStickerTransform(int stickerId, float x, float y, float scale, float rotation, float alpha);
+    bool setStickerTimeRange(int stickerId, int64_t startTime, int64_t duration);
+    bool setStickerAnimation(int stickerId, const std::string& animation, int64_t duration);
+
+    // Background replacement: composite an RGBA frame in place from a segmentation
+    // matte of any resolution (8-bit, 255 = foreground)
+    bool compositeMask(VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight,
+                       const MaskCompositeParams& params);
+    void setMaskBackgroundImage(const uint8_t* pixels, int width, int height, int stride);
+
+    // Scopes of the current preview frame (ScopeFlags mask); with a preview surface
+    // they are recomputed only once the posted frame has changed
+    bool getScopes(uint32_t scopes, ScopeData& out);
+
+    // Auto levels and white balance for a clip's source, from its keyframes;
+    // decodes with a decoder of its own, so it can run beside preview and export
+    bool analyzeAutoEnhance(int clipId, AutoEnhanceResult& out);
+
+    // Analyse a clip's camera shake and stabilise it from then on; decodes every
+    // frame of the trimmed source, so call it off the UI thread
+    bool stabilizeClip(int clipId);
+    bool removeStabilization(int clipId);
+
     // Audio
     bool addAudioTrack(const std::string& filePath, int64_t position);
     bool removeAudioTrack(int audioId);
@@ -87,6 +143,32 @@ private:
     void processFrame(VideoFrame& frame);
     void updatePreview();
 
+    // Incrementally recomposite the retained preview frame; caller holds m_previewMutex
+    DirtyRegion renderPreview(int64_t position);
+
+    // Decoded + filtered frame of the clip at the given source PTS, from the cache if possible
+    std::shared_ptr<const VideoFrame> getClipFrame(const TimelineClip& clip, int64_t sourcePts);
+
+    // Frame of the clip at a timeline position; a slowed clip with interpolation on
+    // gets one synthesised between the source frames either side
+    std::shared_ptr<const VideoFrame> getClipFrameAt(const TimelineClip& clip, int64_t position);
+
+    // Composite the clips bottom to top inside region; a transition's pair is drawn once, at the lower clip
+    void compositeClips(VideoFrame& dest, const Rect& region, const std::vector<TimelineClip>& clips,
+                        const std::vector<ActiveTransition>& transitions,
+                        const std::unordered_map<int, std::shared_ptr<const VideoFrame>>& frames);
+
+    // Filtered frames kept across scrubbing and pauses; ~16 frames at 1080p
+    static constexpr size_t kFrameCacheBytes = 128 * 1024 * 1024;
+
+    // Motion fields kept for interpolated slow motion; ~500 frame pairs
+    static constexpr size_t kMotionCacheBytes = 16 * 1024 * 1024;
+    // Within this fraction of the gap from a source frame, that frame is shown as is
+    static constexpr float kMinInterpolation = 1.0f / 32.0f;
+
+    // Keyframes decoded at most by analyzeAutoEnhance, spread over the clip
+    static constexpr size_t kAutoEnhanceFrames = 12;
+
     // Project settings
     int m_projectWidth;
     int m_projectHeight;
@@ -99,10 +181,27 @@ private:
     std::unique_ptr<AudioEngine> m_audioEngine;
     std::unique_ptr<FilterManager> m_filterManager;
     std::unique_ptr<FrameBuffer> m_frameBuffer;
+    std::unique_ptr<FrameCache> m_frameCache;
+    std::unique_ptr<TransitionRenderer> m_transitionRenderer;
+    std::unique_ptr<StickerOverlayManager> m_stickerOverlays;
+    std::unique_ptr<TextOverlayManager> m_textOverlays;
+    std::unique_ptr<MaskCompositor> m_maskCompositor;
+    std::unique_ptr<VideoScopes> m_videoScopes;
+    std::unique_ptr<SceneDetector> m_sceneDetector;
+    std::unique_ptr<VideoStabilizer> m_videoStabilizer;
+    std::unique_ptr<FrameInterpolator> m_frameInterpolator;
     std::unique_ptr<ThreadPool> m_threadPool;
 
     // Preview surface
     ANativeWindow* m_previewSurface;
+    std::unordered_map<int, std::shared_ptr<const VideoFrame>> m_visibleLayers;  // clipId -> frame
+    std::mutex m_previewMutex;
+    uint64_t m_previewRevision;         // Bumped whenever a changed frame is posted
+
+    // Last scopes of the posted frame; guarded by m_previewMutex
+    ScopeData m_scopes;
+    uint32_t m_scopeFlags;
+    uint64_t m_scopeRevision;
 
     // State
     std::atomic<bool> m_initialized;
@@ -0,0 +1,172 @@
+#include "video_stabilizer.h"
+#include "video_decoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace videoeditor {
+
+namespace {
+
+// Tracks are told apart by this rather than by address, which a new track can reuse
+uint64_t nextGeneration() {
+    static std::atomic<uint64_t> counter(1);
+    return counter.fetch_add(1);
+}
+
+}  // namespace
+
+const FrameTransform* StabilizationTrack::find(int64_t time) const {
+    if (transforms.empty()) {
+        return nullptr;
+    }
+    auto it = std::upper_bound(times.begin(), times.end(), time);
+    if (it == times.begin()) {
+        return &transforms.front();  // Before the first analysed frame; hold its correction
+    }
+    return &transforms[(it - times.begin()) - 1];
+}
+
+VideoStabilizer::VideoStabilizer()
+    : m_threadPool(nullptr) {
+    LOGI("VideoStabilizer created");
+}
+
+VideoStabilizer::~VideoStabilizer() {
+    LOGI("VideoStabilizer destroyed");
+}
+
+void VideoStabilizer::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+    m_estimator.setThreadPool(pool);
+}
+
+std::shared_ptr<StabilizationTrack> VideoStabilizer::analyse(const std::string& filePath, int64_t start,
+                                                             int64_t end) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    // From the keyframe at or before start, so every frame of the range is decoded
+    VideoDecoder decoder;
+    if (end <= start || !decoder.initialize() || !decoder.openFile(filePath) ||
+        !decoder.seekTo(filePath, start, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC)) {
+        return nullptr;
+    }
+    
+    // Camera path: the frame-to-frame motion summed up. Adding the rotation and
+    // log-scale terms treats each step as small, which they are between frames.
+    std::vector<int64_t> times;
+    std::vector<float> pathX, pathY, pathAngle, pathScale;
+    float x = 0.0f, y = 0.0f, angle = 0.0f, logScale = 0.0f;
+    int width = 0;
+    int height = 0;
+    int failed = 0;
+    
+    while (true) {
+        VideoFrame frame = decoder.decodeNextFrame(filePath);
+        if (frame.data.empty() || frame.timestamp_us >= end) {
+            break;
+        }
+        if (frame.timestamp_us < start) {
+            continue;  // Lead-in from the keyframe before start
+        }
+        
+        LumaPyramid& current = m_pyramids[times.size() & 1];
+        current.build(frame, kAnalysisWidth, kPyramidLevels, m_threadPool);
+        
+        if (!times.empty()) {
+            // A failed fit (cut, flat or blurred frame) counts as no motion rather than a jump
+            GlobalMotion motion;
+            const LumaPyramid& previous = m_pyramids[(times.size() - 1) & 1];
+            if (m_estimator.estimate(previous, current, m_field) && MotionEstimator::fitGlobalMotion(m_field, motion)) {
+                x += motion.dx;
+                y += motion.dy;
+                angle += motion.angle;
+                logScale += std::log(motion.scale);
+            } else {
+                failed++;
+            }
+        }
+        
+        width = frame.width;
+        height = frame.height;
+        times.push_back(frame.timestamp_us);
+        pathX.push_back(x);
+        pathY.push_back(y);
+        pathAngle.push_back(angle);
+        pathScale.push_back(logScale);
+    }
+    
+    if (times.empty() || width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    
+    size_t count = times.size();
+    int64_t interval = count > 1 ? std::max<int64_t>(1, (times.back() - times.front()) / static_cast<int64_t>(count - 1))
+                                 : 33333;
+    int radius = static_cast<int>(std::min<int64_t>(kSmoothingUs / interval, static_cast<int64_t>(count)));
+    
+    std::vector<float> smoothX, smoothY, smoothAngle, smoothScale;
+    smoothPath(pathX, radius, smoothX);
+    smoothPath(pathY, radius, smoothY);
+    smoothPath(pathAngle, radius, smoothAngle);
+    smoothPath(pathScale, radius, smoothScale);
+    
+    // Each correction moves its frame from the real path onto the smooth one, clamped
+    // so a sudden pan is followed rather than fought. The zoom is the largest any
+    // frame needs for its moved, rotated and scaled picture to cover the output.
+    auto track = std::make_shared<StabilizationTrack>();
+    track->times = std::move(times);
+    track->transforms.resize(count);
+    float maxShiftX = kMaxShift * width;
+    float maxShiftY = kMaxShift * height;
+    float aspect = std::max(static_cast<float>(width) / height, static_cast<float>(height) / width);
+    float zoom = 1.0f;
+    for (size_t i = 0; i < count; i++) {
+        FrameTransform& t = track->transforms[i];
+        t.dx = std::max(-maxShiftX, std::min(maxShiftX, smoothX[i] - pathX[i]));
+        t.dy = std::max(-maxShiftY, std::min(maxShiftY, smoothY[i] - pathY[i]));
+        t.angle = std::max(-kMaxAngle, std::min(kMaxAngle, smoothAngle[i] - pathAngle[i]));
+        t.scale = std::exp(std::max(-0.1f, std::min(0.1f, smoothScale[i] - pathScale[i])));
+        
+        float shift = 1.0f + 2.0f * std::max(std::fabs(t.dx) / width, std::fabs(t.dy) / height);
+        float turn = std::cos(std::fabs(t.angle)) + std::sin(std::fabs(t.angle)) * aspect;
+        zoom = std::max(zoom, shift * turn / t.scale);
+    }
+    track->zoom = std::min(kMaxZoom, zoom);
+    track->generation = nextGeneration();
+    
+    LOGI("Stabilised %zu frames (%d without a motion fit), radius %d, zoom %.3f",
+        count, failed, radius, track->zoom);
+    return track;
+}
+
+void VideoStabilizer::smoothPath(const std::vector<float>& path, int radius, std::vector<float>& out) {
+    int count = static_cast<int>(path.size());
+    out.resize(count);
+    if (radius <= 0) {
+        out = path;
+        return;
+    }
+    
+    // Sigma of a third of the radius, so the cut-off tails carry almost no weight
+    std::vector<float> weights(radius + 1);
+    float sigma = std::max(1.0f, radius / 3.0f);
+    for (int k = 0; k <= radius; k++) {
+        weights[k] = std::exp(-0.5f * k * k / (sigma * sigma));
+    }
+    
+    for (int i = 0; i < count; i++) {
+        int first = std::max(0, i - radius);
+        int last = std::min(count - 1, i + radius);
+        float sum = 0.0f;
+        float total = 0.0f;
+        for (int j = first; j <= last; j++) {
+            float w = weights[std::abs(j - i)];
+            sum += path[j] * w;
+            total += w;
+        }
+        out[i] = sum / total;
+    }
+}
+
+}  // namespace videoeditor
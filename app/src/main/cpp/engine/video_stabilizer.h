@@ -0,0 +1,67 @@
+#ifndef VIDEO_EDITOR_VIDEO_STABILIZER_H
+#define VIDEO_EDITOR_VIDEO_STABILIZER_H
+
+#include "common.h"
+#include "../utils/motion_estimation.h"
+
+namespace videoeditor {
+
+// Correction for one frame, in source pixels about the frame centre: the
+// picture is scaled and rotated by (scale, angle) and then moved by (dx, dy)
+struct FrameTransform {
+    float dx = 0.0f;
+    float dy = 0.0f;
+    float angle = 0.0f;     // Radians, clockwise
+    float scale = 1.0f;
+};
+
+// Per-frame corrections for part of one source file, by source timestamp.
+// FrameBuffer::composite applies them in its sampling pass.
+struct StabilizationTrack {
+    std::vector<int64_t> times;             // Decoded frame timestamps, ascending
+    std::vector<FrameTransform> transforms;
+    float zoom = 1.0f;                      // Crop that keeps the corrected frames covering the picture
+    uint64_t generation = 0;                // Unique per analysis, nonzero; marks the layer changed
+
+    // Transform of the frame shown at time (the last one at or before it, or the
+    // first for earlier times); null only for an empty track
+    const FrameTransform* find(int64_t time) const;
+};
+
+// Analysis pass for handheld footage. Every frame's luma pyramid is matched
+// against the previous one (MotionEstimator), the fitted camera motion is
+// summed into a path, and the difference between a smoothed path and the
+// real one becomes each frame's correction.
+class VideoStabilizer {
+public:
+    VideoStabilizer();
+    ~VideoStabilizer();
+
+    // Motion search and pyramid rows run on the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Corrections for the frames in [start, end) of the file; null if nothing decodes
+    std::shared_ptr<StabilizationTrack> analyse(const std::string& filePath, int64_t start, int64_t end);
+
+private:
+    // Gaussian moving average of path, radius samples each side; the window is
+    // renormalised where it runs off either end
+    static void smoothPath(const std::vector<float>& path, int radius, std::vector<float>& out);
+
+    static constexpr int kAnalysisWidth = 480;          // Level-0 pyramid width
+    static constexpr int kPyramidLevels = 3;
+    static constexpr int64_t kSmoothingUs = 1000000;    // Half-width of the smoothing window
+    static constexpr float kMaxShift = 0.06f;           // Of the frame size, per axis
+    static constexpr float kMaxAngle = 0.05f;           // Radians, about 3 degrees
+    static constexpr float kMaxZoom = 1.2f;
+
+    MotionEstimator m_estimator;
+    LumaPyramid m_pyramids[2];
+    MotionField m_field;
+    ThreadPool* m_threadPool;
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_VIDEO_STABILIZER_H
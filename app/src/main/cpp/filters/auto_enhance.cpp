@@ -0,0 +1,125 @@
+#include "auto_enhance.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videoeditor {
+
+namespace {
+
+constexpr int kBins = VideoScopes::kHistogramBins;
+
+// Lowest bin below which no more than fraction of the samples lie
+int lowPercentile(const uint64_t* bins, uint64_t total, float fraction) {
+    uint64_t limit = static_cast<uint64_t>(static_cast<double>(total) * fraction);
+    uint64_t count = 0;
+    for (int i = 0; i < kBins; i++) {
+        count += bins[i];
+        if (count > limit) return i;
+    }
+    return kBins - 1;
+}
+
+int highPercentile(const uint64_t* bins, uint64_t total, float fraction) {
+    uint64_t limit = static_cast<uint64_t>(static_cast<double>(total) * fraction);
+    uint64_t count = 0;
+    for (int i = kBins - 1; i >= 0; i--) {
+        count += bins[i];
+        if (count > limit) return i;
+    }
+    return 0;
+}
+
+}  // namespace
+
+std::vector<ColorOpParams> AutoEnhanceResult::ops() const {
+    return {
+        {ColorOp::Levels, 1.0f, {black, white, gamma}},
+        {ColorOp::Temperature, temperature, {0.0f, 255.0f, 1.0f}},
+        {ColorOp::Tint, tint, {0.0f, 255.0f, 1.0f}}
+    };
+}
+
+AutoEnhance::AutoEnhance()
+    : m_histogram(4 * kBins, 0)
+    , m_frames(0) {
+    LOGI("AutoEnhance created");
+}
+
+AutoEnhance::~AutoEnhance() {
+    LOGI("AutoEnhance destroyed");
+}
+
+void AutoEnhance::setThreadPool(ThreadPool* pool) {
+    m_scopes.setThreadPool(pool);
+}
+
+void AutoEnhance::reset() {
+    std::fill(m_histogram.begin(), m_histogram.end(), 0);
+    m_frames = 0;
+}
+
+bool AutoEnhance::addFrame(const VideoFrame& frame) {
+    if (!m_scopes.compute(frame, kScopeHistogram, m_frameScopes)) {
+        return false;
+    }
+    
+    // Weighted by samples, which VideoScopes keeps about equal for every frame size
+    for (size_t i = 0; i < m_histogram.size(); i++) {
+        m_histogram[i] += m_frameScopes.histogram[i];
+    }
+    m_frames++;
+    return true;
+}
+
+bool AutoEnhance::analyse(AutoEnhanceResult& out) const {
+    const uint64_t* luma = m_histogram.data() + 3 * kBins;
+    uint64_t total = 0;
+    for (int i = 0; i < kBins; i++) {
+        total += luma[i];
+    }
+    if (m_frames == 0 || total == 0) {
+        return false;
+    }
+    
+    // Levels from the luma percentiles, so clipping one channel can't tint the picture
+    AutoEnhanceResult result;
+    result.black = std::min(kMaxBlack, static_cast<float>(lowPercentile(luma, total, kClipFraction)));
+    result.white = std::max(kMinWhite, static_cast<float>(highPercentile(luma, total, kClipFraction)) + 1.0f);
+    float range = result.white - result.black;
+    
+    // Gamma that brings the median to mid-grey
+    float median = static_cast<float>(lowPercentile(luma, total, 0.5f)) + 0.5f;
+    float t = std::max(0.01f, std::min(0.99f, (median - result.black) / range));
+    result.gamma = std::max(kMinGamma, std::min(kMaxGamma, std::log(t) / std::log(0.5f)));
+    
+    // Trimmed channel means, taken through the levels above
+    float means[3];
+    for (int c = 0; c < 3; c++) {
+        const uint64_t* bins = m_histogram.data() + c * kBins;
+        int low = lowPercentile(bins, total, kTrimFraction);
+        int high = highPercentile(bins, total, kTrimFraction);
+        double sum = 0.0;
+        uint64_t count = 0;
+        for (int i = low; i <= high; i++) {
+            sum += static_cast<double>(bins[i]) * i;
+            count += bins[i];
+        }
+        float mean = count ? static_cast<float>(sum / count) : 128.0f;
+        float level = std::max(0.0f, std::min(1.0f, (mean - result.black) / range));
+        means[c] = 255.0f * std::pow(level, 1.0f / result.gamma);
+    }
+    
+    // Grey world: offsets that pull every channel mean to their average. Temperature
+    // moves R and B by +-30 * value, tint G by 30 * value and R, B by -15 * value.
+    float grey = (means[0] + means[1] + means[2]) / 3.0f;
+    float dr = (grey - means[0]) * kBalanceStrength;
+    float dg = (grey - means[1]) * kBalanceStrength;
+    float db = (grey - means[2]) * kBalanceStrength;
+    result.temperature = std::max(-kMaxBalance, std::min(kMaxBalance, (dr - db) / 60.0f));
+    result.tint = std::max(-kMaxBalance, std::min(kMaxBalance, (dg - (dr + db) * 0.5f) / 45.0f));
+    
+    out = result;
+    return true;
+}
+
+}  // namespace videoeditor
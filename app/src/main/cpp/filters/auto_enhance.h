@@ -0,0 +1,70 @@
+#ifndef VIDEO_EDITOR_AUTO_ENHANCE_H
+#define VIDEO_EDITOR_AUTO_ENHANCE_H
+
+#include "common.h"
+#include "color_filter.h"
+#include "color_lut.h"
+#include "video_scopes.h"
+
+namespace videoeditor {
+
+// Corrections found by AutoEnhance, in the units of the "levels",
+// "temperature" and "tint" filters
+struct AutoEnhanceResult {
+    float black = 0.0f;         // Levels: black point, white point (0-255) and gamma
+    float white = 255.0f;
+    float gamma = 1.0f;
+    float temperature = 0.0f;   // -1 to 1
+    float tint = 0.0f;
+
+    // Levels, temperature and tint as colour ops, in the order they apply
+    std::vector<ColorOpParams> ops() const;
+
+    // The ops baked into per-channel tables
+    ColorLut1D lut() const { return ColorLut1D(ops()); }
+};
+
+// Auto levels and white balance. Histograms of each frame added are summed
+// (VideoScopes' strided pass, so a frame costs the same at any size); the
+// luma percentiles set the levels and the grey-world balance of the trimmed
+// channel means sets temperature and tint.
+class AutoEnhance {
+public:
+    AutoEnhance();
+    ~AutoEnhance();
+
+    void setThreadPool(ThreadPool* pool);
+
+    void reset();
+
+    // Add an RGBA frame to the statistics
+    bool addFrame(const VideoFrame& frame);
+
+    // Corrections for the frames added so far; false if there are none
+    bool analyse(AutoEnhanceResult& out) const;
+
+    int frameCount() const { return m_frames; }
+
+private:
+    // Fraction of samples clipped at each end by the levels
+    static constexpr float kClipFraction = 0.005f;
+    // Fraction of each channel left out of its mean at each end
+    static constexpr float kTrimFraction = 0.01f;
+    // Stretch limits, so a dark or low-key shot isn't forced to full range
+    static constexpr float kMaxBlack = 48.0f;
+    static constexpr float kMinWhite = 192.0f;
+    static constexpr float kMinGamma = 0.8f;
+    static constexpr float kMaxGamma = 1.25f;
+    // Share of the grey-world cast removed; a scene can be coloured on purpose
+    static constexpr float kBalanceStrength = 0.7f;
+    static constexpr float kMaxBalance = 0.5f;
+
+    VideoScopes m_scopes;
+    ScopeData m_frameScopes;
+    std::vector<uint64_t> m_histogram;  // R, G, B, luma
+    int m_frames;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_AUTO_ENHANCE_H
@@ -1,9 +1,185 @@
 #include "blur_filter.h"
 #include <cmath>
+#include <algorithm>
 
 namespace videoeditor {
 
-BlurFilter::BlurFilter() {
+namespace {
+
+// Columns processed together by the vertical pass; the running sums for one
+// block (kColumnBlock * 4 channels) stay in L1
+constexpr int kColumnBlock = 256;
+
+// Keeps 255 * count * count below 2^32 so the reciprocal divide stays exact
+constexpr int kMaxBoxRadius = 2000;
+
+constexpr int kMaxMotionDistance = 256;
+
+// Fewer rows per band than this isn't worth a thread hand-off
+constexpr int kMinBandRows = 16;
+
+// floor(sum / count) as a multiply; exact while sum * count < 2^32
+inline uint8_t divide(uint32_t sum, uint64_t reciprocal) {
+    return static_cast<uint8_t>((sum * reciprocal) >> 32);
+}
+
+// Columns per vertical block of the recursive Gaussian; its causal buffer is
+// height * block * 4 floats per worker
+constexpr int kRecursiveColumnBlock = 32;
+
+inline uint8_t toByte(float v) {
+    return static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, v + 0.5f)));
+}
+
+// Third-order recursive Gaussian (Young & van Vliet, 1995). A causal and an
+// anti-causal pass together approximate the kernel at a fixed cost of six
+// multiply-adds per sample, whatever sigma is. Samples outside the frame
+// count as zero and each output is divided by the part of the kernel that
+// fell inside, the same edge handling as the direct convolution.
+struct RecursiveGaussian {
+    float b;            // Input gain, B in the paper
+    float a[3];         // Feedback on the previous three outputs, b1..b3 / b0
+    float tail[3][3];   // Last three causal outputs -> first three anti-causal states
+    
+    explicit RecursiveGaussian(float sigma) {
+        sigma = std::max(sigma, 0.5f);
+        float q = sigma >= 2.5f
+            ? 0.98711f * sigma - 0.96330f
+            : 3.97156f - 4.14554f * std::sqrt(1.0f - 0.26891f * sigma);
+        float q2 = q * q;
+        float q3 = q2 * q;
+        float b0 = 1.57825f + 2.44413f * q + 1.4281f * q2 + 0.422205f * q3;
+        a[0] = (2.44413f * q + 2.85619f * q2 + 1.26661f * q3) / b0;
+        a[1] = -(1.4281f * q2 + 1.26661f * q3) / b0;
+        a[2] = 0.422205f * q3 / b0;
+        b = 1.0f - (a[0] + a[1] + a[2]);
+        
+        // The causal response keeps ringing past the last sample. Rather than run
+        // it out on every line, follow each unit state out once and record where
+        // the anti-causal pass must start (the Triggs-Sdika boundary matrix)
+        int length = static_cast<int>(sigma * 12.0f) + 32;
+        std::vector<double> w(length + 3);
+        for (int j = 0; j < 3; j++) {
+            std::fill(w.begin(), w.end(), 0.0);
+            w[2 - j] = 1.0;  // w[0..2] = w[N-3], w[N-2], w[N-1]
+            for (int i = 3; i < length + 3; i++) {
+                w[i] = a[0] * w[i - 1] + a[1] * w[i - 2] + a[2] * w[i - 3];
+            }
+            double y1 = 0, y2 = 0, y3 = 0;
+            for (int i = length + 2; i >= 3; i--) {
+                double y = b * w[i] + a[0] * y1 + a[1] * y2 + a[2] * y3;
+                y3 = y2;
+                y2 = y1;
+                y1 = y;
+            }
+            // y1..y3 now hold y[N], y[N+1], y[N+2]
+            tail[0][j] = static_cast<float>(y1);
+            tail[1][j] = static_cast<float>(y2);
+            tail[2][j] = static_cast<float>(y3);
+        }
+    }
+    
+    inline void startBackward(float w1, float w2, float w3, float& y1, float& y2, float& y3) const {
+        y1 = tail[0][0] * w1 + tail[0][1] * w2 + tail[0][2] * w3;
+        y2 = tail[1][0] * w1 + tail[1][1] * w2 + tail[1][2] * w3;
+        y3 = tail[2][0] * w1 + tail[2][1] * w2 + tail[2][2] * w3;
+    }
+    
+    // 1 / (filtered line of ones): renormalises the clipped kernel near the edges
+    std::vector<float> edgeGains(int count) const {
+        std::vector<float> gains(count);
+        float w1 = 0, w2 = 0, w3 = 0;
+        for (int i = 0; i < count; i++) {
+            float w = b + a[0] * w1 + a[1] * w2 + a[2] * w3;
+            gains[i] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+        }
+        float y1, y2, y3;
+        startBackward(w1, w2, w3, y1, y2, y3);
+        for (int i = count - 1; i >= 0; i--) {
+            float y = b * gains[i] + a[0] * y1 + a[1] * y2 + a[2] * y3;
+            gains[i] = 1.0f / y;
+            y3 = y2;
+            y2 = y1;
+            y1 = y;
+        }
+        return gains;
+    }
+    
+    // One row of `count` pixels with `lanes` interleaved channels
+    void filter(const uint8_t* src, uint8_t* dst, float* causal, const float* gains,
+                int count, int lanes) const {
+        for (int c = 0; c < lanes; c++) {
+            float w1 = 0, w2 = 0, w3 = 0;
+            for (int i = 0; i < count; i++) {
+                float w = b * src[i * lanes + c] + a[0] * w1 + a[1] * w2 + a[2] * w3;
+                causal[i * lanes + c] = w;
+                w3 = w2;
+                w2 = w1;
+                w1 = w;
+            }
+            
+            float y1, y2, y3;
+            startBackward(w1, w2, w3, y1, y2, y3);
+            for (int i = count - 1; i >= 0; i--) {
+                float y = b * causal[i * lanes + c] + a[0] * y1 + a[1] * y2 + a[2] * y3;
+                dst[i * lanes + c] = toByte(y * gains[i]);
+                y3 = y2;
+                y2 = y1;
+                y1 = y;
+            }
+        }
+    }
+    
+    // Down `count` rows of `lanes` adjacent bytes; each step touches one contiguous segment
+    void filterColumns(const uint8_t* src, uint8_t* dst, float* causal, const float* gains,
+                       int count, size_t stride, int lanes) const {
+        // Rolling three-row history; h1 is the newest
+        float history[3][kRecursiveColumnBlock * 4] = {};
+        float* h1 = history[0];
+        float* h2 = history[1];
+        float* h3 = history[2];
+        
+        for (int i = 0; i < count; i++) {
+            const uint8_t* row = src + i * stride;
+            float* w = causal + i * lanes;
+            for (int c = 0; c < lanes; c++) {
+                w[c] = b * row[c] + a[0] * h1[c] + a[1] * h2[c] + a[2] * h3[c];
+                h3[c] = w[c];
+            }
+            float* newest = h3;
+            h3 = h2;
+            h2 = h1;
+            h1 = newest;
+        }
+        
+        for (int c = 0; c < lanes; c++) {
+            startBackward(h1[c], h2[c], h3[c], h1[c], h2[c], h3[c]);
+        }
+        
+        for (int i = count - 1; i >= 0; i--) {
+            const float* w = causal + i * lanes;
+            uint8_t* out = dst + i * stride;
+            float gain = gains[i];
+            for (int c = 0; c < lanes; c++) {
+                float y = b * w[c] + a[0] * h1[c] + a[1] * h2[c] + a[2] * h3[c];
+                out[c] = toByte(y * gain);
+                h3[c] = y;
+            }
+            float* newest = h3;
+            h3 = h2;
+            h2 = h1;
+            h1 = newest;
+        }
+    }
+};
+
+}  // namespace
+
+BlurFilter::BlurFilter()
+    : m_threadPool(nullptr) {
     LOGI("BlurFilter created");
 }
 
@@ -16,134 +192,302 @@ void BlurFilter::apply(VideoFrame& frame, int radius) {
 }
 
 void BlurFilter::boxBlur(VideoFrame& frame, int radius) {
-    if (radius <= 0) return;
+    boxBlurBuffer(frame.data.data(), frame.width, frame.height, 4, radius);
+}
+
+void BlurFilter::boxBlurPlane(uint8_t* plane, int width, int height, int radius) {
+    boxBlurBuffer(plane, width, height, 1, radius);
+}
+
+void BlurFilter::boxBlurBuffer(uint8_t* data, int width, int height, int channels, int radius) {
+    if (radius <= 0 || width <= 0 || height <= 0) return;
     
-    std::vector<uint8_t> temp(frame.data.size());
+    // A window wider than the frame averages the same pixels as one that just covers it
+    radius = std::min({radius, std::max(width, height), kMaxBoxRadius});
     
-    // Two-pass box blur (horizontal then vertical)
-    horizontalBlur(frame.data.data(), temp.data(), frame.width, frame.height, radius);
-    verticalBlur(temp.data(), frame.data.data(), frame.width, frame.height, radius);
+    int kernelSize = radius * 2 + 1;
+    if (static_cast<int>(m_reciprocals.size()) != kernelSize + 1) {
+        m_reciprocals.resize(kernelSize + 1);
+        m_reciprocals[0] = 0;
+        for (int count = 1; count <= kernelSize; count++) {
+            m_reciprocals[count] = (1ULL << 32) / count + 1;
+        }
+    }
+    m_temp.resize(static_cast<size_t>(width) * height * channels);
+    uint8_t* temp = m_temp.data();
+    
+    // Two-pass box blur (horizontal then vertical); the second pass needs all of the first
+    forEachBand(height, [=](int rowBegin, int rowEnd) {
+        horizontalBlur(data, temp, width, channels, rowBegin, rowEnd, radius);
+    });
+    forEachBand(height, [=](int rowBegin, int rowEnd) {
+        verticalBlur(temp, data, width, height, channels, rowBegin, rowEnd, radius);
+    });
 }
 
-void BlurFilter::horizontalBlur(uint8_t* src, uint8_t* dst, int width, int height, int radius) {
-    int kernelSize = radius * 2 + 1;
+void BlurFilter::forEachBand(int height, const std::function<void(int, int)>& body) {
+    if (m_threadPool) {
+        m_threadPool->parallelFor(0, height, kMinBandRows, body);
+    } else {
+        body(0, height);
+    }
+}
+
+void BlurFilter::horizontalBlur(const uint8_t* src, uint8_t* dst, int width, int channels,
+                                int rowBegin, int rowEnd, int radius) {
+    const uint64_t* reciprocals = m_reciprocals.data();
+    const size_t stride = static_cast<size_t>(width) * channels;
     
-    for (int y = 0; y < height; y++) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const uint8_t* in = src + y * stride;
+        uint8_t* out = dst + y * stride;
+        
+        // Window for x = 0 covers [0, radius]
+        uint32_t sum[4] = {0, 0, 0, 0};
+        int last = std::min(radius, width - 1);
+        for (int x = 0; x <= last; x++) {
+            for (int c = 0; c < channels; c++) {
+                sum[c] += in[x * channels + c];
+            }
+        }
+        
         for (int x = 0; x < width; x++) {
-            int sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-            int count = 0;
+            // Edge windows are clipped to the row, matching the old per-tap bounds check
+            int count = std::min(x + radius, width - 1) - std::max(x - radius, 0) + 1;
+            uint64_t reciprocal = reciprocals[count];
+            for (int c = 0; c < channels; c++) {
+                out[x * channels + c] = divide(sum[c], reciprocal);
+            }
             
-            for (int kx = -radius; kx <= radius; kx++) {
-                int sx = x + kx;
-                if (sx >= 0 && sx < width) {
-                    int idx = (y * width + sx) * 4;
-                    sumR += src[idx + 0];
-                    sumG += src[idx + 1];
-                    sumB += src[idx + 2];
-                    sumA += src[idx + 3];
-                    count++;
+            int enter = x + radius + 1;
+            int leave = x - radius;
+            if (enter < width) {
+                for (int c = 0; c < channels; c++) {
+                    sum[c] += in[enter * channels + c];
+                }
+            }
+            if (leave >= 0) {
+                for (int c = 0; c < channels; c++) {
+                    sum[c] -= in[leave * channels + c];
                 }
             }
-            
-            int dstIdx = (y * width + x) * 4;
-            dst[dstIdx + 0] = sumR / count;
-            dst[dstIdx + 1] = sumG / count;
-            dst[dstIdx + 2] = sumB / count;
-            dst[dstIdx + 3] = sumA / count;
         }
     }
 }
 
-void BlurFilter::verticalBlur(uint8_t* src, uint8_t* dst, int width, int height, int radius) {
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-            int count = 0;
+void BlurFilter::verticalBlur(const uint8_t* src, uint8_t* dst, int width, int height, int channels,
+                              int rowBegin, int rowEnd, int radius) {
+    const uint64_t* reciprocals = m_reciprocals.data();
+    const size_t stride = static_cast<size_t>(width) * channels;
+    uint32_t sums[kColumnBlock * 4];
+    
+    // Slide a window of whole row segments down each column block, so every
+    // step reads two contiguous rows instead of walking a column
+    for (int blockX = 0; blockX < width; blockX += kColumnBlock) {
+        int blockChannels = std::min(kColumnBlock, width - blockX) * channels;
+        const uint8_t* column = src + static_cast<size_t>(blockX) * channels;
+        uint8_t* outColumn = dst + static_cast<size_t>(blockX) * channels;
+        
+        std::fill(sums, sums + blockChannels, 0u);
+        int first = std::max(rowBegin - radius, 0);
+        int last = std::min(rowBegin + radius, height - 1);
+        for (int y = first; y <= last; y++) {
+            const uint8_t* row = column + y * stride;
+            for (int i = 0; i < blockChannels; i++) {
+                sums[i] += row[i];
+            }
+        }
+        
+        for (int y = rowBegin; y < rowEnd; y++) {
+            int count = std::min(y + radius, height - 1) - std::max(y - radius, 0) + 1;
+            uint64_t reciprocal = reciprocals[count];
+            uint8_t* out = outColumn + y * stride;
+            for (int i = 0; i < blockChannels; i++) {
+                out[i] = divide(sums[i], reciprocal);
+            }
             
-            for (int ky = -radius; ky <= radius; ky++) {
-                int sy = y + ky;
-                if (sy >= 0 && sy < height) {
-                    int idx = (sy * width + x) * 4;
-                    sumR += src[idx + 0];
-                    sumG += src[idx + 1];
-                    sumB += src[idx + 2];
-                    sumA += src[idx + 3];
-                    count++;
+            int enter = y + radius + 1;
+            int leave = y - radius;
+            if (enter < height) {
+                const uint8_t* row = column + enter * stride;
+                for (int i = 0; i < blockChannels; i++) {
+                    sums[i] += row[i];
+                }
+            }
+            if (leave >= 0) {
+                const uint8_t* row = column + leave * stride;
+                for (int i = 0; i < blockChannels; i++) {
+                    sums[i] -= row[i];
                 }
             }
-            
-            int dstIdx = (y * width + x) * 4;
-            dst[dstIdx + 0] = sumR / count;
-            dst[dstIdx + 1] = sumG / count;
-            dst[dstIdx + 2] = sumB / count;
-            dst[dstIdx + 3] = sumA / count;
         }
     }
 }
 
 void BlurFilter::gaussianBlur(VideoFrame& frame, int radius) {
-    if (radius <= 0) return;
+    if (radius <= 0 || frame.width <= 0 || frame.height <= 0) return;
     
+    // Short kernels (up to 17 taps) are cheapest convolved directly, and the
+    // recursive approximation is loosest at those small sigmas; past that the
+    // recursive filter costs the same at any sigma
+    if (radius <= kMaxDirectGaussianRadius) {
+        directGaussian(frame, radius);
+    } else {
+        recursiveGaussian(frame, radius / 3.0f);
+    }
+}
+
+void BlurFilter::directGaussian(VideoFrame& frame, int radius) {
     std::vector<float> kernel = createGaussianKernel(radius);
-    std::vector<uint8_t> temp(frame.data.size());
+    m_temp.resize(frame.data.size());
     
-    int kernelSize = radius * 2 + 1;
+    uint8_t* data = frame.data.data();
+    uint8_t* temp = m_temp.data();
+    const float* weights = kernel.data();
+    int width = frame.width;
+    int height = frame.height;
+    size_t stride = static_cast<size_t>(width) * 4;
     
-    // Horizontal pass
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            float sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-            float sumWeight = 0;
-            
-            for (int kx = -radius; kx <= radius; kx++) {
-                int sx = x + kx;
-                if (sx >= 0 && sx < frame.width) {
-                    int idx = (y * frame.width + sx) * 4;
-                    float weight = kernel[kx + radius];
-                    sumR += frame.data[idx + 0] * weight;
-                    sumG += frame.data[idx + 1] * weight;
-                    sumB += frame.data[idx + 2] * weight;
-                    sumA += frame.data[idx + 3] * weight;
-                    sumWeight += weight;
+    // Clipped windows at the frame edges are renormalised, as before; the
+    // full kernel already sums to one
+    auto edgeScale = [weights, radius](int pos, int size) {
+        float sum = 0;
+        for (int k = std::max(-radius, -pos); k <= std::min(radius, size - 1 - pos); k++) {
+            sum += weights[k + radius];
+        }
+        return 1.0f / sum;
+    };
+    
+    forEachBand(height, [=](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            const uint8_t* in = data + y * stride;
+            uint8_t* out = temp + y * stride;
+            for (int x = 0; x < width; x++) {
+                int kBegin = std::max(-radius, -x);
+                int kEnd = std::min(radius, width - 1 - x);
+                float scale = (kBegin == -radius && kEnd == radius) ? 1.0f : edgeScale(x, width);
+                
+                float sum[4] = {0, 0, 0, 0};
+                for (int k = kBegin; k <= kEnd; k++) {
+                    const uint8_t* px = in + (x + k) * 4;
+                    float weight = weights[k + radius];
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += px[c] * weight;
+                    }
+                }
+                for (int c = 0; c < 4; c++) {
+                    out[x * 4 + c] = static_cast<uint8_t>(sum[c] * scale + 0.5f);
                 }
             }
-            
-            int dstIdx = (y * frame.width + x) * 4;
-            temp[dstIdx + 0] = static_cast<uint8_t>(sumR / sumWeight);
-            temp[dstIdx + 1] = static_cast<uint8_t>(sumG / sumWeight);
-            temp[dstIdx + 2] = static_cast<uint8_t>(sumB / sumWeight);
-            temp[dstIdx + 3] = static_cast<uint8_t>(sumA / sumWeight);
         }
-    }
+    });
     
-    // Vertical pass
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            float sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-            float sumWeight = 0;
+    // Vertical pass accumulates whole weighted rows, so memory is read in order
+    forEachBand(height, [=](int rowBegin, int rowEnd) {
+        std::vector<float> acc(stride);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            int kBegin = std::max(-radius, -y);
+            int kEnd = std::min(radius, height - 1 - y);
+            float scale = (kBegin == -radius && kEnd == radius) ? 1.0f : edgeScale(y, height);
             
-            for (int ky = -radius; ky <= radius; ky++) {
-                int sy = y + ky;
-                if (sy >= 0 && sy < frame.height) {
-                    int idx = (sy * frame.width + x) * 4;
-                    float weight = kernel[ky + radius];
-                    sumR += temp[idx + 0] * weight;
-                    sumG += temp[idx + 1] * weight;
-                    sumB += temp[idx + 2] * weight;
-                    sumA += temp[idx + 3] * weight;
-                    sumWeight += weight;
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int k = kBegin; k <= kEnd; k++) {
+                const uint8_t* row = temp + (y + k) * stride;
+                float weight = weights[k + radius] * scale;
+                for (size_t i = 0; i < stride; i++) {
+                    acc[i] += row[i] * weight;
                 }
             }
             
-            int dstIdx = (y * frame.width + x) * 4;
-            frame.data[dstIdx + 0] = static_cast<uint8_t>(sumR / sumWeight);
-            frame.data[dstIdx + 1] = static_cast<uint8_t>(sumG / sumWeight);
-            frame.data[dstIdx + 2] = static_cast<uint8_t>(sumB / sumWeight);
-            frame.data[dstIdx + 3] = static_cast<uint8_t>(sumA / sumWeight);
+            uint8_t* out = data + y * stride;
+            for (size_t i = 0; i < stride; i++) {
+                out[i] = static_cast<uint8_t>(acc[i] + 0.5f);
+            }
+        }
+    });
+}
+
+void BlurFilter::recursiveGaussian(VideoFrame& frame, float sigma) {
+    const RecursiveGaussian coef(sigma);
+    m_temp.resize(frame.data.size());
+    
+    uint8_t* data = frame.data.data();
+    uint8_t* temp = m_temp.data();
+    int width = frame.width;
+    int height = frame.height;
+    size_t stride = static_cast<size_t>(width) * 4;
+    
+    const std::vector<float> rowGains = coef.edgeGains(width);
+    const std::vector<float> columnGains = coef.edgeGains(height);
+    
+    // Horizontal: causal then anti-causal pass along each row
+    forEachBand(height, [=, &coef, &rowGains](int rowBegin, int rowEnd) {
+        std::vector<float> causal(stride);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            coef.filter(data + y * stride, temp + y * stride, causal.data(), rowGains.data(), width, 4);
         }
+    });
+    
+    // Vertical: the same recursion run down blocks of columns, one row segment at a time
+    int blocks = (width + kRecursiveColumnBlock - 1) / kRecursiveColumnBlock;
+    auto verticalBlocks = [=, &coef, &columnGains](int blockBegin, int blockEnd) {
+        std::vector<float> causal(static_cast<size_t>(height) * kRecursiveColumnBlock * 4);
+        for (int block = blockBegin; block < blockEnd; block++) {
+            int x = block * kRecursiveColumnBlock;
+            int lanes = std::min(kRecursiveColumnBlock, width - x) * 4;
+            coef.filterColumns(temp + x * 4, data + x * 4, causal.data(), columnGains.data(),
+                               height, stride, lanes);
+        }
+    };
+    if (m_threadPool) {
+        m_threadPool->parallelFor(0, blocks, 1, verticalBlocks);
+    } else {
+        verticalBlocks(0, blocks);
     }
 }
 
+bool BlurFilter::verifyRecursiveGaussian() {
+    // Noise plus hard-edged blocks, the worst case for the approximation; an odd
+    // size so partial column blocks are covered
+    const int width = 131;
+    const int height = 97;
+    VideoFrame source;
+    source.width = width;
+    source.height = height;
+    source.format = PixelFormat::RGBA;
+    source.data.resize(source.dataSize());
+    uint32_t state = 0x12345678u;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t* px = source.data.data() + (static_cast<size_t>(y) * width + x) * 4;
+            bool block = ((x / 16) + (y / 16)) % 2 == 0;
+            for (int c = 0; c < 4; c++) {
+                state = state * 1664525u + 1013904223u;
+                px[c] = block ? static_cast<uint8_t>(state >> 24) : (c == 3 ? 255 : 0);
+            }
+        }
+    }
+    
+    BlurFilter filter;
+    bool ok = true;
+    const int radii[] = {kMaxDirectGaussianRadius + 1, 12, 24, 48};
+    for (int radius : radii) {
+        VideoFrame direct = source;
+        VideoFrame recursive = source;
+        filter.directGaussian(direct, radius);
+        filter.recursiveGaussian(recursive, radius / 3.0f);
+        
+        int maxError = 0;
+        for (size_t i = 0; i < direct.data.size(); i++) {
+            maxError = std::max(maxError, std::abs(direct.data[i] - recursive.data[i]));
+        }
+        bool passed = maxError <= kRecursiveGaussianTolerance;
+        LOGI("Recursive Gaussian radius %d: max error %d (%s)", radius, maxError, passed ? "passed" : "FAILED");
+        ok &= passed;
+    }
+    return ok;
+}
+
 std::vector<float> BlurFilter::createGaussianKernel(int radius) {
     std::vector<float> kernel(radius * 2 + 1);
     float sigma = radius / 3.0f;
@@ -163,43 +507,115 @@ std::vector<float> BlurFilter::createGaussianKernel(int radius) {
     return kernel;
 }
 
-void BlurFilter::motionBlur(VideoFrame& frame, int angle, int distance) {
-    if (distance <= 0) return;
+const BlurFilter::MotionKernel& BlurFilter::motionKernel(int angle, int distance) {
+    MotionKernel& kernel = m_motionKernel;
+    if (!kernel.dx.empty() && kernel.angle == angle && kernel.distance == distance) {
+        return kernel;
+    }
     
     float radians = angle * M_PI / 180.0f;
-    float dx = std::cos(radians);
-    float dy = std::sin(radians);
+    float dirX = std::cos(radians);
+    float dirY = std::sin(radians);
+    
+    kernel.angle = angle;
+    kernel.distance = distance;
+    kernel.dx.clear();
+    kernel.dy.clear();
+    // The small bias snaps float noise (cos 90deg is not exactly 0) onto whole pixels
+    for (int d = -distance / 2; d <= distance / 2; d++) {
+        kernel.dx.push_back(static_cast<int>(std::floor(d * dirX + 1e-4f)));
+        kernel.dy.push_back(static_cast<int>(std::floor(d * dirY + 1e-4f)));
+    }
+    kernel.minDx = *std::min_element(kernel.dx.begin(), kernel.dx.end());
+    kernel.maxDx = *std::max_element(kernel.dx.begin(), kernel.dx.end());
+    kernel.minDy = *std::min_element(kernel.dy.begin(), kernel.dy.end());
+    kernel.maxDy = *std::max_element(kernel.dy.begin(), kernel.dy.end());
+    kernel.reciprocal = (1ULL << 32) / kernel.dx.size() + 1;
+    return kernel;
+}
+
+void BlurFilter::motionBlur(VideoFrame& frame, int angle, int distance) {
+    if (distance <= 0 || frame.width <= 0 || frame.height <= 0) return;
+    
+    // At most 257 taps, so a 16-bit accumulator can't overflow
+    distance = std::min(distance, kMaxMotionDistance);
+    
+    const MotionKernel& kernel = motionKernel(angle, distance);
+    m_temp.resize(frame.data.size());
     
-    std::vector<uint8_t> result(frame.data.size());
+    const uint8_t* src = frame.data.data();
+    uint8_t* dst = m_temp.data();
+    int width = frame.width;
+    int height = frame.height;
+    size_t stride = static_cast<size_t>(width) * 4;
+    int taps = static_cast<int>(kernel.dx.size());
     
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            float sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-            int count = 0;
+    // Pixels whose taps all land inside the frame
+    int interiorLeft = std::min(width, -kernel.minDx);
+    int interiorRight = std::max(interiorLeft, width - kernel.maxDx);
+    int interiorTop = -kernel.minDy;
+    int interiorBottom = height - kernel.maxDy;
+    
+    // Taps outside the frame are skipped and the rest averaged
+    auto edgePixel = [&kernel, src, dst, width, height, stride, taps](int x, int y) {
+        uint32_t sum[4] = {0, 0, 0, 0};
+        uint32_t count = 0;
+        for (int t = 0; t < taps; t++) {
+            int sx = x + kernel.dx[t];
+            int sy = y + kernel.dy[t];
+            if (sx >= 0 && sx < width && sy >= 0 && sy < height) {
+                const uint8_t* px = src + sy * stride + sx * 4;
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += px[c];
+                }
+                count++;
+            }
+        }
+        uint8_t* out = dst + y * stride + x * 4;
+        for (int c = 0; c < 4; c++) {
+            out[c] = static_cast<uint8_t>(count ? sum[c] / count : 0);
+        }
+    };
+    
+    forEachBand(height, [&, src, dst](int rowBegin, int rowEnd) {
+        // Interior rows sum whole shifted row segments, which vectorises cleanly
+        static thread_local std::vector<uint16_t> accumulator;
+        int spanChannels = (interiorRight - interiorLeft) * 4;
+        accumulator.resize(std::max(spanChannels, 0));
+        
+        for (int y = rowBegin; y < rowEnd; y++) {
+            if (y < interiorTop || y >= interiorBottom || spanChannels <= 0) {
+                for (int x = 0; x < width; x++) {
+                    edgePixel(x, y);
+                }
+                continue;
+            }
             
-            for (int d = -distance/2; d <= distance/2; d++) {
-                int sx = static_cast<int>(x + d * dx);
-                int sy = static_cast<int>(y + d * dy);
-                
-                if (sx >= 0 && sx < frame.width && sy >= 0 && sy < frame.height) {
-                    int idx = (sy * frame.width + sx) * 4;
-                    sumR += frame.data[idx + 0];
-                    sumG += frame.data[idx + 1];
-                    sumB += frame.data[idx + 2];
-                    sumA += frame.data[idx + 3];
-                    count++;
+            for (int x = 0; x < interiorLeft; x++) {
+                edgePixel(x, y);
+            }
+            
+            uint16_t* acc = accumulator.data();
+            std::fill(acc, acc + spanChannels, 0);
+            for (int t = 0; t < taps; t++) {
+                const uint8_t* segment = src + (y + kernel.dy[t]) * stride + (interiorLeft + kernel.dx[t]) * 4;
+                for (int i = 0; i < spanChannels; i++) {
+                    acc[i] += segment[i];
                 }
             }
+            uint8_t* out = dst + y * stride + interiorLeft * 4;
+            for (int i = 0; i < spanChannels; i++) {
+                out[i] = divide(acc[i], kernel.reciprocal);
+            }
             
-            int dstIdx = (y * frame.width + x) * 4;
-            result[dstIdx + 0] = static_cast<uint8_t>(sumR / count);
-            result[dstIdx + 1] = static_cast<uint8_t>(sumG / count);
-            result[dstIdx + 2] = static_cast<uint8_t>(sumB / count);
-            result[dstIdx + 3] = static_cast<uint8_t>(sumA / count);
+            for (int x = interiorRight; x < width; x++) {
+                edgePixel(x, y);
+            }
         }
-    }
+    });
     
-    frame.data = std::move(result);
+    // Result becomes the frame; the old buffer is kept as scratch for next time
+    frame.data.swap(m_temp);
 }
 
 }  // namespace videoeditor
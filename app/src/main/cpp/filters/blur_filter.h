@@ -2,26 +2,73 @@
 #define VIDEO_EDITOR_BLUR_FILTER_H
 
 #include "common.h"
+#include "thread_pool.h"
 
 namespace videoeditor {
 
 class BlurFilter {
 public:
+    // Gaussians up to this radius are convolved directly; larger ones use a
+    // recursive filter that needs whole columns
+    static constexpr int kMaxDirectGaussianRadius = 8;
+
+    // Largest channel difference the recursive path may have from direct convolution
+    static constexpr int kRecursiveGaussianTolerance = 7;
+
     BlurFilter();
     ~BlurFilter();
 
+    // Debug self-test: the recursive Gaussian against direct convolution of the
+    // same radius on random frames, within kRecursiveGaussianTolerance
+    static bool verifyRecursiveGaussian();
+
+    // Rows are split into bands across the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
     // Apply blur
     void apply(VideoFrame& frame, int radius);
 
     // Specific blur types
     void boxBlur(VideoFrame& frame, int radius);
+    void boxBlurPlane(uint8_t* plane, int width, int height, int radius);  // Single 8-bit channel
     void gaussianBlur(VideoFrame& frame, int radius);
     void motionBlur(VideoFrame& frame, int angle, int distance);
 
 private:
-    void horizontalBlur(uint8_t* src, uint8_t* dst, int width, int height, int radius);
-    void verticalBlur(uint8_t* src, uint8_t* dst, int width, int height, int radius);
+    // Integer tap offsets for one (angle, distance), rebuilt only when those change
+    struct MotionKernel {
+        int angle = 0;
+        int distance = 0;
+        std::vector<int> dx;
+        std::vector<int> dy;
+        int minDx = 0, maxDx = 0;
+        int minDy = 0, maxDy = 0;
+        uint64_t reciprocal = 0;  // 2^32 / taps + 1
+    };
+
+    const MotionKernel& motionKernel(int angle, int distance);
+
+    void boxBlurBuffer(uint8_t* data, int width, int height, int channels, int radius);
+
+    // Running-sum passes, O(1) per pixel; rows [rowBegin, rowEnd) of dst are written
+    void horizontalBlur(const uint8_t* src, uint8_t* dst, int width, int channels,
+                        int rowBegin, int rowEnd, int radius);
+    void verticalBlur(const uint8_t* src, uint8_t* dst, int width, int height, int channels,
+                      int rowBegin, int rowEnd, int radius);
     std::vector<float> createGaussianKernel(int radius);
+
+    // Gaussian with sigma = radius / 3: direct convolution for small radii,
+    // recursive filter (cost independent of sigma) above that
+    void directGaussian(VideoFrame& frame, int radius);
+    void recursiveGaussian(VideoFrame& frame, float sigma);
+
+    // Run body over row bands on the pool, or inline without one
+    void forEachBand(int height, const std::function<void(int, int)>& body);
+
+    ThreadPool* m_threadPool;
+    std::vector<uint8_t> m_temp;
+    std::vector<uint64_t> m_reciprocals;  // 2^32 / count + 1, for count = 0..kernelSize
+    MotionKernel m_motionKernel;
 };
 
 }  // namespace videoeditor
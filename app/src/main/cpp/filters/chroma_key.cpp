@@ -0,0 +1,63 @@
+#include "chroma_key.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videoeditor {
+
+namespace {
+
+// Chroma distance that tolerance and softness 1.0 stand for; the CbCr values
+// of saturated colours lie about this far from grey
+constexpr float kChromaRange = 128.0f;
+
+// Key directions shorter than this are too close to grey to say which hue is spill
+constexpr float kMinSpillChroma = 8.0f;
+
+}  // namespace
+
+ChromaKey::ChromaKey(uint32_t keyColor, float tolerance, float softness, float spill) {
+    int r = (keyColor >> 16) & 0xFF;
+    int g = (keyColor >> 8) & 0xFF;
+    int b = keyColor & 0xFF;
+    
+    // Same fixed-point chroma the kernel computes per pixel
+    ChromaKeyCoefficients& k = m_coefficients;
+    k.keyCb = static_cast<int16_t>((-43 * r - 85 * g + 128 * b) >> 8);
+    k.keyCr = static_cast<int16_t>((128 * r - 107 * g - 21 * b) >> 8);
+    k.inner = static_cast<int16_t>(std::max(0.0f, std::min(1.0f, tolerance)) * kChromaRange + 0.5f);
+    k.width = static_cast<int16_t>(std::max(1.0f, std::min(255.0f, softness * kChromaRange + 0.5f)));
+    k.rampQ8 = static_cast<uint16_t>((255 << 8) / k.width);
+    
+    // Spill removes the pixel's chroma along the key direction, keeping luma:
+    // dCb = -e * ux, dCr = -e * uy turned into R, G, B with the BT.601 inverse
+    float length = std::sqrt(static_cast<float>(k.keyCb * k.keyCb + k.keyCr * k.keyCr));
+    float amount = std::max(0.0f, std::min(1.0f, spill));
+    float ux = 0.0f;
+    float uy = 0.0f;
+    if (length >= kMinSpillChroma && amount > 0.0f) {
+        ux = k.keyCb / length;
+        uy = k.keyCr / length;
+    }
+    k.kx = static_cast<int16_t>(std::lround(ux * 127.0f));
+    k.ky = static_cast<int16_t>(std::lround(uy * 127.0f));
+    
+    const float delta[3] = {
+        -1.402f * uy,
+        0.344136f * ux + 0.714136f * uy,
+        -1.772f * ux
+    };
+    for (int c = 0; c < 3; c++) {
+        float q6 = std::max(-127.0f, std::min(127.0f, delta[c] * amount * 64.0f));
+        k.spill[c] = static_cast<int16_t>(std::lround(q6));
+    }
+}
+
+void ChromaKey::apply(VideoFrame& frame) const {
+    apply(frame.data.data(), frame.data.size() / 4);
+}
+
+void ChromaKey::apply(uint8_t* rgba, size_t pixelCount) const {
+    pixelKernels().chromaKey(rgba, pixelCount, m_coefficients);
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,34 @@
+#ifndef VIDEO_EDITOR_CHROMA_KEY_H
+#define VIDEO_EDITOR_CHROMA_KEY_H
+
+#include "common.h"
+#include "pixel_kernels.h"
+
+namespace videoeditor {
+
+// Green/blue screen key. Distance to the key colour is measured in the CbCr
+// plane only, so shadows and folds in the screen key out like its lit parts.
+// Pixels within the tolerance get alpha 0, then alpha ramps up to opaque over
+// the softness; spill suppression takes the key hue out of what remains. The
+// result is straight-alpha RGBA, ready for FrameBuffer::composite.
+class ChromaKey {
+public:
+    // keyColor ARGB. tolerance and softness are 0-1 of the chroma range, spill 0-1.
+    ChromaKey(uint32_t keyColor, float tolerance, float softness, float spill);
+
+    void apply(VideoFrame& frame) const;
+    void apply(uint8_t* rgba, size_t pixelCount) const;
+
+    const ChromaKeyCoefficients& coefficients() const { return m_coefficients; }
+
+    static constexpr uint32_t kDefaultKeyColor = 0xFF00B140;  // Chroma green
+    static constexpr float kDefaultTolerance = 0.3f;
+    static constexpr float kDefaultSoftness = 0.1f;
+
+private:
+    ChromaKeyCoefficients m_coefficients;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_CHROMA_KEY_H
@@ -1,9 +1,18 @@
 #include "color_filter.h"
+#include "color_matrix.h"
 #include <cmath>
 #include <algorithm>
 
 namespace videoeditor {
 
+namespace {
+
+inline float clampChannel(float v) {
+    return std::max(0.0f, std::min(255.0f, v));
+}
+
+}  // namespace
+
 ColorFilter::ColorFilter() {
     LOGI("ColorFilter created");
 }
@@ -21,6 +30,10 @@ void ColorFilter::apply(VideoFrame& frame, const std::string& type, float intens
         adjustSaturation(frame, intensity);
     } else if (type == "hue") {
         adjustHue(frame, intensity);
+    } else if (type == "temperature") {
+        adjustTemperature(frame, intensity);
+    } else if (type == "tint") {
+        adjustTint(frame, intensity);
     } else if (type == "sepia") {
         applySepia(frame, intensity);
     } else if (type == "grayscale") {
@@ -29,6 +42,11 @@ void ColorFilter::apply(VideoFrame& frame, const std::string& type, float intens
         applyInvert(frame);
     } else if (type == "vignette") {
         applyVignette(frame, intensity);
+    } else {
+        ColorOp op;
+        if (toColorOp(type, op)) {
+            applyPreset(frame, op, intensity);
+        }
     }
 }
 
@@ -56,35 +74,11 @@ void ColorFilter::adjustContrast(VideoFrame& frame, float value) {
 }
 
 void ColorFilter::adjustSaturation(VideoFrame& frame, float value) {
-    for (size_t i = 0; i < frame.data.size(); i += 4) {
-        uint8_t r = frame.data[i + 0];
-        uint8_t g = frame.data[i + 1];
-        uint8_t b = frame.data[i + 2];
-        
-        float gray = 0.299f * r + 0.587f * g + 0.114f * b;
-        
-        frame.data[i + 0] = std::max(0, std::min(255, 
-            static_cast<int>(gray + value * (r - gray))));
-        frame.data[i + 1] = std::max(0, std::min(255, 
-            static_cast<int>(gray + value * (g - gray))));
-        frame.data[i + 2] = std::max(0, std::min(255, 
-            static_cast<int>(gray + value * (b - gray))));
-    }
+    ColorMatrix::saturation(value).apply(frame);
 }
 
 void ColorFilter::adjustHue(VideoFrame& frame, float degrees) {
-    float hueShift = degrees / 360.0f;
-    
-    for (size_t i = 0; i < frame.data.size(); i += 4) {
-        float h, s, l;
-        rgbToHsl(frame.data[i + 0], frame.data[i + 1], frame.data[i + 2], h, s, l);
-        
-        h += hueShift;
-        if (h > 1.0f) h -= 1.0f;
-        if (h < 0.0f) h += 1.0f;
-        
-        hslToRgb(h, s, l, frame.data[i + 0], frame.data[i + 1], frame.data[i + 2]);
-    }
+    ColorMatrix::hueRotation(degrees).apply(frame);
 }
 
 void ColorFilter::adjustTemperature(VideoFrame& frame, float value) {
@@ -108,36 +102,29 @@ void ColorFilter::adjustTint(VideoFrame& frame, float value) {
     }
 }
 
-void ColorFilter::applySepia(VideoFrame& frame, float intensity) {
+void ColorFilter::adjustLevels(VideoFrame& frame, float black, float white, float gamma) {
+    ColorOpParams params = {ColorOp::Levels, 1.0f, {black, white, gamma}};
+    
+    uint8_t table[256];
+    for (int v = 0; v < 256; v++) {
+        float r = v, g = v, b = v;
+        transformPixel(params, r, g, b);
+        table[v] = static_cast<uint8_t>(r + 0.5f);
+    }
+    
     for (size_t i = 0; i < frame.data.size(); i += 4) {
-        uint8_t r = frame.data[i + 0];
-        uint8_t g = frame.data[i + 1];
-        uint8_t b = frame.data[i + 2];
-        
-        int newR = static_cast<int>(0.393f * r + 0.769f * g + 0.189f * b);
-        int newG = static_cast<int>(0.349f * r + 0.686f * g + 0.168f * b);
-        int newB = static_cast<int>(0.272f * r + 0.534f * g + 0.131f * b);
-        
-        frame.data[i + 0] = std::max(0, std::min(255, 
-            static_cast<int>(r + intensity * (newR - r))));
-        frame.data[i + 1] = std::max(0, std::min(255, 
-            static_cast<int>(g + intensity * (newG - g))));
-        frame.data[i + 2] = std::max(0, std::min(255, 
-            static_cast<int>(b + intensity * (newB - b))));
+        frame.data[i + 0] = table[frame.data[i + 0]];
+        frame.data[i + 1] = table[frame.data[i + 1]];
+        frame.data[i + 2] = table[frame.data[i + 2]];
     }
 }
 
+void ColorFilter::applySepia(VideoFrame& frame, float intensity) {
+    ColorMatrix::sepia(intensity).apply(frame);
+}
+
 void ColorFilter::applyGrayscale(VideoFrame& frame) {
-    for (size_t i = 0; i < frame.data.size(); i += 4) {
-        uint8_t gray = static_cast<uint8_t>(
-            0.299f * frame.data[i + 0] + 
-            0.587f * frame.data[i + 1] + 
-            0.114f * frame.data[i + 2]);
-        
-        frame.data[i + 0] = gray;
-        frame.data[i + 1] = gray;
-        frame.data[i + 2] = gray;
-    }
+    ColorMatrix::grayscale().apply(frame);
 }
 
 void ColorFilter::applyInvert(VideoFrame& frame) {
@@ -149,14 +136,18 @@ void ColorFilter::applyInvert(VideoFrame& frame) {
 }
 
 void ColorFilter::applyVignette(VideoFrame& frame, float intensity) {
+    applyVignette(frame, intensity, 0, frame.height);
+}
+
+void ColorFilter::applyVignette(VideoFrame& frame, float intensity, int top, int fullHeight) {
     float centerX = frame.width / 2.0f;
-    float centerY = frame.height / 2.0f;
+    float centerY = fullHeight / 2.0f;
     float maxDist = std::sqrt(centerX * centerX + centerY * centerY);
     
     for (int y = 0; y < frame.height; y++) {
         for (int x = 0; x < frame.width; x++) {
             float dx = x - centerX;
-            float dy = y - centerY;
+            float dy = y + top - centerY;
             float dist = std::sqrt(dx * dx + dy * dy);
             float factor = 1.0f - intensity * std::pow(dist / maxDist, 2);
             factor = std::max(0.0f, factor);
@@ -169,60 +160,147 @@ void ColorFilter::applyVignette(VideoFrame& frame, float intensity) {
     }
 }
 
-void ColorFilter::rgbToHsl(uint8_t r, uint8_t g, uint8_t b, float& h, float& s, float& l) {
-    float rf = r / 255.0f;
-    float gf = g / 255.0f;
-    float bf = b / 255.0f;
-    
-    float maxVal = std::max({rf, gf, bf});
-    float minVal = std::min({rf, gf, bf});
-    float delta = maxVal - minVal;
+void ColorFilter::applyPreset(VideoFrame& frame, ColorOp preset, float intensity) {
+    ColorMatrix matrix;
+    if (!ColorMatrix::preset(preset, matrix)) {
+        return;
+    }
     
-    l = (maxVal + minVal) / 2.0f;
+    float amount = std::max(0.0f, std::min(1.0f, intensity));
+    matrix.lerpFromIdentity(amount).apply(frame);
     
-    if (delta == 0) {
-        h = 0;
-        s = 0;
-    } else {
-        s = l > 0.5f ? delta / (2.0f - maxVal - minVal) : delta / (maxVal + minVal);
-        
-        if (maxVal == rf) {
-            h = (gf - bf) / delta + (gf < bf ? 6.0f : 0.0f);
-        } else if (maxVal == gf) {
-            h = (bf - rf) / delta + 2.0f;
-        } else {
-            h = (rf - gf) / delta + 4.0f;
-        }
-        
-        h /= 6.0f;
+    float vignette = ColorMatrix::presetVignette(preset);
+    if (vignette > 0.0f) {
+        applyVignette(frame, vignette * amount);
     }
 }
 
-void ColorFilter::hslToRgb(float h, float s, float l, uint8_t& r, uint8_t& g, uint8_t& b) {
-    auto hueToRgb = [](float p, float q, float t) -> float {
-        if (t < 0) t += 1;
-        if (t > 1) t -= 1;
-        if (t < 1.0f/6.0f) return p + (q - p) * 6 * t;
-        if (t < 1.0f/2.0f) return q;
-        if (t < 2.0f/3.0f) return p + (q - p) * (2.0f/3.0f - t) * 6;
-        return p;
+bool ColorFilter::toColorOp(const std::string& type, ColorOp& op) {
+    static const std::pair<const char*, ColorOp> kOps[] = {
+        {"brightness", ColorOp::Brightness},
+        {"contrast", ColorOp::Contrast},
+        {"saturation", ColorOp::Saturation},
+        {"hue", ColorOp::Hue},
+        {"temperature", ColorOp::Temperature},
+        {"tint", ColorOp::Tint},
+        {"sepia", ColorOp::Sepia},
+        {"grayscale", ColorOp::Grayscale},
+        {"invert", ColorOp::Invert},
+        {"levels", ColorOp::Levels},
+        {"vintage", ColorOp::Vintage},
+        {"cool", ColorOp::Cool},
+        {"warm", ColorOp::Warm},
+        {"dramatic", ColorOp::Dramatic},
+        {"fade", ColorOp::Fade},
+        {"noir", ColorOp::Noir},
     };
     
-    float rf, gf, bf;
-    
-    if (s == 0) {
-        rf = gf = bf = l;
-    } else {
-        float q = l < 0.5f ? l * (1 + s) : l + s - l * s;
-        float p = 2 * l - q;
-        rf = hueToRgb(p, q, h + 1.0f/3.0f);
-        gf = hueToRgb(p, q, h);
-        bf = hueToRgb(p, q, h - 1.0f/3.0f);
+    for (const auto& entry : kOps) {
+        if (type == entry.first) {
+            op = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ColorFilter::isSeparable(ColorOp op) {
+    switch (op) {
+        case ColorOp::Brightness:
+        case ColorOp::Contrast:
+        case ColorOp::Temperature:
+        case ColorOp::Tint:
+        case ColorOp::Invert:
+        case ColorOp::Levels:
+            return true;
+        default:
+            return false;
     }
+}
+
+void ColorFilter::transformPixel(const ColorOpParams& params, float& r, float& g, float& b) {
+    float value = params.value;
     
-    r = static_cast<uint8_t>(rf * 255);
-    g = static_cast<uint8_t>(gf * 255);
-    b = static_cast<uint8_t>(bf * 255);
+    switch (params.op) {
+        case ColorOp::Brightness: {
+            float adjustment = static_cast<float>(static_cast<int>(value * 255));
+            r = clampChannel(r + adjustment);
+            g = clampChannel(g + adjustment);
+            b = clampChannel(b + adjustment);
+            break;
+        }
+        case ColorOp::Contrast: {
+            float factor = (259.0f * (value * 255 + 255)) / (255.0f * (259 - value * 255));
+            r = clampChannel(factor * (r - 128) + 128);
+            g = clampChannel(factor * (g - 128) + 128);
+            b = clampChannel(factor * (b - 128) + 128);
+            break;
+        }
+        case ColorOp::Saturation: {
+            float gray = 0.299f * r + 0.587f * g + 0.114f * b;
+            r = clampChannel(gray + value * (r - gray));
+            g = clampChannel(gray + value * (g - gray));
+            b = clampChannel(gray + value * (b - gray));
+            break;
+        }
+        case ColorOp::Hue:
+            ColorMatrix::hueRotation(value).transform(r, g, b);
+            break;
+        case ColorOp::Temperature: {
+            float adjust = static_cast<float>(static_cast<int>(value * 30));
+            r = clampChannel(r + adjust);
+            b = clampChannel(b - adjust);
+            break;
+        }
+        case ColorOp::Tint: {
+            float gAdjust = static_cast<float>(static_cast<int>(value * 30));
+            float mAdjust = static_cast<float>(static_cast<int>(-value * 15));
+            r = clampChannel(r + mAdjust);
+            g = clampChannel(g + gAdjust);
+            b = clampChannel(b + mAdjust);
+            break;
+        }
+        case ColorOp::Sepia: {
+            float newR = 0.393f * r + 0.769f * g + 0.189f * b;
+            float newG = 0.349f * r + 0.686f * g + 0.168f * b;
+            float newB = 0.272f * r + 0.534f * g + 0.131f * b;
+            r = clampChannel(r + value * (newR - r));
+            g = clampChannel(g + value * (newG - g));
+            b = clampChannel(b + value * (newB - b));
+            break;
+        }
+        case ColorOp::Grayscale: {
+            float gray = 0.299f * r + 0.587f * g + 0.114f * b;
+            r = g = b = gray;
+            break;
+        }
+        case ColorOp::Invert:
+            r = 255.0f - r;
+            g = 255.0f - g;
+            b = 255.0f - b;
+            break;
+        case ColorOp::Levels: {
+            float black = params.args[0];
+            float range = std::max(1.0f, params.args[1] - black);
+            float invGamma = 1.0f / std::max(0.1f, params.args[2]);
+            auto level = [&](float v) {
+                float t = std::max(0.0f, std::min(1.0f, (v - black) / range));
+                return 255.0f * std::pow(t, invGamma);
+            };
+            r = level(r);
+            g = level(g);
+            b = level(b);
+            break;
+        }
+        default: {
+            // Presets
+            ColorMatrix matrix;
+            if (ColorMatrix::fromColorOp(params, matrix)) {
+                matrix.transform(r, g, b);
+            }
+            break;
+        }
+    }
 }
 
 }  // namespace videoeditor
@@ -5,6 +5,34 @@
 
 namespace videoeditor {
 
+// Colour operations that only depend on the pixel value, not its position,
+// so any chain of them can be baked into a single lookup table
+enum class ColorOp {
+    Brightness,
+    Contrast,
+    Saturation,
+    Hue,
+    Temperature,
+    Tint,
+    Sepia,
+    Grayscale,
+    Invert,
+    Levels,
+    // VideoEffects presets; value is the blend from identity (0-1)
+    Vintage,
+    Cool,
+    Warm,
+    Dramatic,
+    Fade,
+    Noir
+};
+
+struct ColorOpParams {
+    ColorOp op;
+    float value;
+    float args[3];  // Extra arguments (levels: black point, white point, gamma)
+};
+
 class ColorFilter {
 public:
     ColorFilter();
@@ -20,16 +48,25 @@ public:
     void adjustHue(VideoFrame& frame, float degrees);       // -180 to 180
     void adjustTemperature(VideoFrame& frame, float value); // -1.0 to 1.0
     void adjustTint(VideoFrame& frame, float value);        // -1.0 to 1.0
+    void adjustLevels(VideoFrame& frame, float black, float white, float gamma);  // 0-255, 0-255, 0.1-10
 
     // Preset filters
     void applySepia(VideoFrame& frame, float intensity);
     void applyGrayscale(VideoFrame& frame);
     void applyInvert(VideoFrame& frame);
     void applyVignette(VideoFrame& frame, float intensity);
+    // frame holds rows [top, top + frame.height) of a picture fullHeight rows tall
+    void applyVignette(VideoFrame& frame, float intensity, int top, int fullHeight);
+    void applyPreset(VideoFrame& frame, ColorOp preset, float intensity);  // 0.0 to 1.0
+
+    // Map a filter type name to a fusable colour op
+    static bool toColorOp(const std::string& type, ColorOp& op);
+
+    // True if the op maps each channel independently of the others
+    static bool isSeparable(ColorOp op);
 
-private:
-    void rgbToHsl(uint8_t r, uint8_t g, uint8_t b, float& h, float& s, float& l);
-    void hslToRgb(float h, float s, float l, uint8_t& r, uint8_t& g, uint8_t& b);
+    // Reference per-pixel transform on 0-255 float channels, used to build LUTs
+    static void transformPixel(const ColorOpParams& params, float& r, float& g, float& b);
 };
 
 }  // namespace videoeditor
@@ -0,0 +1,90 @@
+#include "color_lut.h"
+#include <cstring>
+
+namespace videoeditor {
+
+ColorLut3D::ColorLut3D(const std::vector<ColorOpParams>& ops) {
+    m_table.resize(kSize * kSize * kSize * 4);
+    
+    uint16_t* node = m_table.data();
+    for (int bi = 0; bi < kSize; bi++) {
+        for (int gi = 0; gi < kSize; gi++) {
+            for (int ri = 0; ri < kSize; ri++) {
+                float r = ri * 255.0f / (kSize - 1);
+                float g = gi * 255.0f / (kSize - 1);
+                float b = bi * 255.0f / (kSize - 1);
+                
+                for (const auto& op : ops) {
+                    ColorFilter::transformPixel(op, r, g, b);
+                }
+                
+                node[0] = static_cast<uint16_t>(std::max(0.0f, std::min(255.0f, r)) * 16.0f + 0.5f);
+                node[1] = static_cast<uint16_t>(std::max(0.0f, std::min(255.0f, g)) * 16.0f + 0.5f);
+                node[2] = static_cast<uint16_t>(std::max(0.0f, std::min(255.0f, b)) * 16.0f + 0.5f);
+                node[3] = 0;
+                node += 4;
+            }
+        }
+    }
+}
+
+void ColorLut3D::apply(VideoFrame& frame) const {
+    apply(frame.data.data(), frame.data.size() / 4);
+}
+
+void ColorLut3D::apply(uint8_t* rgba, size_t pixelCount) const {
+    pixelKernels().colorLut3D(m_table.data(), rgba, pixelCount);
+}
+
+uint64_t ColorLut3D::hash(const std::vector<ColorOpParams>& ops) {
+    // FNV-1a over (op, value bits)
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](uint32_t word) {
+        for (int i = 0; i < 4; i++) {
+            h ^= (word >> (i * 8)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+    };
+    
+    auto mixFloat = [&mix](float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        mix(bits);
+    };
+    
+    for (const auto& op : ops) {
+        mix(static_cast<uint32_t>(op.op));
+        mixFloat(op.value);
+        for (float arg : op.args) {
+            mixFloat(arg);
+        }
+    }
+    return h;
+}
+
+ColorLut1D::ColorLut1D(const std::vector<ColorOpParams>& ops) {
+    // Separable ops map (v, v, v) to each channel's own curve
+    for (int v = 0; v < 256; v++) {
+        float r = v, g = v, b = v;
+        for (const auto& op : ops) {
+            ColorFilter::transformPixel(op, r, g, b);
+        }
+        m_tables[0][v] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, r)) + 0.5f);
+        m_tables[1][v] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, g)) + 0.5f);
+        m_tables[2][v] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, b)) + 0.5f);
+    }
+}
+
+void ColorLut1D::apply(VideoFrame& frame) const {
+    applyInterleaved(frame.data.data(), frame.data.size() / 4);
+}
+
+void ColorLut1D::applyInterleaved(uint8_t* rgba, size_t pixelCount) const {
+    pixelKernels().channelLut(m_tables[0], rgba, pixelCount);
+}
+
+void ColorLut1D::applyPlanar(uint8_t* plane, size_t count, int channel) const {
+    pixelKernels().planeLut(m_tables[channel], plane, count);
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,56 @@
+#ifndef VIDEO_EDITOR_COLOR_LUT_H
+#define VIDEO_EDITOR_COLOR_LUT_H
+
+#include "common.h"
+#include "color_filter.h"
+#include "pixel_kernels.h"
+
+namespace videoeditor {
+
+// 33x33x33 RGB lookup table with tetrahedral interpolation. A whole chain of
+// position-independent colour ops is baked into one table and applied in a
+// single pass over the frame.
+class ColorLut3D {
+public:
+    static constexpr int kSize = kColorLutSize;
+    
+    // Bake the ops, in order, into the table
+    explicit ColorLut3D(const std::vector<ColorOpParams>& ops);
+    
+    void apply(VideoFrame& frame) const;
+    void apply(uint8_t* rgba, size_t pixelCount) const;
+    
+    // Stable hash of an op chain, used as the LUT cache key
+    static uint64_t hash(const std::vector<ColorOpParams>& ops);
+
+private:
+    // RGBx nodes, red fastest, channels in 12-bit fixed point (value * 16);
+    // the layout PixelKernels::colorLut3D reads
+    std::vector<uint16_t> m_table;
+};
+
+// Per-channel 256-entry tables for chains of separable ops (brightness,
+// contrast, invert, temperature, tint, levels). Exact for 8-bit input and
+// cheaper than the 3D table when no op mixes channels.
+class ColorLut1D {
+public:
+    // All ops must satisfy ColorFilter::isSeparable
+    explicit ColorLut1D(const std::vector<ColorOpParams>& ops);
+    
+    void apply(VideoFrame& frame) const;
+    
+    // Interleaved RGBA, alpha untouched
+    void applyInterleaved(uint8_t* rgba, size_t pixelCount) const;
+    
+    // Single plane holding one channel (0 = R, 1 = G, 2 = B)
+    void applyPlanar(uint8_t* plane, size_t count, int channel) const;
+    
+    const uint8_t* table(int channel) const { return m_tables[channel]; }
+
+private:
+    alignas(16) uint8_t m_tables[3][256];  // Back to back, as PixelKernels::channelLut takes them
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_COLOR_LUT_H
@@ -0,0 +1,271 @@
+#include "color_matrix.h"
+#include <cmath>
+#include <algorithm>
+#include "pixel_kernels.h"
+
+namespace videoeditor {
+
+namespace {
+
+// Same luma weights as ColorFilter's grayscale/saturation
+constexpr float kLumaR = 0.299f;
+constexpr float kLumaG = 0.587f;
+constexpr float kLumaB = 0.114f;
+
+// Matrix converted to integer coefficients with a per-matrix binary point
+FixedColorMatrix toFixed(const ColorMatrix& matrix) {
+    float maxCoef = 0.0f;
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            maxCoef = std::max(maxCoef, std::fabs(matrix.m[row * 5 + col]));
+        }
+    }
+    
+    // Most matrices fit Q12; extreme contrast factors trade precision for range
+    FixedColorMatrix fixed;
+    fixed.shift = 12;
+    while (fixed.shift > 4 && maxCoef * (1 << fixed.shift) > 32767.0f) {
+        fixed.shift--;
+    }
+    
+    float unit = static_cast<float>(1 << fixed.shift);
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            float v = std::round(matrix.m[row * 5 + col] * unit);
+            fixed.coef[row * 4 + col] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, v)));
+        }
+        fixed.offset[row] = static_cast<int32_t>(std::round(matrix.m[row * 5 + 4] * unit));
+    }
+    return fixed;
+}
+
+}  // namespace
+
+ColorMatrix ColorMatrix::identity() {
+    return {{
+        1, 0, 0, 0, 0,
+        0, 1, 0, 0, 0,
+        0, 0, 1, 0, 0,
+        0, 0, 0, 1, 0
+    }};
+}
+
+ColorMatrix ColorMatrix::offset(float value) {
+    ColorMatrix result = identity();
+    result.m[4] = value;
+    result.m[9] = value;
+    result.m[14] = value;
+    return result;
+}
+
+ColorMatrix ColorMatrix::scale(float r, float g, float b) {
+    ColorMatrix result = identity();
+    result.m[0] = r;
+    result.m[6] = g;
+    result.m[12] = b;
+    return result;
+}
+
+ColorMatrix ColorMatrix::contrast(float factor) {
+    ColorMatrix result = scale(factor, factor, factor);
+    float translate = 128.0f * (1.0f - factor);
+    result.m[4] = translate;
+    result.m[9] = translate;
+    result.m[14] = translate;
+    return result;
+}
+
+ColorMatrix ColorMatrix::saturation(float value) {
+    float inv = 1.0f - value;
+    float r = kLumaR * inv;
+    float g = kLumaG * inv;
+    float b = kLumaB * inv;
+    return {{
+        r + value, g,         b,         0, 0,
+        r,         g + value, b,         0, 0,
+        r,         g,         b + value, 0, 0,
+        0,         0,         0,         1, 0
+    }};
+}
+
+ColorMatrix ColorMatrix::hueRotation(float degrees) {
+    // Rotation about the grey axis, compensated so luma stays constant. The green
+    // row's sine terms are whatever keeps each column's luma contribution at zero,
+    // so the matrix holds the same luma as saturation() for any weights.
+    float radians = degrees * static_cast<float>(M_PI) / 180.0f;
+    float c = std::cos(radians);
+    float s = std::sin(radians);
+    const float lr = kLumaR, lg = kLumaG, lb = kLumaB;
+    float sr = (lr * lr + lb * (1.0f - lr)) / lg;
+    float sg = lr - lb;
+    float sb = -(lr * (1.0f - lb) + lb * lb) / lg;
+    return {{
+        lr + c * (1 - lr) - s * lr,       lg - c * lg - s * lg,             lb - c * lb + s * (1 - lb),       0, 0,
+        lr - c * lr + s * sr,             lg + c * (1 - lg) + s * sg,       lb - c * lb + s * sb,             0, 0,
+        lr - c * lr - s * (1 - lr),       lg - c * lg + s * lg,             lb + c * (1 - lb) + s * lb,       0, 0,
+        0,                                0,                                0,                                1, 0
+    }};
+}
+
+ColorMatrix ColorMatrix::sepia(float intensity) {
+    ColorMatrix full = {{
+        0.393f, 0.769f, 0.189f, 0, 0,
+        0.349f, 0.686f, 0.168f, 0, 0,
+        0.272f, 0.534f, 0.131f, 0, 0,
+        0,      0,      0,      1, 0
+    }};
+    return full.lerpFromIdentity(intensity);
+}
+
+ColorMatrix ColorMatrix::grayscale() {
+    return saturation(0.0f);
+}
+
+ColorMatrix ColorMatrix::invert() {
+    return {{
+        -1,  0,  0, 0, 255,
+         0, -1,  0, 0, 255,
+         0,  0, -1, 0, 255,
+         0,  0,  0, 1, 0
+    }};
+}
+
+bool ColorMatrix::fromColorOp(const ColorOpParams& params, ColorMatrix& out) {
+    float value = params.value;
+    
+    switch (params.op) {
+        case ColorOp::Brightness:
+            out = offset(static_cast<float>(static_cast<int>(value * 255)));
+            return true;
+        case ColorOp::Contrast:
+            out = contrast((259.0f * (value * 255 + 255)) / (255.0f * (259 - value * 255)));
+            return true;
+        case ColorOp::Saturation:
+            out = saturation(value);
+            return true;
+        case ColorOp::Hue:
+            out = hueRotation(value);
+            return true;
+        case ColorOp::Temperature: {
+            float adjust = static_cast<float>(static_cast<int>(value * 30));
+            out = identity();
+            out.m[4] = adjust;
+            out.m[14] = -adjust;
+            return true;
+        }
+        case ColorOp::Tint: {
+            out = identity();
+            out.m[4] = static_cast<float>(static_cast<int>(-value * 15));
+            out.m[9] = static_cast<float>(static_cast<int>(value * 30));
+            out.m[14] = out.m[4];
+            return true;
+        }
+        case ColorOp::Sepia:
+            out = sepia(value);
+            return true;
+        case ColorOp::Grayscale:
+            out = grayscale();
+            return true;
+        case ColorOp::Invert:
+            out = invert();
+            return true;
+        case ColorOp::Levels:
+            return false;  // Gamma curve isn't affine
+        default: {
+            ColorMatrix presetMatrix;
+            if (!preset(params.op, presetMatrix)) {
+                return false;
+            }
+            out = presetMatrix.lerpFromIdentity(std::max(0.0f, std::min(1.0f, value)));
+            return true;
+        }
+    }
+}
+
+bool ColorMatrix::preset(ColorOp op, ColorMatrix& out) {
+    // Mirrors the presets in VideoEffects.kt; vignettes are applied separately
+    switch (op) {
+        case ColorOp::Vintage:
+            out = sepia(0.4f).postConcat(contrast(1.1f)).postConcat(offset(-10.0f));
+            return true;
+        case ColorOp::Cool:
+            out = {{
+                0.9f, 0,     0,    0, 0,
+                0,    0.95f, 0,    0, 0,
+                0,    0,     1.1f, 0, 10,
+                0,    0,     0,    1, 0
+            }};
+            return true;
+        case ColorOp::Warm:
+            out = {{
+                1.1f, 0,    0,    0, 10,
+                0,    1.0f, 0,    0, 5,
+                0,    0,    0.9f, 0, 0,
+                0,    0,    0,    1, 0
+            }};
+            return true;
+        case ColorOp::Dramatic:
+            out = contrast(1.3f).postConcat(saturation(1.2f));
+            return true;
+        case ColorOp::Fade:
+            out = contrast(0.85f).postConcat(saturation(0.8f)).postConcat(offset(15.0f));
+            return true;
+        case ColorOp::Noir:
+            out = grayscale().postConcat(contrast(1.4f));
+            return true;
+        default:
+            return false;
+    }
+}
+
+float ColorMatrix::presetVignette(ColorOp op) {
+    switch (op) {
+        case ColorOp::Vintage: return 0.3f;
+        case ColorOp::Dramatic: return 0.4f;
+        case ColorOp::Noir: return 0.5f;
+        default: return 0.0f;
+    }
+}
+
+ColorMatrix ColorMatrix::postConcat(const ColorMatrix& next) const {
+    ColorMatrix result;
+    for (int row = 0; row < 4; row++) {
+        const float* b = next.m + row * 5;
+        for (int col = 0; col < 5; col++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += b[k] * m[k * 5 + col];
+            }
+            result.m[row * 5 + col] = sum;
+        }
+        result.m[row * 5 + 4] += b[4];
+    }
+    return result;
+}
+
+ColorMatrix ColorMatrix::lerpFromIdentity(float t) const {
+    ColorMatrix result = identity();
+    for (int i = 0; i < 20; i++) {
+        result.m[i] += t * (m[i] - result.m[i]);
+    }
+    return result;
+}
+
+void ColorMatrix::transform(float& r, float& g, float& b) const {
+    float nr = m[0] * r + m[1] * g + m[2] * b + m[3] * 255.0f + m[4];
+    float ng = m[5] * r + m[6] * g + m[7] * b + m[8] * 255.0f + m[9];
+    float nb = m[10] * r + m[11] * g + m[12] * b + m[13] * 255.0f + m[14];
+    r = std::max(0.0f, std::min(255.0f, nr));
+    g = std::max(0.0f, std::min(255.0f, ng));
+    b = std::max(0.0f, std::min(255.0f, nb));
+}
+
+void ColorMatrix::apply(VideoFrame& frame) const {
+    apply(frame.data.data(), frame.data.size() / 4);
+}
+
+void ColorMatrix::apply(uint8_t* rgba, size_t pixelCount) const {
+    pixelKernels().colorMatrix(toFixed(*this), rgba, pixelCount);
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,48 @@
+#ifndef VIDEO_EDITOR_COLOR_MATRIX_H
+#define VIDEO_EDITOR_COLOR_MATRIX_H
+
+#include "common.h"
+#include "color_filter.h"
+
+namespace videoeditor {
+
+// 4x5 colour matrix, same layout as android.graphics.ColorMatrix:
+//   R' = m[0]*R + m[1]*G + m[2]*B + m[3]*A + m[4]   (offsets in 0-255 units)
+// Linear ops are concatenated on the CPU and applied in one fixed-point pass.
+struct ColorMatrix {
+    float m[20];
+
+    static ColorMatrix identity();
+    static ColorMatrix offset(float value);                        // Add to R, G, B
+    static ColorMatrix scale(float r, float g, float b);
+    static ColorMatrix contrast(float factor);                     // Scale around mid-grey
+    static ColorMatrix saturation(float value);                    // 0 = grey, 1 = unchanged
+    static ColorMatrix hueRotation(float degrees);                 // Luma-preserving
+    static ColorMatrix sepia(float intensity);
+    static ColorMatrix grayscale();
+    static ColorMatrix invert();
+
+    // Matrix form of a colour op; false for ops that aren't affine (e.g. levels)
+    static bool fromColorOp(const ColorOpParams& params, ColorMatrix& out);
+
+    // Matrix part of a VideoEffects preset (vintage, cool, warm, dramatic, fade, noir)
+    static bool preset(ColorOp op, ColorMatrix& out);
+
+    // Vignette amount that accompanies a preset, 0 if none
+    static float presetVignette(ColorOp op);
+
+    // Apply this matrix, then next
+    ColorMatrix postConcat(const ColorMatrix& next) const;
+
+    // Blend towards identity (0) or this matrix (1)
+    ColorMatrix lerpFromIdentity(float t) const;
+
+    void transform(float& r, float& g, float& b) const;
+
+    void apply(VideoFrame& frame) const;
+    void apply(uint8_t* rgba, size_t pixelCount) const;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_COLOR_MATRIX_H
@@ -1,9 +1,11 @@
 #include "filter_manager.h"
+#include <algorithm>
 
 namespace videoeditor {
 
 FilterManager::FilterManager()
     : m_nextFilterId(1)
+    , m_threadPool(nullptr)
     , m_initialized(false) {
     LOGI("FilterManager created");
 }
@@ -16,9 +18,6 @@ FilterManager::~FilterManager() {
 bool FilterManager::initialize() {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    m_colorFilter = std::make_unique<ColorFilter>();
-    m_blurFilter = std::make_unique<BlurFilter>();
-    
     m_initialized = true;
     LOGI("FilterManager initialized");
     return true;
@@ -28,13 +27,24 @@ void FilterManager::release() {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     m_clipFilters.clear();
-    m_colorFilter.reset();
-    m_blurFilter.reset();
+    m_programs.clear();
+    m_lutCache.clear();
+    m_channelLutCache.clear();
+    m_idleExecutors.clear();  // Ones still running are dropped when they come back
     
     m_initialized = false;
     LOGI("FilterManager released");
 }
 
+void FilterManager::setThreadPool(ThreadPool* pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_threadPool = pool;
+    for (auto& executor : m_idleExecutors) {
+        executor->setThreadPool(pool);
+    }
+}
+
 bool FilterManager::addFilter(int clipId, const std::string& filterType, const EffectParams& params) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
@@ -44,6 +54,7 @@ bool FilterManager::addFilter(int clipId, const std::string& filterType, const E
     filter.params = params;
     
     m_clipFilters[clipId].push_back(filter);
+    rebuildProgram(clipId);
     
     LOGI("Added filter %d (%s) to clip %d", filter.id, filterType.c_str(), clipId);
     return true;
@@ -61,6 +72,7 @@ bool FilterManager::removeFilter(int clipId, int filterId) {
     for (auto filterIt = filters.begin(); filterIt != filters.end(); ++filterIt) {
         if (filterIt->id == filterId) {
             filters.erase(filterIt);
+            rebuildProgram(clipId);
             LOGI("Removed filter %d from clip %d", filterId, clipId);
             return true;
         }
@@ -80,6 +92,7 @@ bool FilterManager::updateFilter(int clipId, int filterId, const EffectParams& p
     for (auto& filter : it->second) {
         if (filter.id == filterId) {
             filter.params = params;
+            rebuildProgram(clipId);
             LOGI("Updated filter %d on clip %d", filterId, clipId);
             return true;
         }
@@ -88,26 +101,224 @@ bool FilterManager::updateFilter(int clipId, int filterId, const EffectParams& p
     return false;
 }
 
-void FilterManager::applyFilters(VideoFrame& frame, const std::string& clipPath) {
+std::shared_ptr<const FilterProgram> FilterManager::applyFilters(VideoFrame& frame, int clipId) {
+    // The lock only covers picking up the program and an executor; the run itself
+    // goes without it so preview, export and filter edits don't wait on each other
+    std::shared_ptr<const FilterProgram> program;
+    std::unique_ptr<FilterExecutor> executor;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        if (!m_initialized || clipId < 0 || clipId >= static_cast<int>(m_programs.size())) {
+            return nullptr;
+        }
+        program = m_programs[clipId];
+        if (!program || program->empty()) {
+            return program;
+        }
+        
+        if (m_idleExecutors.empty()) {
+            executor = std::make_unique<FilterExecutor>();
+            executor->setThreadPool(m_threadPool);
+        } else {
+            executor = std::move(m_idleExecutors.back());
+            m_idleExecutors.pop_back();
+        }
+    }
+    
+    executor->run(*program, frame);
+    
+    // Keep its scratch buffers for the next call unless the manager moved on meanwhile
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_initialized && executor->threadPool() == m_threadPool && m_idleExecutors.size() < kMaxIdleExecutors) {
+        m_idleExecutors.push_back(std::move(executor));
+    }
+    return program;
+}
+
+std::shared_ptr<const FilterProgram> FilterManager::getProgram(int clipId) const {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    // Find clip ID by path (simplified - in real implementation, would have proper mapping)
-    // For now, apply global filters
+    if (clipId < 0 || clipId >= static_cast<int>(m_programs.size())) {
+        return nullptr;
+    }
+    return m_programs[clipId];
+}
+
+uint64_t FilterManager::getProgramHash(int clipId) const {
+    auto program = getProgram(clipId);
+    return program ? program->hash() : 0;
+}
+
+void FilterManager::rebuildProgram(int clipId) {
+    if (clipId < 0) {
+        return;
+    }
+    if (clipId >= static_cast<int>(m_programs.size())) {
+        m_programs.resize(clipId + 1);
+    }
     
-    for (const auto& pair : m_clipFilters) {
-        for (const auto& filter : pair.second) {
-            if (filter.type == "brightness" || filter.type == "contrast" || 
-                filter.type == "saturation" || filter.type == "hue") {
-                if (m_colorFilter) {
-                    m_colorFilter->apply(frame, filter.type, filter.params.intensity);
-                }
-            } else if (filter.type == "blur" || filter.type == "gaussian") {
-                if (m_blurFilter) {
-                    m_blurFilter->apply(frame, static_cast<int>(filter.params.intensity));
+    auto it = m_clipFilters.find(clipId);
+    if (it == m_clipFilters.end() || it->second.empty()) {
+        m_programs[clipId].reset();
+        return;
+    }
+    
+    // FNV-1a over each filter's type and parameters
+    uint64_t hash = 1469598103934665603ULL;
+    auto mixBytes = [&hash](const void* bytes, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(bytes);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= p[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    
+    FilterProgramBuilder builder;
+    
+    // Consecutive position-independent colour ops are collected and compiled into one pass
+    std::vector<ColorOpParams> colorOps;
+    
+    for (const auto& filter : it->second) {
+        const EffectParams& params = filter.params;
+        mixBytes(filter.type.data(), filter.type.size() + 1);
+        mixBytes(&params.intensity, sizeof(params.intensity));
+        if (!params.params.empty()) {
+            mixBytes(params.params.data(), params.params.size() * sizeof(float));
+        }
+        
+        ColorOp op;
+        if (ColorFilter::toColorOp(filter.type, op)) {
+            ColorOpParams opParams = {op, params.intensity, {0.0f, 255.0f, 1.0f}};
+            for (size_t i = 0; i < 3 && i < params.params.size(); i++) {
+                opParams.args[i] = params.params[i];
+            }
+            colorOps.push_back(opParams);
+            
+            // Preset vignettes depend on position, so they end the fused run
+            float vignette = ColorMatrix::presetVignette(op);
+            if (vignette > 0.0f) {
+                appendColorStages(builder, colorOps);
+                builder.addVignette(vignette * std::max(0.0f, std::min(1.0f, params.intensity)));
+            }
+            continue;
+        }
+        
+        appendColorStages(builder, colorOps);
+        
+        if (filter.type == "blur") {
+            builder.addBoxBlur(static_cast<int>(params.intensity));
+        } else if (filter.type == "gaussian") {
+            builder.addGaussianBlur(static_cast<int>(params.intensity));
+        } else if (filter.type == "sharpen") {
+            builder.addSharpen(params.intensity);
+        } else if (filter.type == "unsharp") {
+            // intensity = amount, params[0] = radius (default 2), params[1] = threshold
+            float radius = params.params.size() > 0 ? params.params[0] : 2.0f;
+            float threshold = params.params.size() > 1 ? params.params[1] : 0.0f;
+            builder.addUnsharp(params.intensity, radius, threshold);
+        } else if (filter.type == "motion_blur") {
+            // intensity = distance in pixels, params[0] = angle in degrees
+            int angle = params.params.empty() ? 0 : static_cast<int>(params.params[0]);
+            builder.addMotionBlur(angle, static_cast<int>(params.intensity));
+        } else if (filter.type == "grain") {
+            // intensity 0-2, params[0] = seed (pattern choice)
+            uint32_t seed = params.params.empty() ? 0 : static_cast<uint32_t>(params.params[0]);
+            builder.addGrain(params.intensity, seed);
+        } else if (filter.type == "chroma_key") {
+            // intensity = spill suppression 0-1, params = key R, G, B (0-255),
+            // tolerance and softness (0-1); defaults key out chroma green
+            uint32_t key = ChromaKey::kDefaultKeyColor;
+            if (params.params.size() >= 3) {
+                key = 0xFF000000u;
+                for (int c = 0; c < 3; c++) {
+                    int value = static_cast<int>(std::max(0.0f, std::min(255.0f, params.params[c])));
+                    key |= static_cast<uint32_t>(value) << (16 - 8 * c);
                 }
             }
+            float tolerance = params.params.size() > 3 ? params.params[3] : ChromaKey::kDefaultTolerance;
+            float softness = params.params.size() > 4 ? params.params[4] : ChromaKey::kDefaultSoftness;
+            builder.addChromaKey(key, tolerance, softness, params.intensity);
+        } else if (filter.type == "vignette") {
+            builder.addVignette(params.intensity);
+        } else {
+            LOGW("Unknown filter type %s on clip %d", filter.type.c_str(), clipId);
+        }
+    }
+    
+    appendColorStages(builder, colorOps);
+    m_programs[clipId] = builder.build(hash);
+}
+
+void FilterManager::appendColorStages(FilterProgramBuilder& builder, std::vector<ColorOpParams>& ops) {
+    if (ops.empty()) {
+        return;
+    }
+    
+    bool separable = std::all_of(ops.begin(), ops.end(),
+        [](const ColorOpParams& params) { return ColorFilter::isSeparable(params.op); });
+    
+    // Channel-independent chains are exact (and cheaper) as three 1D tables
+    if (separable) {
+        builder.addChannelLut(getChannelLut(ops));
+        ops.clear();
+        return;
+    }
+    
+    // Affine chains collapse into one matrix
+    ColorMatrix combined = ColorMatrix::identity();
+    bool affine = true;
+    for (const auto& params : ops) {
+        ColorMatrix matrix;
+        if (!ColorMatrix::fromColorOp(params, matrix)) {
+            affine = false;
+            break;
         }
+        combined = combined.postConcat(matrix);
     }
+    
+    if (affine) {
+        builder.addColorMatrix(combined);
+    } else {
+        builder.addColorLut(getColorLut(ops));
+    }
+    ops.clear();
+}
+
+std::shared_ptr<const ColorLut3D> FilterManager::getColorLut(const std::vector<ColorOpParams>& ops) {
+    uint64_t key = ColorLut3D::hash(ops);
+    
+    auto it = m_lutCache.find(key);
+    if (it != m_lutCache.end()) {
+        return it->second;
+    }
+    
+    // Slider drags produce a new chain per step; keep the cache from growing unbounded
+    if (m_lutCache.size() >= kMaxCachedLuts) {
+        m_lutCache.clear();
+    }
+    
+    auto lut = std::make_shared<const ColorLut3D>(ops);
+    m_lutCache[key] = lut;
+    LOGD("Built colour LUT for %zu ops", ops.size());
+    return lut;
+}
+
+std::shared_ptr<const ColorLut1D> FilterManager::getChannelLut(const std::vector<ColorOpParams>& ops) {
+    uint64_t key = ColorLut3D::hash(ops);
+    
+    auto it = m_channelLutCache.find(key);
+    if (it != m_channelLutCache.end()) {
+        return it->second;
+    }
+    
+    if (m_channelLutCache.size() >= kMaxCachedLuts) {
+        m_channelLutCache.clear();
+    }
+    
+    auto lut = std::make_shared<const ColorLut1D>(ops);
+    m_channelLutCache[key] = lut;
+    return lut;
 }
 
 std::vector<std::string> FilterManager::getAvailableFilters() const {
@@ -116,13 +327,26 @@ std::vector<std::string> FilterManager::getAvailableFilters() const {
         "contrast",
         "saturation",
         "hue",
+        "temperature",
+        "tint",
+        "levels",
         "blur",
         "gaussian",
+        "motion_blur",
         "sharpen",
+        "unsharp",
         "vignette",
+        "grain",
+        "chroma_key",
         "sepia",
         "grayscale",
-        "invert"
+        "invert",
+        "vintage",
+        "cool",
+        "warm",
+        "dramatic",
+        "fade",
+        "noir"
     };
 }
 
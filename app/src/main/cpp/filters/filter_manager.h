@@ -4,7 +4,11 @@
 #include "common.h"
 #include "color_filter.h"
 #include "blur_filter.h"
+#include "sharpen_filter.h"
+#include "color_lut.h"
+#include "filter_program.h"
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
@@ -18,13 +22,25 @@ public:
     bool initialize();
     void release();
 
+    // Worker pool that filter programs run their bands on; must outlive the manager
+    void setThreadPool(ThreadPool* pool);
+
     // Filter operations
     bool addFilter(int clipId, const std::string& filterType, const EffectParams& params);
     bool removeFilter(int clipId, int filterId);
     bool updateFilter(int clipId, int filterId, const EffectParams& params);
 
-    // Apply all filters to frame
-    void applyFilters(VideoFrame& frame, const std::string& clipPath);
+    // Run the clip's compiled filter program on the frame and return that program
+    // (null without filters). It is the one in effect when the call started, so its
+    // hash names the pixels even if the filters change meanwhile. Calls from
+    // different threads run side by side, each on its own executor.
+    std::shared_ptr<const FilterProgram> applyFilters(VideoFrame& frame, int clipId);
+
+    // Current program for the clip, null if it has no filters
+    std::shared_ptr<const FilterProgram> getProgram(int clipId) const;
+
+    // Hash of the clip's filter settings, 0 when it has none; changes whenever they do
+    uint64_t getProgramHash(int clipId) const;
 
     // Available filter types
     std::vector<std::string> getAvailableFilters() const;
@@ -36,13 +52,27 @@ private:
         EffectParams params;
     };
 
+    // Recompile the clip's program from its filter list; caller holds m_mutex
+    void rebuildProgram(int clipId);
+
+    // Compile a run of fused colour ops into a single stage and clear the run
+    void appendColorStages(FilterProgramBuilder& builder, std::vector<ColorOpParams>& ops);
+    std::shared_ptr<const ColorLut3D> getColorLut(const std::vector<ColorOpParams>& ops);
+    std::shared_ptr<const ColorLut1D> getChannelLut(const std::vector<ColorOpParams>& ops);
+
+    static constexpr size_t kMaxCachedLuts = 16;
+    static constexpr size_t kMaxIdleExecutors = 4;
+
     std::map<int, std::vector<FilterInstance>> m_clipFilters;  // clipId -> filters
+    std::vector<std::shared_ptr<const FilterProgram>> m_programs;  // Indexed by clip ID
     int m_nextFilterId;
     
-    std::unique_ptr<ColorFilter> m_colorFilter;
-    std::unique_ptr<BlurFilter> m_blurFilter;
+    std::vector<std::unique_ptr<FilterExecutor>> m_idleExecutors;  // Scratch space for applyFilters
+    ThreadPool* m_threadPool;
+    std::unordered_map<uint64_t, std::shared_ptr<const ColorLut3D>> m_lutCache;  // op-chain hash -> LUT
+    std::unordered_map<uint64_t, std::shared_ptr<const ColorLut1D>> m_channelLutCache;
     
-    std::mutex m_mutex;
+    mutable std::mutex m_mutex;
     bool m_initialized;
 };
 
@@ -0,0 +1,281 @@
+#include "filter_program.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+// Rows per band: a 1080p band of 64 RGBA rows is ~0.5 MB, around L2 size
+constexpr int kBandRows = 64;
+
+// Bands are grown so halo rows never exceed this fraction of the work
+constexpr int kBandRowsPerHalo = 4;
+
+void runChannelLut(const FilterStage& stage, VideoFrame& frame, const FilterKernels&) {
+    stage.channelLut->apply(frame);
+}
+
+void runColorLut(const FilterStage& stage, VideoFrame& frame, const FilterKernels&) {
+    stage.colorLut->apply(frame);
+}
+
+void runColorMatrix(const FilterStage& stage, VideoFrame& frame, const FilterKernels&) {
+    stage.matrix.apply(frame);
+}
+
+void runVignette(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.color->applyVignette(frame, stage.amount, kernels.top, kernels.fullHeight);
+}
+
+void runBoxBlur(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.blur->boxBlur(frame, stage.radius);
+}
+
+void runGaussianBlur(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.blur->gaussianBlur(frame, stage.radius);
+}
+
+void runMotionBlur(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.blur->motionBlur(frame, stage.angle, stage.radius);
+}
+
+void runSharpen(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.sharpen->apply(frame, stage.amount);
+}
+
+void runGrain(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    // New grain every frame, but the same grain whenever this frame is rendered again
+    uint64_t time = static_cast<uint64_t>(frame.timestamp_us);
+    uint32_t frameSeed = stage.seed ^ static_cast<uint32_t>(time * 0x9E3779B97F4A7C15ULL >> 32);
+    kernels.grain->apply(frame, stage.amount, frameSeed, kernels.top);
+}
+
+void runUnsharp(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels) {
+    kernels.sharpen->unsharpMask(frame, stage.amount, static_cast<float>(stage.radius), stage.threshold);
+}
+
+void runChromaKey(const FilterStage& stage, VideoFrame& frame, const FilterKernels&) {
+    stage.chromaKey->apply(frame);
+}
+
+}  // namespace
+
+FilterProgram::FilterProgram(std::vector<FilterStage> stages, uint64_t hash)
+    : m_stages(std::move(stages))
+    , m_hash(hash) {
+    // Full-frame stages split the chain; banded neighbours accumulate their halos
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        const FilterStage& stage = m_stages[i];
+        if (stage.banded && !m_segments.empty() && m_segments.back().banded) {
+            m_segments.back().end = i + 1;
+            m_segments.back().halo += stage.halo;
+        } else {
+            m_segments.push_back({i, i + 1, stage.halo, stage.banded});
+        }
+    }
+}
+
+void FilterProgram::run(VideoFrame& frame, const FilterKernels& kernels, size_t begin, size_t end) const {
+    for (size_t i = begin; i < end; i++) {
+        m_stages[i].kernel(m_stages[i], frame, kernels);
+    }
+}
+
+FilterExecutor::FilterExecutor()
+    : m_threadPool(nullptr)
+    , m_frameWorker(std::make_unique<Worker>()) {
+}
+
+FilterExecutor::~FilterExecutor() = default;
+
+void FilterExecutor::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+    m_frameWorker->blur.setThreadPool(pool);
+    
+    // One worker per pool thread plus the caller, which claims bands too
+    m_workers.clear();
+    if (pool) {
+        for (size_t i = 0; i <= pool->size(); i++) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+    }
+}
+
+void FilterExecutor::run(const FilterProgram& program, VideoFrame& frame) {
+    Worker& whole = *m_frameWorker;
+    FilterKernels kernels = {&whole.color, &whole.blur, &whole.sharpen, &whole.grain, 0, frame.height};
+    
+    for (const auto& segment : program.segments()) {
+        if (segment.banded && !m_workers.empty()) {
+            runBanded(program, segment, frame);
+        } else {
+            program.run(frame, kernels, segment.begin, segment.end);
+        }
+    }
+}
+
+void FilterExecutor::runBanded(const FilterProgram& program, const FilterProgram::Segment& segment,
+                               VideoFrame& frame) {
+    int width = frame.width;
+    int height = frame.height;
+    int bandRows = std::max(kBandRows, segment.halo * kBandRowsPerHalo);
+    int bands = (height + bandRows - 1) / bandRows;
+    
+    if (bands < 2) {
+        Worker& whole = *m_frameWorker;
+        program.run(frame, {&whole.color, &whole.blur, &whole.sharpen, &whole.grain, 0, height},
+                    segment.begin, segment.end);
+        return;
+    }
+    
+    // Bands read their halo from the input, so results go to a separate buffer
+    size_t stride = static_cast<size_t>(width) * 4;
+    m_output.resize(frame.data.size());
+    const uint8_t* input = frame.data.data();
+    uint8_t* output = m_output.data();
+    std::atomic<int> nextBand(0);
+    
+    auto runWorker = [&](int workerBegin, int workerEnd) {
+        for (int w = workerBegin; w < workerEnd; w++) {
+            Worker& worker = *m_workers[w];
+            VideoFrame& band = worker.band;
+            
+            int index;
+            while ((index = nextBand.fetch_add(1)) < bands) {
+                int top = index * bandRows;
+                int bottom = std::min(top + bandRows, height);
+                int haloTop = std::max(0, top - segment.halo);
+                int haloBottom = std::min(height, bottom + segment.halo);
+                
+                band.width = width;
+                band.height = haloBottom - haloTop;
+                band.format = frame.format;
+                band.timestamp_us = frame.timestamp_us;
+                band.data.resize(band.height * stride);
+                memcpy(band.data.data(), input + haloTop * stride, band.data.size());
+                
+                // Rows near a cut edge go wrong stage by stage, but never reach the core rows
+                program.run(band, {&worker.color, &worker.blur, &worker.sharpen, &worker.grain, haloTop, height},
+                            segment.begin, segment.end);
+                
+                memcpy(output + top * stride, band.data.data() + (top - haloTop) * stride,
+                       (bottom - top) * stride);
+            }
+        }
+    };
+    
+    // One call per worker; each then pulls bands until none are left
+    m_threadPool->parallelFor(0, static_cast<int>(m_workers.size()), 1, runWorker);
+    frame.data.swap(m_output);
+}
+
+void FilterProgramBuilder::addChannelLut(std::shared_ptr<const ColorLut1D> lut) {
+    FilterStage stage;
+    stage.kernel = runChannelLut;
+    stage.channelLut = std::move(lut);
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addColorLut(std::shared_ptr<const ColorLut3D> lut) {
+    FilterStage stage;
+    stage.kernel = runColorLut;
+    stage.colorLut = std::move(lut);
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addColorMatrix(const ColorMatrix& matrix) {
+    FilterStage stage;
+    stage.kernel = runColorMatrix;
+    stage.matrix = matrix;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addVignette(float intensity) {
+    if (intensity <= 0.0f) return;
+    
+    FilterStage stage;
+    stage.kernel = runVignette;
+    stage.amount = intensity;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addBoxBlur(int radius) {
+    if (radius <= 0) return;
+    
+    FilterStage stage;
+    stage.kernel = runBoxBlur;
+    stage.halo = radius;
+    stage.radius = radius;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addGaussianBlur(int radius) {
+    if (radius <= 0) return;
+    
+    FilterStage stage;
+    stage.kernel = runGaussianBlur;
+    stage.halo = radius;
+    stage.banded = radius <= BlurFilter::kMaxDirectGaussianRadius;  // Recursive pass runs whole columns
+    stage.radius = radius;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addMotionBlur(int angle, int distance) {
+    if (distance <= 0) return;
+    
+    FilterStage stage;
+    stage.kernel = runMotionBlur;
+    stage.halo = distance / 2 + 1;
+    stage.angle = ((angle % 360) + 360) % 360;
+    stage.radius = distance;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addSharpen(float intensity) {
+    if (intensity <= 0.0f) return;
+    
+    FilterStage stage;
+    stage.kernel = runSharpen;
+    stage.halo = 1;
+    stage.amount = intensity;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addGrain(float intensity, uint32_t seed) {
+    if (intensity <= 0.0f) return;
+    
+    FilterStage stage;
+    stage.kernel = runGrain;
+    stage.amount = intensity;
+    stage.seed = seed;
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addUnsharp(float amount, float radius, float threshold) {
+    if (amount <= 0.0f) return;
+    
+    FilterStage stage;
+    stage.kernel = runUnsharp;
+    stage.amount = amount;
+    stage.radius = std::max(0, static_cast<int>(radius));
+    stage.halo = stage.radius;
+    stage.threshold = std::max(0.0f, threshold);
+    m_stages.push_back(std::move(stage));
+}
+
+void FilterProgramBuilder::addChromaKey(uint32_t keyColor, float tolerance, float softness, float spill) {
+    FilterStage stage;
+    stage.kernel = runChromaKey;
+    stage.chromaKey = std::make_shared<const ChromaKey>(keyColor, tolerance, softness, spill);
+    m_stages.push_back(std::move(stage));
+}
+
+std::shared_ptr<const FilterProgram> FilterProgramBuilder::build(uint64_t hash) {
+    auto program = std::make_shared<const FilterProgram>(std::move(m_stages), hash);
+    m_stages.clear();
+    return program;
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,133 @@
+#ifndef VIDEO_EDITOR_FILTER_PROGRAM_H
+#define VIDEO_EDITOR_FILTER_PROGRAM_H
+
+#include "common.h"
+#include "color_filter.h"
+#include "color_lut.h"
+#include "color_matrix.h"
+#include "blur_filter.h"
+#include "sharpen_filter.h"
+#include "grain_filter.h"
+#include "chroma_key.h"
+#include "thread_pool.h"
+
+namespace videoeditor {
+
+// Filter objects the stages of a program run on, and where the frame they are
+// given sits in the full picture (a band is rows [top, top + height) of it)
+struct FilterKernels {
+    ColorFilter* color;
+    BlurFilter* blur;
+    SharpenFilter* sharpen;
+    GrainFilter* grain;
+    int top;
+    int fullHeight;
+};
+
+// One resolved step of a clip's filter chain: the kernel to call and its
+// already validated parameters
+struct FilterStage {
+    using Kernel = void (*)(const FilterStage& stage, VideoFrame& frame, const FilterKernels& kernels);
+
+    Kernel kernel = nullptr;
+    int halo = 0;          // Rows of context needed above and below each output row
+    bool banded = true;    // False if the stage needs the whole frame at once
+    int radius = 0;
+    int angle = 0;
+    float amount = 0.0f;
+    float threshold = 0.0f;
+    uint32_t seed = 0;
+    ColorMatrix matrix = ColorMatrix::identity();
+    std::shared_ptr<const ColorLut1D> channelLut;
+    std::shared_ptr<const ColorLut3D> colorLut;
+    std::shared_ptr<const ChromaKey> chromaKey;
+};
+
+// Immutable, compiled filter chain for one clip. Built whenever the clip's
+// filters change; rendering only walks the stage list.
+class FilterProgram {
+public:
+    // Run of consecutive stages executed together: either band by band with
+    // `halo` rows of overlap, or as one full-frame stage
+    struct Segment {
+        size_t begin;
+        size_t end;
+        int halo;
+        bool banded;
+    };
+
+    FilterProgram(std::vector<FilterStage> stages, uint64_t hash);
+
+    // Run stages [begin, end) on the frame with one set of kernels
+    void run(VideoFrame& frame, const FilterKernels& kernels, size_t begin, size_t end) const;
+
+    bool empty() const { return m_stages.empty(); }
+    uint64_t hash() const { return m_hash; }  // Identifies the filter settings that built it
+    const std::vector<FilterStage>& stages() const { return m_stages; }
+    const std::vector<Segment>& segments() const { return m_segments; }
+
+private:
+    std::vector<FilterStage> m_stages;
+    std::vector<Segment> m_segments;
+    uint64_t m_hash;
+};
+
+// Runs programs band by band across a thread pool. Each band (plus halo rows)
+// is copied out, taken through a whole segment of the chain while it is in
+// cache, and its core rows written back. Every worker has its own filter
+// objects, since they keep scratch buffers.
+class FilterExecutor {
+public:
+    FilterExecutor();
+    ~FilterExecutor();
+
+    // Must outlive the executor; null runs everything on the calling thread
+    void setThreadPool(ThreadPool* pool);
+    ThreadPool* threadPool() const { return m_threadPool; }
+
+    // Not reentrant: the workers and output buffer are scratch for one run at a time
+    void run(const FilterProgram& program, VideoFrame& frame);
+
+private:
+    struct Worker {
+        ColorFilter color;
+        BlurFilter blur;
+        SharpenFilter sharpen;
+        GrainFilter grain;
+        VideoFrame band;
+
+        Worker() : sharpen(&blur) {}
+    };
+
+    void runBanded(const FilterProgram& program, const FilterProgram::Segment& segment, VideoFrame& frame);
+
+    ThreadPool* m_threadPool;
+    std::unique_ptr<Worker> m_frameWorker;  // Full-frame stages; its blur bands internally
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<uint8_t> m_output;
+};
+
+// Appends stages in chain order; stages whose parameters make them a no-op are dropped
+class FilterProgramBuilder {
+public:
+    void addChannelLut(std::shared_ptr<const ColorLut1D> lut);
+    void addColorLut(std::shared_ptr<const ColorLut3D> lut);
+    void addColorMatrix(const ColorMatrix& matrix);
+    void addVignette(float intensity);
+    void addBoxBlur(int radius);
+    void addGaussianBlur(int radius);
+    void addMotionBlur(int angle, int distance);
+    void addSharpen(float intensity);
+    void addGrain(float intensity, uint32_t seed);
+    void addUnsharp(float amount, float radius, float threshold);
+    void addChromaKey(uint32_t keyColor, float tolerance, float softness, float spill);
+
+    std::shared_ptr<const FilterProgram> build(uint64_t hash);
+
+private:
+    std::vector<FilterStage> m_stages;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_FILTER_PROGRAM_H
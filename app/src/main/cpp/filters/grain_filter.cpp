@@ -0,0 +1,132 @@
+#include "grain_filter.h"
+#include <algorithm>
+
+namespace videoeditor {
+
+namespace {
+
+constexpr int kTileMask = GrainFilter::kTileSize - 1;
+constexpr int kTileShift = 7;  // log2(kTileSize)
+static_assert((1 << kTileShift) == GrainFilter::kTileSize, "tile size must match its shift");
+
+// Peak grain in 0-255 levels at intensity 1, as in VideoEffects.applyGrain
+constexpr float kGrainLevels = 25.0f;
+
+// Four independent xorshift32 streams; the lanes don't depend on each other,
+// so the compiler keeps them in one vector register
+struct XorShift4 {
+    uint32_t state[4];
+    
+    explicit XorShift4(uint32_t seed) {
+        for (int lane = 0; lane < 4; lane++) {
+            state[lane] = (seed + 0x9E3779B9u * (lane + 1)) | 1u;
+        }
+    }
+    
+    void next(uint32_t out[4]) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint32_t x = state[lane];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state[lane] = x;
+            out[lane] = x;
+        }
+    }
+};
+
+// Integer finaliser (murmur3) used to pick a tile and offset per block
+inline uint32_t mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+}  // namespace
+
+GrainFilter::GrainFilter() {
+    // Strongest in the midtones, a quarter of that at black and white
+    for (int luma = 0; luma < 256; luma++) {
+        int midtone = 4 * luma * (255 - luma);  // 0 to ~65025
+        m_lumaWeight[luma] = static_cast<int16_t>(64 + (192 * midtone + 32512) / 65025);
+    }
+    LOGI("GrainFilter created");
+}
+
+GrainFilter::~GrainFilter() {
+    LOGI("GrainFilter destroyed");
+}
+
+const std::vector<int8_t>& GrainFilter::tiles() {
+    static const std::vector<int8_t> samples = [] {
+        std::vector<int8_t> data(static_cast<size_t>(kTileCount) * kTileSize * kTileSize);
+        
+        // Sum of two uniform bytes: triangular, closer to real grain than flat noise
+        XorShift4 rng(0x6A09E667u);
+        uint32_t random[4];
+        for (size_t i = 0; i < data.size(); i += 8) {
+            rng.next(random);
+            for (int lane = 0; lane < 4; lane++) {
+                uint32_t r = random[lane];
+                data[i + lane * 2] = static_cast<int8_t>(((r & 0xFF) + ((r >> 8) & 0xFF) - 255) / 2);
+                data[i + lane * 2 + 1] = static_cast<int8_t>((((r >> 16) & 0xFF) + (r >> 24) - 255) / 2);
+            }
+        }
+        return data;
+    }();
+    return samples;
+}
+
+void GrainFilter::apply(VideoFrame& frame, float intensity, uint32_t seed) {
+    apply(frame, intensity, seed, 0);
+}
+
+void GrainFilter::apply(VideoFrame& frame, float intensity, uint32_t seed, int top) {
+    intensity = std::min(intensity, 2.0f);
+    if (intensity <= 0.0f || frame.width <= 0 || frame.height <= 0) return;
+    
+    const std::vector<int8_t>& grain = tiles();
+    
+    // delta = sample * gain * weight >> 22, rounded; 127 * gain * 256 stays well inside 32 bits
+    int gain = static_cast<int>(intensity * kGrainLevels / 127.0f * (1 << 14) + 0.5f);
+    
+    int width = frame.width;
+    int blocksPerRow = (width + kTileMask) >> kTileShift;
+    std::vector<const int8_t*> rows(blocksPerRow);
+    std::vector<int> offsets(blocksPerRow);
+    
+    for (int y = 0; y < frame.height; y++) {
+        int frameY = top + y;
+        uint32_t blockRow = static_cast<uint32_t>(frameY >> kTileShift);
+        
+        // Tile, column and row offset per block, fixed by the seed and block position
+        for (int block = 0; block < blocksPerRow; block++) {
+            uint32_t h = mix(seed ^ mix(blockRow * 0x9E3779B1u + static_cast<uint32_t>(block)));
+            int tile = h % kTileCount;
+            int tileY = (frameY + static_cast<int>(h >> 8)) & kTileMask;
+            rows[block] = grain.data() + (static_cast<size_t>(tile) * kTileSize + tileY) * kTileSize;
+            offsets[block] = static_cast<int>(h >> 16) & kTileMask;
+        }
+        
+        uint8_t* px = frame.data.data() + static_cast<size_t>(y) * width * 4;
+        for (int block = 0; block < blocksPerRow; block++) {
+            const int8_t* row = rows[block];
+            int offset = offsets[block];
+            int end = std::min(kTileSize, width - (block << kTileShift));
+            
+            for (int x = 0; x < end; x++) {
+                int luma = (77 * px[0] + 150 * px[1] + 29 * px[2] + 128) >> 8;
+                int delta = (row[(x + offset) & kTileMask] * gain * m_lumaWeight[luma] + (1 << 21)) >> 22;
+                px[0] = static_cast<uint8_t>(std::max(0, std::min(255, px[0] + delta)));
+                px[1] = static_cast<uint8_t>(std::max(0, std::min(255, px[1] + delta)));
+                px[2] = static_cast<uint8_t>(std::max(0, std::min(255, px[2] + delta)));
+                px += 4;
+            }
+        }
+    }
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,35 @@
+#ifndef VIDEO_EDITOR_GRAIN_FILTER_H
+#define VIDEO_EDITOR_GRAIN_FILTER_H
+
+#include "common.h"
+
+namespace videoeditor {
+
+// Film grain from a few precomputed noise tiles. Each 128x128 block of the
+// frame samples a tile at an offset chosen by hashing (seed, frame time,
+// block), so the pattern changes every frame without generating noise per
+// pixel. The same seed and timestamp always give the same output.
+class GrainFilter {
+public:
+    GrainFilter();
+    ~GrainFilter();
+
+    // intensity 0.0 to 2.0; 1.0 matches VideoEffects.applyGrain (about +-25 levels)
+    void apply(VideoFrame& frame, float intensity, uint32_t seed);
+
+    // The frame is rows [top, top + height) of a larger one; grain lines up across bands
+    void apply(VideoFrame& frame, float intensity, uint32_t seed, int top);
+
+    static constexpr int kTileSize = 128;  // Also the block size
+    static constexpr int kTileCount = 8;
+
+private:
+    // Signed grain samples, kTileCount tiles of kTileSize^2; built once and shared
+    static const std::vector<int8_t>& tiles();
+
+    int16_t m_lumaWeight[256];  // Q8 grain strength by luma, weaker in shadows and highlights
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_GRAIN_FILTER_H
@@ -0,0 +1,330 @@
+#include "mask_compositor.h"
+#include "pixel_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+// Per output column (or row): source index << 8 | Q8 weight of the next one.
+// Centres are aligned the way Bitmap.createScaledBitmap filters.
+void buildTaps(int srcSize, int dstSize, std::vector<int32_t>& taps) {
+    taps.resize(dstSize);
+    float ratio = static_cast<float>(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; i++) {
+        float pos = std::max(0.0f, std::min((i + 0.5f) * ratio - 0.5f, static_cast<float>(srcSize - 1)));
+        int index = static_cast<int>(pos);
+        int weight = static_cast<int>((pos - index) * 256.0f);
+        taps[i] = (index << 8) | weight;
+    }
+}
+
+// Bilinear resize of rows [rowBegin, rowEnd) of dst. The two source rows are
+// blended once per output row at source width, which is the smaller one when
+// upsampling, so each output sample is then a single horizontal lerp.
+template <int Channels>
+void resizeRows(const uint8_t* src, int srcWidth, int srcHeight, size_t srcStride, uint8_t* dst, int dstWidth,
+                const int32_t* columns, const int32_t* rows, int rowBegin, int rowEnd) {
+    std::vector<uint16_t> blended((static_cast<size_t>(srcWidth) + 1) * Channels);
+    
+    for (int y = rowBegin; y < rowEnd; y++) {
+        int sy = rows[y] >> 8;
+        int fy = rows[y] & 0xFF;
+        const uint8_t* top = src + sy * srcStride;
+        const uint8_t* bottom = src + std::min(sy + 1, srcHeight - 1) * srcStride;
+        for (int i = 0; i < srcWidth * Channels; i++) {
+            blended[i] = static_cast<uint16_t>(top[i] * (256 - fy) + bottom[i] * fy);
+        }
+        // Repeat the last pixel so the right edge needs no clamp
+        for (int c = 0; c < Channels; c++) {
+            blended[srcWidth * Channels + c] = blended[(srcWidth - 1) * Channels + c];
+        }
+        
+        uint8_t* out = dst + static_cast<size_t>(y) * dstWidth * Channels;
+        for (int x = 0; x < dstWidth; x++, out += Channels) {
+            const uint16_t* left = blended.data() + (columns[x] >> 8) * Channels;
+            int fx = columns[x] & 0xFF;
+            for (int c = 0; c < Channels; c++) {
+                out[c] = static_cast<uint8_t>((left[c] * (256 - fx) + left[c + Channels] * fx + 32768) >> 16);
+            }
+        }
+    }
+}
+
+// Area-average rows [rowBegin, rowEnd) of dst from factor x factor blocks of src (RGBA)
+void downsampleRows(const uint8_t* src, int srcWidth, int srcHeight, uint8_t* dst, int dstWidth, int factor,
+                    int rowBegin, int rowEnd) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+        int top = y * factor;
+        int bottom = std::min(top + factor, srcHeight);
+        uint8_t* out = dst + static_cast<size_t>(y) * dstWidth * 4;
+        for (int x = 0; x < dstWidth; x++, out += 4) {
+            int left = x * factor;
+            int right = std::min(left + factor, srcWidth);
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int sy = top; sy < bottom; sy++) {
+                const uint8_t* in = src + (static_cast<size_t>(sy) * srcWidth + left) * 4;
+                for (int sx = left; sx < right; sx++, in += 4) {
+                    sum[0] += in[0];
+                    sum[1] += in[1];
+                    sum[2] += in[2];
+                    sum[3] += in[3];
+                }
+            }
+            uint32_t count = static_cast<uint32_t>((bottom - top) * (right - left));
+            for (int c = 0; c < 4; c++) {
+                out[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+MaskCompositor::MaskCompositor()
+    : m_threadPool(nullptr)
+    , m_imageScaled(false) {
+    LOGI("MaskCompositor created");
+}
+
+MaskCompositor::~MaskCompositor() {
+    LOGI("MaskCompositor destroyed");
+}
+
+void MaskCompositor::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+    m_blur.setThreadPool(pool);
+    m_refiner.setThreadPool(pool);
+}
+
+void MaskCompositor::setBackgroundImage(const uint8_t* pixels, int width, int height, int stride) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_imageScaled = false;
+    if (!pixels || width <= 0 || height <= 0 || stride < width * 4) {
+        m_image = VideoFrame();
+        return;
+    }
+    
+    m_image.width = width;
+    m_image.height = height;
+    m_image.format = PixelFormat::RGBA;
+    m_image.data.resize(m_image.dataSize());
+    for (int y = 0; y < height; y++) {
+        memcpy(m_image.data.data() + static_cast<size_t>(y) * width * 4, pixels + static_cast<size_t>(y) * stride,
+               static_cast<size_t>(width) * 4);
+    }
+}
+
+bool MaskCompositor::apply(VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight,
+                           int matteStride, const MaskCompositeParams& params) {
+    if (!matte || matteWidth <= 0 || matteHeight <= 0 || matteStride < matteWidth ||
+        frame.width <= 0 || frame.height <= 0 || frame.format != PixelFormat::RGBA ||
+        frame.data.size() < frame.dataSize()) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int width = frame.width;
+    const int height = frame.height;
+    
+    // Refine in matte space: a low-resolution matte needs proportionally smaller windows
+    float scale = static_cast<float>(matteWidth) / width;
+    auto toMatte = [scale](int radius) {
+        if (radius == 0) return 0;
+        int scaled = std::max(1, static_cast<int>(std::lround(std::abs(radius) * scale)));
+        return radius < 0 ? -scaled : scaled;
+    };
+    MatteRefineParams refine = params.refine;
+    refine.openRadius = toMatte(refine.openRadius);
+    refine.closeRadius = toMatte(refine.closeRadius);
+    refine.shrinkRadius = toMatte(refine.shrinkRadius);
+    refine.guidedRadius = toMatte(refine.guidedRadius);
+    refine.featherRadius = toMatte(refine.featherRadius);
+    refineMatte(frame, matte, matteWidth, matteHeight, matteStride, refine);
+    upsampleMatte(matteWidth, matteHeight, width, height);
+    
+    if (params.background == MaskBackground::Transparent) {
+        // Alpha from the matte; RGB is scaled too when the target is premultiplied
+        bool premultiplied = params.premultiplied;
+        forRows(height, [&](int rowBegin, int rowEnd) {
+            for (int y = rowBegin; y < rowEnd; y++) {
+                uint8_t* px = frame.data.data() + static_cast<size_t>(y) * width * 4;
+                const uint8_t* m = m_matte.data() + static_cast<size_t>(y) * width;
+                for (int x = 0; x < width; x++, px += 4) {
+                    int weight = m[x] + (m[x] >> 7);
+                    px[3] = static_cast<uint8_t>((px[3] * weight + 128) >> 8);
+                    if (premultiplied) {
+                        px[0] = static_cast<uint8_t>((px[0] * weight + 128) >> 8);
+                        px[1] = static_cast<uint8_t>((px[1] * weight + 128) >> 8);
+                        px[2] = static_cast<uint8_t>((px[2] * weight + 128) >> 8);
+                    }
+                }
+            }
+        });
+        return true;
+    }
+    
+    if (!prepareBackground(frame, params)) {
+        return false;
+    }
+    
+    const PixelKernels& kernels = pixelKernels();
+    bool solid = params.background == MaskBackground::Color;
+    forRows(height, [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            size_t offset = static_cast<size_t>(y) * width;
+            const uint8_t* bg = solid ? m_colorRow.data() : m_background.data.data() + offset * 4;
+            kernels.blendMatte(frame.data.data() + offset * 4, bg, m_matte.data() + offset, width);
+        }
+    });
+    return true;
+}
+
+void MaskCompositor::refineMatte(const VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight,
+                                 int matteStride, const MatteRefineParams& params) {
+    m_refined.resize(static_cast<size_t>(matteWidth) * matteHeight);
+    for (int y = 0; y < matteHeight; y++) {
+        memcpy(m_refined.data() + static_cast<size_t>(y) * matteWidth,
+               matte + static_cast<size_t>(y) * matteStride, matteWidth);
+    }
+    
+    const uint8_t* guide = nullptr;
+    if (params.guidedRadius > 0) {
+        // Frame luma at the matte's size; a full-size matte uses the frame as it is
+        const VideoFrame* source = &frame;
+        if (matteWidth != frame.width || matteHeight != frame.height) {
+            m_scaledFrame.width = matteWidth;
+            m_scaledFrame.height = matteHeight;
+            m_scaledFrame.format = PixelFormat::RGBA;
+            m_scaledFrame.data.resize(m_scaledFrame.dataSize());
+            std::vector<int32_t> columns;
+            std::vector<int32_t> rows;
+            buildTaps(frame.width, matteWidth, columns);
+            buildTaps(frame.height, matteHeight, rows);
+            forRows(matteHeight, [&](int rowBegin, int rowEnd) {
+                resizeRows<4>(frame.data.data(), frame.width, frame.height, static_cast<size_t>(frame.width) * 4,
+                              m_scaledFrame.data.data(), matteWidth, columns.data(), rows.data(), rowBegin, rowEnd);
+            });
+            source = &m_scaledFrame;
+        }
+        m_guide.resize(m_refined.size());
+        pixelKernels().extractLuma(source->data.data(), m_guide.data(), m_guide.size());
+        guide = m_guide.data();
+    }
+    
+    m_refiner.refine(m_refined.data(), guide, matteWidth, matteHeight, params);
+}
+
+void MaskCompositor::upsampleMatte(int matteWidth, int matteHeight, int width, int height) {
+    m_matte.resize(static_cast<size_t>(width) * height);
+    if (matteWidth == width && matteHeight == height) {
+        memcpy(m_matte.data(), m_refined.data(), m_matte.size());
+        return;
+    }
+    
+    std::vector<int32_t> columns;
+    std::vector<int32_t> rows;
+    buildTaps(matteWidth, width, columns);
+    buildTaps(matteHeight, height, rows);
+    forRows(height, [&](int rowBegin, int rowEnd) {
+        resizeRows<1>(m_refined.data(), matteWidth, matteHeight, matteWidth, m_matte.data(), width,
+                      columns.data(), rows.data(), rowBegin, rowEnd);
+    });
+}
+
+bool MaskCompositor::prepareBackground(const VideoFrame& frame, const MaskCompositeParams& params) {
+    const int width = frame.width;
+    const int height = frame.height;
+    
+    switch (params.background) {
+        case MaskBackground::Transparent:
+            return false;
+        
+        case MaskBackground::Color: {
+            uint8_t rgba[4] = {
+                static_cast<uint8_t>(params.color >> 16), static_cast<uint8_t>(params.color >> 8),
+                static_cast<uint8_t>(params.color), static_cast<uint8_t>(params.color >> 24)
+            };
+            m_colorRow.resize(static_cast<size_t>(width) * 4);
+            for (int x = 0; x < width; x++) {
+                memcpy(m_colorRow.data() + x * 4, rgba, 4);
+            }
+            return true;
+        }
+        
+        case MaskBackground::Blur: {
+            // Box blur, as BackgroundRemover.blurBitmap. A wide blur leaves no detail
+            // worth keeping, so it runs on a copy shrunk by about radius / 4 and is
+            // scaled back up bilinearly.
+            int factor = std::max(1, std::min(params.blurRadius / kBlurDetail, kMaxBlurDownscale));
+            int smallWidth = (width + factor - 1) / factor;
+            int smallHeight = (height + factor - 1) / factor;
+            m_blurred.width = smallWidth;
+            m_blurred.height = smallHeight;
+            m_blurred.format = PixelFormat::RGBA;
+            m_blurred.data.resize(m_blurred.dataSize());
+            forRows(smallHeight, [&](int rowBegin, int rowEnd) {
+                downsampleRows(frame.data.data(), width, height, m_blurred.data.data(), smallWidth, factor,
+                               rowBegin, rowEnd);
+            });
+            m_blur.boxBlur(m_blurred, std::max(1, (params.blurRadius + factor / 2) / factor));
+            
+            m_background.width = width;
+            m_background.height = height;
+            m_background.format = PixelFormat::RGBA;
+            m_background.data.resize(m_background.dataSize());
+            std::vector<int32_t> columns;
+            std::vector<int32_t> rows;
+            buildTaps(smallWidth, width, columns);
+            buildTaps(smallHeight, height, rows);
+            forRows(height, [&](int rowBegin, int rowEnd) {
+                resizeRows<4>(m_blurred.data.data(), smallWidth, smallHeight, static_cast<size_t>(smallWidth) * 4,
+                              m_background.data.data(), width, columns.data(), rows.data(), rowBegin, rowEnd);
+            });
+            m_imageScaled = false;
+            return true;
+        }
+        
+        case MaskBackground::Image:
+            if (m_image.data.empty()) {
+                LOGW("No background image set for mask composite");
+                return false;
+            }
+            if (m_imageScaled && m_background.width == width && m_background.height == height) {
+                return true;
+            }
+            
+            // Stretched to the frame, as Bitmap.createScaledBitmap did
+            m_background.width = width;
+            m_background.height = height;
+            m_background.format = PixelFormat::RGBA;
+            m_background.data.resize(m_background.dataSize());
+            {
+                std::vector<int32_t> columns;
+                std::vector<int32_t> rows;
+                buildTaps(m_image.width, width, columns);
+                buildTaps(m_image.height, height, rows);
+                forRows(height, [&](int rowBegin, int rowEnd) {
+                    resizeRows<4>(m_image.data.data(), m_image.width, m_image.height,
+                                  static_cast<size_t>(m_image.width) * 4, m_background.data.data(), width,
+                                  columns.data(), rows.data(), rowBegin, rowEnd);
+                });
+            }
+            m_imageScaled = true;
+            return true;
+    }
+    return false;
+}
+
+void MaskCompositor::forRows(int height, const std::function<void(int, int)>& body) {
+    if (m_threadPool) {
+        m_threadPool->parallelFor(0, height, kMinBandRows, body);
+    } else {
+        body(0, height);
+    }
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,85 @@
+#ifndef VIDEO_EDITOR_MASK_COMPOSITOR_H
+#define VIDEO_EDITOR_MASK_COMPOSITOR_H
+
+#include "common.h"
+#include "blur_filter.h"
+#include "matte_refiner.h"
+#include "thread_pool.h"
+
+namespace videoeditor {
+
+// What shows through where the matte is 0; same set as
+// VideoBackgroundProcessor.BackgroundMode
+enum class MaskBackground {
+    Transparent,
+    Color,
+    Blur,
+    Image
+};
+
+struct MaskCompositeParams {
+    MaskBackground background = MaskBackground::Blur;
+    uint32_t color = 0xFF00FF00;    // ARGB, for Color
+    int blurRadius = 25;            // Box radius in frame pixels, for Blur
+    MatteRefineParams refine;       // Matte clean-up; radii in frame pixels
+    bool premultiplied = false;     // Transparent output goes to a premultiplied bitmap
+};
+
+// Background replacement from a segmentation matte. The matte (8-bit, 255 =
+// foreground) may come at the model's resolution: it is refined there, where
+// it is cheapest, then upsampled bilinearly to the frame, and every row is
+// blended over the background with the SIMD blendMatte kernel.
+class MaskCompositor {
+public:
+    MaskCompositor();
+    ~MaskCompositor();
+
+    // Rows are split into bands across the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // RGBA background for MaskBackground::Image, copied; it is scaled to the
+    // frame size once and reused until replaced or the frame size changes
+    void setBackgroundImage(const uint8_t* pixels, int width, int height, int stride);
+
+    // Composite frame (RGBA) in place; matteStride is bytes per matte row
+    bool apply(VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight, int matteStride,
+               const MaskCompositeParams& params);
+
+private:
+    // Refined copy of the matte at its own resolution in m_refined; the guide is
+    // the frame's luma scaled to the matte
+    void refineMatte(const VideoFrame& frame, const uint8_t* matte, int matteWidth, int matteHeight,
+                     int matteStride, const MatteRefineParams& params);
+
+    // Bilinear upsample of m_refined to width x height into m_matte
+    void upsampleMatte(int matteWidth, int matteHeight, int width, int height);
+
+    // m_background filled for the mode; false if there is nothing to draw behind
+    bool prepareBackground(const VideoFrame& frame, const MaskCompositeParams& params);
+
+    // Run body over row bands on the pool, or inline without one
+    void forRows(int height, const std::function<void(int, int)>& body);
+
+    static constexpr int kMinBandRows = 32;
+    static constexpr int kBlurDetail = 4;         // Blur radius per pixel of downscale
+    static constexpr int kMaxBlurDownscale = 8;
+
+    BlurFilter m_blur;
+    MatteRefiner m_refiner;
+    ThreadPool* m_threadPool;
+    std::vector<uint8_t> m_refined;     // Matte resolution
+    std::vector<uint8_t> m_guide;       // Frame luma at matte resolution
+    VideoFrame m_scaledFrame;           // Frame at matte resolution, for the guide
+    std::vector<uint8_t> m_matte;       // Frame resolution
+    VideoFrame m_background;            // Frame-sized background for Blur and Image
+    VideoFrame m_blurred;               // Downscaled copy the blur runs on
+    std::vector<uint8_t> m_colorRow;    // One row of the solid colour
+
+    VideoFrame m_image;                 // Background image as uploaded
+    bool m_imageScaled;                 // m_background holds m_image at the current frame size
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_MASK_COMPOSITOR_H
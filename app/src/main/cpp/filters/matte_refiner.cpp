@@ -0,0 +1,397 @@
+#include "matte_refiner.h"
+#include "pixel_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+namespace {
+
+struct MinOp {
+    static constexpr uint8_t kIdentity = 255;
+    static uint8_t apply(uint8_t a, uint8_t b) { return a < b ? a : b; }
+};
+
+struct MaxOp {
+    static constexpr uint8_t kIdentity = 0;
+    static uint8_t apply(uint8_t a, uint8_t b) { return a > b ? a : b; }
+};
+
+// Van Herk/Gil-Werman pass down columns [columnBegin, columnEnd). The column
+// is padded with the identity by radius at each end and cut into blocks of
+// the window size; prefix runs forward from each block start, suffix backward
+// from each block end, and every window [y, y + 2r] spans at most two blocks,
+// so its result is op(suffix[y], prefix[y + 2r]). The elements are whole row
+// segments, so every inner loop runs along x and vectorises.
+template <class Op>
+void verticalPass(uint8_t* matte, int width, int height, int radius, int columnBegin, int columnEnd) {
+    const int window = radius * 2 + 1;
+    const int padded = height + radius * 2;
+    const size_t span = static_cast<size_t>(columnEnd - columnBegin);
+    static thread_local std::vector<uint8_t> scratch;
+    scratch.resize(span * (static_cast<size_t>(padded) * 2 + 1));
+    uint8_t* prefix = scratch.data();
+    uint8_t* suffix = prefix + span * padded;
+    uint8_t* identity = suffix + span * padded;
+    memset(identity, Op::kIdentity, span);
+    
+    auto source = [&](int i) -> const uint8_t* {
+        int y = i - radius;
+        return y < 0 || y >= height ? identity : matte + static_cast<size_t>(y) * width + columnBegin;
+    };
+    
+    for (int start = 0; start < padded; start += window) {
+        int end = std::min(start + window, padded);
+        memcpy(prefix + start * span, source(start), span);
+        for (int i = start + 1; i < end; i++) {
+            const uint8_t* in = source(i);
+            const uint8_t* previous = prefix + (i - 1) * span;
+            uint8_t* out = prefix + i * span;
+            for (size_t x = 0; x < span; x++) {
+                out[x] = Op::apply(previous[x], in[x]);
+            }
+        }
+        memcpy(suffix + (end - 1) * span, source(end - 1), span);
+        for (int i = end - 2; i >= start; i--) {
+            const uint8_t* in = source(i);
+            const uint8_t* next = suffix + (i + 1) * span;
+            uint8_t* out = suffix + i * span;
+            for (size_t x = 0; x < span; x++) {
+                out[x] = Op::apply(next[x], in[x]);
+            }
+        }
+    }
+    
+    for (int y = 0; y < height; y++) {
+        const uint8_t* s = suffix + y * span;
+        const uint8_t* p = prefix + (y + radius * 2) * span;
+        uint8_t* out = matte + static_cast<size_t>(y) * width + columnBegin;
+        for (size_t x = 0; x < span; x++) {
+            out[x] = Op::apply(s[x], p[x]);
+        }
+    }
+}
+
+// Horizontal pass over rows [rowBegin, rowEnd): each band of rows is transposed
+// so the vertical pass can run along it, then transposed back
+template <class Op>
+void horizontalPass(uint8_t* matte, int width, int radius, int rowBegin, int rowEnd, int bandRows) {
+    const PixelKernels& kernels = pixelKernels();
+    static thread_local std::vector<uint8_t> transposed;
+    transposed.resize(static_cast<size_t>(width) * bandRows);
+    
+    for (int y = rowBegin; y < rowEnd; y += bandRows) {
+        int rows = std::min(bandRows, rowEnd - y);
+        uint8_t* band = matte + static_cast<size_t>(y) * width;
+        kernels.transposePlane(band, width, transposed.data(), rows, width, rows);
+        verticalPass<Op>(transposed.data(), rows, width, radius, 0, rows);
+        kernels.transposePlane(transposed.data(), rows, band, width, rows, width);
+    }
+}
+
+// Area average of step x step blocks of an 8-bit plane, scaled to 0-1. Source
+// rows are summed whole first, which vectorises, so only the column sums are
+// added up per block.
+void downsampleToFloat(const uint8_t* src, int width, int height, int step, float* dst, int dstWidth,
+                       int dstHeight) {
+    std::vector<uint32_t> columnSums(width);
+    for (int y = 0; y < dstHeight; y++) {
+        int top = y * step;
+        int bottom = std::min(top + step, height);
+        std::fill(columnSums.begin(), columnSums.end(), 0);
+        for (int sy = top; sy < bottom; sy++) {
+            const uint8_t* in = src + static_cast<size_t>(sy) * width;
+            for (int x = 0; x < width; x++) {
+                columnSums[x] += in[x];
+            }
+        }
+        
+        for (int x = 0; x < dstWidth; x++) {
+            int left = x * step;
+            int right = std::min(left + step, width);
+            uint32_t sum = 0;
+            for (int sx = left; sx < right; sx++) {
+                sum += columnSums[sx];
+            }
+            dst[static_cast<size_t>(y) * dstWidth + x] = sum / (255.0f * (bottom - top) * (right - left));
+        }
+    }
+}
+
+// Position of output index i on a grid subsampled by step, centre aligned
+void sampleTaps(int size, int step, int gridSize, std::vector<int>& index, std::vector<float>& weight) {
+    index.resize(size);
+    weight.resize(size);
+    for (int i = 0; i < size; i++) {
+        float pos = (i + 0.5f) / step - 0.5f;
+        pos = std::max(0.0f, std::min(pos, static_cast<float>(gridSize - 1)));
+        index[i] = std::min(static_cast<int>(pos), gridSize - 1);
+        weight[i] = pos - index[i];
+    }
+}
+
+}  // namespace
+
+MatteRefiner::MatteRefiner()
+    : m_threadPool(nullptr) {
+    LOGI("MatteRefiner created");
+}
+
+MatteRefiner::~MatteRefiner() {
+    LOGI("MatteRefiner destroyed");
+}
+
+void MatteRefiner::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+    m_blur.setThreadPool(pool);
+}
+
+void MatteRefiner::erode(uint8_t* matte, int width, int height, int radius) {
+    morphology(matte, width, height, radius, false);
+}
+
+void MatteRefiner::dilate(uint8_t* matte, int width, int height, int radius) {
+    morphology(matte, width, height, radius, true);
+}
+
+void MatteRefiner::open(uint8_t* matte, int width, int height, int radius) {
+    morphology(matte, width, height, radius, false);
+    morphology(matte, width, height, radius, true);
+}
+
+void MatteRefiner::close(uint8_t* matte, int width, int height, int radius) {
+    morphology(matte, width, height, radius, true);
+    morphology(matte, width, height, radius, false);
+}
+
+void MatteRefiner::feather(uint8_t* matte, int width, int height, int radius) {
+    // Two box passes make a tent, which ramps the edge without the box's flat shoulders
+    if (radius > 0) {
+        m_blur.boxBlurPlane(matte, width, height, radius);
+        m_blur.boxBlurPlane(matte, width, height, radius);
+    }
+}
+
+void MatteRefiner::refine(uint8_t* matte, const uint8_t* guide, int width, int height,
+                          const MatteRefineParams& params) {
+    open(matte, width, height, params.openRadius);
+    close(matte, width, height, params.closeRadius);
+    if (params.shrinkRadius > 0) {
+        erode(matte, width, height, params.shrinkRadius);
+    } else if (params.shrinkRadius < 0) {
+        dilate(matte, width, height, -params.shrinkRadius);
+    }
+    if (guide) {
+        guidedFilter(matte, guide, width, height, params.guidedRadius, params.guidedEpsilon);
+    }
+    feather(matte, width, height, params.featherRadius);
+}
+
+void MatteRefiner::morphology(uint8_t* matte, int width, int height, int radius, bool dilate) {
+    if (!matte || radius <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+    
+    // A window wider than the matte sees the same pixels as one that just covers it
+    radius = std::min(radius, std::max(width, height));
+    
+    forRows(height, [=](int rowBegin, int rowEnd) {
+        if (dilate) {
+            horizontalPass<MaxOp>(matte, width, radius, rowBegin, rowEnd, kStripeWidth);
+        } else {
+            horizontalPass<MinOp>(matte, width, radius, rowBegin, rowEnd, kStripeWidth);
+        }
+    });
+    
+    int stripes = (width + kStripeWidth - 1) / kStripeWidth;
+    auto columns = [=](int stripeBegin, int stripeEnd) {
+        for (int stripe = stripeBegin; stripe < stripeEnd; stripe++) {
+            int columnBegin = stripe * kStripeWidth;
+            int columnEnd = std::min(columnBegin + kStripeWidth, width);
+            if (dilate) {
+                verticalPass<MaxOp>(matte, width, height, radius, columnBegin, columnEnd);
+            } else {
+                verticalPass<MinOp>(matte, width, height, radius, columnBegin, columnEnd);
+            }
+        }
+    };
+    if (m_threadPool) {
+        m_threadPool->parallelFor(0, stripes, 1, columns);
+    } else {
+        columns(0, stripes);
+    }
+}
+
+void MatteRefiner::guidedFilter(uint8_t* matte, const uint8_t* guide, int width, int height, int radius,
+                                float epsilon) {
+    if (!matte || !guide || radius <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+    
+    // The coefficients vary slowly, so they are solved on a coarser grid
+    int step = std::max(1, (std::max(width, height) + kGuidedWorkSize - 1) / kGuidedWorkSize);
+    int gridWidth = (width + step - 1) / step;
+    int gridHeight = (height + step - 1) / step;
+    int gridRadius = std::max(1, (radius + step / 2) / step);
+    size_t count = static_cast<size_t>(gridWidth) * gridHeight;
+    
+    m_planes.resize(count * 8);
+    float* guideMean = m_planes.data();
+    float* matteMean = guideMean + count;
+    float* crossMean = matteMean + count;
+    float* guideSquareMean = crossMean + count;
+    float* guideGrid = guideSquareMean + count;
+    float* matteGrid = guideGrid + count;
+    float* cross = matteGrid + count;
+    float* guideSquare = cross + count;
+    
+    downsampleToFloat(guide, width, height, step, guideGrid, gridWidth, gridHeight);
+    downsampleToFloat(matte, width, height, step, matteGrid, gridWidth, gridHeight);
+    for (size_t i = 0; i < count; i++) {
+        cross[i] = guideGrid[i] * matteGrid[i];
+        guideSquare[i] = guideGrid[i] * guideGrid[i];
+    }
+    boxMean(guideGrid, guideMean, gridWidth, gridHeight, gridRadius);
+    boxMean(matteGrid, matteMean, gridWidth, gridHeight, gridRadius);
+    boxMean(cross, crossMean, gridWidth, gridHeight, gridRadius);
+    boxMean(guideSquare, guideSquareMean, gridWidth, gridHeight, gridRadius);
+    
+    // Per window: matte ~= a * guide + b, least squares with a ridge of epsilon on a
+    float* a = cross;
+    float* b = guideSquare;
+    for (size_t i = 0; i < count; i++) {
+        float covariance = crossMean[i] - guideMean[i] * matteMean[i];
+        float variance = guideSquareMean[i] - guideMean[i] * guideMean[i];
+        a[i] = covariance / (variance + epsilon);
+        b[i] = matteMean[i] - a[i] * guideMean[i];
+    }
+    
+    // Each pixel averages the coefficients of every window that covers it
+    float* meanA = guideGrid;
+    float* meanB = matteGrid;
+    boxMean(a, meanA, gridWidth, gridHeight, gridRadius);
+    boxMean(b, meanB, gridWidth, gridHeight, gridRadius);
+    
+    // Back at full resolution with the full-resolution guide, so the edge is sharp.
+    // Grid rows of coefficients are interpolated out to the full width once and
+    // kept while the output rows between them are blended, so the per-pixel
+    // loop has no gathers and vectorises.
+    std::vector<int> columnIndex;
+    std::vector<float> columnWeight;
+    std::vector<int> rowIndex;
+    std::vector<float> rowWeight;
+    sampleTaps(width, step, gridWidth, columnIndex, columnWeight);
+    sampleTaps(height, step, gridHeight, rowIndex, rowWeight);
+    
+    auto expandRow = [&](int gridRow, float* outA, float* outB) {
+        const float* rowA = meanA + static_cast<size_t>(gridRow) * gridWidth;
+        const float* rowB = meanB + static_cast<size_t>(gridRow) * gridWidth;
+        for (int x = 0; x < width; x++) {
+            int i = columnIndex[x];
+            int next = std::min(i + 1, gridWidth - 1);
+            float fx = columnWeight[x];
+            outA[x] = rowA[i] + (rowA[next] - rowA[i]) * fx;
+            outB[x] = (rowB[i] + (rowB[next] - rowB[i]) * fx) * 255.0f + 0.5f;
+        }
+    };
+    
+    forRows(height, [&](int rowBegin, int rowEnd) {
+        // Local copy: the byte stores could alias a captured width, which stops vectorisation
+        const int columns = width;
+        std::vector<float> expanded(static_cast<size_t>(columns) * 4);
+        float* topA = expanded.data();
+        float* topB = topA + columns;
+        float* bottomA = topB + columns;
+        float* bottomB = bottomA + columns;
+        int cachedRow = -2;
+        
+        for (int y = rowBegin; y < rowEnd; y++) {
+            int top = rowIndex[y];
+            if (top != cachedRow) {
+                if (top == cachedRow + 1) {
+                    std::swap(topA, bottomA);
+                    std::swap(topB, bottomB);
+                } else {
+                    expandRow(top, topA, topB);
+                }
+                expandRow(std::min(top + 1, gridHeight - 1), bottomA, bottomB);
+                cachedRow = top;
+            }
+            
+            float fy = rowWeight[y];
+            const uint8_t* g = guide + static_cast<size_t>(y) * columns;
+            uint8_t* out = matte + static_cast<size_t>(y) * columns;
+            for (int x = 0; x < columns; x++) {
+                float ca = topA[x] + (bottomA[x] - topA[x]) * fy;
+                float cb = topB[x] + (bottomB[x] - topB[x]) * fy;
+                float value = ca * g[x] + cb;
+                out[x] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, value)));
+            }
+        }
+    });
+}
+
+void MatteRefiner::boxMean(const float* src, float* dst, int width, int height, int radius) {
+    m_boxTemp.resize(static_cast<size_t>(width) * (height + 2));
+    float* sums = m_boxTemp.data();
+    float* accumulator = sums + static_cast<size_t>(width) * height;
+    float* columnScale = accumulator + width;
+    
+    // Horizontal window sums, the window truncated at the edges
+    for (int y = 0; y < height; y++) {
+        const float* in = src + static_cast<size_t>(y) * width;
+        float* out = sums + static_cast<size_t>(y) * width;
+        float sum = 0.0f;
+        for (int x = 0; x <= std::min(radius, width - 1); x++) {
+            sum += in[x];
+        }
+        for (int x = 0; x < width; x++) {
+            out[x] = sum;
+            if (x + radius + 1 < width) sum += in[x + radius + 1];
+            if (x - radius >= 0) sum -= in[x - radius];
+        }
+    }
+    
+    for (int x = 0; x < width; x++) {
+        columnScale[x] = 1.0f / (std::min(x + radius, width - 1) - std::max(x - radius, 0) + 1);
+    }
+    
+    // Vertical sums a row at a time, so the inner loops run along x
+    std::fill(accumulator, accumulator + width, 0.0f);
+    for (int y = 0; y <= std::min(radius, height - 1); y++) {
+        const float* row = sums + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            accumulator[x] += row[x];
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        float rowScale = 1.0f / (std::min(y + radius, height - 1) - std::max(y - radius, 0) + 1);
+        float* out = dst + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            out[x] = accumulator[x] * columnScale[x] * rowScale;
+        }
+        if (y + radius + 1 < height) {
+            const float* row = sums + static_cast<size_t>(y + radius + 1) * width;
+            for (int x = 0; x < width; x++) {
+                accumulator[x] += row[x];
+            }
+        }
+        if (y - radius >= 0) {
+            const float* row = sums + static_cast<size_t>(y - radius) * width;
+            for (int x = 0; x < width; x++) {
+                accumulator[x] -= row[x];
+            }
+        }
+    }
+}
+
+void MatteRefiner::forRows(int height, const std::function<void(int, int)>& body) {
+    if (m_threadPool) {
+        m_threadPool->parallelFor(0, height, kMinBandRows, body);
+    } else {
+        body(0, height);
+    }
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,72 @@
+#ifndef VIDEO_EDITOR_MATTE_REFINER_H
+#define VIDEO_EDITOR_MATTE_REFINER_H
+
+#include "common.h"
+#include "blur_filter.h"
+#include "thread_pool.h"
+
+namespace videoeditor {
+
+// Clean-up applied to a segmentation matte, in this order. Radii are in matte
+// pixels; 0 skips the step.
+struct MatteRefineParams {
+    int openRadius = 0;           // Erode then dilate: drops foreground specks smaller than the window
+    int closeRadius = 0;          // Dilate then erode: fills holes and notches in the foreground
+    int shrinkRadius = 0;         // Erodes the matte, or dilates it when negative
+    int guidedRadius = 0;         // Edge-aware pass against the frame's luma
+    float guidedEpsilon = 0.01f;  // Guided filter regulariser; larger smooths more across weak edges
+    int featherRadius = 0;        // Tent blur of the final edge
+};
+
+// Morphology and edge refinement on 8-bit mattes (255 = foreground). Erode and
+// dilate are separable running min/max over a (2r + 1)^2 square using the van
+// Herk/Gil-Werman scheme: three compares per pixel and direction whatever the
+// radius. The vertical pass works on whole rows, so it vectorises; rows and
+// column stripes are split across the thread pool.
+class MatteRefiner {
+public:
+    MatteRefiner();
+    ~MatteRefiner();
+
+    // Null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // All in place on a tightly packed width x height matte
+    void erode(uint8_t* matte, int width, int height, int radius);
+    void dilate(uint8_t* matte, int width, int height, int radius);
+    void open(uint8_t* matte, int width, int height, int radius);
+    void close(uint8_t* matte, int width, int height, int radius);
+    void feather(uint8_t* matte, int width, int height, int radius);
+
+    // Guided filter (He et al.) with the guide luma at the matte's size: the
+    // matte becomes a local linear function of the guide, so its edge follows
+    // the image edge. Large mattes are solved on a grid subsampled to about
+    // kGuidedWorkSize and the coefficients interpolated back (the fast variant).
+    void guidedFilter(uint8_t* matte, const uint8_t* guide, int width, int height, int radius, float epsilon);
+
+    // Every step of params; guide may be null, which skips the guided pass
+    void refine(uint8_t* matte, const uint8_t* guide, int width, int height, const MatteRefineParams& params);
+
+    static constexpr int kGuidedWorkSize = 512;
+
+private:
+    // Erode (running min) or dilate (running max)
+    void morphology(uint8_t* matte, int width, int height, int radius, bool dilate);
+
+    // Mean over the (2r + 1)^2 window, truncated at the edges, through m_boxTemp
+    void boxMean(const float* src, float* dst, int width, int height, int radius);
+
+    void forRows(int height, const std::function<void(int, int)>& body);
+
+    static constexpr int kMinBandRows = 32;
+    static constexpr int kStripeWidth = 128;  // Columns per vertical-pass task; its buffers stay in L2
+
+    BlurFilter m_blur;
+    ThreadPool* m_threadPool;
+    std::vector<float> m_planes;    // Guided filter working set, at the subsampled size
+    std::vector<float> m_boxTemp;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_MATTE_REFINER_H
@@ -0,0 +1,451 @@
+#include "pixel_kernels.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/system_properties.h>
+
+namespace videoeditor {
+
+namespace {
+
+void colorMatrixScalar(const FixedColorMatrix& matrix, uint8_t* rgba, size_t pixelCount) {
+    const int32_t round = 1 << (matrix.shift - 1);
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        int32_t in[4] = {px[0], px[1], px[2], px[3]};
+        
+        for (int row = 0; row < 4; row++) {
+            const int16_t* m = matrix.coef + row * 4;
+            int32_t acc = matrix.offset[row] + m[0] * in[0] + m[1] * in[1] + m[2] * in[2] + m[3] * in[3];
+            acc = (acc + round) >> matrix.shift;
+            px[row] = static_cast<uint8_t>(std::max(0, std::min(255, acc)));
+        }
+    }
+}
+
+void extractLumaScalar(const uint8_t* rgba, uint8_t* luma, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        const uint8_t* px = rgba + i * 4;
+        luma[i] = static_cast<uint8_t>((77 * px[0] + 150 * px[1] + 29 * px[2] + 128) >> 8);
+    }
+}
+
+void addDetailScalar(uint8_t* rgba, const uint8_t* luma, const uint8_t* blurred, size_t pixelCount,
+                     int amountQ8, int threshold) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        int diff = luma[i] - blurred[i];
+        if (std::abs(diff) <= threshold) continue;
+        
+        int delta = static_cast<int16_t>((diff * amountQ8 + 128) >> 8);
+        uint8_t* px = rgba + i * 4;
+        for (int c = 0; c < 3; c++) {
+            px[c] = static_cast<uint8_t>(std::max(0, std::min(255, px[c] + delta)));
+        }
+    }
+}
+
+void blendRgbScalar(uint8_t* dst, const uint8_t* src, size_t pixelCount, int alpha) {
+    int inverse = 256 - alpha;
+    for (size_t i = 0; i < pixelCount * 4; i += 4) {
+        dst[i + 0] = static_cast<uint8_t>((src[i + 0] * alpha + dst[i + 0] * inverse + 128) >> 8);
+        dst[i + 1] = static_cast<uint8_t>((src[i + 1] * alpha + dst[i + 1] * inverse + 128) >> 8);
+        dst[i + 2] = static_cast<uint8_t>((src[i + 2] * alpha + dst[i + 2] * inverse + 128) >> 8);
+    }
+}
+
+void blendMatteScalar(uint8_t* dst, const uint8_t* background, const uint8_t* matte, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        int weight = matte[i] + (matte[i] >> 7);
+        int inverse = 256 - weight;
+        uint8_t* px = dst + i * 4;
+        const uint8_t* bg = background + i * 4;
+        px[0] = static_cast<uint8_t>((px[0] * weight + bg[0] * inverse + 128) >> 8);
+        px[1] = static_cast<uint8_t>((px[1] * weight + bg[1] * inverse + 128) >> 8);
+        px[2] = static_cast<uint8_t>((px[2] * weight + bg[2] * inverse + 128) >> 8);
+    }
+}
+
+void chromaKeyScalar(uint8_t* rgba, size_t pixelCount, const ChromaKeyCoefficients& key) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        int cb = (-43 * px[0] - 85 * px[1] + 128 * px[2]) >> 8;
+        int cr = (128 * px[0] - 107 * px[1] - 21 * px[2]) >> 8;
+        
+        int a = std::abs(cb - key.keyCb);
+        int b = std::abs(cr - key.keyCr);
+        int distance = std::max(a, b) + ((std::min(a, b) * 3) >> 3);
+        int t = std::max(0, std::min<int>(key.width, distance - key.inner));
+        int alpha = (t * key.rampQ8 + 255) >> 8;
+        
+        int excess = std::max(0, (cb * key.kx + cr * key.ky) >> 7);
+        for (int c = 0; c < 3; c++) {
+            px[c] = static_cast<uint8_t>(std::max(0, std::min(255, px[c] + ((excess * key.spill[c] + 32) >> 6))));
+        }
+        px[3] = static_cast<uint8_t>(std::min<int>(px[3], alpha));
+    }
+}
+
+void transposePlaneScalar(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width,
+                          int height) {
+    // 16x16 tiles so both sides stay within a few cache lines
+    for (int y0 = 0; y0 < height; y0 += 16) {
+        int y1 = std::min(y0 + 16, height);
+        for (int x0 = 0; x0 < width; x0 += 16) {
+            int x1 = std::min(x0 + 16, width);
+            for (int x = x0; x < x1; x++) {
+                uint8_t* out = dst + x * dstStride;
+                for (int y = y0; y < y1; y++) {
+                    out[y] = src[y * srcStride + x];
+                }
+            }
+        }
+    }
+}
+
+uint32_t sumAbsDiffScalar(const uint8_t* a, size_t aStride, const uint8_t* b, size_t bStride, int width,
+                          int height) {
+    uint32_t sum = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* rowA = a + y * aStride;
+        const uint8_t* rowB = b + y * bStride;
+        for (int x = 0; x < width; x++) {
+            sum += static_cast<uint32_t>(std::abs(rowA[x] - rowB[x]));
+        }
+    }
+    return sum;
+}
+
+void colorLut3DScalar(const uint16_t* table, uint8_t* rgba, size_t pixelCount) {
+    LutTetrahedron t;
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        lutTetrahedron(table, px, t);
+        for (int c = 0; c < 3; c++) {
+            uint32_t sum = t.node[0][c] * t.weight[0] + t.node[1][c] * t.weight[1] +
+                           t.node[2][c] * t.weight[2] + t.node[3][c] * t.weight[3];
+            px[c] = static_cast<uint8_t>((sum + (1 << 11)) >> 12);
+        }
+    }
+}
+
+void channelLutScalar(const uint8_t* tables, uint8_t* rgba, size_t pixelCount) {
+    const uint8_t* tr = tables;
+    const uint8_t* tg = tables + 256;
+    const uint8_t* tb = tables + 512;
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        px[0] = tr[px[0]];
+        px[1] = tg[px[1]];
+        px[2] = tb[px[2]];
+    }
+}
+
+void planeLutScalar(const uint8_t* table, uint8_t* plane, size_t count) {
+    size_t i = 0;
+    
+    // Unrolled so the four independent loads can overlap
+    for (; i + 4 <= count; i += 4) {
+        uint8_t a = table[plane[i + 0]];
+        uint8_t b = table[plane[i + 1]];
+        uint8_t c = table[plane[i + 2]];
+        uint8_t d = table[plane[i + 3]];
+        plane[i + 0] = a;
+        plane[i + 1] = b;
+        plane[i + 2] = c;
+        plane[i + 3] = d;
+    }
+    for (; i < count; i++) {
+        plane[i] = table[plane[i]];
+    }
+}
+
+const PixelKernels kScalarKernels = {
+    SimdLevel::Scalar,
+    colorMatrixScalar,
+    extractLumaScalar,
+    addDetailScalar,
+    blendRgbScalar,
+    blendMatteScalar,
+    chromaKeyScalar,
+    transposePlaneScalar,
+    sumAbsDiffScalar,
+    colorLut3DScalar,
+    channelLutScalar,
+    planeLutScalar
+};
+
+const PixelKernels* tableFor(SimdLevel level) {
+    if (!CpuFeatures::supports(level)) {
+        return nullptr;
+    }
+    switch (level) {
+        case SimdLevel::Neon: return neonPixelKernels();
+        case SimdLevel::Sse41: return sse41PixelKernels();
+        case SimdLevel::Avx2: return avx2PixelKernels();
+        default: return scalarPixelKernels();
+    }
+}
+
+const PixelKernels* selectAtStartup() {
+    const PixelKernels* table = tableFor(CpuFeatures::detect());
+    if (!table) {
+        table = scalarPixelKernels();  // Detected, but this ABI wasn't built with it
+    }
+    
+    char value[PROP_VALUE_MAX] = {0};
+    SimdLevel forced;
+    if (__system_property_get("debug.videoeditor.simd", value) > 0 && CpuFeatures::fromName(value, forced)) {
+        const PixelKernels* forcedTable = tableFor(forced);
+        if (forcedTable) {
+            table = forcedTable;
+        } else {
+            LOGW("SIMD level %s not available, ignoring override", value);
+        }
+    }
+    
+    LOGI("Pixel kernels: %s", CpuFeatures::name(table->level));
+    return table;
+}
+
+std::atomic<const PixelKernels*>& activeKernels() {
+    static std::atomic<const PixelKernels*> active(selectAtStartup());
+    return active;
+}
+
+// Deterministic pseudo-random bytes so failures reproduce
+void fillPattern(std::vector<uint8_t>& data, uint32_t seed) {
+    for (auto& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+}
+
+bool compare(const char* kernel, const PixelKernels& table, const std::vector<uint8_t>& expected,
+             const std::vector<uint8_t>& actual) {
+    auto mismatch = std::mismatch(expected.begin(), expected.end(), actual.begin());
+    if (mismatch.first == expected.end()) {
+        return true;
+    }
+    size_t offset = mismatch.first - expected.begin();
+    LOGE("%s kernel %s differs from scalar at byte %zu (%d vs %d)", CpuFeatures::name(table.level),
+         kernel, offset, *mismatch.first, *mismatch.second);
+    return false;
+}
+
+bool verifyTable(const PixelKernels& table) {
+    const PixelKernels& reference = kScalarKernels;
+    bool ok = true;
+    
+    // Odd lengths so every vector loop also runs its scalar tail
+    const size_t counts[] = {1, 7, 33, 1031};
+    
+    // LUT nodes over the full 12-bit range, and byte tables for the 1D lookups
+    std::vector<uint16_t> lut3D(kColorLutSize * kColorLutSize * kColorLutSize * 4);
+    {
+        std::vector<uint8_t> bytes(lut3D.size() * 2);
+        fillPattern(bytes, 3000);
+        for (size_t i = 0; i < lut3D.size(); i++) {
+            lut3D[i] = static_cast<uint16_t>((bytes[i * 2] | (bytes[i * 2 + 1] << 8)) % 4081);
+        }
+    }
+    std::vector<uint8_t> lut1D(3 * 256);
+    fillPattern(lut1D, 3001);
+    
+    for (size_t count : counts) {
+        std::vector<uint8_t> rgba(count * 4);
+        std::vector<uint8_t> other(count * 4);
+        fillPattern(rgba, static_cast<uint32_t>(count));
+        fillPattern(other, static_cast<uint32_t>(count) * 7 + 1);
+        
+        // Colour matrix over the whole coefficient range and every shift
+        for (int trial = 0; trial < 8; trial++) {
+            FixedColorMatrix matrix;
+            std::vector<uint8_t> bytes(sizeof(matrix.coef) + sizeof(matrix.offset));
+            fillPattern(bytes, 1000 + trial);
+            memcpy(matrix.coef, bytes.data(), sizeof(matrix.coef));
+            for (int row = 0; row < 4; row++) {
+                matrix.offset[row] = (static_cast<int8_t>(bytes[sizeof(matrix.coef) + row]) * 2) << 12;
+            }
+            matrix.shift = 4 + trial;
+            
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.colorMatrix(matrix, expected.data(), count);
+            table.colorMatrix(matrix, actual.data(), count);
+            ok &= compare("colorMatrix", table, expected, actual);
+        }
+        
+        std::vector<uint8_t> luma(count);
+        std::vector<uint8_t> expectedLuma(count);
+        reference.extractLuma(rgba.data(), expectedLuma.data(), count);
+        table.extractLuma(rgba.data(), luma.data(), count);
+        ok &= compare("extractLuma", table, expectedLuma, luma);
+        
+        std::vector<uint8_t> blurred(count);
+        fillPattern(blurred, static_cast<uint32_t>(count) + 99);
+        const int amounts[] = {0, 77, 256, 1024, 4096};
+        const int thresholds[] = {0, 20};
+        for (int amount : amounts) {
+            for (int threshold : thresholds) {
+                std::vector<uint8_t> expected = rgba;
+                std::vector<uint8_t> actual = rgba;
+                reference.addDetail(expected.data(), expectedLuma.data(), blurred.data(), count, amount, threshold);
+                table.addDetail(actual.data(), expectedLuma.data(), blurred.data(), count, amount, threshold);
+                ok &= compare("addDetail", table, expected, actual);
+            }
+        }
+        
+        const int alphas[] = {0, 1, 128, 255, 256};
+        for (int alpha : alphas) {
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.blendRgb(expected.data(), other.data(), count, alpha);
+            table.blendRgb(actual.data(), other.data(), count, alpha);
+            ok &= compare("blendRgb", table, expected, actual);
+        }
+        
+        // Matte with the 0 and 255 end points forced in, where the weight rounding matters
+        std::vector<uint8_t> matte(count);
+        fillPattern(matte, static_cast<uint32_t>(count) * 3 + 5);
+        for (size_t i = 0; i < count; i += 3) {
+            matte[i] = i % 2 ? 0 : 255;
+        }
+        {
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.blendMatte(expected.data(), other.data(), matte.data(), count);
+            table.blendMatte(actual.data(), other.data(), matte.data(), count);
+            ok &= compare("blendMatte", table, expected, actual);
+        }
+        
+        // Green and blue screens with extreme ramps and spill, then random coefficients
+        for (int trial = 0; trial < 6; trial++) {
+            ChromaKeyCoefficients key = {-85, -107, 40, 30, (255 << 8) / 30, -72, -105, {73, 38, 62}};
+            if (trial == 1) {
+                key = {127, -21, 0, 1, 255 << 8, 127, 0, {0, -31, -113}};
+            } else if (trial > 1) {
+                std::vector<uint8_t> bytes(16);
+                fillPattern(bytes, 2000 + trial);
+                key.keyCb = static_cast<int8_t>(bytes[0]);
+                key.keyCr = static_cast<int8_t>(bytes[1]);
+                key.inner = static_cast<int16_t>(bytes[2] + bytes[3] / 3);
+                key.width = static_cast<int16_t>(std::max<int>(1, bytes[4]));
+                key.rampQ8 = static_cast<uint16_t>((255 << 8) / key.width);
+                key.kx = static_cast<int16_t>(std::max<int>(-127, static_cast<int8_t>(bytes[5])));
+                key.ky = static_cast<int16_t>(std::max<int>(-127, static_cast<int8_t>(bytes[6])));
+                for (int c = 0; c < 3; c++) {
+                    key.spill[c] = static_cast<int16_t>(std::max<int>(-127, static_cast<int8_t>(bytes[7 + c])));
+                }
+            }
+            
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.chromaKey(expected.data(), count, key);
+            table.chromaKey(actual.data(), count, key);
+            ok &= compare("chromaKey", table, expected, actual);
+        }
+        
+        // Plane transpose with partial tiles on both edges
+        {
+            int width = static_cast<int>(count);
+            int height = 17 + static_cast<int>(count % 5);
+            std::vector<uint8_t> plane(static_cast<size_t>(width) * height);
+            fillPattern(plane, static_cast<uint32_t>(count) + 11);
+            std::vector<uint8_t> expected(plane.size());
+            std::vector<uint8_t> actual(plane.size());
+            reference.transposePlane(plane.data(), width, expected.data(), height, width, height);
+            table.transposePlane(plane.data(), width, actual.data(), height, width, height);
+            ok &= compare("transposePlane", table, expected, actual);
+        }
+        
+        // Block SAD, offset so rows start unaligned, including identical blocks
+        {
+            int width = static_cast<int>(count % 67) + 1;
+            int height = static_cast<int>(count % 9) + 1;
+            size_t stride = static_cast<size_t>(width) + 3;
+            std::vector<uint8_t> blockA(stride * height + 1);
+            std::vector<uint8_t> blockB(stride * height + 1);
+            fillPattern(blockA, static_cast<uint32_t>(count) + 21);
+            fillPattern(blockB, static_cast<uint32_t>(count) + 22);
+            const uint8_t* pairs[][2] = {{blockA.data() + 1, blockB.data()}, {blockA.data(), blockA.data()}};
+            for (const auto& pair : pairs) {
+                uint32_t expected = reference.sumAbsDiff(pair[0], stride, pair[1], stride, width, height);
+                uint32_t actual = table.sumAbsDiff(pair[0], stride, pair[1], stride, width, height);
+                if (expected != actual) {
+                    LOGE("%s kernel sumAbsDiff differs from scalar for %dx%d (%u vs %u)",
+                         CpuFeatures::name(table.level), width, height, expected, actual);
+                    ok = false;
+                }
+            }
+        }
+        
+        // Grey pixels in between, where fractions tie and the tetrahedron choice flips
+        {
+            std::vector<uint8_t> expected = rgba;
+            for (size_t i = 0; i < count; i += 5) {
+                expected[i * 4 + 1] = expected[i * 4 + 2] = expected[i * 4];
+            }
+            std::vector<uint8_t> actual = expected;
+            reference.colorLut3D(lut3D.data(), expected.data(), count);
+            table.colorLut3D(lut3D.data(), actual.data(), count);
+            ok &= compare("colorLut3D", table, expected, actual);
+        }
+        
+        {
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.channelLut(lut1D.data(), expected.data(), count);
+            table.channelLut(lut1D.data(), actual.data(), count);
+            ok &= compare("channelLut", table, expected, actual);
+        }
+        
+        {
+            std::vector<uint8_t> expected = rgba;
+            std::vector<uint8_t> actual = rgba;
+            reference.planeLut(lut1D.data() + 256, expected.data(), expected.size() - 1);
+            table.planeLut(lut1D.data() + 256, actual.data(), actual.size() - 1);
+            ok &= compare("planeLut", table, expected, actual);
+        }
+    }
+    
+    return ok;
+}
+
+}  // namespace
+
+const PixelKernels& pixelKernels() {
+    return *activeKernels().load(std::memory_order_acquire);
+}
+
+bool setPixelKernelLevel(SimdLevel level) {
+    const PixelKernels* table = tableFor(level);
+    if (!table) {
+        LOGW("SIMD level %s not available", CpuFeatures::name(level));
+        return false;
+    }
+    
+    activeKernels().store(table, std::memory_order_release);
+    LOGI("Pixel kernels forced to %s", CpuFeatures::name(level));
+    return true;
+}
+
+bool verifyPixelKernels() {
+    const SimdLevel levels[] = {SimdLevel::Neon, SimdLevel::Sse41, SimdLevel::Avx2};
+    bool ok = true;
+    
+    for (SimdLevel level : levels) {
+        const PixelKernels* table = tableFor(level);
+        if (table) {
+            bool passed = verifyTable(*table);
+            LOGI("Pixel kernel self-test %s: %s", CpuFeatures::name(level), passed ? "passed" : "FAILED");
+            ok &= passed;
+        }
+    }
+    return ok;
+}
+
+const PixelKernels* scalarPixelKernels() {
+    return &kScalarKernels;
+}
+
+}  // namespace videoeditor
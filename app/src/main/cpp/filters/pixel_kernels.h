@@ -0,0 +1,167 @@
+#ifndef VIDEO_EDITOR_PIXEL_KERNELS_H
+#define VIDEO_EDITOR_PIXEL_KERNELS_H
+
+#include "common.h"
+#include "cpu_features.h"
+#include <algorithm>
+
+namespace videoeditor {
+
+// 4x4 colour matrix in fixed point: out = clamp((coef * in + offset + round) >> shift)
+struct FixedColorMatrix {
+    int16_t coef[16];   // Row-major 4x4
+    int32_t offset[4];  // Pre-scaled by 1 << shift
+    int shift;          // 4-12
+};
+
+// Chroma key in fixed point. Per pixel, with arithmetic shifts:
+//   cb = (-43R - 85G + 128B) >> 8, cr = (128R - 107G - 21B) >> 8
+//   a = |cb - keyCb|, b = |cr - keyCr|, d = max(a, b) + (min(a, b) * 3 >> 3)
+//   alpha = min(A, (clamp(d - inner, 0, width) * rampQ8 + 255) >> 8)
+//   e = max(0, (cb * kx + cr * ky) >> 7), C += (e * spill[C] + 32) >> 6 on R, G, B
+struct ChromaKeyCoefficients {
+    int16_t keyCb;      // Key colour chroma, -128 to 127
+    int16_t keyCr;
+    int16_t inner;      // Chroma distance keyed out fully, 0-350
+    int16_t width;      // Ramp from transparent to opaque, 1-255
+    uint16_t rampQ8;    // (255 << 8) / width
+    int16_t kx;         // Unit key direction in the CbCr plane, Q7 (-127 to 127)
+    int16_t ky;
+    int16_t spill[3];   // R, G, B change per unit of key chroma removed, Q6 (-127 to 127)
+};
+
+// 3D colour LUT: kColorLutSize^3 nodes of R, G, B, 0 as 8-bit values * 16, red fastest
+constexpr int kColorLutSize = 33;
+
+// The four LUT nodes around one RGB sample, c000 first and c111 last, with
+// weights summing to 256 for tetrahedral interpolation
+struct LutTetrahedron {
+    const uint16_t* node[4];
+    int weight[4];
+};
+
+inline void lutTetrahedron(const uint16_t* table, const uint8_t* px, LutTetrahedron& t) {
+    constexpr int kStrideR = 4;
+    constexpr int kStrideG = kColorLutSize * kStrideR;
+    constexpr int kStrideB = kColorLutSize * kStrideG;
+    const int strides[3] = {kStrideR, kStrideG, kStrideB};
+    
+    int frac[3];
+    int offset = 0;
+    for (int c = 0; c < 3; c++) {
+        int scaled = px[c] * (kColorLutSize - 1) * 256 / 255;
+        int cell = std::min(scaled >> 8, kColorLutSize - 2);
+        offset += cell * strides[c];
+        frac[c] = scaled - cell * 256;
+    }
+    int fr = frac[0];
+    int fg = frac[1];
+    int fb = frac[2];
+    
+    const uint16_t* c000 = table + offset;
+    t.node[0] = c000;
+    t.node[3] = c000 + kStrideR + kStrideG + kStrideB;
+    
+    // Pick the tetrahedron of the cube that contains the sample
+    int first, second, last;
+    if (fr > fg) {
+        if (fg > fb) {
+            t.node[1] = c000 + kStrideR;
+            t.node[2] = c000 + kStrideR + kStrideG;
+            first = fr, second = fg, last = fb;
+        } else if (fr > fb) {
+            t.node[1] = c000 + kStrideR;
+            t.node[2] = c000 + kStrideR + kStrideB;
+            first = fr, second = fb, last = fg;
+        } else {
+            t.node[1] = c000 + kStrideB;
+            t.node[2] = c000 + kStrideR + kStrideB;
+            first = fb, second = fr, last = fg;
+        }
+    } else {
+        if (fb > fg) {
+            t.node[1] = c000 + kStrideB;
+            t.node[2] = c000 + kStrideG + kStrideB;
+            first = fb, second = fg, last = fr;
+        } else if (fb > fr) {
+            t.node[1] = c000 + kStrideG;
+            t.node[2] = c000 + kStrideG + kStrideB;
+            first = fg, second = fb, last = fr;
+        } else {
+            t.node[1] = c000 + kStrideG;
+            t.node[2] = c000 + kStrideR + kStrideG;
+            first = fg, second = fr, last = fb;
+        }
+    }
+    t.weight[0] = 256 - first;
+    t.weight[1] = first - second;
+    t.weight[2] = second - last;
+    t.weight[3] = last;
+}
+
+// Hot per-pixel loops, one table per instruction set. Every variant gives the
+// same bytes as the scalar one; verifyPixelKernels() checks that.
+struct PixelKernels {
+    SimdLevel level;
+    
+    // Applies the matrix to RGBA pixels in place
+    void (*colorMatrix)(const FixedColorMatrix& matrix, uint8_t* rgba, size_t pixelCount);
+    
+    // luma = (77R + 150G + 29B + 128) >> 8
+    void (*extractLuma)(const uint8_t* rgba, uint8_t* luma, size_t pixelCount);
+    
+    // Adds (amountQ8 * (luma - blurred) + 128) >> 8 to R, G, B where |luma - blurred| > threshold
+    void (*addDetail)(uint8_t* rgba, const uint8_t* luma, const uint8_t* blurred, size_t pixelCount,
+                      int amountQ8, int threshold);
+    
+    // dst = (src * alpha + dst * (256 - alpha) + 128) >> 8 on R, G, B, alpha 0-256; dst alpha kept
+    void (*blendRgb)(uint8_t* dst, const uint8_t* src, size_t pixelCount, int alpha);
+    
+    // blendRgb with a weight per pixel: dst = (dst * w + background * (256 - w) + 128) >> 8
+    // on R, G, B with w = matte + (matte >> 7), so matte 255 keeps dst; dst alpha kept
+    void (*blendMatte)(uint8_t* dst, const uint8_t* background, const uint8_t* matte, size_t pixelCount);
+    
+    // Keys RGBA pixels in place: alpha from the chroma distance to the key,
+    // key-coloured spill taken out of R, G, B
+    void (*chromaKey)(uint8_t* rgba, size_t pixelCount, const ChromaKeyCoefficients& key);
+    
+    // 8-bit plane transpose: dst row x is src column x (width x height in, height x width out)
+    void (*transposePlane)(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width,
+                           int height);
+    
+    // Sum of |a - b| over a width x height block of 8-bit samples (psadbw / vabd)
+    uint32_t (*sumAbsDiff)(const uint8_t* a, size_t aStride, const uint8_t* b, size_t bStride, int width,
+                           int height);
+    
+    // 3D LUT on RGBA pixels in place, alpha kept: C = (sum of node[i][C] * weight[i] + 2048) >> 12
+    // over the lutTetrahedron() of each pixel
+    void (*colorLut3D)(const uint16_t* table, uint8_t* rgba, size_t pixelCount);
+    
+    // 256-entry byte tables for R, G, B (back to back) on RGBA pixels in place, alpha kept
+    void (*channelLut)(const uint8_t* tables, uint8_t* rgba, size_t pixelCount);
+    
+    // One 256-entry byte table over a plane in place
+    void (*planeLut)(const uint8_t* table, uint8_t* plane, size_t count);
+};
+
+// Kernels for the best instruction set this CPU has, or the forced one
+const PixelKernels& pixelKernels();
+
+// Force an instruction set, e.g. scalar to compare output against; false if
+// this build or CPU can't run it. The debug.videoeditor.simd system property
+// ("scalar", "neon", "sse4.1", "avx2") does the same at startup.
+bool setPixelKernelLevel(SimdLevel level);
+
+// Runs every variant this CPU supports against scalar on generated input and
+// logs any mismatch; true if all agree
+bool verifyPixelKernels();
+
+// Per instruction set tables; null when not built for this ABI
+const PixelKernels* scalarPixelKernels();
+const PixelKernels* neonPixelKernels();
+const PixelKernels* sse41PixelKernels();
+const PixelKernels* avx2PixelKernels();
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_PIXEL_KERNELS_H
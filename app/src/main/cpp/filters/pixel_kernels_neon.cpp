@@ -0,0 +1,355 @@
+#include "pixel_kernels.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace videoeditor {
+
+#if defined(__ARM_NEON)
+
+namespace {
+
+void colorMatrixNeon(const FixedColorMatrix& matrix, uint8_t* rgba, size_t pixelCount) {
+    const int32x4_t negShift = vdupq_n_s32(-matrix.shift);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint8x8x4_t px = vld4_u8(rgba + i * 4);
+        int16x8_t ch[4];
+        for (int c = 0; c < 4; c++) {
+            ch[c] = vreinterpretq_s16_u16(vmovl_u8(px.val[c]));
+        }
+        
+        uint8x8x4_t out;
+        for (int row = 0; row < 4; row++) {
+            const int16_t* m = matrix.coef + row * 4;
+            int32x4_t lo = vdupq_n_s32(matrix.offset[row]);
+            int32x4_t hi = lo;
+            for (int k = 0; k < 4; k++) {
+                lo = vmlal_n_s16(lo, vget_low_s16(ch[k]), m[k]);
+                hi = vmlal_n_s16(hi, vget_high_s16(ch[k]), m[k]);
+            }
+            // Rounding shift, then saturate to 0-255
+            lo = vrshlq_s32(lo, negShift);
+            hi = vrshlq_s32(hi, negShift);
+            out.val[row] = vqmovun_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+        }
+        vst4_u8(rgba + i * 4, out);
+    }
+    
+    scalarPixelKernels()->colorMatrix(matrix, rgba + i * 4, pixelCount - i);
+}
+
+void extractLumaNeon(const uint8_t* rgba, uint8_t* luma, size_t pixelCount) {
+    const uint8x8_t weightR = vdup_n_u8(77);
+    const uint8x8_t weightG = vdup_n_u8(150);
+    const uint8x8_t weightB = vdup_n_u8(29);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint8x8x4_t px = vld4_u8(rgba + i * 4);
+        uint16x8_t sum = vmull_u8(px.val[0], weightR);
+        sum = vmlal_u8(sum, px.val[1], weightG);
+        sum = vmlal_u8(sum, px.val[2], weightB);
+        vst1_u8(luma + i, vrshrn_n_u16(sum, 8));
+    }
+    
+    scalarPixelKernels()->extractLuma(rgba + i * 4, luma + i, pixelCount - i);
+}
+
+void addDetailNeon(uint8_t* rgba, const uint8_t* luma, const uint8_t* blurred, size_t pixelCount,
+                   int amountQ8, int threshold) {
+    const int16x8_t thresholdVec = vdupq_n_s16(static_cast<int16_t>(threshold));
+    const int16_t amountLane = static_cast<int16_t>(amountQ8);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        int16x8_t diff = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(luma + i), vld1_u8(blurred + i)));
+        uint16x8_t keep = vcgtq_s16(vabsq_s16(diff), thresholdVec);
+        
+        int16x8_t delta = vcombine_s16(vrshrn_n_s32(vmull_n_s16(vget_low_s16(diff), amountLane), 8),
+                                       vrshrn_n_s32(vmull_n_s16(vget_high_s16(diff), amountLane), 8));
+        delta = vandq_s16(delta, vreinterpretq_s16_u16(keep));
+        
+        uint8x8x4_t px = vld4_u8(rgba + i * 4);
+        for (int c = 0; c < 3; c++) {
+            int16x8_t channel = vreinterpretq_s16_u16(vmovl_u8(px.val[c]));
+            px.val[c] = vqmovun_s16(vaddq_s16(channel, delta));
+        }
+        vst4_u8(rgba + i * 4, px);
+    }
+    
+    scalarPixelKernels()->addDetail(rgba + i * 4, luma + i, blurred + i, pixelCount - i, amountQ8, threshold);
+}
+
+void blendRgbNeon(uint8_t* dst, const uint8_t* src, size_t pixelCount, int alpha) {
+    const uint16_t srcWeight = static_cast<uint16_t>(alpha);
+    const uint16_t dstWeight = static_cast<uint16_t>(256 - alpha);
+    size_t i = 0;
+    
+    // 255 * 256 still fits 16 bits, so the whole sum stays in u16 lanes
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint8x8x4_t s = vld4_u8(src + i * 4);
+        uint8x8x4_t d = vld4_u8(dst + i * 4);
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t sum = vmulq_n_u16(vmovl_u8(s.val[c]), srcWeight);
+            sum = vmlaq_n_u16(sum, vmovl_u8(d.val[c]), dstWeight);
+            d.val[c] = vrshrn_n_u16(sum, 8);
+        }
+        vst4_u8(dst + i * 4, d);
+    }
+    
+    scalarPixelKernels()->blendRgb(dst + i * 4, src + i * 4, pixelCount - i, alpha);
+}
+
+void blendMatteNeon(uint8_t* dst, const uint8_t* background, const uint8_t* matte, size_t pixelCount) {
+    const uint16x8_t full = vdupq_n_u16(256);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint16x8_t m = vmovl_u8(vld1_u8(matte + i));
+        uint16x8_t weight = vaddq_u16(m, vshrq_n_u16(m, 7));
+        uint16x8_t inverse = vsubq_u16(full, weight);
+        uint8x8x4_t b = vld4_u8(background + i * 4);
+        uint8x8x4_t d = vld4_u8(dst + i * 4);
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t sum = vmulq_u16(vmovl_u8(d.val[c]), weight);
+            sum = vmlaq_u16(sum, vmovl_u8(b.val[c]), inverse);
+            d.val[c] = vrshrn_n_u16(sum, 8);
+        }
+        vst4_u8(dst + i * 4, d);
+    }
+    
+    scalarPixelKernels()->blendMatte(dst + i * 4, background + i * 4, matte + i, pixelCount - i);
+}
+
+void chromaKeyNeon(uint8_t* rgba, size_t pixelCount, const ChromaKeyCoefficients& key) {
+    const int16x8_t keyCb = vdupq_n_s16(key.keyCb);
+    const int16x8_t keyCr = vdupq_n_s16(key.keyCr);
+    const int16x8_t inner = vdupq_n_s16(key.inner);
+    const int16x8_t width = vdupq_n_s16(key.width);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const uint16x8_t alphaRound = vdupq_n_u16(255);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint8x8x4_t px = vld4_u8(rgba + i * 4);
+        int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(px.val[0]));
+        int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(px.val[1]));
+        int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(px.val[2]));
+        
+        int16x8_t cb = vshrq_n_s16(vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, -43), g, -85), b, 128), 8);
+        int16x8_t cr = vshrq_n_s16(vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, 128), g, -107), b, -21), 8);
+        
+        int16x8_t da = vabdq_s16(cb, keyCb);
+        int16x8_t db = vabdq_s16(cr, keyCr);
+        int16x8_t distance = vaddq_s16(vmaxq_s16(da, db), vshrq_n_s16(vmulq_n_s16(vminq_s16(da, db), 3), 3));
+        int16x8_t t = vminq_s16(vmaxq_s16(vsubq_s16(distance, inner), zero), width);
+        uint16x8_t alpha = vshrq_n_u16(vmlaq_n_u16(alphaRound, vreinterpretq_u16_s16(t), key.rampQ8), 8);
+        px.val[3] = vmin_u8(px.val[3], vmovn_u16(alpha));
+        
+        // (e * spill + 32) >> 6 is a rounding shift
+        int16x8_t excess = vmaxq_s16(vshrq_n_s16(vmlaq_n_s16(vmulq_n_s16(cb, key.kx), cr, key.ky), 7), zero);
+        px.val[0] = vqmovun_s16(vaddq_s16(r, vrshrq_n_s16(vmulq_n_s16(excess, key.spill[0]), 6)));
+        px.val[1] = vqmovun_s16(vaddq_s16(g, vrshrq_n_s16(vmulq_n_s16(excess, key.spill[1]), 6)));
+        px.val[2] = vqmovun_s16(vaddq_s16(b, vrshrq_n_s16(vmulq_n_s16(excess, key.spill[2]), 6)));
+        vst4_u8(rgba + i * 4, px);
+    }
+    
+    scalarPixelKernels()->chromaKey(rgba + i * 4, pixelCount - i, key);
+}
+
+void transposePlaneNeon(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width,
+                        int height) {
+    int fullWidth = width & ~15;
+    int fullHeight = height & ~15;
+    
+    for (int y0 = 0; y0 < fullHeight; y0 += 16) {
+        for (int x0 = 0; x0 < fullWidth; x0 += 16) {
+            uint8x16_t a[16];
+            uint8x16_t b[16];
+            for (int i = 0; i < 16; i++) {
+                a[i] = vld1q_u8(src + (y0 + i) * srcStride + x0);
+            }
+            
+            // Same ladder as the SSE4.1 version: zip bytes, halfwords, words, then
+            // combine doublewords, each step doubling the rows interleaved together
+            for (int i = 0; i < 8; i++) {
+                uint8x16x2_t z = vzipq_u8(a[2 * i], a[2 * i + 1]);
+                b[i] = z.val[0];
+                b[i + 8] = z.val[1];
+            }
+            for (int half = 0; half < 16; half += 8) {
+                for (int j = 0; j < 4; j++) {
+                    uint16x8x2_t z = vzipq_u16(vreinterpretq_u16_u8(b[half + 2 * j]),
+                                               vreinterpretq_u16_u8(b[half + 2 * j + 1]));
+                    a[half + j] = vreinterpretq_u8_u16(z.val[0]);
+                    a[half + 4 + j] = vreinterpretq_u8_u16(z.val[1]);
+                }
+            }
+            for (int group = 0; group < 16; group += 4) {
+                uint32x4x2_t low = vzipq_u32(vreinterpretq_u32_u8(a[group]), vreinterpretq_u32_u8(a[group + 1]));
+                uint32x4x2_t high = vzipq_u32(vreinterpretq_u32_u8(a[group + 2]), vreinterpretq_u32_u8(a[group + 3]));
+                b[group] = vreinterpretq_u8_u32(low.val[0]);
+                b[group + 1] = vreinterpretq_u8_u32(low.val[1]);
+                b[group + 2] = vreinterpretq_u8_u32(high.val[0]);
+                b[group + 3] = vreinterpretq_u8_u32(high.val[1]);
+            }
+            for (int group = 0; group < 16; group += 4) {
+                for (int pair = 0; pair < 2; pair++) {
+                    uint8x16_t top = b[group + pair];
+                    uint8x16_t bottom = b[group + 2 + pair];
+                    uint8_t* out = dst + (x0 + group + pair * 2) * dstStride + y0;
+                    vst1q_u8(out, vcombine_u8(vget_low_u8(top), vget_low_u8(bottom)));
+                    vst1q_u8(out + dstStride, vcombine_u8(vget_high_u8(top), vget_high_u8(bottom)));
+                }
+            }
+        }
+    }
+    
+    // Right columns, then bottom rows
+    scalarPixelKernels()->transposePlane(src + fullWidth, srcStride, dst + fullWidth * dstStride, dstStride,
+                                         width - fullWidth, fullHeight);
+    scalarPixelKernels()->transposePlane(src + fullHeight * srcStride, srcStride, dst + fullHeight, dstStride,
+                                         width, height - fullHeight);
+}
+
+uint32_t sumAbsDiffNeon(const uint8_t* a, size_t aStride, const uint8_t* b, size_t bStride, int width,
+                        int height) {
+    int fullWidth = width & ~15;
+    uint32x4_t total = vdupq_n_u32(0);
+    uint32_t tail = 0;
+    
+    for (int y = 0; y < height; y++) {
+        const uint8_t* rowA = a + y * aStride;
+        const uint8_t* rowB = b + y * bStride;
+        
+        // Pairwise sums of |a - b| in 16-bit lanes, widened before they can overflow
+        uint16x8_t partial = vdupq_n_u16(0);
+        int pending = 0;
+        for (int x = 0; x < fullWidth; x += 16) {
+            partial = vpadalq_u8(partial, vabdq_u8(vld1q_u8(rowA + x), vld1q_u8(rowB + x)));
+            if (++pending == 64) {
+                total = vpadalq_u16(total, partial);
+                partial = vdupq_n_u16(0);
+                pending = 0;
+            }
+        }
+        total = vpadalq_u16(total, partial);
+        tail += scalarPixelKernels()->sumAbsDiff(rowA + fullWidth, aStride, rowB + fullWidth, bStride,
+                                                 width - fullWidth, 1);
+    }
+    
+    uint64x2_t pairs = vpaddlq_u32(total);
+    return static_cast<uint32_t>(vgetq_lane_u64(pairs, 0) + vgetq_lane_u64(pairs, 1)) + tail;
+}
+
+void colorLut3DNeon(const uint16_t* table, uint8_t* rgba, size_t pixelCount) {
+    LutTetrahedron t;
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        lutTetrahedron(table, px, t);
+        
+        uint32x4_t acc = vmull_n_u16(vld1_u16(t.node[0]), static_cast<uint16_t>(t.weight[0]));
+        acc = vmlal_n_u16(acc, vld1_u16(t.node[1]), static_cast<uint16_t>(t.weight[1]));
+        acc = vmlal_n_u16(acc, vld1_u16(t.node[2]), static_cast<uint16_t>(t.weight[2]));
+        acc = vmlal_n_u16(acc, vld1_u16(t.node[3]), static_cast<uint16_t>(t.weight[3]));
+        uint16x4_t result = vrshrn_n_u32(acc, 12);
+        px[0] = static_cast<uint8_t>(vget_lane_u16(result, 0));
+        px[1] = static_cast<uint8_t>(vget_lane_u16(result, 1));
+        px[2] = static_cast<uint8_t>(vget_lane_u16(result, 2));
+    }
+}
+
+#if defined(__aarch64__)
+// A 256-entry byte table as four 64-byte TBL registers (vqtbl4q is AArch64 only)
+struct NeonTable {
+    uint8x16x4_t quarter[4];
+    
+    explicit NeonTable(const uint8_t* table) {
+        for (int q = 0; q < 4; q++) {
+            for (int r = 0; r < 4; r++) {
+                quarter[q].val[r] = vld1q_u8(table + q * 64 + r * 16);
+            }
+        }
+    }
+    
+    // Out-of-range TBL indices yield 0, so each quarter only answers its own range
+    inline uint8x16_t lookup(uint8x16_t idx) const {
+        const uint8x16_t step = vdupq_n_u8(64);
+        uint8x16_t result = vqtbl4q_u8(quarter[0], idx);
+        idx = vsubq_u8(idx, step);
+        result = vorrq_u8(result, vqtbl4q_u8(quarter[1], idx));
+        idx = vsubq_u8(idx, step);
+        result = vorrq_u8(result, vqtbl4q_u8(quarter[2], idx));
+        idx = vsubq_u8(idx, step);
+        result = vorrq_u8(result, vqtbl4q_u8(quarter[3], idx));
+        return result;
+    }
+};
+#endif
+
+void channelLutNeon(const uint8_t* tables, uint8_t* rgba, size_t pixelCount) {
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    const NeonTable tableR(tables);
+    const NeonTable tableG(tables + 256);
+    const NeonTable tableB(tables + 512);
+    
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t px = vld4q_u8(rgba + i * 4);
+        px.val[0] = tableR.lookup(px.val[0]);
+        px.val[1] = tableG.lookup(px.val[1]);
+        px.val[2] = tableB.lookup(px.val[2]);
+        vst4q_u8(rgba + i * 4, px);
+    }
+#endif
+
+    scalarPixelKernels()->channelLut(tables, rgba + i * 4, pixelCount - i);
+}
+
+void planeLutNeon(const uint8_t* table, uint8_t* plane, size_t count) {
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    const NeonTable neonTable(table);
+    for (; i + 16 <= count; i += 16) {
+        vst1q_u8(plane + i, neonTable.lookup(vld1q_u8(plane + i)));
+    }
+#endif
+
+    scalarPixelKernels()->planeLut(table, plane + i, count - i);
+}
+
+const PixelKernels kNeonKernels = {
+    SimdLevel::Neon,
+    colorMatrixNeon,
+    extractLumaNeon,
+    addDetailNeon,
+    blendRgbNeon,
+    blendMatteNeon,
+    chromaKeyNeon,
+    transposePlaneNeon,
+    sumAbsDiffNeon,
+    colorLut3DNeon,
+    channelLutNeon,
+    planeLutNeon
+};
+
+}  // namespace
+
+const PixelKernels* neonPixelKernels() {
+    return &kNeonKernels;
+}
+
+#else
+
+const PixelKernels* neonPixelKernels() {
+    return nullptr;
+}
+
+#endif
+
+}  // namespace videoeditor
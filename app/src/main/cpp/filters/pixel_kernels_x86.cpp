@@ -0,0 +1,670 @@
+#include "pixel_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include <cstring>
+#endif
+
+// The ABI baseline is below SSE4.1/AVX2, so each kernel enables its own
+// instruction set and is only called after CpuFeatures has seen it
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+namespace videoeditor {
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace {
+
+SSE41_TARGET void colorMatrixSse41(const FixedColorMatrix& matrix, uint8_t* rgba, size_t pixelCount) {
+    const int16_t* m = matrix.coef;
+    
+    // Column pairs for pmaddwd: (R,G) and (B,A) weights of every output row
+    const __m128i colRG = _mm_setr_epi16(m[0], m[1], m[4], m[5], m[8], m[9], m[12], m[13]);
+    const __m128i colBA = _mm_setr_epi16(m[2], m[3], m[6], m[7], m[10], m[11], m[14], m[15]);
+    const __m128i bias = _mm_add_epi32(
+        _mm_setr_epi32(matrix.offset[0], matrix.offset[1], matrix.offset[2], matrix.offset[3]),
+        _mm_set1_epi32(1 << (matrix.shift - 1)));
+    const __m128i shiftCount = _mm_cvtsi32_si128(matrix.shift);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+        __m128i lo = _mm_unpacklo_epi8(px, zero);  // Pixels 0, 1 as 16-bit
+        __m128i hi = _mm_unpackhi_epi8(px, zero);  // Pixels 2, 3
+        
+        // Broadcast each pixel's (R,G) and (B,A) pair, multiply-add against the columns
+        __m128i p0 = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(lo, 0x00), colRG),
+                                   _mm_madd_epi16(_mm_shuffle_epi32(lo, 0x55), colBA));
+        __m128i p1 = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(lo, 0xAA), colRG),
+                                   _mm_madd_epi16(_mm_shuffle_epi32(lo, 0xFF), colBA));
+        __m128i p2 = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(hi, 0x00), colRG),
+                                   _mm_madd_epi16(_mm_shuffle_epi32(hi, 0x55), colBA));
+        __m128i p3 = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(hi, 0xAA), colRG),
+                                   _mm_madd_epi16(_mm_shuffle_epi32(hi, 0xFF), colBA));
+        
+        p0 = _mm_sra_epi32(_mm_add_epi32(p0, bias), shiftCount);
+        p1 = _mm_sra_epi32(_mm_add_epi32(p1, bias), shiftCount);
+        p2 = _mm_sra_epi32(_mm_add_epi32(p2, bias), shiftCount);
+        p3 = _mm_sra_epi32(_mm_add_epi32(p3, bias), shiftCount);
+        
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), packed);
+    }
+    
+    scalarPixelKernels()->colorMatrix(matrix, rgba + i * 4, pixelCount - i);
+}
+
+SSE41_TARGET void extractLumaSse41(const uint8_t* rgba, uint8_t* luma, size_t pixelCount) {
+    const __m128i weights = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4 + 16));
+        
+        // (77R + 150G, 29B) per pixel, then the pair summed
+        __m128i sumA = _mm_hadd_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(a, zero), weights),
+                                      _mm_madd_epi16(_mm_unpackhi_epi8(a, zero), weights));
+        __m128i sumB = _mm_hadd_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(b, zero), weights),
+                                      _mm_madd_epi16(_mm_unpackhi_epi8(b, zero), weights));
+        sumA = _mm_srli_epi32(_mm_add_epi32(sumA, round), 8);
+        sumB = _mm_srli_epi32(_mm_add_epi32(sumB, round), 8);
+        
+        __m128i words = _mm_packs_epi32(sumA, sumB);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(luma + i), _mm_packus_epi16(words, words));
+    }
+    
+    scalarPixelKernels()->extractLuma(rgba + i * 4, luma + i, pixelCount - i);
+}
+
+SSE41_TARGET void addDetailSse41(uint8_t* rgba, const uint8_t* luma, const uint8_t* blurred, size_t pixelCount,
+                                 int amountQ8, int threshold) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thresholdVec = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    const __m128i amountVec = _mm_set1_epi16(static_cast<int16_t>(amountQ8));
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m128i y = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(luma + i)));
+        __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blurred + i)));
+        __m128i diff = _mm_sub_epi16(y, b);
+        __m128i keep = _mm_cmpgt_epi16(_mm_abs_epi16(diff), thresholdVec);
+        
+        // 32-bit products from the low and high halves, rounded back to 16 bits
+        __m128i productLo = _mm_mullo_epi16(diff, amountVec);
+        __m128i productHi = _mm_mulhi_epi16(diff, amountVec);
+        __m128i delta0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(productLo, productHi), round), 8);
+        __m128i delta1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(productLo, productHi), round), 8);
+        __m128i delta = _mm_and_si128(_mm_packs_epi32(delta0, delta1), keep);
+        
+        // Spread each pixel's delta over R, G, B (alpha gets 0)
+        __m128i pairs0 = _mm_unpacklo_epi16(delta, delta);  // d0 d0 d1 d1 d2 d2 d3 d3
+        __m128i pairs1 = _mm_unpackhi_epi16(delta, delta);  // d4 d4 ... d7 d7
+        __m128i spread[4] = {
+            _mm_and_si128(_mm_unpacklo_epi32(pairs0, pairs0), rgbMask),
+            _mm_and_si128(_mm_unpackhi_epi32(pairs0, pairs0), rgbMask),
+            _mm_and_si128(_mm_unpacklo_epi32(pairs1, pairs1), rgbMask),
+            _mm_and_si128(_mm_unpackhi_epi32(pairs1, pairs1), rgbMask),
+        };
+        
+        for (int half = 0; half < 2; half++) {
+            __m128i* ptr = reinterpret_cast<__m128i*>(rgba + i * 4 + half * 16);
+            __m128i px = _mm_loadu_si128(ptr);
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(px, zero), spread[half * 2]);
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(px, zero), spread[half * 2 + 1]);
+            _mm_storeu_si128(ptr, _mm_packus_epi16(lo, hi));
+        }
+    }
+    
+    scalarPixelKernels()->addDetail(rgba + i * 4, luma + i, blurred + i, pixelCount - i, amountQ8, threshold);
+}
+
+SSE41_TARGET void blendRgbSse41(uint8_t* dst, const uint8_t* src, size_t pixelCount, int alpha) {
+    // Alpha lanes weight dst by 256, which leaves it unchanged
+    const int16_t a = static_cast<int16_t>(alpha);
+    const int16_t inv = static_cast<int16_t>(256 - alpha);
+    const __m128i srcWeight = _mm_setr_epi16(a, a, a, 0, a, a, a, 0);
+    const __m128i dstWeight = _mm_setr_epi16(inv, inv, inv, 256, inv, inv, inv, 256);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    
+    // Sums reach 255 * 256 + 128, which wraps as signed but is exact as unsigned
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+        
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), srcWeight),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), dstWeight));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), srcWeight),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), dstWeight));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    
+    scalarPixelKernels()->blendRgb(dst + i * 4, src + i * 4, pixelCount - i, alpha);
+}
+
+SSE41_TARGET void blendMatteSse41(uint8_t* dst, const uint8_t* background, const uint8_t* matte,
+                                  size_t pixelCount) {
+    // Spread each pixel's weight over its four 16-bit lanes, then force the alpha
+    // lanes to 256 / 0 so dst alpha passes through
+    const __m128i spreadLo = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3);
+    const __m128i spreadHi = _mm_setr_epi8(4, 5, 4, 5, 4, 5, 4, 5, 6, 7, 6, 7, 6, 7, 6, 7);
+    const __m128i full = _mm_set1_epi16(256);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 4 <= pixelCount; i += 4) {
+        int32_t packed;
+        memcpy(&packed, matte + i, 4);
+        __m128i m = _mm_cvtepu8_epi16(_mm_cvtsi32_si128(packed));
+        __m128i weight = _mm_add_epi16(m, _mm_srli_epi16(m, 7));
+        __m128i weightLo = _mm_blend_epi16(_mm_shuffle_epi8(weight, spreadLo), full, 0x88);
+        __m128i weightHi = _mm_blend_epi16(_mm_shuffle_epi8(weight, spreadHi), full, 0x88);
+        
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i * 4));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+        
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), weightLo),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), _mm_sub_epi16(full, weightLo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), weightHi),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), _mm_sub_epi16(full, weightHi)));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    
+    scalarPixelKernels()->blendMatte(dst + i * 4, background + i * 4, matte + i, pixelCount - i);
+}
+
+SSE41_TARGET void chromaKeySse41(uint8_t* rgba, size_t pixelCount, const ChromaKeyCoefficients& key) {
+    // Gathers R, G, B, A of the four pixels in a register into 4-byte runs
+    const __m128i planar = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128i keyCb = _mm_set1_epi16(key.keyCb);
+    const __m128i keyCr = _mm_set1_epi16(key.keyCr);
+    const __m128i inner = _mm_set1_epi16(key.inner);
+    const __m128i width = _mm_set1_epi16(key.width);
+    const __m128i ramp = _mm_set1_epi16(static_cast<int16_t>(key.rampQ8));
+    const __m128i kx = _mm_set1_epi16(key.kx);
+    const __m128i ky = _mm_set1_epi16(key.ky);
+    const __m128i spillR = _mm_set1_epi16(key.spill[0]);
+    const __m128i spillG = _mm_set1_epi16(key.spill[1]);
+    const __m128i spillB = _mm_set1_epi16(key.spill[2]);
+    const __m128i alphaRound = _mm_set1_epi16(255);
+    const __m128i spillRound = _mm_set1_epi16(32);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4)), planar);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4 + 16)), planar);
+        __m128i rg = _mm_unpacklo_epi32(a, b);  // R0-3 R4-7 G0-3 G4-7
+        __m128i ba = _mm_unpackhi_epi32(a, b);
+        __m128i r = _mm_unpacklo_epi8(rg, zero);
+        __m128i g = _mm_unpackhi_epi8(rg, zero);
+        __m128i bl = _mm_unpacklo_epi8(ba, zero);
+        __m128i al = _mm_unpackhi_epi8(ba, zero);
+        
+        __m128i cb = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(-43)),
+            _mm_mullo_epi16(g, _mm_set1_epi16(-85))), _mm_slli_epi16(bl, 7)), 8);
+        __m128i cr = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(_mm_slli_epi16(r, 7),
+            _mm_mullo_epi16(g, _mm_set1_epi16(107))), _mm_mullo_epi16(bl, _mm_set1_epi16(21))), 8);
+        
+        __m128i da = _mm_abs_epi16(_mm_sub_epi16(cb, keyCb));
+        __m128i db = _mm_abs_epi16(_mm_sub_epi16(cr, keyCr));
+        __m128i small = _mm_min_epi16(da, db);
+        __m128i distance = _mm_add_epi16(_mm_max_epi16(da, db),
+                                         _mm_srli_epi16(_mm_add_epi16(small, _mm_add_epi16(small, small)), 3));
+        __m128i t = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(distance, inner), zero), width);
+        __m128i alpha = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(t, ramp), alphaRound), 8);
+        al = _mm_min_epi16(al, alpha);
+        
+        __m128i excess = _mm_max_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(cb, kx),
+                                                                    _mm_mullo_epi16(cr, ky)), 7), zero);
+        r = _mm_add_epi16(r, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(excess, spillR), spillRound), 6));
+        g = _mm_add_epi16(g, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(excess, spillG), spillRound), 6));
+        bl = _mm_add_epi16(bl, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(excess, spillB), spillRound), 6));
+        
+        // Saturate back to bytes and re-interleave: (R, B) and (G, A) rows, then pairs, then quads
+        __m128i rb = _mm_packus_epi16(r, bl);
+        __m128i ga = _mm_packus_epi16(g, al);
+        __m128i rgPairs = _mm_unpacklo_epi8(rb, ga);
+        __m128i baPairs = _mm_unpackhi_epi8(rb, ga);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_unpacklo_epi16(rgPairs, baPairs));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4 + 16), _mm_unpackhi_epi16(rgPairs, baPairs));
+    }
+    
+    scalarPixelKernels()->chromaKey(rgba + i * 4, pixelCount - i, key);
+}
+
+SSE41_TARGET void transposePlaneSse41(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                                      int width, int height) {
+    int fullWidth = width & ~15;
+    int fullHeight = height & ~15;
+    
+    for (int y0 = 0; y0 < fullHeight; y0 += 16) {
+        for (int x0 = 0; x0 < fullWidth; x0 += 16) {
+            __m128i a[16];
+            __m128i b[16];
+            for (int i = 0; i < 16; i++) {
+                a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (y0 + i) * srcStride + x0));
+            }
+            
+            // Interleave bytes, words, dwords and qwords of ever larger row groups:
+            // row pairs, then quads, then octets, until each register is one column
+            for (int i = 0; i < 8; i++) {
+                b[i] = _mm_unpacklo_epi8(a[2 * i], a[2 * i + 1]);      // Columns 0-7
+                b[i + 8] = _mm_unpackhi_epi8(a[2 * i], a[2 * i + 1]);  // Columns 8-15
+            }
+            for (int half = 0; half < 16; half += 8) {
+                for (int j = 0; j < 4; j++) {
+                    a[half + j] = _mm_unpacklo_epi16(b[half + 2 * j], b[half + 2 * j + 1]);
+                    a[half + 4 + j] = _mm_unpackhi_epi16(b[half + 2 * j], b[half + 2 * j + 1]);
+                }
+            }
+            for (int group = 0; group < 16; group += 4) {
+                b[group] = _mm_unpacklo_epi32(a[group], a[group + 1]);
+                b[group + 1] = _mm_unpackhi_epi32(a[group], a[group + 1]);
+                b[group + 2] = _mm_unpacklo_epi32(a[group + 2], a[group + 3]);
+                b[group + 3] = _mm_unpackhi_epi32(a[group + 2], a[group + 3]);
+            }
+            for (int group = 0; group < 16; group += 4) {
+                for (int pair = 0; pair < 2; pair++) {
+                    __m128i top = b[group + pair];
+                    __m128i bottom = b[group + 2 + pair];
+                    uint8_t* out = dst + (x0 + group + pair * 2) * dstStride + y0;
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi64(top, bottom));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + dstStride), _mm_unpackhi_epi64(top, bottom));
+                }
+            }
+        }
+    }
+    
+    // Right columns, then bottom rows
+    scalarPixelKernels()->transposePlane(src + fullWidth, srcStride, dst + fullWidth * dstStride, dstStride,
+                                         width - fullWidth, fullHeight);
+    scalarPixelKernels()->transposePlane(src + fullHeight * srcStride, srcStride, dst + fullHeight, dstStride,
+                                         width, height - fullHeight);
+}
+
+SSE41_TARGET uint32_t sumAbsDiffSse41(const uint8_t* a, size_t aStride, const uint8_t* b, size_t bStride,
+                                      int width, int height) {
+    int fullWidth = width & ~15;
+    __m128i total = _mm_setzero_si128();
+    uint32_t tail = 0;
+    
+    // psadbw leaves two 16-bit sums in 64-bit lanes, so they add up without overflow
+    for (int y = 0; y < height; y++) {
+        const uint8_t* rowA = a + y * aStride;
+        const uint8_t* rowB = b + y * bStride;
+        for (int x = 0; x < fullWidth; x += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowA + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowB + x));
+            total = _mm_add_epi64(total, _mm_sad_epu8(va, vb));
+        }
+        tail += scalarPixelKernels()->sumAbsDiff(rowA + fullWidth, aStride, rowB + fullWidth, bStride,
+                                                 width - fullWidth, 1);
+    }
+    
+    total = _mm_add_epi64(total, _mm_unpackhi_epi64(total, total));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(total)) + tail;
+}
+
+SSE41_TARGET void colorLut3DSse41(const uint16_t* table, uint8_t* rgba, size_t pixelCount) {
+    LutTetrahedron t;
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* px = rgba + i * 4;
+        lutTetrahedron(table, px, t);
+        
+        // pmaddwd on interleaved node pairs: (c0 * w0 + c1 * w1) per channel
+        __m128i n01 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t.node[0])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(t.node[1])));
+        __m128i n23 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t.node[2])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(t.node[3])));
+        __m128i acc = _mm_add_epi32(_mm_madd_epi16(n01, _mm_set1_epi32(t.weight[0] | (t.weight[1] << 16))),
+                                    _mm_madd_epi16(n23, _mm_set1_epi32(t.weight[2] | (t.weight[3] << 16))));
+        acc = _mm_srli_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 11)), 12);
+        __m128i words = _mm_packs_epi32(acc, acc);
+        uint32_t rgbx = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+        px[0] = static_cast<uint8_t>(rgbx);
+        px[1] = static_cast<uint8_t>(rgbx >> 8);
+        px[2] = static_cast<uint8_t>(rgbx >> 16);
+    }
+}
+
+// No byte gather before AVX-512 VBMI, and sixteen pshufb per 16-entry slice cost more
+// than the loads they replace, so table lookups stay scalar on x86
+void channelLutSse41(const uint8_t* tables, uint8_t* rgba, size_t pixelCount) {
+    scalarPixelKernels()->channelLut(tables, rgba, pixelCount);
+}
+
+void planeLutSse41(const uint8_t* table, uint8_t* plane, size_t count) {
+    scalarPixelKernels()->planeLut(table, plane, count);
+}
+
+// AVX2 versions do twice the pixels per step. Most instructions work within
+// 128-bit lanes, so they keep the SSE data layout and fix the order at the end.
+
+AVX2_TARGET void colorMatrixAvx2(const FixedColorMatrix& matrix, uint8_t* rgba, size_t pixelCount) {
+    const int16_t* m = matrix.coef;
+    const __m256i colRG = _mm256_broadcastsi128_si256(
+        _mm_setr_epi16(m[0], m[1], m[4], m[5], m[8], m[9], m[12], m[13]));
+    const __m256i colBA = _mm256_broadcastsi128_si256(
+        _mm_setr_epi16(m[2], m[3], m[6], m[7], m[10], m[11], m[14], m[15]));
+    const __m256i bias = _mm256_broadcastsi128_si256(_mm_add_epi32(
+        _mm_setr_epi32(matrix.offset[0], matrix.offset[1], matrix.offset[2], matrix.offset[3]),
+        _mm_set1_epi32(1 << (matrix.shift - 1))));
+    const __m128i shiftCount = _mm_cvtsi32_si128(matrix.shift);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4));
+        __m256i lo = _mm256_unpacklo_epi8(px, zero);  // Pixels 0, 1 | 4, 5
+        __m256i hi = _mm256_unpackhi_epi8(px, zero);  // Pixels 2, 3 | 6, 7
+        
+        __m256i p0 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(lo, 0x00), colRG),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(lo, 0x55), colBA));
+        __m256i p1 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(lo, 0xAA), colRG),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(lo, 0xFF), colBA));
+        __m256i p2 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(hi, 0x00), colRG),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(hi, 0x55), colBA));
+        __m256i p3 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(hi, 0xAA), colRG),
+                                      _mm256_madd_epi16(_mm256_shuffle_epi32(hi, 0xFF), colBA));
+        
+        p0 = _mm256_sra_epi32(_mm256_add_epi32(p0, bias), shiftCount);
+        p1 = _mm256_sra_epi32(_mm256_add_epi32(p1, bias), shiftCount);
+        p2 = _mm256_sra_epi32(_mm256_add_epi32(p2, bias), shiftCount);
+        p3 = _mm256_sra_epi32(_mm256_add_epi32(p3, bias), shiftCount);
+        
+        // Packing is per lane too, which puts the pixels back in order
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(p0, p1), _mm256_packs_epi32(p2, p3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), packed);
+    }
+    
+    colorMatrixSse41(matrix, rgba + i * 4, pixelCount - i);
+}
+
+AVX2_TARGET void extractLumaAvx2(const uint8_t* rgba, uint8_t* luma, size_t pixelCount) {
+    const __m256i weights = _mm256_set1_epi64x((29LL << 32) | (150LL << 16) | 77LL);
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 16 <= pixelCount; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4 + 32));
+        
+        __m256i sumA = _mm256_hadd_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(a, zero), weights),
+                                         _mm256_madd_epi16(_mm256_unpackhi_epi8(a, zero), weights));
+        __m256i sumB = _mm256_hadd_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(b, zero), weights),
+                                         _mm256_madd_epi16(_mm256_unpackhi_epi8(b, zero), weights));
+        sumA = _mm256_srli_epi32(_mm256_add_epi32(sumA, round), 8);  // Pixels 0-3 | 4-7
+        sumB = _mm256_srli_epi32(_mm256_add_epi32(sumB, round), 8);  // Pixels 8-11 | 12-15
+        
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(sumA, sumB), 0xD8);
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(luma + i), _mm256_castsi256_si128(bytes));
+    }
+    
+    extractLumaSse41(rgba + i * 4, luma + i, pixelCount - i);
+}
+
+AVX2_TARGET void addDetailAvx2(uint8_t* rgba, const uint8_t* luma, const uint8_t* blurred, size_t pixelCount,
+                               int amountQ8, int threshold) {
+    const __m256i thresholdVec = _mm256_set1_epi16(static_cast<int16_t>(threshold));
+    const __m256i amountVec = _mm256_set1_epi16(static_cast<int16_t>(amountQ8));
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i rgbMask = _mm256_set1_epi64x(0x0000FFFFFFFFFFFFLL);
+    const __m256i spreadLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i spreadHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+    size_t i = 0;
+    
+    for (; i + 16 <= pixelCount; i += 16) {
+        __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + i)));
+        __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blurred + i)));
+        __m256i diff = _mm256_sub_epi16(y, b);
+        __m256i keep = _mm256_cmpgt_epi16(_mm256_abs_epi16(diff), thresholdVec);
+        
+        __m256i productLo = _mm256_mullo_epi16(diff, amountVec);
+        __m256i productHi = _mm256_mulhi_epi16(diff, amountVec);
+        __m256i delta0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(productLo, productHi), round), 8);
+        __m256i delta1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(productLo, productHi), round), 8);
+        __m256i delta = _mm256_and_si256(_mm256_packs_epi32(delta0, delta1), keep);
+        
+        for (int half = 0; half < 2; half++) {
+            // Each 32-bit element holds one pixel's delta twice
+            __m256i wide = _mm256_cvtepu16_epi32(half ? _mm256_extracti128_si256(delta, 1)
+                                                      : _mm256_castsi256_si128(delta));
+            __m256i pairs = _mm256_or_si256(wide, _mm256_slli_epi32(wide, 16));
+            
+            for (int quarter = 0; quarter < 2; quarter++) {
+                __m256i spread = _mm256_and_si256(
+                    _mm256_permutevar8x32_epi32(pairs, quarter ? spreadHi : spreadLo), rgbMask);
+                
+                __m128i* ptr = reinterpret_cast<__m128i*>(rgba + (i + half * 8 + quarter * 4) * 4);
+                __m256i px = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(ptr)), spread);
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(px, px), 0x08);
+                _mm_storeu_si128(ptr, _mm256_castsi256_si128(packed));
+            }
+        }
+    }
+    
+    addDetailSse41(rgba + i * 4, luma + i, blurred + i, pixelCount - i, amountQ8, threshold);
+}
+
+AVX2_TARGET void blendRgbAvx2(uint8_t* dst, const uint8_t* src, size_t pixelCount, int alpha) {
+    const long long a = alpha;
+    const long long inv = 256 - alpha;
+    const __m256i srcWeight = _mm256_set1_epi64x(a | (a << 16) | (a << 32));
+    const __m256i dstWeight = _mm256_set1_epi64x(inv | (inv << 16) | (inv << 32) | (256LL << 48));
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i * 4));
+        
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), srcWeight),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), dstWeight));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), srcWeight),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), dstWeight));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+        
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    
+    blendRgbSse41(dst + i * 4, src + i * 4, pixelCount - i, alpha);
+}
+
+AVX2_TARGET void blendMatteAvx2(uint8_t* dst, const uint8_t* background, const uint8_t* matte,
+                                size_t pixelCount) {
+    // Unpacks work per 128-bit lane: the low half of lane 1 holds pixels 4-5, not 2-3
+    const __m256i spreadLo = _mm256_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3,
+                                              8, 9, 8, 9, 8, 9, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11);
+    const __m256i spreadHi = _mm256_setr_epi8(4, 5, 4, 5, 4, 5, 4, 5, 6, 7, 6, 7, 6, 7, 6, 7,
+                                              12, 13, 12, 13, 12, 13, 12, 13, 14, 15, 14, 15, 14, 15, 14, 15);
+    const __m256i full = _mm256_set1_epi16(256);
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m128i m = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(matte + i)));
+        __m256i weight = _mm256_broadcastsi128_si256(_mm_add_epi16(m, _mm_srli_epi16(m, 7)));
+        __m256i weightLo = _mm256_blend_epi16(_mm256_shuffle_epi8(weight, spreadLo), full, 0x88);
+        __m256i weightHi = _mm256_blend_epi16(_mm256_shuffle_epi8(weight, spreadHi), full, 0x88);
+        
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(background + i * 4));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i * 4));
+        
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), weightLo),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), _mm256_sub_epi16(full, weightLo)));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), weightHi),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), _mm256_sub_epi16(full, weightHi)));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+        
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    
+    blendMatteSse41(dst + i * 4, background + i * 4, matte + i, pixelCount - i);
+}
+
+AVX2_TARGET void chromaKeyAvx2(uint8_t* rgba, size_t pixelCount, const ChromaKeyCoefficients& key) {
+    // Same steps as the SSE4.1 version on 16 pixels. Every shuffle and unpack stays
+    // within 128-bit lanes, so lane 0 carries pixels 0-3 and 8-11, lane 1 pixels
+    // 4-7 and 12-15, and the final unpacks put them back in order.
+    const __m256i planar = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                                            0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256i keyCb = _mm256_set1_epi16(key.keyCb);
+    const __m256i keyCr = _mm256_set1_epi16(key.keyCr);
+    const __m256i inner = _mm256_set1_epi16(key.inner);
+    const __m256i width = _mm256_set1_epi16(key.width);
+    const __m256i ramp = _mm256_set1_epi16(static_cast<int16_t>(key.rampQ8));
+    const __m256i kx = _mm256_set1_epi16(key.kx);
+    const __m256i ky = _mm256_set1_epi16(key.ky);
+    const __m256i spillR = _mm256_set1_epi16(key.spill[0]);
+    const __m256i spillG = _mm256_set1_epi16(key.spill[1]);
+    const __m256i spillB = _mm256_set1_epi16(key.spill[2]);
+    const __m256i alphaRound = _mm256_set1_epi16(255);
+    const __m256i spillRound = _mm256_set1_epi16(32);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 16 <= pixelCount; i += 16) {
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4)), planar);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4 + 32)),
+                                        planar);
+        __m256i rg = _mm256_unpacklo_epi32(a, b);
+        __m256i ba = _mm256_unpackhi_epi32(a, b);
+        __m256i r = _mm256_unpacklo_epi8(rg, zero);
+        __m256i g = _mm256_unpackhi_epi8(rg, zero);
+        __m256i bl = _mm256_unpacklo_epi8(ba, zero);
+        __m256i al = _mm256_unpackhi_epi8(ba, zero);
+        
+        __m256i cb = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(
+            _mm256_mullo_epi16(r, _mm256_set1_epi16(-43)), _mm256_mullo_epi16(g, _mm256_set1_epi16(-85))),
+            _mm256_slli_epi16(bl, 7)), 8);
+        __m256i cr = _mm256_srai_epi16(_mm256_sub_epi16(_mm256_sub_epi16(_mm256_slli_epi16(r, 7),
+            _mm256_mullo_epi16(g, _mm256_set1_epi16(107))), _mm256_mullo_epi16(bl, _mm256_set1_epi16(21))), 8);
+        
+        __m256i da = _mm256_abs_epi16(_mm256_sub_epi16(cb, keyCb));
+        __m256i db = _mm256_abs_epi16(_mm256_sub_epi16(cr, keyCr));
+        __m256i small = _mm256_min_epi16(da, db);
+        __m256i distance = _mm256_add_epi16(_mm256_max_epi16(da, db),
+            _mm256_srli_epi16(_mm256_add_epi16(small, _mm256_add_epi16(small, small)), 3));
+        __m256i t = _mm256_min_epi16(_mm256_max_epi16(_mm256_sub_epi16(distance, inner), zero), width);
+        __m256i alpha = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(t, ramp), alphaRound), 8);
+        al = _mm256_min_epi16(al, alpha);
+        
+        __m256i excess = _mm256_max_epi16(_mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(cb, kx),
+                                                                             _mm256_mullo_epi16(cr, ky)), 7), zero);
+        r = _mm256_add_epi16(r, _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(excess, spillR),
+                                                                   spillRound), 6));
+        g = _mm256_add_epi16(g, _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(excess, spillG),
+                                                                   spillRound), 6));
+        bl = _mm256_add_epi16(bl, _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(excess, spillB),
+                                                                     spillRound), 6));
+        
+        __m256i rb = _mm256_packus_epi16(r, bl);
+        __m256i ga = _mm256_packus_epi16(g, al);
+        __m256i rgPairs = _mm256_unpacklo_epi8(rb, ga);
+        __m256i baPairs = _mm256_unpackhi_epi8(rb, ga);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), _mm256_unpacklo_epi16(rgPairs, baPairs));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4 + 32), _mm256_unpackhi_epi16(rgPairs, baPairs));
+    }
+    
+    chromaKeySse41(rgba + i * 4, pixelCount - i, key);
+}
+
+AVX2_TARGET uint32_t sumAbsDiffAvx2(const uint8_t* a, size_t aStride, const uint8_t* b, size_t bStride,
+                                    int width, int height) {
+    int wideWidth = width & ~31;
+    __m256i total = _mm256_setzero_si256();
+    uint32_t rest = 0;
+    
+    for (int y = 0; y < height; y++) {
+        const uint8_t* rowA = a + y * aStride;
+        const uint8_t* rowB = b + y * bStride;
+        for (int x = 0; x < wideWidth; x += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowA + x));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowB + x));
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(va, vb));
+        }
+        if (wideWidth < width) {
+            rest += sumAbsDiffSse41(rowA + wideWidth, aStride, rowB + wideWidth, bStride, width - wideWidth, 1);
+        }
+    }
+    
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum)) + rest;
+}
+
+const PixelKernels kSse41Kernels = {
+    SimdLevel::Sse41,
+    colorMatrixSse41,
+    extractLumaSse41,
+    addDetailSse41,
+    blendRgbSse41,
+    blendMatteSse41,
+    chromaKeySse41,
+    transposePlaneSse41,
+    sumAbsDiffSse41,
+    colorLut3DSse41,
+    channelLutSse41,
+    planeLutSse41
+};
+
+const PixelKernels kAvx2Kernels = {
+    SimdLevel::Avx2,
+    colorMatrixAvx2,
+    extractLumaAvx2,
+    addDetailAvx2,
+    blendRgbAvx2,
+    blendMatteAvx2,
+    chromaKeyAvx2,
+    transposePlaneSse41,  // Shuffles stay within 128-bit lanes; AVX2 gains nothing here
+    sumAbsDiffAvx2,
+    colorLut3DSse41,  // One pixel per step; wider registers gain nothing
+    channelLutSse41,
+    planeLutSse41
+};
+
+}  // namespace
+
+const PixelKernels* sse41PixelKernels() {
+    return &kSse41Kernels;
+}
+
+const PixelKernels* avx2PixelKernels() {
+    return &kAvx2Kernels;
+}
+
+#else
+
+const PixelKernels* sse41PixelKernels() {
+    return nullptr;
+}
+
+const PixelKernels* avx2PixelKernels() {
+    return nullptr;
+}
+
+#endif
+
+}  // namespace videoeditor
@@ -1,126 +1,75 @@
 #include "sharpen_filter.h"
 #include <cmath>
+#include <algorithm>
+#include "pixel_kernels.h"
 
 namespace videoeditor {
 
+namespace {
+
+// Detail gain in 8.8 fixed point; 16x is far beyond any useful sharpening
+constexpr float kMaxAmount = 16.0f;
+
+}  // namespace
+
+SharpenFilter::SharpenFilter(BlurFilter* blurFilter)
+    : m_blurFilter(blurFilter) {
+    LOGI("SharpenFilter created");
+}
+
+SharpenFilter::~SharpenFilter() {
+    LOGI("SharpenFilter destroyed");
+}
+
 void SharpenFilter::apply(VideoFrame& frame, float intensity) {
-    // 3x3 sharpening kernel
-    float kernel[9] = {
-         0, -intensity,  0,
-        -intensity, 1 + 4 * intensity, -intensity,
-         0, -intensity,  0
-    };
+    if (intensity <= 0 || frame.width < 3 || frame.height < 3) return;
     
-    std::vector<uint8_t> result(frame.data.size());
+    extractLuma(frame);
+    m_blurred = m_luma;
     
+    // The old kernel (centre 1 + 4k, cross -k) is luma + 4k * (luma - cross mean);
+    // border pixels keep their value as before
+    int width = frame.width;
     for (int y = 1; y < frame.height - 1; y++) {
-        for (int x = 1; x < frame.width - 1; x++) {
-            for (int c = 0; c < 3; c++) {  // RGB only
-                float sum = 0;
-                
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int idx = ((y + ky) * frame.width + (x + kx)) * 4 + c;
-                        sum += frame.data[idx] * kernel[(ky + 1) * 3 + (kx + 1)];
-                    }
-                }
-                
-                int dstIdx = (y * frame.width + x) * 4 + c;
-                result[dstIdx] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, sum)));
-            }
-            
-            // Alpha
-            int alphaIdx = (y * frame.width + x) * 4 + 3;
-            result[alphaIdx] = frame.data[alphaIdx];
+        const uint8_t* above = m_luma.data() + (y - 1) * width;
+        const uint8_t* row = m_luma.data() + y * width;
+        const uint8_t* below = m_luma.data() + (y + 1) * width;
+        uint8_t* out = m_blurred.data() + y * width;
+        for (int x = 1; x < width - 1; x++) {
+            out[x] = static_cast<uint8_t>((above[x] + below[x] + row[x - 1] + row[x + 1] + 2) >> 2);
         }
     }
     
-    // Copy edges
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            if (y == 0 || y == frame.height - 1 || x == 0 || x == frame.width - 1) {
-                int idx = (y * frame.width + x) * 4;
-                result[idx + 0] = frame.data[idx + 0];
-                result[idx + 1] = frame.data[idx + 1];
-                result[idx + 2] = frame.data[idx + 2];
-                result[idx + 3] = frame.data[idx + 3];
-            }
-        }
-    }
-    
-    frame.data = std::move(result);
+    addDetail(frame, 4.0f * intensity, 0);
 }
 
 void SharpenFilter::unsharpMask(VideoFrame& frame, float amount, float radius, float threshold) {
-    // Create blurred version
-    VideoFrame blurred = frame;
+    if (amount <= 0 || frame.width <= 0 || frame.height <= 0) return;
     
-    // Simple box blur for the mask
-    int blurRadius = static_cast<int>(radius);
-    std::vector<uint8_t> temp(blurred.data.size());
+    extractLuma(frame);
+    m_blurred = m_luma;
     
-    // Horizontal blur
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            int sumR = 0, sumG = 0, sumB = 0;
-            int count = 0;
-            
-            for (int kx = -blurRadius; kx <= blurRadius; kx++) {
-                int sx = x + kx;
-                if (sx >= 0 && sx < frame.width) {
-                    int idx = (y * frame.width + sx) * 4;
-                    sumR += blurred.data[idx + 0];
-                    sumG += blurred.data[idx + 1];
-                    sumB += blurred.data[idx + 2];
-                    count++;
-                }
-            }
-            
-            int dstIdx = (y * frame.width + x) * 4;
-            temp[dstIdx + 0] = sumR / count;
-            temp[dstIdx + 1] = sumG / count;
-            temp[dstIdx + 2] = sumB / count;
-            temp[dstIdx + 3] = blurred.data[dstIdx + 3];
-        }
+    int blurRadius = static_cast<int>(radius);
+    if (blurRadius > 0 && m_blurFilter) {
+        m_blurFilter->boxBlurPlane(m_blurred.data(), frame.width, frame.height, blurRadius);
     }
     
-    // Vertical blur
-    for (int y = 0; y < frame.height; y++) {
-        for (int x = 0; x < frame.width; x++) {
-            int sumR = 0, sumG = 0, sumB = 0;
-            int count = 0;
-            
-            for (int ky = -blurRadius; ky <= blurRadius; ky++) {
-                int sy = y + ky;
-                if (sy >= 0 && sy < frame.height) {
-                    int idx = (sy * frame.width + x) * 4;
-                    sumR += temp[idx + 0];
-                    sumG += temp[idx + 1];
-                    sumB += temp[idx + 2];
-                    count++;
-                }
-            }
-            
-            int dstIdx = (y * frame.width + x) * 4;
-            blurred.data[dstIdx + 0] = sumR / count;
-            blurred.data[dstIdx + 1] = sumG / count;
-            blurred.data[dstIdx + 2] = sumB / count;
-        }
-    }
+    addDetail(frame, amount, static_cast<int>(threshold));
+}
+
+void SharpenFilter::extractLuma(const VideoFrame& frame) {
+    size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+    m_luma.resize(pixelCount);
     
-    // Apply unsharp mask
-    int thresholdInt = static_cast<int>(threshold);
+    pixelKernels().extractLuma(frame.data.data(), m_luma.data(), pixelCount);
+}
+
+void SharpenFilter::addDetail(VideoFrame& frame, float amount, int threshold) {
+    size_t pixelCount = m_luma.size();
+    int amountQ8 = static_cast<int>(std::min(amount, kMaxAmount) * 256.0f + 0.5f);
+    threshold = std::max(threshold, 0);
     
-    for (size_t i = 0; i < frame.data.size(); i += 4) {
-        for (int c = 0; c < 3; c++) {
-            int diff = frame.data[i + c] - blurred.data[i + c];
-            
-            if (std::abs(diff) > thresholdInt) {
-                int newVal = frame.data[i + c] + static_cast<int>(diff * amount);
-                frame.data[i + c] = static_cast<uint8_t>(std::max(0, std::min(255, newVal)));
-            }
-        }
-    }
+    pixelKernels().addDetail(frame.data.data(), m_luma.data(), m_blurred.data(), pixelCount, amountQ8, threshold);
 }
 
 }  // namespace videoeditor
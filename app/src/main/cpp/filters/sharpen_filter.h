@@ -2,13 +2,31 @@
 #define VIDEO_EDITOR_SHARPEN_FILTER_H
 
 #include "common.h"
+#include "blur_filter.h"
 
 namespace videoeditor {
 
+// Sharpening works on luma only: the detail (luma minus blurred luma) is added
+// equally to R, G and B, so edges get crisper without colour fringes
 class SharpenFilter {
 public:
-    void apply(VideoFrame& frame, float intensity);
+    // The blur filter provides the low-pass for unsharp masking and must outlive this
+    explicit SharpenFilter(BlurFilter* blurFilter);
+    ~SharpenFilter();
+
+    void apply(VideoFrame& frame, float intensity);  // 0.0 to 2.0, 3x3 cross kernel
     void unsharpMask(VideoFrame& frame, float amount, float radius, float threshold);
+
+private:
+    // Fill m_luma from the frame (BT.601 weights, 8-bit)
+    void extractLuma(const VideoFrame& frame);
+
+    // frame.rgb += amount * (luma - blurred) wherever |luma - blurred| > threshold
+    void addDetail(VideoFrame& frame, float amount, int threshold);
+
+    BlurFilter* m_blurFilter;
+    std::vector<uint8_t> m_luma;
+    std::vector<uint8_t> m_blurred;
 };
 
 }  // namespace videoeditor
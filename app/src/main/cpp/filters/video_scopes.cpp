@@ -0,0 +1,177 @@
+#include "video_scopes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace videoeditor {
+
+VideoScopes::VideoScopes()
+    : m_threadPool(nullptr)
+    , m_toYCbCr() {
+    // BT.601 full range, Cb and Cr offset to 128; same luma weights as extractLuma
+    const int16_t coef[16] = {
+         77,  150,   29,   0,
+        -43,  -85,  128,   0,
+        128, -107,  -21,   0,
+          0,    0,    0, 256
+    };
+    memcpy(m_toYCbCr.coef, coef, sizeof(coef));
+    m_toYCbCr.offset[0] = 0;
+    m_toYCbCr.offset[1] = 128 << 8;
+    m_toYCbCr.offset[2] = 128 << 8;
+    m_toYCbCr.offset[3] = 0;
+    m_toYCbCr.shift = 8;
+    LOGI("VideoScopes created");
+}
+
+VideoScopes::~VideoScopes() {
+    LOGI("VideoScopes destroyed");
+}
+
+void VideoScopes::setThreadPool(ThreadPool* pool) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadPool = pool;
+}
+
+bool VideoScopes::compute(const VideoFrame& frame, uint32_t scopes, ScopeData& out) {
+    if (frame.width <= 0 || frame.height <= 0 || frame.format != PixelFormat::RGBA ||
+        frame.data.size() < frame.dataSize() || (scopes & kScopeAll) == 0) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    // Same step both ways, sampling the centre of each step x step cell
+    double pixels = static_cast<double>(frame.width) * frame.height;
+    int step = std::max(1, static_cast<int>(std::ceil(std::sqrt(pixels / kTargetSamples))));
+    int columns = (frame.width - 1 - step / 2) / step + 1;
+    int rows = (frame.height - 1 - step / 2) / step + 1;
+    
+    if (scopes & kScopeWaveform) {
+        m_waveformColumn.resize(columns);
+        for (int x = 0; x < columns; x++) {
+            m_waveformColumn[x] = static_cast<uint16_t>(
+                static_cast<int64_t>(x) * kWaveformColumns / columns * kWaveformLevels);
+        }
+    }
+    
+    // One band per thread that can run, each with private bins
+    int bands = m_threadPool ? static_cast<int>(m_threadPool->size()) + 1 : 1;
+    bands = std::min(bands, rows);
+    if (m_bins.size() < static_cast<size_t>(bands)) {
+        m_bins.resize(bands);
+    }
+    auto body = [&](int bandBegin, int bandEnd) {
+        for (int band = bandBegin; band < bandEnd; band++) {
+            countBand(frame, scopes, step, static_cast<int64_t>(rows) * band / bands,
+                      static_cast<int64_t>(rows) * (band + 1) / bands, m_bins[band]);
+        }
+    };
+    if (m_threadPool && bands > 1) {
+        m_threadPool->parallelFor(0, bands, 1, body);
+    } else {
+        body(0, bands);
+    }
+    
+    // Merge the bands
+    out.histogram.clear();
+    out.waveform.clear();
+    out.vectorscope.clear();
+    if (scopes & kScopeHistogram) {
+        out.histogram.assign(4 * kHistogramBins, 0);
+        for (int band = 0; band < bands; band++) {
+            const uint32_t* counts = m_bins[band].histogram.data();
+            for (int c = 0; c < 4; c++) {
+                uint32_t* dst = out.histogram.data() + c * kHistogramBins;
+                const uint32_t* even = counts + c * 2 * kHistogramBins;
+                const uint32_t* odd = even + kHistogramBins;
+                for (int i = 0; i < kHistogramBins; i++) {
+                    dst[i] += even[i] + odd[i];
+                }
+            }
+        }
+    }
+    if (scopes & kScopeWaveform) {
+        out.waveform.assign(kWaveformColumns * kWaveformLevels, 0);
+        for (int band = 0; band < bands; band++) {
+            const uint32_t* counts = m_bins[band].waveform.data();
+            for (size_t i = 0; i < out.waveform.size(); i++) {
+                out.waveform[i] += counts[i];
+            }
+        }
+    }
+    if (scopes & kScopeVectorscope) {
+        out.vectorscope.assign(kVectorscopeSize * kVectorscopeSize, 0);
+        for (int band = 0; band < bands; band++) {
+            const uint32_t* counts = m_bins[band].vectorscope.data();
+            for (size_t i = 0; i < out.vectorscope.size(); i++) {
+                out.vectorscope[i] += counts[i];
+            }
+        }
+    }
+    out.samples = columns * rows;
+    return true;
+}
+
+void VideoScopes::countBand(const VideoFrame& frame, uint32_t scopes, int step, int rowBegin, int rowEnd,
+                            Bins& bins) {
+    const int columns = (frame.width - 1 - step / 2) / step + 1;
+    const PixelKernels& kernels = pixelKernels();
+    bool histogram = scopes & kScopeHistogram;
+    bool waveform = scopes & kScopeWaveform;
+    bool vectorscope = scopes & kScopeVectorscope;
+    
+    if (histogram) bins.histogram.assign(8 * kHistogramBins, 0);
+    if (waveform) bins.waveform.assign(kWaveformColumns * kWaveformLevels, 0);
+    if (vectorscope) bins.vectorscope.assign(kVectorscopeSize * kVectorscopeSize, 0);
+    bins.row.resize(static_cast<size_t>(columns) * 4 + 4);
+    
+    uint32_t* hist = bins.histogram.data();
+    uint32_t* wave = bins.waveform.data();
+    uint32_t* scope = bins.vectorscope.data();
+    const uint16_t* waveColumn = m_waveformColumn.data();
+    uint8_t* row = bins.row.data();
+    
+    for (int ys = rowBegin; ys < rowEnd; ys++) {
+        int y = step / 2 + ys * step;
+        const uint8_t* src = frame.data.data() + (static_cast<size_t>(y) * frame.width + step / 2) * 4;
+        size_t srcStep = static_cast<size_t>(step) * 4;
+        for (int x = 0; x < columns; x++) {
+            memcpy(row + x * 4, src + x * srcStep, 4);
+        }
+        
+        // Alternate pixels count into separate copies, so runs of one value
+        // don't serialise on the same counter
+        if (histogram) {
+            for (int x = 0; x < columns; x++) {
+                const uint8_t* px = row + x * 4;
+                uint32_t* copy = hist + (x & 1) * kHistogramBins;
+                copy[px[0]]++;
+                copy[2 * kHistogramBins + px[1]]++;
+                copy[4 * kHistogramBins + px[2]]++;
+            }
+        }
+        
+        kernels.colorMatrix(m_toYCbCr, row, columns);
+        
+        if (histogram) {
+            uint32_t* luma = hist + 6 * kHistogramBins;
+            for (int x = 0; x < columns; x++) {
+                luma[(x & 1) * kHistogramBins + row[x * 4]]++;
+            }
+        }
+        if (waveform) {
+            for (int x = 0; x < columns; x++) {
+                wave[waveColumn[x] + (row[x * 4] >> 1)]++;
+            }
+        }
+        if (vectorscope) {
+            for (int x = 0; x < columns; x++) {
+                const uint8_t* px = row + x * 4;
+                scope[(px[2] >> 1) * kVectorscopeSize + (px[1] >> 1)]++;
+            }
+        }
+    }
+}
+
+}  // namespace videoeditor
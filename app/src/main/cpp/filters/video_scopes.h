@@ -0,0 +1,67 @@
+#ifndef VIDEO_EDITOR_VIDEO_SCOPES_H
+#define VIDEO_EDITOR_VIDEO_SCOPES_H
+
+#include "common.h"
+#include "pixel_kernels.h"
+#include "thread_pool.h"
+
+namespace videoeditor {
+
+// Scopes to compute, as a mask
+enum ScopeFlags : uint32_t {
+    kScopeHistogram = 1,
+    kScopeWaveform = 2,
+    kScopeVectorscope = 4,
+    kScopeAll = 7
+};
+
+// Counts of sampled pixels; a scope that wasn't asked for is left empty
+struct ScopeData {
+    std::vector<uint32_t> histogram;     // R, G, B, then luma; kHistogramBins each
+    std::vector<uint32_t> waveform;      // Luma: kWaveformColumns columns of kWaveformLevels, dark first
+    std::vector<uint32_t> vectorscope;   // kVectorscopeSize rows of Cr by columns of Cb, lowest first
+    int samples = 0;                     // Pixels read
+};
+
+// Histogram, luma waveform and vectorscope of a frame from a strided subsample,
+// so the cost is bounded by kTargetSamples rather than the frame size. Each band
+// of sampled rows counts into its own bins, merged once at the end; Y, Cb and Cr
+// come from the SIMD colorMatrix kernel one gathered row at a time.
+class VideoScopes {
+public:
+    VideoScopes();
+    ~VideoScopes();
+
+    // Bands run on the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Scopes in the mask for an RGBA frame
+    bool compute(const VideoFrame& frame, uint32_t scopes, ScopeData& out);
+
+    static constexpr int kHistogramBins = 256;
+    static constexpr int kWaveformColumns = 256;
+    static constexpr int kWaveformLevels = 128;   // Luma >> 1
+    static constexpr int kVectorscopeSize = 128;  // Cb, Cr >> 1
+    static constexpr int kTargetSamples = 128 * 1024;
+
+private:
+    // Private counts of one band
+    struct Bins {
+        std::vector<uint32_t> histogram;    // Two copies per channel, for alternate pixels
+        std::vector<uint32_t> waveform;
+        std::vector<uint32_t> vectorscope;
+        std::vector<uint8_t> row;           // Gathered samples of one row, RGBA
+    };
+
+    void countBand(const VideoFrame& frame, uint32_t scopes, int step, int rowBegin, int rowEnd, Bins& bins);
+
+    ThreadPool* m_threadPool;
+    FixedColorMatrix m_toYCbCr;
+    std::vector<Bins> m_bins;
+    std::vector<uint16_t> m_waveformColumn;  // Sample column -> waveform column offset
+    std::mutex m_mutex;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_VIDEO_SCOPES_H
@@ -31,7 +31,9 @@ enum class PixelFormat {
     RGBA,
     RGB,
     NV21,
-    YUV420P,
+    YUV420P,    // I420: Y, then U, then V planes
+    BGRA,
+    NV12,
     UNKNOWN
 };
 
@@ -49,17 +51,20 @@ struct Resolution {
 // Video frame data
 struct VideoFrame {
     std::vector<uint8_t> data;
-    int width;
-    int height;
-    PixelFormat format;
-    int64_t timestamp_us;  // microseconds
+    int width = 0;
+    int height = 0;
+    PixelFormat format = PixelFormat::RGBA;  // Kernels dispatch on this once per frame
+    int64_t timestamp_us = 0;  // microseconds
     
     size_t dataSize() const {
         switch (format) {
             case PixelFormat::RGBA: return width * height * 4;
+            case PixelFormat::BGRA: return width * height * 4;
             case PixelFormat::RGB: return width * height * 3;
-            case PixelFormat::NV21: return width * height * 3 / 2;
-            case PixelFormat::YUV420P: return width * height * 3 / 2;
+            // 4:2:0 chroma rounds up, so odd sizes keep their last column and row
+            case PixelFormat::NV12:
+            case PixelFormat::NV21:
+            case PixelFormat::YUV420P: return width * height + ((width + 1) / 2) * ((height + 1) / 2) * 2;
             default: return 0;
         }
     }
@@ -1,5 +1,6 @@
 #include <jni.h>
 #include "../engine/video_engine.h"
+#include <cstring>
 
 using namespace videoeditor;
 
@@ -69,6 +70,37 @@ Java_com_videoeditor_app_core_NativeEngine_nativeSplitClip(JNIEnv* env, jobject
     return engine->splitClip(clipId, position) ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jlongArray JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeDetectSceneCuts(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    std::vector<int64_t> cuts = engine->detectSceneCuts(clipId);
+    
+    jlongArray result = env->NewLongArray(static_cast<jsize>(cuts.size()));
+    if (result && !cuts.empty()) {
+        env->SetLongArrayRegion(result, 0, static_cast<jsize>(cuts.size()),
+                                reinterpret_cast<const jlong*>(cuts.data()));
+    }
+    return result;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSplitClipAt(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId, jlongArray sourceTimes) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    std::vector<int64_t> times(env->GetArrayLength(sourceTimes));
+    env->GetLongArrayRegion(sourceTimes, 0, static_cast<jsize>(times.size()), reinterpret_cast<jlong*>(times.data()));
+    std::vector<int> newClipIds = engine->splitClipAtSourceTimes(clipId, times);
+    
+    jintArray result = env->NewIntArray(static_cast<jsize>(newClipIds.size()));
+    if (result && !newClipIds.empty()) {
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(newClipIds.size()),
+                               reinterpret_cast<const jint*>(newClipIds.data()));
+    }
+    return result;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_videoeditor_app_core_NativeEngine_nativeSetClipSpeed(JNIEnv* env, jobject thiz,
         jlong handle, jint clipId, jfloat speed) {
@@ -76,6 +108,13 @@ Java_com_videoeditor_app_core_NativeEngine_nativeSetClipSpeed(JNIEnv* env, jobje
     return engine->setClipSpeed(clipId, speed) ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetClipFrameInterpolation(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId, jboolean enabled) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->setClipFrameInterpolation(clipId, enabled == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_videoeditor_app_core_NativeEngine_nativeSetClipVolume(JNIEnv* env, jobject thiz,
         jlong handle, jint clipId, jfloat volume) {
@@ -144,13 +183,17 @@ Java_com_videoeditor_app_core_NativeEngine_nativeSetPreviewSurface(JNIEnv* env,
 
 JNIEXPORT jboolean JNICALL
 Java_com_videoeditor_app_core_NativeEngine_nativeAddFilter(JNIEnv* env, jobject thiz,
-        jlong handle, jint clipId, jstring filterType, jfloat intensity) {
+        jlong handle, jint clipId, jstring filterType, jfloat intensity, jfloatArray extraParams) {
     auto* engine = reinterpret_cast<VideoEngine*>(handle);
     const char* type = env->GetStringUTFChars(filterType, nullptr);
     
     EffectParams params;
     params.effectType = type;
     params.intensity = intensity;
+    if (extraParams) {
+        params.params.resize(env->GetArrayLength(extraParams));
+        env->GetFloatArrayRegion(extraParams, 0, static_cast<jsize>(params.params.size()), params.params.data());
+    }
     
     bool result = engine->addFilter(clipId, type, params);
     env->ReleaseStringUTFChars(filterType, type);
@@ -164,6 +207,315 @@ Java_com_videoeditor_app_core_NativeEngine_nativeRemoveFilter(JNIEnv* env, jobje
     return engine->removeFilter(clipId, filterId) ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jint JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeAddTransition(JNIEnv* env, jobject thiz,
+        jlong handle, jint fromClipId, jint toClipId, jstring transitionType, jlong duration) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* type = env->GetStringUTFChars(transitionType, nullptr);
+    int result = engine->addTransition(fromClipId, toClipId, type, duration);
+    env->ReleaseStringUTFChars(transitionType, type);
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeRemoveTransition(JNIEnv* env, jobject thiz,
+        jlong handle, jint transitionId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->removeTransition(transitionId) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeAddText(JNIEnv* env, jobject thiz,
+        jlong handle, jstring text, jlong startTime, jlong duration,
+        jfloat x, jfloat y, jfloat fontSize, jint color) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* str = env->GetStringUTFChars(text, nullptr);
+    int result = engine->addText(str, startTime, duration, x, y, fontSize, static_cast<uint32_t>(color));
+    env->ReleaseStringUTFChars(text, str);
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeUpdateText(JNIEnv* env, jobject thiz,
+        jlong handle, jint textId, jstring text, jfloat fontSize) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* str = env->GetStringUTFChars(text, nullptr);
+    bool result = engine->updateText(textId, str, fontSize);
+    env->ReleaseStringUTFChars(text, str);
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetTextAnimation(JNIEnv* env, jobject thiz,
+        jlong handle, jint textId, jstring animation, jlong duration) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* name = env->GetStringUTFChars(animation, nullptr);
+    bool result = engine->setTextAnimation(textId, name, duration);
+    env->ReleaseStringUTFChars(animation, name);
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeRemoveText(JNIEnv* env, jobject thiz,
+        jlong handle, jint textId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->removeText(textId) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeGetMissingGlyphs(JNIEnv* env, jobject thiz,
+        jlong handle, jstring text, jfloat fontSize) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* str = env->GetStringUTFChars(text, nullptr);
+    std::vector<uint32_t> missing = engine->getMissingGlyphs(str, fontSize);
+    env->ReleaseStringUTFChars(text, str);
+    
+    jintArray result = env->NewIntArray(static_cast<jsize>(missing.size()));
+    if (result && !missing.empty()) {
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(missing.size()),
+                               reinterpret_cast<const jint*>(missing.data()));
+    }
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeUploadGlyph(JNIEnv* env, jobject thiz,
+        jlong handle, jfloat fontSize, jint codepoint, jbyteArray coverage, jint width, jint height,
+        jint stride, jint bearingX, jint bearingY, jint advance) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    jbyte* pixels = coverage ? env->GetByteArrayElements(coverage, nullptr) : nullptr;
+    if (pixels && env->GetArrayLength(coverage) < static_cast<jsize>(stride) * height) {
+        env->ReleaseByteArrayElements(coverage, pixels, JNI_ABORT);
+        return JNI_FALSE;
+    }
+    
+    bool result = engine->addGlyph(fontSize, static_cast<uint32_t>(codepoint),
+                                   reinterpret_cast<const uint8_t*>(pixels), width, height, stride,
+                                   bearingX, bearingY, advance);
+    if (pixels) {
+        env->ReleaseByteArrayElements(coverage, pixels, JNI_ABORT);
+    }
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeAddStickerImage(JNIEnv* env, jobject thiz,
+        jlong handle, jobject bitmap) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Sticker bitmap must be ARGB_8888");
+        return -1;
+    }
+    
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        return -1;
+    }
+    
+    // Bitmaps are premultiplied unless the app opted out with setPremultiplied(false);
+    // before API 30 flags is always 0, which reads as premultiplied
+    bool premultiplied = (info.flags & ANDROID_BITMAP_FLAGS_ALPHA_MASK) == ANDROID_BITMAP_FLAGS_ALPHA_PREMUL;
+    int result = engine->addStickerImage(static_cast<const uint8_t*>(pixels), info.width, info.height,
+                                         info.stride, premultiplied);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeRemoveStickerImage(JNIEnv* env, jobject thiz,
+        jlong handle, jint imageId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->removeStickerImage(imageId) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeAddSticker(JNIEnv* env, jobject thiz,
+        jlong handle, jint imageId, jfloat x, jfloat y, jlong startTime, jlong duration) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->addSticker(imageId, x, y, startTime, duration);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeRemoveSticker(JNIEnv* env, jobject thiz,
+        jlong handle, jint stickerId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->removeSticker(stickerId) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetStickerTransform(JNIEnv* env, jobject thiz,
+        jlong handle, jint stickerId, jfloat x, jfloat y, jfloat scale, jfloat rotation, jfloat alpha) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->setStickerTransform(stickerId, x, y, scale, rotation, alpha) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetStickerTimeRange(JNIEnv* env, jobject thiz,
+        jlong handle, jint stickerId, jlong startTime, jlong duration) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->setStickerTimeRange(stickerId, startTime, duration) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetStickerAnimation(JNIEnv* env, jobject thiz,
+        jlong handle, jint stickerId, jstring animation, jlong duration) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    const char* name = env->GetStringUTFChars(animation, nullptr);
+    bool result = engine->setStickerAnimation(stickerId, name, duration);
+    env->ReleaseStringUTFChars(animation, name);
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeCompositeMask(JNIEnv* env, jobject thiz,
+        jlong handle, jobject bitmap, jbyteArray matte, jint matteWidth, jint matteHeight,
+        jint mode, jint color, jint blurRadius, jint featherRadius, jint openRadius, jint closeRadius,
+        jint guidedRadius) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || mode < 0 || mode > 3 ||
+        matteWidth <= 0 || matteHeight <= 0 ||
+        env->GetArrayLength(matte) < static_cast<jsize>(matteWidth) * matteHeight) {
+        return JNI_FALSE;
+    }
+    
+    MaskCompositeParams params;
+    params.background = static_cast<MaskBackground>(mode);  // BackgroundMode ordinal
+    params.color = static_cast<uint32_t>(color);
+    params.blurRadius = blurRadius;
+    params.refine.openRadius = openRadius;
+    params.refine.closeRadius = closeRadius;
+    params.refine.guidedRadius = guidedRadius;
+    params.refine.featherRadius = featherRadius;
+    params.premultiplied = (info.flags & ANDROID_BITMAP_FLAGS_ALPHA_MASK) == ANDROID_BITMAP_FLAGS_ALPHA_PREMUL;
+    
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        return JNI_FALSE;
+    }
+    
+    // Bitmap rows may be padded; the compositor works on a packed frame
+    VideoFrame frame;
+    frame.width = info.width;
+    frame.height = info.height;
+    frame.format = PixelFormat::RGBA;
+    frame.data.resize(frame.dataSize());
+    size_t rowBytes = static_cast<size_t>(info.width) * 4;
+    for (uint32_t y = 0; y < info.height; y++) {
+        memcpy(frame.data.data() + y * rowBytes, static_cast<uint8_t*>(pixels) + y * info.stride, rowBytes);
+    }
+    
+    jbyte* matteBytes = env->GetByteArrayElements(matte, nullptr);
+    bool result = engine->compositeMask(frame, reinterpret_cast<const uint8_t*>(matteBytes),
+                                        matteWidth, matteHeight, params);
+    env->ReleaseByteArrayElements(matte, matteBytes, JNI_ABORT);
+    
+    if (result) {
+        for (uint32_t y = 0; y < info.height; y++) {
+            memcpy(static_cast<uint8_t*>(pixels) + y * info.stride, frame.data.data() + y * rowBytes, rowBytes);
+        }
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeSetMaskBackground(JNIEnv* env, jobject thiz,
+        jlong handle, jobject bitmap) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    AndroidBitmapInfo info;
+    void* pixels = nullptr;
+    if (!bitmap || AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+        AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        engine->setMaskBackgroundImage(nullptr, 0, 0, 0);
+        return;
+    }
+    
+    engine->setMaskBackgroundImage(static_cast<const uint8_t*>(pixels), info.width, info.height, info.stride);
+    AndroidBitmap_unlockPixels(env, bitmap);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeGetScopes(JNIEnv* env, jobject thiz,
+        jlong handle, jintArray histogram, jintArray waveform, jintArray vectorscope) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    // A null or short array skips that scope
+    auto wanted = [env](jintArray array, int size) {
+        return array && env->GetArrayLength(array) >= size;
+    };
+    uint32_t scopes = 0;
+    if (wanted(histogram, 4 * VideoScopes::kHistogramBins)) scopes |= kScopeHistogram;
+    if (wanted(waveform, VideoScopes::kWaveformColumns * VideoScopes::kWaveformLevels)) scopes |= kScopeWaveform;
+    if (wanted(vectorscope, VideoScopes::kVectorscopeSize * VideoScopes::kVectorscopeSize)) {
+        scopes |= kScopeVectorscope;
+    }
+    
+    ScopeData data;
+    if (scopes == 0 || !engine->getScopes(scopes, data)) {
+        return 0;
+    }
+    
+    auto copy = [env](jintArray array, const std::vector<uint32_t>& counts) {
+        if (!counts.empty()) {
+            env->SetIntArrayRegion(array, 0, static_cast<jsize>(counts.size()),
+                                   reinterpret_cast<const jint*>(counts.data()));
+        }
+    };
+    copy(histogram, data.histogram);
+    copy(waveform, data.waveform);
+    copy(vectorscope, data.vectorscope);
+    return data.samples;
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeAnalyzeAutoEnhance(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId, jbyteArray lut) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    
+    AutoEnhanceResult enhance;
+    if (!engine->analyzeAutoEnhance(clipId, enhance)) {
+        return nullptr;
+    }
+    
+    // Per-channel tables, R then G then B
+    if (lut && env->GetArrayLength(lut) >= 3 * 256) {
+        ColorLut1D tables = enhance.lut();
+        for (int c = 0; c < 3; c++) {
+            env->SetByteArrayRegion(lut, c * 256, 256, reinterpret_cast<const jbyte*>(tables.table(c)));
+        }
+    }
+    
+    const float values[5] = {enhance.black, enhance.white, enhance.gamma, enhance.temperature, enhance.tint};
+    jfloatArray result = env->NewFloatArray(5);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeStabilizeClip(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->stabilizeClip(clipId) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_videoeditor_app_core_NativeEngine_nativeRemoveStabilization(JNIEnv* env, jobject thiz,
+        jlong handle, jint clipId) {
+    auto* engine = reinterpret_cast<VideoEngine*>(handle);
+    return engine->removeStabilization(clipId) ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_videoeditor_app_core_NativeEngine_nativeAddAudioTrack(JNIEnv* env, jobject thiz,
         jlong handle, jstring filePath, jlong position) {
@@ -0,0 +1,64 @@
+#include "cpu_features.h"
+#include <cstring>
+
+#if defined(__arm__) && !defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace videoeditor {
+
+namespace {
+
+SimdLevel probe() {
+#if defined(__aarch64__)
+    return SimdLevel::Neon;  // Mandatory on arm64
+#elif defined(__arm__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) ? SimdLevel::Neon : SimdLevel::Scalar;
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::Sse41;
+    return SimdLevel::Scalar;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+}  // namespace
+
+SimdLevel CpuFeatures::detect() {
+    static const SimdLevel level = probe();
+    return level;
+}
+
+bool CpuFeatures::supports(SimdLevel level) {
+    SimdLevel best = detect();
+    if (level == SimdLevel::Scalar || level == best) {
+        return true;
+    }
+    // x86 levels are cumulative; NEON is its own family
+    return level == SimdLevel::Sse41 && best == SimdLevel::Avx2;
+}
+
+const char* CpuFeatures::name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Neon: return "neon";
+        case SimdLevel::Sse41: return "sse4.1";
+        case SimdLevel::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+bool CpuFeatures::fromName(const char* name, SimdLevel& level) {
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::Neon, SimdLevel::Sse41, SimdLevel::Avx2};
+    for (SimdLevel candidate : levels) {
+        if (strcmp(name, CpuFeatures::name(candidate)) == 0) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,30 @@
+#ifndef VIDEO_EDITOR_CPU_FEATURES_H
+#define VIDEO_EDITOR_CPU_FEATURES_H
+
+namespace videoeditor {
+
+// Instruction sets pixel kernels are written for, lowest first
+enum class SimdLevel {
+    Scalar,
+    Neon,
+    Sse41,
+    Avx2
+};
+
+class CpuFeatures {
+public:
+    // Detected once; the best level this CPU can run
+    static SimdLevel detect();
+
+    // Whether kernels for the level can run here (Scalar always can)
+    static bool supports(SimdLevel level);
+
+    static const char* name(SimdLevel level);
+
+    // Parses "scalar", "neon", "sse4.1" or "avx2"; false if unknown
+    static bool fromName(const char* name, SimdLevel& level);
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_CPU_FEATURES_H
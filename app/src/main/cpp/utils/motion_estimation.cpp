@@ -0,0 +1,363 @@
+#include "motion_estimation.h"
+#include "../filters/pixel_kernels.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace videoeditor {
+
+namespace {
+
+// Offset of the minimum between three SADs a pixel apart. SAD grows about
+// linearly with misalignment, so two lines of equal and opposite slope are
+// fitted (a parabola pulls the estimate towards whole pixels). Zero when a side
+// is off the plane or the centre isn't the lowest.
+float subPixelOffset(uint32_t left, uint32_t centre, uint32_t right) {
+    if (left == UINT32_MAX || right == UINT32_MAX || centre > left || centre > right) {
+        return 0.0f;
+    }
+    float slope = static_cast<float>(std::max(left, right) - centre);
+    if (slope <= 0.0f) {
+        return 0.0f;
+    }
+    float offset = (static_cast<float>(left) - static_cast<float>(right)) / (2.0f * slope);
+    return std::max(-0.5f, std::min(0.5f, offset));
+}
+
+// SAD of the block at (x, y) in from against the one at (x + dx, y + dy) in to;
+// UINT32_MAX when the moved block leaves the plane
+inline uint32_t blockCost(const PixelKernels& kernels, const LumaPlane& from, const LumaPlane& to,
+                          int x, int y, int dx, int dy) {
+    int tx = x + dx;
+    int ty = y + dy;
+    if (tx < 0 || ty < 0 || tx > to.width - MotionEstimator::kBlockSize || ty > to.height - MotionEstimator::kBlockSize) {
+        return UINT32_MAX;
+    }
+    return kernels.sumAbsDiff(from.row(y) + x, from.width, to.row(ty) + tx, to.width,
+                              MotionEstimator::kBlockSize, MotionEstimator::kBlockSize);
+}
+
+}  // namespace
+
+void LumaPyramid::build(const VideoFrame& frame, int maxWidth, int levels, ThreadPool* pool) {
+    // Whole-factor box filter; column sums stay within 16 bits up to 16 rows
+    m_factor = std::max(1, std::min(16, (frame.width + maxWidth - 1) / std::max(1, maxWidth)));
+    const int factor = m_factor;
+    
+    m_levels.resize(std::max(1, levels));
+    LumaPlane& base = m_levels[0];
+    base.width = frame.width / factor;
+    base.height = frame.height / factor;
+    base.pixels.resize(static_cast<size_t>(base.width) * base.height);
+    if (base.pixels.empty() || frame.data.size() < static_cast<size_t>(frame.width) * frame.height * 4) {
+        m_levels.resize(1);
+        base.width = 0;
+        base.height = 0;
+        base.pixels.clear();
+        return;
+    }
+    
+    const PixelKernels& kernels = pixelKernels();
+    const int area = factor * factor;
+    auto body = [&](int rowBegin, int rowEnd) {
+        std::vector<uint8_t> luma(frame.width);
+        std::vector<uint16_t> columnSums(frame.width);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            std::fill(columnSums.begin(), columnSums.end(), 0);
+            for (int k = 0; k < factor; k++) {
+                const uint8_t* rgba = frame.data.data() + static_cast<size_t>(y * factor + k) * frame.width * 4;
+                kernels.extractLuma(rgba, luma.data(), frame.width);
+                for (int x = 0; x < frame.width; x++) {
+                    columnSums[x] += luma[x];
+                }
+            }
+            
+            uint8_t* out = base.pixels.data() + static_cast<size_t>(y) * base.width;
+            const uint16_t* sums = columnSums.data();
+            for (int x = 0; x < base.width; x++, sums += factor) {
+                uint32_t sum = 0;
+                for (int k = 0; k < factor; k++) {
+                    sum += sums[k];
+                }
+                out[x] = static_cast<uint8_t>((sum + area / 2) / area);
+            }
+        }
+    };
+    if (pool && base.height > 32) {
+        pool->parallelFor(0, base.height, 16, body);
+    } else {
+        body(0, base.height);
+    }
+    
+    // Halve until the next level would be too small to hold a few blocks
+    for (size_t i = 1; i < m_levels.size(); i++) {
+        const LumaPlane& below = m_levels[i - 1];
+        if (below.width / 2 < 2 * MotionEstimator::kBlockSize || below.height / 2 < 2 * MotionEstimator::kBlockSize) {
+            m_levels.resize(i);
+            break;
+        }
+        
+        LumaPlane& level = m_levels[i];
+        level.width = below.width / 2;
+        level.height = below.height / 2;
+        level.pixels.resize(static_cast<size_t>(level.width) * level.height);
+        for (int y = 0; y < level.height; y++) {
+            const uint8_t* top = below.row(2 * y);
+            const uint8_t* bottom = below.row(2 * y + 1);
+            uint8_t* out = level.pixels.data() + static_cast<size_t>(y) * level.width;
+            for (int x = 0; x < level.width; x++) {
+                out[x] = static_cast<uint8_t>((top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1] + 2) >> 2);
+            }
+        }
+    }
+}
+
+MotionEstimator::MotionEstimator()
+    : m_threadPool(nullptr) {
+    LOGI("MotionEstimator created");
+}
+
+MotionEstimator::~MotionEstimator() {
+    LOGI("MotionEstimator destroyed");
+}
+
+void MotionEstimator::setThreadPool(ThreadPool* pool) {
+    m_threadPool = pool;
+}
+
+bool MotionEstimator::estimate(const LumaPyramid& from, const LumaPyramid& to, MotionField& out) {
+    out.vectors.clear();
+    int levels = std::min(from.levels(), to.levels());
+    if (levels == 0 || from.level(0).width != to.level(0).width || from.level(0).height != to.level(0).height) {
+        return false;
+    }
+    
+    // Coarsest level first; each level seeds the one below it
+    m_levels.resize(levels);
+    const std::vector<Candidate>* parent = nullptr;
+    int parentColumns = 0;
+    int parentRows = 0;
+    for (int level = levels - 1; level >= 0; level--) {
+        const LumaPlane& a = from.level(level);
+        const LumaPlane& b = to.level(level);
+        int columns = a.width / kBlockSize;
+        int rows = a.height / kBlockSize;
+        
+        std::vector<Candidate>& vectors = m_levels[level];
+        vectors.assign(static_cast<size_t>(columns) * rows, {0, 0});
+        forRows(rows, [&](int rowBegin, int rowEnd) {
+            searchRows(a, b, columns, parent, parentColumns, parentRows, vectors, rowBegin, rowEnd);
+        });
+        
+        parent = columns > 0 && rows > 0 ? &vectors : nullptr;
+        parentColumns = columns;
+        parentRows = rows;
+    }
+    
+    const LumaPlane& base = from.level(0);
+    out.blockSize = kBlockSize;
+    out.columns = base.width / kBlockSize;
+    out.rows = base.height / kBlockSize;
+    out.width = base.width;
+    out.height = base.height;
+    out.factor = from.factor();
+    out.vectors.resize(static_cast<size_t>(out.columns) * out.rows);
+    forRows(out.rows, [&](int rowBegin, int rowEnd) {
+        finishRows(base, to.level(0), m_levels[0], out, rowBegin, rowEnd);
+    });
+    return !out.vectors.empty();
+}
+
+void MotionEstimator::searchRows(const LumaPlane& from, const LumaPlane& to, int columns,
+                                 const std::vector<Candidate>* parent, int parentColumns, int parentRows,
+                                 std::vector<Candidate>& vectors, int rowBegin, int rowEnd) {
+    static const int kNeighbours[5][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    const PixelKernels& kernels = pixelKernels();
+    
+    for (int by = rowBegin; by < rowEnd; by++) {
+        for (int bx = 0; bx < columns; bx++) {
+            int x = bx * kBlockSize;
+            int y = by * kBlockSize;
+            Candidate best = {0, 0};
+            uint32_t bestCost = blockCost(kernels, from, to, x, y, 0, 0);
+            auto consider = [&](int dx, int dy) {
+                uint32_t cost = blockCost(kernels, from, to, x, y, dx, dy);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = {dx, dy};
+                }
+            };
+            
+            if (!parent) {
+                for (int dy = -kSearchRadius; dy <= kSearchRadius; dy++) {
+                    for (int dx = -kSearchRadius; dx <= kSearchRadius; dx++) {
+                        consider(dx, dy);
+                    }
+                }
+            } else {
+                // Neighbouring parents catch blocks that straddle a motion boundary
+                int px = std::min(bx / 2, parentColumns - 1);
+                int py = std::min(by / 2, parentRows - 1);
+                for (const auto& offset : kNeighbours) {
+                    int nx = px + offset[0];
+                    int ny = py + offset[1];
+                    if (nx < 0 || ny < 0 || nx >= parentColumns || ny >= parentRows) {
+                        continue;
+                    }
+                    const Candidate& predictor = (*parent)[static_cast<size_t>(ny) * parentColumns + nx];
+                    consider(predictor.dx * 2, predictor.dy * 2);
+                }
+                
+                Candidate centre = best;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (dx != 0 || dy != 0) {
+                            consider(centre.dx + dx, centre.dy + dy);
+                        }
+                    }
+                }
+            }
+            vectors[static_cast<size_t>(by) * columns + bx] = best;
+        }
+    }
+}
+
+void MotionEstimator::finishRows(const LumaPlane& from, const LumaPlane& to, const std::vector<Candidate>& vectors,
+                                 MotionField& out, int rowBegin, int rowEnd) {
+    const PixelKernels& kernels = pixelKernels();
+    
+    for (int by = rowBegin; by < rowEnd; by++) {
+        for (int bx = 0; bx < out.columns; bx++) {
+            size_t index = static_cast<size_t>(by) * out.columns + bx;
+            const Candidate& v = vectors[index];
+            int x = bx * kBlockSize;
+            int y = by * kBlockSize;
+            
+            uint32_t centre = blockCost(kernels, from, to, x, y, v.dx, v.dy);
+            float fx = subPixelOffset(blockCost(kernels, from, to, x, y, v.dx - 1, v.dy), centre,
+                                      blockCost(kernels, from, to, x, y, v.dx + 1, v.dy));
+            float fy = subPixelOffset(blockCost(kernels, from, to, x, y, v.dx, v.dy - 1), centre,
+                                      blockCost(kernels, from, to, x, y, v.dx, v.dy + 1));
+            
+            // Against itself a pixel across and a pixel down (up or left at the far edges)
+            int sx = x + 1 <= from.width - kBlockSize ? 1 : -1;
+            int sy = y + 1 <= from.height - kBlockSize ? 1 : -1;
+            uint32_t texture = blockCost(kernels, from, from, x, y, sx, 0) + blockCost(kernels, from, from, x, y, 0, sy);
+            
+            out.vectors[index] = {v.dx + fx, v.dy + fy, centre, texture};
+        }
+    }
+}
+
+bool MotionEstimator::fitGlobalMotion(const MotionField& field, GlobalMotion& out) {
+    struct Sample {
+        float x;
+        float y;
+        float tx;
+        float ty;
+    };
+    
+    // Block centres relative to the plane centre, and where they moved to
+    std::vector<Sample> samples;
+    samples.reserve(field.vectors.size());
+    float cx = field.width * 0.5f;
+    float cy = field.height * 0.5f;
+    for (int by = 0; by < field.rows; by++) {
+        for (int bx = 0; bx < field.columns; bx++) {
+            const MotionVector& v = field.at(bx, by);
+            if (v.texture < kMinTexture) {
+                continue;
+            }
+            float x = (bx + 0.5f) * field.blockSize - cx;
+            float y = (by + 0.5f) * field.blockSize - cy;
+            samples.push_back({x, y, x + v.dx, y + v.dy});
+        }
+    }
+    if (static_cast<int>(samples.size()) < kMinInliers) {
+        return false;
+    }
+    
+    std::vector<uint8_t> inlier(samples.size(), 1);
+    std::vector<float> residuals(samples.size());
+    std::vector<float> sorted;
+    float a = 1.0f;
+    float b = 0.0f;
+    float tx = 0.0f;
+    float ty = 0.0f;
+    
+    for (int round = 0; round < kFitRounds; round++) {
+        // x' = a x - b y + tx, y' = b x + a y + ty in closed form about the centroids
+        double count = 0.0;
+        double mx = 0.0, my = 0.0, mtx = 0.0, mty = 0.0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (!inlier[i]) continue;
+            count += 1.0;
+            mx += samples[i].x;
+            my += samples[i].y;
+            mtx += samples[i].tx;
+            mty += samples[i].ty;
+        }
+        mx /= count;
+        my /= count;
+        mtx /= count;
+        mty /= count;
+        
+        double norm = 0.0, dot = 0.0, cross = 0.0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (!inlier[i]) continue;
+            double x = samples[i].x - mx;
+            double y = samples[i].y - my;
+            double u = samples[i].tx - mtx;
+            double v = samples[i].ty - mty;
+            norm += x * x + y * y;
+            dot += x * u + y * v;
+            cross += x * v - y * u;
+        }
+        if (norm <= 0.0) {
+            return false;
+        }
+        a = static_cast<float>(dot / norm);
+        b = static_cast<float>(cross / norm);
+        tx = static_cast<float>(mtx - (a * mx - b * my));
+        ty = static_cast<float>(mty - (b * mx + a * my));
+        
+        if (round + 1 == kFitRounds) {
+            break;
+        }
+        
+        // Drop blocks well off the fit; the median keeps the cut relative to how noisy this pair is
+        sorted.clear();
+        for (size_t i = 0; i < samples.size(); i++) {
+            const Sample& s = samples[i];
+            residuals[i] = std::hypot(a * s.x - b * s.y + tx - s.tx, b * s.x + a * s.y + ty - s.ty);
+            if (inlier[i]) sorted.push_back(residuals[i]);
+        }
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        float limit = std::max(0.75f, 2.5f * sorted[sorted.size() / 2]);
+        
+        int kept = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            inlier[i] = residuals[i] <= limit;
+            kept += inlier[i];
+        }
+        if (kept < kMinInliers) {
+            return false;
+        }
+    }
+    
+    out.dx = tx * field.factor;
+    out.dy = ty * field.factor;
+    out.angle = std::atan2(b, a);
+    out.scale = std::hypot(a, b);
+    return true;
+}
+
+void MotionEstimator::forRows(int rows, const std::function<void(int, int)>& body) {
+    if (m_threadPool && rows > 4) {
+        m_threadPool->parallelFor(0, rows, 2, body);
+    } else {
+        body(0, rows);
+    }
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,115 @@
+#ifndef VIDEO_EDITOR_MOTION_ESTIMATION_H
+#define VIDEO_EDITOR_MOTION_ESTIMATION_H
+
+#include "common.h"
+#include "thread_pool.h"
+
+namespace videoeditor {
+
+// 8-bit luma plane, rows packed
+struct LumaPlane {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    const uint8_t* row(int y) const { return pixels.data() + static_cast<size_t>(y) * width; }
+};
+
+// Luma of a frame at falling resolutions. Level 0 is box-downscaled by a whole
+// factor to at most maxWidth; each level above it is half the one below.
+class LumaPyramid {
+public:
+    // RGBA frame; rows are banded across the pool when one is given
+    void build(const VideoFrame& frame, int maxWidth, int levels, ThreadPool* pool = nullptr);
+
+    int levels() const { return static_cast<int>(m_levels.size()); }
+    const LumaPlane& level(int index) const { return m_levels[index]; }
+
+    // Frame pixels per level-0 pixel
+    int factor() const { return m_factor; }
+
+private:
+    std::vector<LumaPlane> m_levels;
+    int m_factor = 1;
+};
+
+// Where a block of the first frame went in the second, in level-0 pixels
+struct MotionVector {
+    float dx;
+    float dy;
+    uint32_t sad;       // Of the best whole-pixel match
+    uint32_t texture;   // Block SAD against itself moved one pixel across and one down; low on flat areas
+};
+
+// Block motion between two frames on the level-0 grid of their pyramids
+struct MotionField {
+    int blockSize = 0;
+    int columns = 0;
+    int rows = 0;
+    int width = 0;          // Level-0 plane size
+    int height = 0;
+    int factor = 1;         // Frame pixels per level-0 pixel
+    std::vector<MotionVector> vectors;
+
+    bool empty() const { return vectors.empty(); }
+    const MotionVector& at(int column, int row) const { return vectors[static_cast<size_t>(row) * columns + column]; }
+};
+
+// Camera motion between two frames as a similarity about the frame centre:
+// p' = scale * R(angle) * p + (dx, dy), in frame pixels
+struct GlobalMotion {
+    float dx = 0.0f;
+    float dy = 0.0f;
+    float angle = 0.0f;     // Radians, clockwise in image coordinates
+    float scale = 1.0f;
+};
+
+// Hierarchical SAD block matching (sumAbsDiff kernel: psadbw / vabd). The
+// coarsest level gets a full search; each finer level starts from the best of
+// the parent block's vector and its neighbours', scaled up, and searches one
+// pixel around it. Level 0 adds a sub-pixel step.
+class MotionEstimator {
+public:
+    static constexpr int kBlockSize = 8;
+
+    MotionEstimator();
+    ~MotionEstimator();
+
+    // Block rows are banded across the pool; null runs on the calling thread
+    void setThreadPool(ThreadPool* pool);
+
+    // Motion from from to to; both pyramids must have the same shape
+    bool estimate(const LumaPyramid& from, const LumaPyramid& to, MotionField& out);
+
+    // Least-squares similarity over the textured blocks, refitted without the
+    // outliers (moving subjects) a few times; false if too few blocks agree
+    static bool fitGlobalMotion(const MotionField& field, GlobalMotion& out);
+
+private:
+    struct Candidate {
+        int dx;
+        int dy;
+    };
+
+    // Blocks of rows [rowBegin, rowEnd) at one level, given the level above (null at the top)
+    void searchRows(const LumaPlane& from, const LumaPlane& to, int columns, const std::vector<Candidate>* parent,
+                    int parentColumns, int parentRows, std::vector<Candidate>& vectors, int rowBegin, int rowEnd);
+
+    // Sub-pixel vectors and texture for level-0 rows [rowBegin, rowEnd)
+    void finishRows(const LumaPlane& from, const LumaPlane& to, const std::vector<Candidate>& vectors,
+                    MotionField& out, int rowBegin, int rowEnd);
+
+    void forRows(int rows, const std::function<void(int, int)>& body);
+
+    static constexpr int kSearchRadius = 4;         // Full search at the coarsest level
+    static constexpr uint32_t kMinTexture = 512;    // Blocks flatter than this don't steer the global fit
+    static constexpr int kMinInliers = 8;
+    static constexpr int kFitRounds = 3;
+
+    std::vector<std::vector<Candidate>> m_levels;   // Whole-pixel vectors per pyramid level
+    ThreadPool* m_threadPool;
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_MOTION_ESTIMATION_H
@@ -0,0 +1,63 @@
+#include "pixel_format.h"
+
+namespace videoeditor {
+
+bool PixelConverter::toRgba(const VideoFrame& src, VideoFrame& dst) {
+    BufferPadding padding;
+    padding.stride = tightStride(src.format, src.width);
+    return toRgba(src.data.data(), src.data.size(), src.format, src.width, src.height, padding, dst);
+}
+
+bool PixelConverter::toRgba(const uint8_t* src, size_t srcSize, PixelFormat format, int width, int height,
+                            const BufferPadding& padding, VideoFrame& dst) {
+    if (!src || width <= 0 || height <= 0) {
+        return false;
+    }
+    
+    dst.width = width;
+    dst.height = height;
+    dst.format = PixelFormat::RGBA;
+    
+    bool fits = false;
+    bool known = dispatchPixelFormat(format, [&](auto layout) {
+        using Format = decltype(layout);
+        PlaneLayout planes = planeLayout<Format>(width, height, padding);
+        fits = planes.size <= srcSize;
+        if (fits) {
+            dst.data.resize(dst.dataSize());
+            videoeditor::toRgba<Format>(src, width, height, planes, dst.data.data());
+        }
+    });
+    return known && fits;
+}
+
+bool PixelConverter::fromRgba(const VideoFrame& rgba, PixelFormat format, uint8_t* dst, size_t dstSize) {
+    if (rgba.format != PixelFormat::RGBA || rgba.width <= 0 || rgba.height <= 0 ||
+        rgba.data.size() < rgba.dataSize()) {
+        return false;
+    }
+    
+    bool fits = false;
+    bool known = dispatchPixelFormat(format, [&](auto layout) {
+        using Format = decltype(layout);
+        PlaneLayout planes = tightLayout<Format>(rgba.width, rgba.height);
+        fits = planes.size <= dstSize;
+        if (fits) {
+            videoeditor::fromRgba<Format>(rgba.data.data(), rgba.width, rgba.height, planes, dst);
+        }
+    });
+    return known && fits;
+}
+
+int PixelConverter::tightStride(PixelFormat format, int width) {
+    int stride = width;  // Y plane of the 4:2:0 formats
+    dispatchPixelFormat(format, [&](auto layout) {
+        using Format = decltype(layout);
+        if constexpr (Format::kPacked) {
+            stride = width * Format::kBytesPerPixel;
+        }
+    });
+    return stride;
+}
+
+}  // namespace videoeditor
@@ -0,0 +1,272 @@
+#ifndef VIDEO_EDITOR_PIXEL_FORMAT_H
+#define VIDEO_EDITOR_PIXEL_FORMAT_H
+
+#include "common.h"
+#include <algorithm>
+
+namespace videoeditor {
+
+// Compile-time frame layouts. Kernels are templates over one of these and are
+// instantiated per format, so the choice is made once per frame by
+// dispatchPixelFormat and the pixel loops themselves never branch on it.
+
+// Interleaved formats: byte offset of each channel within a pixel
+struct RgbaFormat {
+    static constexpr PixelFormat kFormat = PixelFormat::RGBA;
+    static constexpr bool kPacked = true;
+    static constexpr int kBytesPerPixel = 4;
+    static constexpr int kR = 0, kG = 1, kB = 2, kA = 3;
+};
+
+struct BgraFormat {
+    static constexpr PixelFormat kFormat = PixelFormat::BGRA;
+    static constexpr bool kPacked = true;
+    static constexpr int kBytesPerPixel = 4;
+    static constexpr int kR = 2, kG = 1, kB = 0, kA = 3;
+};
+
+struct RgbFormat {
+    static constexpr PixelFormat kFormat = PixelFormat::RGB;
+    static constexpr bool kPacked = true;
+    static constexpr int kBytesPerPixel = 3;
+    static constexpr int kR = 0, kG = 1, kB = 2, kA = -1;  // Opaque
+};
+
+// 4:2:0 formats: full-size Y plane, then chroma at half size both ways.
+// kChromaStep is the byte distance between neighbouring U (or V) samples.
+struct Nv12Format {
+    static constexpr PixelFormat kFormat = PixelFormat::NV12;
+    static constexpr bool kPacked = false;
+    static constexpr int kChromaStep = 2;
+    static constexpr int kU = 0, kV = 1;  // Offsets within each UV pair
+};
+
+struct Nv21Format {
+    static constexpr PixelFormat kFormat = PixelFormat::NV21;
+    static constexpr bool kPacked = false;
+    static constexpr int kChromaStep = 2;
+    static constexpr int kU = 1, kV = 0;
+};
+
+struct I420Format {
+    static constexpr PixelFormat kFormat = PixelFormat::YUV420P;
+    static constexpr bool kPacked = false;
+    static constexpr int kChromaStep = 1;
+    static constexpr int kU = 0, kV = 0;  // Separate planes
+};
+
+// Calls fn(descriptor) for the format; false if it has no descriptor
+template <class Fn>
+bool dispatchPixelFormat(PixelFormat format, Fn&& fn) {
+    switch (format) {
+        case PixelFormat::RGBA: fn(RgbaFormat()); return true;
+        case PixelFormat::BGRA: fn(BgraFormat()); return true;
+        case PixelFormat::RGB: fn(RgbFormat()); return true;
+        case PixelFormat::NV12: fn(Nv12Format()); return true;
+        case PixelFormat::NV21: fn(Nv21Format()); return true;
+        case PixelFormat::YUV420P: fn(I420Format()); return true;
+        default: return false;
+    }
+}
+
+// How a buffer pads the visible picture. Codecs pad each row (stride), the
+// first plane with whole rows (slice height, e.g. 1088 for 1080p) and may start
+// the picture at a crop offset, so chroma isn't always right after the last
+// visible Y row.
+struct BufferPadding {
+    int stride = 0;         // Bytes per row of the first plane
+    int sliceHeight = 0;    // Rows allocated to the first plane; 0 for the picture height
+    int cropLeft = 0;       // Top-left visible pixel
+    int cropTop = 0;
+};
+
+// Byte offsets and strides of each plane of the visible picture
+struct PlaneLayout {
+    size_t yOffset = 0;     // First row (the only plane of packed formats)
+    size_t uOffset = 0;
+    size_t vOffset = 0;
+    int yStride = 0;
+    int chromaStride = 0;   // Bytes per row of U and of V
+    size_t size = 0;        // Bytes the buffer must hold
+};
+
+template <class Format>
+PlaneLayout planeLayout(int width, int height, const BufferPadding& padding) {
+    PlaneLayout layout;
+    int sliceHeight = std::max(padding.sliceHeight, padding.cropTop + height);
+    layout.yStride = padding.stride;
+    
+    if constexpr (Format::kPacked) {
+        layout.yOffset = static_cast<size_t>(padding.cropTop) * padding.stride +
+                         static_cast<size_t>(padding.cropLeft) * Format::kBytesPerPixel;
+        layout.size = layout.yOffset + static_cast<size_t>(height - 1) * padding.stride +
+                      static_cast<size_t>(width) * Format::kBytesPerPixel;
+    } else {
+        // Chroma planes are (width + 1) / 2 samples wide, so odd widths round up
+        int chromaWidth = (padding.cropLeft + width + 1) / 2;
+        int chromaRows = (sliceHeight + 1) / 2;
+        size_t chromaBase = static_cast<size_t>(padding.stride) * sliceHeight;
+        size_t chromaCrop;
+        
+        layout.yOffset = static_cast<size_t>(padding.cropTop) * padding.stride + padding.cropLeft;
+        if (Format::kChromaStep == 2) {
+            layout.chromaStride = std::max(padding.stride, chromaWidth * 2);
+            chromaCrop = static_cast<size_t>(padding.cropTop / 2) * layout.chromaStride + (padding.cropLeft / 2) * 2;
+            layout.uOffset = chromaBase + chromaCrop + Format::kU;
+            layout.vOffset = chromaBase + chromaCrop + Format::kV;
+            layout.size = chromaBase;
+        } else {
+            layout.chromaStride = std::max((padding.stride + 1) / 2, chromaWidth);
+            chromaCrop = static_cast<size_t>(padding.cropTop / 2) * layout.chromaStride + padding.cropLeft / 2;
+            size_t vPlane = chromaBase + static_cast<size_t>(layout.chromaStride) * chromaRows;
+            layout.uOffset = chromaBase + chromaCrop;
+            layout.vOffset = vPlane + chromaCrop;
+            layout.size = vPlane;
+        }
+        layout.size += static_cast<size_t>(layout.chromaStride) * ((padding.cropTop + height + 1) / 2);
+    }
+    return layout;
+}
+
+// Layout of a tightly packed buffer, as VideoFrame::dataSize counts it
+template <class Format>
+PlaneLayout tightLayout(int width, int height) {
+    BufferPadding padding;
+    if constexpr (Format::kPacked) {
+        padding.stride = width * Format::kBytesPerPixel;
+    } else {
+        padding.stride = width;
+    }
+    return planeLayout<Format>(width, height, padding);
+}
+
+// Plane pointers of a 4:2:0 image
+template <class Format, class Byte>
+struct YuvPlanes {
+    Byte* y;
+    Byte* u;
+    Byte* v;
+    int yStride;
+    int chromaStride;
+    
+    YuvPlanes(Byte* base, const PlaneLayout& layout)
+        : y(base + layout.yOffset)
+        , u(base + layout.uOffset)
+        , v(base + layout.vOffset)
+        , yStride(layout.yStride)
+        , chromaStride(layout.chromaStride) {}
+};
+
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::max(0, std::min(255, value)));
+}
+
+// YUV conversions below are BT.601 limited range in 8.8 fixed point
+
+// Convert one image laid out as layout describes to tightly packed RGBA
+template <class Format>
+void toRgba(const uint8_t* src, int width, int height, const PlaneLayout& layout, uint8_t* rgba) {
+    if constexpr (Format::kPacked) {
+        for (int y = 0; y < height; y++) {
+            const uint8_t* in = src + layout.yOffset + static_cast<size_t>(y) * layout.yStride;
+            uint8_t* out = rgba + static_cast<size_t>(y) * width * 4;
+            for (int x = 0; x < width; x++) {
+                out[0] = in[Format::kR];
+                out[1] = in[Format::kG];
+                out[2] = in[Format::kB];
+                if constexpr (Format::kA >= 0) {
+                    out[3] = in[Format::kA];
+                } else {
+                    out[3] = 255;
+                }
+                in += Format::kBytesPerPixel;
+                out += 4;
+            }
+        }
+    } else {
+        YuvPlanes<Format, const uint8_t> planes(src, layout);
+        for (int y = 0; y < height; y++) {
+            const uint8_t* yRow = planes.y + static_cast<size_t>(y) * planes.yStride;
+            const uint8_t* uRow = planes.u + static_cast<size_t>(y / 2) * planes.chromaStride;
+            const uint8_t* vRow = planes.v + static_cast<size_t>(y / 2) * planes.chromaStride;
+            uint8_t* out = rgba + static_cast<size_t>(y) * width * 4;
+            
+            for (int x = 0; x < width; x++) {
+                int Y = yRow[x] - 16;
+                int U = uRow[(x / 2) * Format::kChromaStep] - 128;
+                int V = vRow[(x / 2) * Format::kChromaStep] - 128;
+                
+                out[0] = clampByte((298 * Y + 409 * V + 128) >> 8);
+                out[1] = clampByte((298 * Y - 100 * U - 208 * V + 128) >> 8);
+                out[2] = clampByte((298 * Y + 516 * U + 128) >> 8);
+                out[3] = 255;
+                out += 4;
+            }
+        }
+    }
+}
+
+// Convert tightly packed RGBA into a buffer laid out as layout describes.
+// Chroma is taken from the top-left pixel of each 2x2 block.
+template <class Format>
+void fromRgba(const uint8_t* rgba, int width, int height, const PlaneLayout& layout, uint8_t* dst) {
+    if constexpr (Format::kPacked) {
+        for (int y = 0; y < height; y++) {
+            const uint8_t* in = rgba + static_cast<size_t>(y) * width * 4;
+            uint8_t* out = dst + layout.yOffset + static_cast<size_t>(y) * layout.yStride;
+            for (int x = 0; x < width; x++) {
+                out[Format::kR] = in[0];
+                out[Format::kG] = in[1];
+                out[Format::kB] = in[2];
+                if constexpr (Format::kA >= 0) {
+                    out[Format::kA] = in[3];
+                }
+                in += 4;
+                out += Format::kBytesPerPixel;
+            }
+        }
+    } else {
+        YuvPlanes<Format, uint8_t> planes(dst, layout);
+        for (int y = 0; y < height; y++) {
+            const uint8_t* in = rgba + static_cast<size_t>(y) * width * 4;
+            uint8_t* yRow = planes.y + static_cast<size_t>(y) * planes.yStride;
+            for (int x = 0; x < width; x++) {
+                yRow[x] = static_cast<uint8_t>(((66 * in[0] + 129 * in[1] + 25 * in[2] + 128) >> 8) + 16);
+                in += 4;
+            }
+            
+            if (y % 2 != 0) continue;
+            
+            in = rgba + static_cast<size_t>(y) * width * 4;
+            uint8_t* uRow = planes.u + static_cast<size_t>(y / 2) * planes.chromaStride;
+            uint8_t* vRow = planes.v + static_cast<size_t>(y / 2) * planes.chromaStride;
+            for (int x = 0; x < width; x += 2) {
+                const uint8_t* px = in + x * 4;
+                int offset = (x / 2) * Format::kChromaStep;
+                uRow[offset] = static_cast<uint8_t>(((-38 * px[0] - 74 * px[1] + 112 * px[2] + 128) >> 8) + 128);
+                vRow[offset] = static_cast<uint8_t>(((112 * px[0] - 94 * px[1] - 18 * px[2] + 128) >> 8) + 128);
+            }
+        }
+    }
+}
+
+class PixelConverter {
+public:
+    // Convert a frame in any supported format to RGBA; false if the format is unknown
+    static bool toRgba(const VideoFrame& src, VideoFrame& dst);
+    
+    // Same, from a raw buffer of srcSize bytes with padded rows and planes (e.g. a
+    // codec output buffer); false if the format is unknown or the buffer too small
+    static bool toRgba(const uint8_t* src, size_t srcSize, PixelFormat format, int width, int height,
+                       const BufferPadding& padding, VideoFrame& dst);
+    
+    // Write an RGBA frame into dst in the given format; false if unknown or dst is too small
+    static bool fromRgba(const VideoFrame& rgba, PixelFormat format, uint8_t* dst, size_t dstSize);
+    
+    // Bytes per row of the first plane for a tightly packed frame
+    static int tightStride(PixelFormat format, int width);
+};
+
+}  // namespace videoeditor
+
+#endif  // VIDEO_EDITOR_PIXEL_FORMAT_H
@@ -1,4 +1,6 @@
 #include "thread_pool.h"
+#include <atomic>
+#include <algorithm>
 
 namespace videoeditor {
 
@@ -41,4 +43,58 @@ void ThreadPool::waitAll() {
     m_condition.wait(lock, [this] { return m_tasks.empty(); });
 }
 
+void ThreadPool::parallelFor(int begin, int end, int minBand, const std::function<void(int, int)>& body) {
+    int count = end - begin;
+    if (count <= 0) {
+        return;
+    }
+    
+    int maxBands = static_cast<int>(m_workers.size()) + 1;
+    int bands = std::max(1, std::min(maxBands, count / std::max(1, minBand)));
+    if (bands == 1) {
+        body(begin, end);
+        return;
+    }
+    
+    // Bands are claimed from a shared counter; helpers that start after the caller has
+    // taken everything return without touching body
+    struct Job {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto job = std::make_shared<Job>();
+    const std::function<void(int, int)>* bodyPtr = &body;
+    
+    auto runBands = [job, bodyPtr, begin, count, bands]() {
+        int band;
+        while ((band = job->next.fetch_add(1)) < bands) {
+            int bandBegin = begin + static_cast<int>(static_cast<int64_t>(count) * band / bands);
+            int bandEnd = begin + static_cast<int>(static_cast<int64_t>(count) * (band + 1) / bands);
+            (*bodyPtr)(bandBegin, bandEnd);
+            
+            if (job->done.fetch_add(1) + 1 == bands) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->finished.notify_all();
+            }
+        }
+    };
+    
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_stop) {
+            for (int i = 1; i < bands; i++) {
+                m_tasks.emplace(runBands);
+            }
+        }
+    }
+    m_condition.notify_all();
+    
+    runBands();
+    
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job, bands] { return job->done.load() == bands; });
+}
+
 }  // namespace videoeditor
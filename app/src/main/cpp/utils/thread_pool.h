@@ -22,6 +22,11 @@ public:
     void waitAll();
     size_t size() const { return m_workers.size(); }
 
+    // Split [begin, end) into bands of at least minBand items and run body(bandBegin, bandEnd)
+    // on the workers and the calling thread. Returns once every band is done. The caller
+    // claims bands too, so this is safe to call from inside a pool task.
+    void parallelFor(int begin, int end, int minBand, const std::function<void(int, int)>& body);
+
 private:
     std::vector<std::thread> m_workers;
     std::queue<std::function<void()>> m_tasks;
@@ -1,6 +1,11 @@
 package com.vortexeditor.app.core
 
+import android.graphics.Bitmap
+import android.graphics.Canvas
+import android.graphics.Paint
+import android.graphics.Rect
 import android.view.Surface
+import java.nio.ByteBuffer
 
 class NativeEngine {
     private var nativeHandle: Long = 0
@@ -27,9 +32,22 @@ class NativeEngine {
     fun splitClip(clipId: Int, position: Long): Boolean =
         nativeSplitClip(nativeHandle, clipId, position)
 
+    // Shot changes in the clip's source, in source microseconds. Decodes the
+    // file, so call it from a background thread.
+    fun detectSceneCuts(clipId: Int): LongArray = nativeDetectSceneCuts(nativeHandle, clipId)
+
+    // Split the clip at source times (e.g. detectSceneCuts) in one batch;
+    // returns the IDs of the new clips in timeline order
+    fun splitClipAt(clipId: Int, sourceTimesUs: LongArray): IntArray =
+        nativeSplitClipAt(nativeHandle, clipId, sourceTimesUs)
+
     fun setClipSpeed(clipId: Int, speed: Float): Boolean =
         nativeSetClipSpeed(nativeHandle, clipId, speed)
 
+    // Below 1x, synthesise motion-compensated in-between frames instead of repeating frames
+    fun setClipFrameInterpolation(clipId: Int, enabled: Boolean): Boolean =
+        nativeSetClipFrameInterpolation(nativeHandle, clipId, enabled)
+
     fun setClipVolume(clipId: Int, volume: Float): Boolean =
         nativeSetClipVolume(nativeHandle, clipId, volume)
 
@@ -46,12 +64,159 @@ class NativeEngine {
     fun setPreviewSurface(surface: Surface?) = nativeSetPreviewSurface(nativeHandle, surface)
 
     // Filters
-    fun addFilter(clipId: Int, filterType: String, intensity: Float): Boolean =
-        nativeAddFilter(nativeHandle, clipId, filterType, intensity)
+    fun addFilter(clipId: Int, filterType: String, intensity: Float, params: FloatArray? = null): Boolean =
+        nativeAddFilter(nativeHandle, clipId, filterType, intensity, params)
+
+    // Auto levels and white balance measured on the clip's keyframes. Returns the
+    // "levels" params (black, white, gamma) followed by the "temperature" and
+    // "tint" intensities, or null if no frame could be read. lut, if given
+    // (AUTO_ENHANCE_LUT_SIZE bytes), receives the same correction as R, G and B tables.
+    fun analyzeAutoEnhance(clipId: Int, lut: ByteArray? = null): FloatArray? =
+        nativeAnalyzeAutoEnhance(nativeHandle, clipId, lut)
+
+    // Analyse the clip and add the result as its levels, temperature and tint filters
+    fun autoEnhance(clipId: Int): Boolean {
+        val result = analyzeAutoEnhance(clipId) ?: return false
+        return addFilter(clipId, "levels", 1f, floatArrayOf(result[0], result[1], result[2])) &&
+            addFilter(clipId, "temperature", result[3]) &&
+            addFilter(clipId, "tint", result[4])
+    }
+
+    // Measure the clip's camera shake and play it stabilised (slightly zoomed in
+    // to hide the moving edges). Decodes the whole clip: call from a background thread.
+    fun stabilizeClip(clipId: Int): Boolean = nativeStabilizeClip(nativeHandle, clipId)
+
+    fun removeStabilization(clipId: Int): Boolean = nativeRemoveStabilization(nativeHandle, clipId)
+
+    // Spill 0-1; key colour as 0xRRGGBB, tolerance and softness 0-1
+    fun addChromaKey(
+        clipId: Int,
+        keyColor: Int = 0x00B140,
+        tolerance: Float = 0.3f,
+        softness: Float = 0.1f,
+        spill: Float = 0.5f
+    ): Boolean = addFilter(
+        clipId, "chroma_key", spill,
+        floatArrayOf(
+            ((keyColor shr 16) and 0xFF).toFloat(),
+            ((keyColor shr 8) and 0xFF).toFloat(),
+            (keyColor and 0xFF).toFloat(),
+            tolerance,
+            softness
+        )
+    )
 
     fun removeFilter(clipId: Int, filterId: Int): Boolean =
         nativeRemoveFilter(nativeHandle, clipId, filterId)
 
+    // Transitions; type is the Transitions.TransitionType name in lower case, e.g. "wipe_left".
+    // The incoming clip is moved back to overlap the outgoing one. Returns the ID, or -1.
+    fun addTransition(fromClipId: Int, toClipId: Int, type: String, durationUs: Long): Int =
+        nativeAddTransition(nativeHandle, fromClipId, toClipId, type, durationUs)
+
+    fun removeTransition(transitionId: Int): Boolean =
+        nativeRemoveTransition(nativeHandle, transitionId)
+
+    // Text; times in microseconds, x/y are the baseline centre (0-1), color is ARGB.
+    // Glyphs the native atlas doesn't have yet are rasterised here and uploaded once.
+    fun addText(
+        text: String, startTimeUs: Long, durationUs: Long,
+        x: Float, y: Float, fontSize: Float, color: Int
+    ): Int {
+        uploadMissingGlyphs(text, fontSize)
+        return nativeAddText(nativeHandle, text, startTimeUs, durationUs, x, y, fontSize, color)
+    }
+
+    // fontSize becomes the layer's size, so the glyphs uploaded here are the ones drawn
+    fun updateText(textId: Int, text: String, fontSize: Float): Boolean {
+        uploadMissingGlyphs(text, fontSize)
+        return nativeUpdateText(nativeHandle, textId, text, fontSize)
+    }
+
+    // animation is the TextAnimation name in lower case, e.g. "fade_in"
+    fun setTextAnimation(textId: Int, animation: String, durationUs: Long): Boolean =
+        nativeSetTextAnimation(nativeHandle, textId, animation, durationUs)
+
+    fun removeText(textId: Int): Boolean = nativeRemoveText(nativeHandle, textId)
+
+    private val glyphPaint = Paint().apply { isAntiAlias = true }
+
+    private fun uploadMissingGlyphs(text: String, fontSize: Float) {
+        val missing = nativeGetMissingGlyphs(nativeHandle, text, fontSize)
+        if (missing.isEmpty()) return
+
+        glyphPaint.textSize = fontSize
+        val bounds = Rect()
+        for (codepoint in missing) {
+            val glyph = String(Character.toChars(codepoint))
+            val advance = Math.round(glyphPaint.measureText(glyph))
+            glyphPaint.getTextBounds(glyph, 0, glyph.length, bounds)
+
+            if (bounds.isEmpty) {
+                // Blank glyph (space): metrics only
+                nativeUploadGlyph(nativeHandle, fontSize, codepoint, null, 0, 0, 0, 0, 0, advance)
+                continue
+            }
+
+            val bitmap = Bitmap.createBitmap(bounds.width(), bounds.height(), Bitmap.Config.ALPHA_8)
+            Canvas(bitmap).drawText(glyph, -bounds.left.toFloat(), -bounds.top.toFloat(), glyphPaint)
+            val coverage = ByteArray(bitmap.rowBytes * bitmap.height)
+            bitmap.copyPixelsToBuffer(ByteBuffer.wrap(coverage))
+            nativeUploadGlyph(
+                nativeHandle, fontSize, codepoint, coverage, bitmap.width, bitmap.height,
+                bitmap.rowBytes, bounds.left, -bounds.top, advance
+            )
+            bitmap.recycle()
+        }
+    }
+
+    // Stickers; the bitmap (ARGB_8888) is copied once, so it can be recycled afterwards
+    // and shared by any number of stickers. x/y are the sticker centre (0-1).
+    fun addStickerImage(bitmap: Bitmap): Int = nativeAddStickerImage(nativeHandle, bitmap)
+
+    fun removeStickerImage(imageId: Int): Boolean = nativeRemoveStickerImage(nativeHandle, imageId)
+
+    fun addSticker(imageId: Int, x: Float, y: Float, startTimeUs: Long, durationUs: Long): Int =
+        nativeAddSticker(nativeHandle, imageId, x, y, startTimeUs, durationUs)
+
+    fun removeSticker(stickerId: Int): Boolean = nativeRemoveSticker(nativeHandle, stickerId)
+
+    // rotation in degrees, clockwise; scale is clamped to 0.1-5 like StickerManager
+    fun setStickerTransform(
+        stickerId: Int, x: Float, y: Float, scale: Float, rotation: Float, alpha: Float
+    ): Boolean = nativeSetStickerTransform(nativeHandle, stickerId, x, y, scale, rotation, alpha)
+
+    fun setStickerTimeRange(stickerId: Int, startTimeUs: Long, durationUs: Long): Boolean =
+        nativeSetStickerTimeRange(nativeHandle, stickerId, startTimeUs, durationUs)
+
+    // animation is the StickerAnimation name in lower case, e.g. "pop_in"
+    fun setStickerAnimation(stickerId: Int, animation: String, durationUs: Long): Boolean =
+        nativeSetStickerAnimation(nativeHandle, stickerId, animation, durationUs)
+
+    // Background replacement in place on an ARGB_8888 bitmap. matte is 8-bit
+    // (255 = foreground) at any resolution, e.g. the raw segmentation mask size;
+    // mode is the VideoBackgroundProcessor.BackgroundMode ordinal. Before it is
+    // used the matte is opened (drops specks), closed (fills holes) and snapped
+    // to the frame's edges with a guided filter; 0 skips a step. Radii are in
+    // frame pixels.
+    fun compositeMask(
+        bitmap: Bitmap, matte: ByteArray, matteWidth: Int, matteHeight: Int,
+        mode: Int, color: Int, blurRadius: Int, featherRadius: Int,
+        openRadius: Int = 0, closeRadius: Int = 0, guidedRadius: Int = 0
+    ): Boolean = nativeCompositeMask(
+        nativeHandle, bitmap, matte, matteWidth, matteHeight, mode, color, blurRadius, featherRadius,
+        openRadius, closeRadius, guidedRadius
+    )
+
+    // Image shown behind the matte in IMAGE mode; copied, so it can be recycled afterwards
+    fun setMaskBackground(bitmap: Bitmap?) = nativeSetMaskBackground(nativeHandle, bitmap)
+
+    // Scopes of the current preview frame, counted over a subsample of it, into
+    // arrays the caller keeps; a null array skips that scope. Returns the number
+    // of pixels sampled, 0 if there was no frame.
+    fun getScopes(histogram: IntArray?, waveform: IntArray?, vectorscope: IntArray?): Int =
+        nativeGetScopes(nativeHandle, histogram, waveform, vectorscope)
+
     // Audio
     fun addAudioTrack(filePath: String, position: Long): Boolean =
         nativeAddAudioTrack(nativeHandle, filePath, position)
@@ -88,7 +253,10 @@ class NativeEngine {
     private external fun nativeRemoveClip(handle: Long, clipId: Int): Boolean
     private external fun nativeTrimClip(handle: Long, clipId: Int, trimStart: Long, trimEnd: Long): Boolean
     private external fun nativeSplitClip(handle: Long, clipId: Int, position: Long): Boolean
+    private external fun nativeDetectSceneCuts(handle: Long, clipId: Int): LongArray
+    private external fun nativeSplitClipAt(handle: Long, clipId: Int, sourceTimes: LongArray): IntArray
     private external fun nativeSetClipSpeed(handle: Long, clipId: Int, speed: Float): Boolean
+    private external fun nativeSetClipFrameInterpolation(handle: Long, clipId: Int, enabled: Boolean): Boolean
     private external fun nativeSetClipVolume(handle: Long, clipId: Int, volume: Float): Boolean
 
     private external fun nativePlay(handle: Long)
@@ -101,9 +269,54 @@ class NativeEngine {
 
     private external fun nativeSetPreviewSurface(handle: Long, surface: Surface?)
 
-    private external fun nativeAddFilter(handle: Long, clipId: Int, filterType: String, intensity: Float): Boolean
+    private external fun nativeAddFilter(
+        handle: Long, clipId: Int, filterType: String, intensity: Float, params: FloatArray?
+    ): Boolean
     private external fun nativeRemoveFilter(handle: Long, clipId: Int, filterId: Int): Boolean
 
+    private external fun nativeAddTransition(
+        handle: Long, fromClipId: Int, toClipId: Int, type: String, duration: Long
+    ): Int
+    private external fun nativeRemoveTransition(handle: Long, transitionId: Int): Boolean
+
+    private external fun nativeAddText(
+        handle: Long, text: String, startTime: Long, duration: Long,
+        x: Float, y: Float, fontSize: Float, color: Int
+    ): Int
+    private external fun nativeUpdateText(handle: Long, textId: Int, text: String, fontSize: Float): Boolean
+    private external fun nativeSetTextAnimation(handle: Long, textId: Int, animation: String, duration: Long): Boolean
+    private external fun nativeRemoveText(handle: Long, textId: Int): Boolean
+    private external fun nativeGetMissingGlyphs(handle: Long, text: String, fontSize: Float): IntArray
+    private external fun nativeUploadGlyph(
+        handle: Long, fontSize: Float, codepoint: Int, coverage: ByteArray?, width: Int, height: Int,
+        stride: Int, bearingX: Int, bearingY: Int, advance: Int
+    ): Boolean
+
+    private external fun nativeAddStickerImage(handle: Long, bitmap: Bitmap): Int
+    private external fun nativeRemoveStickerImage(handle: Long, imageId: Int): Boolean
+    private external fun nativeAddSticker(
+        handle: Long, imageId: Int, x: Float, y: Float, startTime: Long, duration: Long
+    ): Int
+    private external fun nativeRemoveSticker(handle: Long, stickerId: Int): Boolean
+    private external fun nativeSetStickerTransform(
+        handle: Long, stickerId: Int, x: Float, y: Float, scale: Float, rotation: Float, alpha: Float
+    ): Boolean
+    private external fun nativeSetStickerTimeRange(handle: Long, stickerId: Int, startTime: Long, duration: Long): Boolean
+    private external fun nativeSetStickerAnimation(handle: Long, stickerId: Int, animation: String, duration: Long): Boolean
+
+    private external fun nativeCompositeMask(
+        handle: Long, bitmap: Bitmap, matte: ByteArray, matteWidth: Int, matteHeight: Int,
+        mode: Int, color: Int, blurRadius: Int, featherRadius: Int,
+        openRadius: Int, closeRadius: Int, guidedRadius: Int
+    ): Boolean
+    private external fun nativeSetMaskBackground(handle: Long, bitmap: Bitmap?)
+    private external fun nativeAnalyzeAutoEnhance(handle: Long, clipId: Int, lut: ByteArray?): FloatArray?
+    private external fun nativeStabilizeClip(handle: Long, clipId: Int): Boolean
+    private external fun nativeRemoveStabilization(handle: Long, clipId: Int): Boolean
+    private external fun nativeGetScopes(
+        handle: Long, histogram: IntArray?, waveform: IntArray?, vectorscope: IntArray?
+    ): Int
+
     private external fun nativeAddAudioTrack(handle: Long, filePath: String, position: Long): Boolean
 
     private external fun nativeExport(
@@ -111,4 +324,16 @@ class NativeEngine {
         progressCallback: ExportProgressCallback
     ): Boolean
     private external fun nativeCancelExport(handle: Long)
+
+    companion object {
+        // getScopes array sizes. Histogram: R, G, B and luma, 256 bins each.
+        // Waveform: 256 columns left to right, each 128 luma levels dark first.
+        // Vectorscope: 128 rows of Cr by 128 columns of Cb, lowest first.
+        const val HISTOGRAM_SIZE = 4 * 256
+        const val WAVEFORM_SIZE = 256 * 128
+        const val VECTORSCOPE_SIZE = 128 * 128
+
+        // analyzeAutoEnhance tables: 256 entries each for R, G and B
+        const val AUTO_ENHANCE_LUT_SIZE = 3 * 256
+    }
 }
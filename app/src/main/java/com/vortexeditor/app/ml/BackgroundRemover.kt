@@ -6,6 +6,7 @@ import com.google.mlkit.vision.common.InputImage
 import com.google.mlkit.vision.segmentation.Segmentation
 import com.google.mlkit.vision.segmentation.SegmentationMask
 import com.google.mlkit.vision.segmentation.selfie.SelfieSegmenterOptions
+import com.vortexeditor.app.core.NativeEngine
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.suspendCancellableCoroutine
 import kotlinx.coroutines.withContext
@@ -13,7 +14,11 @@ import java.nio.ByteBuffer
 import kotlin.coroutines.resume
 import kotlin.coroutines.resumeWithException
 
-class BackgroundRemover {
+/**
+ * With a native engine the mask composite (feather, upsample, blend) runs natively;
+ * the per-pixel Kotlin paths below remain as the fallback.
+ */
+class BackgroundRemover(private val nativeEngine: NativeEngine? = null) {
 
     private val options = SelfieSegmenterOptions.Builder()
         .setDetectorMode(SelfieSegmenterOptions.STREAM_MODE)
@@ -27,7 +32,7 @@ class BackgroundRemover {
      */
     suspend fun removeBackground(bitmap: Bitmap): Bitmap = withContext(Dispatchers.Default) {
         val mask = getSegmentationMask(bitmap)
-        applyMask(bitmap, mask)
+        compositeNative(bitmap, mask, MODE_TRANSPARENT) ?: applyMask(bitmap, mask)
     }
 
     /**
@@ -35,7 +40,8 @@ class BackgroundRemover {
      */
     suspend fun replaceBackground(bitmap: Bitmap, backgroundColor: Int): Bitmap = withContext(Dispatchers.Default) {
         val mask = getSegmentationMask(bitmap)
-        applyMaskWithBackground(bitmap, mask, backgroundColor)
+        compositeNative(bitmap, mask, MODE_SOLID_COLOR, color = backgroundColor)
+            ?: applyMaskWithBackground(bitmap, mask, backgroundColor)
     }
 
     /**
@@ -43,7 +49,11 @@ class BackgroundRemover {
      */
     suspend fun replaceBackground(foreground: Bitmap, background: Bitmap): Bitmap = withContext(Dispatchers.Default) {
         val mask = getSegmentationMask(foreground)
-        compositeWithBackground(foreground, mask, background)
+        if (nativeEngine != null && uploadedBackground !== background) {
+            nativeEngine.setMaskBackground(background)
+            uploadedBackground = background
+        }
+        compositeNative(foreground, mask, MODE_IMAGE) ?: compositeWithBackground(foreground, mask, background)
     }
 
     /**
@@ -51,8 +61,10 @@ class BackgroundRemover {
      */
     suspend fun blurBackground(bitmap: Bitmap, blurRadius: Int = 25): Bitmap = withContext(Dispatchers.Default) {
         val mask = getSegmentationMask(bitmap)
-        val blurredBg = blurBitmap(bitmap, blurRadius)
-        compositeWithBackground(bitmap, mask, blurredBg)
+        compositeNative(bitmap, mask, MODE_BLUR, blurRadius = blurRadius) ?: run {
+            val blurredBg = blurBitmap(bitmap, blurRadius)
+            compositeWithBackground(bitmap, mask, blurredBg)
+        }
     }
 
     private suspend fun getSegmentationMask(bitmap: Bitmap): SegmentationMask {
@@ -69,6 +81,37 @@ class BackgroundRemover {
         }
     }
 
+    // Last image handed to the native compositor, so a video's frames don't re-upload it
+    private var uploadedBackground: Bitmap? = null
+
+    private fun compositeNative(
+        bitmap: Bitmap, mask: SegmentationMask, mode: Int, color: Int = 0, blurRadius: Int = 25
+    ): Bitmap? {
+        val engine = nativeEngine ?: return null
+        val result = bitmap.copy(Bitmap.Config.ARGB_8888, true)
+        val matte = toMatte(mask)
+        if (!engine.compositeMask(
+                result, matte, mask.width, mask.height, mode, color, blurRadius, FEATHER_RADIUS,
+                OPEN_RADIUS, CLOSE_RADIUS, GUIDED_RADIUS
+            )) {
+            result.recycle()
+            return null
+        }
+        return result
+    }
+
+    // Confidence 0-1 per mask pixel to an 8-bit matte at the mask's own resolution
+    private fun toMatte(mask: SegmentationMask): ByteArray {
+        val buffer = mask.buffer
+        buffer.rewind()
+        val confidences = buffer.asFloatBuffer()
+        val matte = ByteArray(mask.width * mask.height)
+        for (i in matte.indices) {
+            matte[i] = (confidences.get(i).coerceIn(0f, 1f) * 255f + 0.5f).toInt().toByte()
+        }
+        return matte
+    }
+
     private fun applyMask(original: Bitmap, mask: SegmentationMask): Bitmap {
         val width = original.width
         val height = original.height
@@ -235,4 +278,23 @@ class BackgroundRemover {
     fun close() {
         segmenter.close()
     }
+
+    companion object {
+        // VideoBackgroundProcessor.BackgroundMode ordinals, as the native side expects
+        private const val MODE_TRANSPARENT = 0
+        private const val MODE_SOLID_COLOR = 1
+        private const val MODE_BLUR = 2
+        private const val MODE_IMAGE = 3
+
+        // Frame pixels over which the matte edge ramps from background to foreground;
+        // small, as the guided filter already follows the edge in the frame
+        private const val FEATHER_RADIUS = 2
+
+        // Matte clean-up before compositing, in frame pixels: specks smaller than
+        // OPEN_RADIUS go, holes smaller than CLOSE_RADIUS fill, and the edge is
+        // snapped to the frame over a GUIDED_RADIUS window
+        private const val OPEN_RADIUS = 2
+        private const val CLOSE_RADIUS = 6
+        private const val GUIDED_RADIUS = 8
+    }
 }
@@ -7,6 +7,7 @@ import android.media.MediaExtractor
 import android.media.MediaFormat
 import android.media.MediaMetadataRetriever
 import android.media.MediaMuxer
+import com.vortexeditor.app.core.NativeEngine
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.flow
@@ -16,9 +17,9 @@ import java.io.File
 /**
  * Process video frames with background removal/replacement
  */
-class VideoBackgroundProcessor {
+class VideoBackgroundProcessor(nativeEngine: NativeEngine? = null) {
 
-    private val backgroundRemover = BackgroundRemover()
+    private val backgroundRemover = BackgroundRemover(nativeEngine)
 
     sealed class ProcessingState {
         data class Progress(val percent: Float, val currentFrame: Int, val totalFrames: Int) : ProcessingState()